@@ -1,8 +1,14 @@
 set(CANEY_CREATE_DOCUMENTATION "ON" CACHE BOOL "whether to build documentation")
 
 if(CANEY_CREATE_DOCUMENTATION)
-	find_package(Doxygen REQUIRED)
+	find_package(Doxygen)
+	if(NOT DOXYGEN_FOUND)
+		message(STATUS "doxygen not found, not building documentation")
+		set(CANEY_CREATE_DOCUMENTATION OFF)
+	endif()
+endif()
 
+if(CANEY_CREATE_DOCUMENTATION)
 	file(GLOB components_includes components/*/include)
 	set(INCLUDE_PATH)
 	foreach(incl ${components_includes})
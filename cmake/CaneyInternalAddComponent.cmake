@@ -23,11 +23,13 @@ endmacro()
 # caney_add_library(component <....>)
 #	HEADERS header files...
 #	SOURCES sources files...
+#	TESTS unit test files (built into one boost unit test executable)
+#	BENCHMARKS benchmark files (each built into a standalone executable)
 #	DEPENDS caney components to depend on (must be defined before)
 #	LINK other targets the interface depends on
 #	PRIVATE_LINK other targets the implementation depends on
 function(caney_add_library _comp)
-	cmake_parse_arguments(args "" "" "HEADERS;SOURCES;TESTS;DEPENDS;LINK;PRIVATE_LINK" ${ARGN})
+	cmake_parse_arguments(args "" "" "HEADERS;SOURCES;TESTS;BENCHMARKS;DEPENDS;LINK;PRIVATE_LINK" ${ARGN})
 	if(args_UNPARSED_ARGUMENTS)
 		message(FATAL_ERROR "caney_add_library: unknown arguments '${args_UNPARSED_ARGUMENTS}'")
 	endif()
@@ -43,6 +45,9 @@ function(caney_add_library _comp)
 	file(GLOB_RECURSE glob_tests RELATIVE "${CMAKE_CURRENT_SOURCE}" tests/*.cpp tests/*.h tests/*.hpp)
 	_caney_glob_files("tests" glob_tests args_TESTS)
 
+	file(GLOB_RECURSE glob_benchmarks RELATIVE "${CMAKE_CURRENT_SOURCE}" benchmarks/*.cpp)
+	_caney_glob_files("benchmarks" glob_benchmarks args_BENCHMARKS)
+
 	set(_target "caney-${_comp}")
 
 	if(args_SOURCES)
@@ -77,6 +82,7 @@ function(caney_add_library _comp)
 				message(FATAL_ERROR "${_dep} is not a valid caney component (${_comp} requires it)")
 			endif()
 			target_include_directories("caney-objects-${_comp}" PUBLIC $<TARGET_PROPERTY:caney-objects-${_dep},INTERFACE_INCLUDE_DIRECTORIES>)
+			target_compile_definitions("caney-objects-${_comp}" PUBLIC $<TARGET_PROPERTY:caney-objects-${_dep},INTERFACE_COMPILE_DEFINITIONS>)
 			# the shared library pulls shared targets, the static library static targets
 			target_link_libraries("caney-static-${_comp}" PUBLIC "caney-static-${_dep}")
 			target_link_libraries("caney-shared-${_comp}" PUBLIC "caney-shared-${_dep}")
@@ -87,6 +93,9 @@ function(caney_add_library _comp)
 
 		set_property(TARGET "caney-static-${_comp}" APPEND PROPERTY INTERFACE_INCLUDE_DIRECTORIES $<TARGET_PROPERTY:caney-objects-${_comp},INTERFACE_INCLUDE_DIRECTORIES>)
 		set_property(TARGET "caney-shared-${_comp}" APPEND PROPERTY INTERFACE_INCLUDE_DIRECTORIES $<TARGET_PROPERTY:caney-objects-${_comp},INTERFACE_INCLUDE_DIRECTORIES>)
+		# definitions changing the ABI of headers (see e.g. CANEY_STREAMS_STATS)
+		set_property(TARGET "caney-static-${_comp}" APPEND PROPERTY INTERFACE_COMPILE_DEFINITIONS $<TARGET_PROPERTY:caney-objects-${_comp},INTERFACE_COMPILE_DEFINITIONS>)
+		set_property(TARGET "caney-shared-${_comp}" APPEND PROPERTY INTERFACE_COMPILE_DEFINITIONS $<TARGET_PROPERTY:caney-objects-${_comp},INTERFACE_COMPILE_DEFINITIONS>)
 
 		if(CANEY_INSTALL_STATIC)
 			install(TARGETS "caney-static-${_comp}"
@@ -140,6 +149,16 @@ function(caney_add_library _comp)
 			"${CMAKE_CURRENT_BINARY_DIR}/run-boost-unit-test.cpp"
 		)
 		target_link_libraries("caney-test-${_comp}" PRIVATE "caney::${_comp}" caney::boost::unit_test_framework)
+		# tests can share helpers of other components ("<component>/tests/...")
+		target_include_directories("caney-test-${_comp}" PRIVATE "${CANEY_SOURCE_DIR}/components")
 		add_test(NAME "caney-${_comp}" COMMAND "caney-test-${_comp}")
 	endif()
+
+	if(CANEY_TOP AND CANEY_BUILD_BENCHMARKS AND args_BENCHMARKS)
+		foreach(_bench ${args_BENCHMARKS})
+			get_filename_component(_bench_name "${_bench}" NAME_WE)
+			add_executable("caney-bench-${_comp}-${_bench_name}" "${_bench}")
+			target_link_libraries("caney-bench-${_comp}-${_bench_name}" PRIVATE "caney::${_comp}")
+		endforeach()
+	endif()
 endfunction()
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "caney/bencode.hpp"
+#include "caney/internal.hpp"
+#include "caney/memory/buffer.hpp"
+#include "caney/memory/unique_buf.hpp"
+#include "caney/std/tags.hpp"
+#include "caney/streams/chunks.hpp"
+#include "caney/streams/streams.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+__CANEY_BENCODEV1_BEGIN
+
+/**
+ * @brief a complete bencode value (or container begin / end) found by the
+ *     @ref tokenizer
+ */
+struct bencode_event {
+	/**
+	 * @brief kind of value: @ref token::Integral, @ref token::String,
+	 *     @ref token::List / @ref token::Dict (container begin) or
+	 *     @ref token::ContainerEnd (never @ref token::Error)
+	 */
+	token type{token::Error};
+	/**
+	 * @brief @ref token::String: the string (a slice of the received
+	 *     chunk unless the string was spread over several chunks);
+	 *     @ref token::Integral: the decimal representation
+	 */
+	memory::shared_const_buf data;
+	/** @brief number of containers the value is nested in */
+	std::size_t depth{0};
+	/** @brief whether the string is a dictionary key */
+	bool key{false};
+
+	/** @brief integer value (for @ref token::Integral) */
+	big_number number() const {
+		return big_number(data);
+	}
+};
+
+/**
+ * @brief configuration for @ref tokenizer
+ */
+struct tokenizer_options {
+	std::size_t max_depth{64}; //!< max nesting of containers
+	std::size_t max_string_size{16 * 1024 * 1024}; //!< max length of strings and integers
+};
+
+/**
+ * @brief parse a stream of bencoded values incrementally
+ *
+ * Emits an event as soon as a value is complete; the input doesn't need to
+ * be buffered until the whole (outer) value arrived. The stream can
+ * contain several top-level values.
+ *
+ * Only memory chunks are supported; terminates on other chunk types.
+ *
+ * Invalid data (or limits from @ref tokenizer_options being exceeded) and
+ * streams ending in the middle of a value end the output with
+ * @ref streams::StreamEnd::Aborted; see @ref error.
+ */
+class tokenizer : public streams::transform<streams::chunk, bencode_event> {
+public:
+	/** @brief create tokenizer */
+	static std::shared_ptr<tokenizer> create(tokenizer_options options = tokenizer_options());
+
+	//! @nowarn
+	/** @internal @brief private constructor */
+	explicit tokenizer(private_tag_t, tokenizer_options options);
+	//! @endnowarn
+
+	/** @brief error which aborted the stream */
+	std::error_code error() const {
+		return m_error;
+	}
+
+protected:
+	void on_receive(streams::chunk_queue&& chunks) override;
+	void on_end(streams::StreamEnd end) override;
+
+private:
+	enum class state {
+		Value, // expecting start of a value (or container end)
+		Integer, // in "i...e"
+		StringLength, // in "...:"
+		StringData, // in string data
+	};
+
+	struct container {
+		bool dict;
+		bool expect_key; // dict: next value is a key
+	};
+
+	// parse buffer; returns false on errors
+	bool parse(memory::shared_const_buf const& buf, chunks_out_t& events, std::error_code& ec);
+	bool parse_value(unsigned char c, chunks_out_t& events, std::error_code& ec);
+	// scan integer / string length up to `delim`; returns false if incomplete (or on errors)
+	bool scan_number(memory::shared_const_buf const& buf, std::size_t& pos, unsigned char delim, memory::shared_const_buf& number, std::error_code& ec);
+	void emit(chunks_out_t& events, token type, memory::shared_const_buf data = memory::shared_const_buf());
+	// a value in the current container is complete
+	void value_done();
+	void fail(std::error_code ec);
+
+	tokenizer_options const m_options;
+	state m_state{state::Value};
+	std::vector<container> m_stack;
+	std::string m_partial; // number spread over several chunks
+	memory::unique_buf m_string; // string spread over several chunks
+	std::size_t m_string_size{0};
+	std::size_t m_string_remaining{0};
+	std::error_code m_error;
+	bool m_failed{false};
+};
+
+__CANEY_BENCODEV1_END
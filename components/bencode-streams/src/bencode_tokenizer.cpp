@@ -0,0 +1,235 @@
+#include "caney/bencode_tokenizer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+__CANEY_BENCODEV1_BEGIN
+
+namespace {
+	// string lengths longer than this can't be valid std::size_t values anyway
+	constexpr std::size_t max_length_digits = 20;
+
+	bool is_digit(unsigned char c) {
+		return c >= '0' && c <= '9';
+	}
+
+	// minimal decimal representation (no leading zeroes, no "-0")
+	bool valid_number(memory::shared_const_buf const& number, bool allow_negative) {
+		std::size_t const size = number.size();
+		if (0 == size) return false;
+		std::size_t i = 0;
+		if (allow_negative && '-' == number[i]) {
+			if (1 == size || '0' == number[1]) return false;
+			i = 1;
+		} else if ('0' == number[i] && size > 1) {
+			return false;
+		}
+		for (; i < size; ++i) {
+			if (!is_digit(number[i])) return false;
+		}
+		return true;
+	}
+} // anonymous namespace
+
+// static
+std::shared_ptr<tokenizer> tokenizer::create(tokenizer_options options) {
+	return std::make_shared<tokenizer>(private_tag, options);
+}
+
+tokenizer::tokenizer(private_tag_t, tokenizer_options options) : m_options(options) {}
+
+void tokenizer::on_receive(streams::chunk_queue&& chunks) {
+	if (m_failed) return;
+	chunks_out_t events;
+	std::error_code ec;
+	for (streams::chunk const& c : chunks.queue()) {
+		streams::memory_chunk const* const mem = c.get_memory_chunk();
+		if (!mem) std::terminate(); // only memory chunks supported
+		if (!parse(mem->buffer(), events, ec)) break;
+	}
+	// pass on values completed before an error
+	if (!events.empty()) send(std::move(events));
+	if (ec) fail(ec);
+}
+
+void tokenizer::on_end(streams::StreamEnd end) {
+	if (m_failed) return;
+	if (streams::StreamEnd::EndOfStream == end && (state::Value != m_state || !m_stack.empty())) {
+		// stream ended in the middle of a value
+		fail(std::make_error_code(std::errc::no_message_available));
+		return;
+	}
+	send_end(end);
+}
+
+bool tokenizer::parse(memory::shared_const_buf const& buf, chunks_out_t& events, std::error_code& ec) {
+	std::size_t pos = 0;
+	std::size_t const size = buf.size();
+	while (pos < size) {
+		switch (m_state) {
+		case state::Value:
+			if (!parse_value(buf[pos], events, ec)) return false;
+			// digits of a string length are scanned by scan_number
+			if (state::StringLength != m_state) ++pos;
+			break;
+		case state::Integer: {
+			memory::shared_const_buf number;
+			if (!scan_number(buf, pos, 'e', number, ec)) {
+				if (ec) return false;
+				break;
+			}
+			emit(events, token::Integral, std::move(number));
+			value_done();
+			m_state = state::Value;
+			break;
+		}
+		case state::StringLength: {
+			memory::shared_const_buf number;
+			if (!scan_number(buf, pos, ':', number, ec)) {
+				if (ec) return false;
+				break;
+			}
+			caney::optional<std::size_t> const length = util::parse_integral<std::size_t>(number);
+			if (!length || *length > m_options.max_string_size) {
+				ec = std::make_error_code(std::errc::message_size);
+				return false;
+			}
+			if (0 == *length) {
+				emit(events, token::String, memory::shared_const_buf());
+				value_done();
+				m_state = state::Value;
+			} else {
+				m_string_size = m_string_remaining = *length;
+				m_state = state::StringData;
+			}
+			break;
+		}
+		case state::StringData: {
+			std::size_t const available = size - pos;
+			if (m_string_remaining == m_string_size && available >= m_string_size) {
+				// complete string in this chunk: no copy
+				emit(events, token::String, buf.shared_slice(pos, m_string_size));
+				pos += m_string_size;
+			} else {
+				if (m_string_remaining == m_string_size) m_string = memory::unique_buf::allocate(m_string_size);
+				std::size_t const n = std::min(available, m_string_remaining);
+				std::memcpy(m_string.data() + (m_string_size - m_string_remaining), buf.data() + pos, n);
+				pos += n;
+				m_string_remaining -= n;
+				if (m_string_remaining > 0) break;
+				emit(events, token::String, m_string.freeze(m_string_size));
+				m_string = memory::unique_buf();
+			}
+			m_string_size = m_string_remaining = 0;
+			value_done();
+			m_state = state::Value;
+			break;
+		}
+		}
+	}
+	return true;
+}
+
+bool tokenizer::parse_value(unsigned char c, chunks_out_t& events, std::error_code& ec) {
+	container const* const top = m_stack.empty() ? nullptr : &m_stack.back();
+	if ('e' == c) {
+		// no container end in dict between key and value
+		if (!top || (top->dict && !top->expect_key)) {
+			ec = std::make_error_code(std::errc::bad_message);
+			return false;
+		}
+		m_stack.pop_back();
+		emit(events, token::ContainerEnd);
+		value_done();
+		return true;
+	}
+	if (top && top->dict && top->expect_key && !is_digit(c)) {
+		// dict keys must be strings
+		ec = std::make_error_code(std::errc::bad_message);
+		return false;
+	}
+	switch (c) {
+	case 'i':
+		m_state = state::Integer;
+		return true;
+	case 'l':
+	case 'd':
+		if (m_stack.size() >= m_options.max_depth) {
+			ec = std::make_error_code(std::errc::message_size);
+			return false;
+		}
+		emit(events, 'l' == c ? token::List : token::Dict);
+		m_stack.push_back(container{'d' == c, true});
+		return true;
+	default:
+		if (is_digit(c)) {
+			m_state = state::StringLength;
+			return true;
+		}
+		ec = std::make_error_code(std::errc::bad_message);
+		return false;
+	}
+}
+
+bool tokenizer::scan_number(memory::shared_const_buf const& buf, std::size_t& pos, unsigned char delim, memory::shared_const_buf& number, std::error_code& ec) {
+	bool const integer = ('e' == delim);
+	unsigned char const* const data = buf.data();
+	void const* const hit = std::memchr(data + pos, delim, buf.size() - pos);
+	std::size_t const end = hit ? static_cast<std::size_t>(static_cast<unsigned char const*>(hit) - data) : buf.size();
+
+	for (std::size_t i = pos; i < end; ++i) {
+		if (!is_digit(data[i]) && !(integer && '-' == data[i])) {
+			ec = std::make_error_code(std::errc::bad_message);
+			return false;
+		}
+	}
+	if (m_partial.size() + (end - pos) > (integer ? m_options.max_string_size : max_length_digits)) {
+		ec = std::make_error_code(std::errc::message_size);
+		return false;
+	}
+
+	if (!hit) {
+		m_partial.append(reinterpret_cast<char const*>(data + pos), end - pos);
+		pos = end;
+		return false;
+	}
+	if (m_partial.empty()) {
+		// complete number in this chunk: no copy
+		number = buf.shared_slice(pos, end - pos);
+	} else {
+		m_partial.append(reinterpret_cast<char const*>(data + pos), end - pos);
+		number = memory::shared_const_buf::copy(m_partial);
+		m_partial.clear();
+	}
+	pos = end + 1;
+	if (!valid_number(number, integer)) {
+		ec = std::make_error_code(std::errc::bad_message);
+		return false;
+	}
+	return true;
+}
+
+void tokenizer::emit(chunks_out_t& events, token type, memory::shared_const_buf data) {
+	bencode_event event;
+	event.type = type;
+	event.data = std::move(data);
+	event.depth = m_stack.size();
+	event.key = token::String == type && !m_stack.empty() && m_stack.back().dict && m_stack.back().expect_key;
+	events.push_back(std::move(event));
+}
+
+void tokenizer::value_done() {
+	// dicts alternate between keys and values
+	if (!m_stack.empty() && m_stack.back().dict) m_stack.back().expect_key = !m_stack.back().expect_key;
+}
+
+void tokenizer::fail(std::error_code ec) {
+	m_error = ec;
+	m_failed = true;
+	m_partial.clear();
+	m_string = memory::unique_buf();
+	send_end(streams::StreamEnd::Aborted);
+	sink_t::disconnect();
+}
+
+__CANEY_BENCODEV1_END
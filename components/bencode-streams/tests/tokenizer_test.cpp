@@ -0,0 +1,150 @@
+#include <caney/bencode_tokenizer.hpp>
+
+#include "streams/tests/test_helpers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+	using test_helpers::test_source;
+
+	class event_sink : public caney::streams::sink<caney::bencode::bencode_event> {
+	public:
+		std::vector<caney::bencode::bencode_event> events;
+		bool ended{false};
+		caney::streams::StreamEnd end{caney::streams::StreamEnd::Aborted};
+
+		// compact description of the events: "i<num>", "s<str>" ("k<str>" for keys), "l", "d", "e"
+		std::string describe() const {
+			std::string result;
+			for (auto const& e : events) {
+				switch (e.type) {
+				case caney::bencode::token::Integral:
+					result += "i" + std::string(e.data.data(), e.data.data() + e.data.size()) + " ";
+					break;
+				case caney::bencode::token::String:
+					result += (e.key ? "k" : "s") + std::string(e.data.data(), e.data.data() + e.data.size()) + " ";
+					break;
+				case caney::bencode::token::List:
+					result += "l ";
+					break;
+				case caney::bencode::token::Dict:
+					result += "d ";
+					break;
+				case caney::bencode::token::ContainerEnd:
+					result += "e ";
+					break;
+				case caney::bencode::token::Error:
+					result += "! ";
+					break;
+				}
+			}
+			return result;
+		}
+
+	protected:
+		void on_receive(chunks_t&& received) override {
+			for (auto& e : received) events.push_back(std::move(e));
+		}
+
+		void on_end(caney::streams::StreamEnd e) override {
+			ended = true;
+			end = e;
+		}
+	};
+
+	struct pipeline {
+		explicit pipeline(caney::bencode::tokenizer_options options = caney::bencode::tokenizer_options())
+		: tokenizer(caney::bencode::tokenizer::create(options)) {
+			caney::streams::connect(source, tokenizer);
+			caney::streams::connect(tokenizer, sink);
+		}
+
+		std::shared_ptr<test_source> source = std::make_shared<test_source>();
+		std::shared_ptr<caney::bencode::tokenizer> tokenizer;
+		std::shared_ptr<event_sink> sink = std::make_shared<event_sink>();
+	};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(tokenizer_test)
+
+BOOST_AUTO_TEST_CASE(chunk_boundaries) {
+	std::string const data = "d8:intervali1800e5:peersld2:ip9:127.0.0.14:porti-6881eeee0:le4:spam";
+	std::string const expected = "d kinterval i1800 kpeers l d kip s127.0.0.1 kport i-6881 e e e s l e sspam ";
+	for (std::size_t step : {0u, 1u, 2u, 3u, 7u}) {
+		pipeline p;
+		p.source->push(data, step);
+		BOOST_CHECK_EQUAL(p.sink->describe(), expected);
+		p.source->end();
+		BOOST_CHECK(p.sink->ended);
+		BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == p.sink->end);
+		BOOST_CHECK(!p.tokenizer->error());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(incremental) {
+	pipeline p;
+	p.source->push("li4");
+	BOOST_CHECK_EQUAL(p.sink->describe(), "l ");
+	p.source->push("2e4:sp");
+	BOOST_CHECK_EQUAL(p.sink->describe(), "l i42 ");
+	p.source->push("am");
+	BOOST_CHECK_EQUAL(p.sink->describe(), "l i42 sspam ");
+	BOOST_CHECK_EQUAL(p.sink->events[1].depth, 1u);
+	BOOST_CHECK(p.sink->events[1].number().try_decode<int>() == 42);
+	p.source->push("e");
+	BOOST_CHECK_EQUAL(p.sink->events[3].depth, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(zero_copy) {
+	caney::memory::shared_const_buf const buf(std::string("5:hello3:ab"));
+	pipeline p;
+	p.source->push(buf);
+	BOOST_REQUIRE_EQUAL(p.sink->describe(), "shello ");
+	// string within a single chunk is a slice of it
+	BOOST_CHECK(p.sink->events[0].data.data() == buf.data() + 2);
+
+	p.source->push("c");
+	BOOST_REQUIRE_EQUAL(p.sink->describe(), "shello sabc ");
+	// string spanning chunks gets copied
+	caney::memory::shared_const_buf const& copied = p.sink->events[1].data;
+	BOOST_CHECK(copied.data() < buf.data() || copied.data() >= buf.data() + buf.size());
+}
+
+BOOST_AUTO_TEST_CASE(errors) {
+	struct error_case {
+		char const* data;
+		std::errc error;
+	};
+	error_case const cases[] = {
+		{"i01e", std::errc::bad_message},
+		{"i-0e", std::errc::bad_message},
+		{"ie", std::errc::bad_message},
+		{"i1x", std::errc::bad_message},
+		{"01:a", std::errc::bad_message},
+		{"di1ei2ee", std::errc::bad_message}, // non-string key
+		{"d1:ae", std::errc::bad_message}, // missing value
+		{"e", std::errc::bad_message},
+		{"x", std::errc::bad_message},
+		{"lllle", std::errc::message_size}, // max_depth
+		{"100:", std::errc::message_size}, // max_string_size
+		{"99999999999999999999999:", std::errc::message_size},
+		{"l", std::errc::no_message_available},
+		{"3:ab", std::errc::no_message_available},
+		{"i12", std::errc::no_message_available},
+	};
+	caney::bencode::tokenizer_options options;
+	options.max_depth = 3;
+	options.max_string_size = 64;
+	for (auto const& c : cases) {
+		pipeline p(options);
+		p.source->push(c.data, 1);
+		if (!p.sink->ended) p.source->end();
+		BOOST_CHECK_MESSAGE(p.tokenizer->error() == c.error, c.data);
+		BOOST_CHECK(caney::streams::StreamEnd::Aborted == p.sink->end);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,8 +2,6 @@
 
 #include "caney/util/to_string.hpp"
 
-#include <iostream>
-
 __CANEY_BENCODEV1_BEGIN
 
 namespace {
@@ -23,8 +21,7 @@ namespace {
 		}
 		for (; i < buf.size(); ++i) {
 			if (delim == buf[i]) {
-				std::cerr << "integer is at slice(" << start << ", " << (i - 1) << ") of '" << buf.data() << "' (length " << buf.size() << ")\n";
-				caney::optional<big_number> result{big_number{buf.shared_slice(start, i - 1)}};
+				caney::optional<big_number> result{big_number{buf.shared_slice(start, i - start)}};
 				buf = buf.shared_slice(i + 1);
 				return result;
 			}
@@ -51,7 +48,7 @@ token peek_token(memory::shared_const_buf const& buf) {
 	case 'e':
 		return token::ContainerEnd;
 	default:
-		if (c >= '0' || c <= '9') return token::String;
+		if (c >= '0' && c <= '9') return token::String;
 		return token::Error;
 	}
 }
@@ -64,9 +61,9 @@ caney::optional<big_number> parse_integral(memory::shared_const_buf& buf) {
 caney::optional<memory::shared_const_buf> parse_string(memory::shared_const_buf& buf) {
 	memory::shared_const_buf bufCopy{buf};
 	caney::optional<big_number> const string_length_big = parse_bignum(bufCopy, 0, ':');
-	if (string_length_big) return caney::nullopt;
-	caney::optional<std::size_t> const string_length = util::parse_integral<std::size_t>(string_length_big->raw().raw_copy());
-	if (string_length) return caney::nullopt;
+	if (!string_length_big) return caney::nullopt;
+	caney::optional<std::size_t> const string_length = string_length_big->try_decode<std::size_t>();
+	if (!string_length) return caney::nullopt;
 	if (*string_length > bufCopy.size()) return caney::nullopt;
 	buf = bufCopy.shared_slice(*string_length);
 	return bufCopy.shared_slice(0, *string_length);
@@ -102,7 +99,9 @@ caney::optional<memory::shared_const_buf> parse_item(memory::shared_const_buf& b
 		return caney::nullopt;
 	}
 	std::size_t const item_length = buf.size() - bufCopy.size();
-	return buf.shared_slice(0, item_length);
+	memory::shared_const_buf item = buf.shared_slice(0, item_length);
+	buf = bufCopy;
+	return item;
 }
 
 __CANEY_BENCODEV1_END
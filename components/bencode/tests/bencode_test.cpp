@@ -2,6 +2,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <cstring>
+
 
 BOOST_AUTO_TEST_SUITE(bencode_test)
 
@@ -37,4 +39,29 @@ BOOST_AUTO_TEST_CASE(test_int_vector) {
 	BOOST_CHECK_EQUAL(l->at(4), 127);
 }
 
+BOOST_AUTO_TEST_CASE(test_string) {
+	caney::memory::shared_const_buf buf(std::string("4:spam0:i1e"));
+	caney::optional<caney::memory::shared_const_buf> s = caney::bencode::parse<caney::memory::shared_const_buf>(buf);
+	BOOST_REQUIRE(s);
+	BOOST_CHECK_EQUAL(s->size(), 4);
+	BOOST_CHECK_EQUAL(0, std::memcmp(s->data(), "spam", 4));
+	s = caney::bencode::parse<caney::memory::shared_const_buf>(buf);
+	BOOST_REQUIRE(s);
+	BOOST_CHECK(s->empty());
+	BOOST_CHECK_EQUAL(buf.size(), 3);
+	BOOST_CHECK(!caney::bencode::parse<caney::memory::shared_const_buf>(buf));
+
+	caney::memory::shared_const_buf truncated(std::string("5:spam"));
+	BOOST_CHECK(!caney::bencode::parse<caney::memory::shared_const_buf>(truncated));
+	BOOST_CHECK(caney::bencode::token::Error == caney::bencode::peek_token(caney::memory::shared_const_buf(std::string("x"))));
+}
+
+BOOST_AUTO_TEST_CASE(test_item) {
+	caney::memory::shared_const_buf buf(std::string("d3:fooli1e2:xye3:bari-2eerest"));
+	caney::optional<caney::memory::shared_const_buf> item = caney::bencode::parse_item(buf);
+	BOOST_REQUIRE(item);
+	BOOST_CHECK_EQUAL(item->size(), 25);
+	BOOST_CHECK_EQUAL(buf.size(), 4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,230 @@
+/** @file */
+
+#pragma once
+
+#include "caney/memory/buffer.hpp"
+#include "caney/memory/intrusive_buffer_pool.hpp"
+#include "caney/std/tags.hpp"
+#include "caney/streams/chunks.hpp"
+#include "caney/streams/streams.hpp"
+
+#include "internal.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <system_error>
+
+/**
+ * @brief whether a codec library was found when building (set by cmake;
+ *     see @ref caney::compress::is_supported)
+ */
+#if !defined(CANEY_COMPRESS_HAVE_ZLIB)
+#define CANEY_COMPRESS_HAVE_ZLIB 0
+#endif
+#if !defined(CANEY_COMPRESS_HAVE_ZSTD)
+#define CANEY_COMPRESS_HAVE_ZSTD 0
+#endif
+#if !defined(CANEY_COMPRESS_HAVE_LZ4)
+#define CANEY_COMPRESS_HAVE_LZ4 0
+#endif
+
+__CANEY_COMPRESSV1_BEGIN
+
+/**
+ * @brief compression formats
+ */
+enum class algorithm {
+	zlib, //!< deflate with zlib header (RFC 1950)
+	gzip, //!< deflate with gzip header (RFC 1952)
+	zstd, //!< Zstandard frames
+	lz4, //!< LZ4 frames
+};
+
+/**
+ * @brief whether support for an algorithm was found when building
+ */
+bool is_supported(algorithm algo);
+
+/**
+ * @brief configuration for compressing @ref codec_transform -s
+ */
+struct compress_options {
+	/**
+	 * @brief compression level in the range of the algorithm; 0 selects
+	 *     the default level of the algorithm
+	 */
+	int level{0};
+	/**
+	 * @brief flush compressed data after this many bytes of input, so the
+	 *     receiver can decompress everything up to that point (0: only
+	 *     flush at @ref codec_transform::flush and the end of the stream)
+	 */
+	std::size_t flush_bytes{0};
+	std::size_t output_buffer_size{64 * 1024}; //!< size of the pooled buffers output is written to
+};
+
+/**
+ * @brief configuration for decompressing @ref codec_transform -s
+ */
+struct decompress_options {
+	std::size_t output_buffer_size{64 * 1024}; //!< size of the pooled buffers output is written to
+};
+
+namespace impl {
+	/** @brief what a @ref codec should do with the input */
+	enum class codec_op {
+		run, //!< consume as much input as possible
+		flush, //!< consume all input and emit all data buffered in the codec
+		finish, //!< consume all input and finish the compressed stream
+	};
+
+	/** @brief result of @ref codec::step */
+	struct codec_result {
+		std::size_t consumed{0}; //!< number of input bytes consumed
+		std::size_t produced{0}; //!< number of output bytes written
+		/**
+		 * @brief compression: flush / finish complete; decompression: a
+		 *     compressed stream ended
+		 */
+		bool done{false};
+	};
+
+	/**
+	 * @brief streaming (de)compression engine of one algorithm
+	 */
+	class codec {
+	public:
+		virtual ~codec() = default;
+
+		/**
+		 * @brief process input into output
+		 *
+		 * Called repeatedly (with more output space) until all input is
+		 * consumed, and for flush / finish until `done` is set.
+		 * Decompressors ignore `op` and accept concatenated streams.
+		 */
+		virtual codec_result step(unsigned char const* in, std::size_t in_size, unsigned char* out, std::size_t out_size, codec_op op, std::error_code& ec) = 0;
+
+		/** @brief decompression: whether the input so far ended with a complete stream */
+		virtual bool at_stream_boundary() const {
+			return true;
+		}
+	};
+
+	/** @brief create compressor; nullptr and `ec` set if not supported */
+	std::unique_ptr<codec> make_compressor(algorithm algo, int level, std::error_code& ec);
+
+	/** @brief create decompressor; nullptr and `ec` set if not supported */
+	std::unique_ptr<codec> make_decompressor(algorithm algo, std::error_code& ec);
+
+#if CANEY_COMPRESS_HAVE_ZLIB
+	std::unique_ptr<codec> make_zlib_compressor(bool gzip, int level, std::error_code& ec);
+	std::unique_ptr<codec> make_zlib_decompressor(bool gzip, std::error_code& ec);
+#endif
+#if CANEY_COMPRESS_HAVE_ZSTD
+	std::unique_ptr<codec> make_zstd_compressor(int level, std::error_code& ec);
+	std::unique_ptr<codec> make_zstd_decompressor(std::error_code& ec);
+#endif
+#if CANEY_COMPRESS_HAVE_LZ4
+	std::unique_ptr<codec> make_lz4_compressor(int level, std::error_code& ec);
+	std::unique_ptr<codec> make_lz4_decompressor(std::error_code& ec);
+#endif
+} // namespace impl
+
+/**
+ * @brief compress or decompress a stream of chunks
+ *
+ * Input memory chunks are passed to the codec without copying; output is
+ * written to buffers from a @ref memory::intrusive_buffer_pool. Only
+ * memory chunks are supported; terminates on other chunk types.
+ *
+ * The transform is the origin for the following stages: while they pause
+ * it no more input is processed (decompression might produce a lot of
+ * output from little input), and the preceding stages are paused until
+ * the remaining input was processed.
+ *
+ * Decompression errors (and compressed data ending in the middle of a
+ * stream) end the output with @ref streams::StreamEnd::Aborted; see
+ * @ref error.
+ */
+class codec_transform : public streams::transform<streams::chunk, streams::chunk>,
+						public streams::origin,
+						public std::enable_shared_from_this<codec_transform> {
+public:
+	/** @brief create compressor; nullptr and `ec` set if `algo` is not supported */
+	static std::shared_ptr<codec_transform> compressor(algorithm algo, compress_options options, std::error_code& ec);
+
+	/** @brief create decompressor; nullptr and `ec` set if `algo` is not supported */
+	static std::shared_ptr<codec_transform> decompressor(algorithm algo, decompress_options options, std::error_code& ec);
+
+	//! @nowarn
+	/** @internal @brief private constructor */
+	codec_transform(private_tag_t, std::unique_ptr<impl::codec> codec, bool compress, std::size_t flush_bytes, std::size_t output_buffer_size);
+	//! @endnowarn
+
+	/**
+	 * @brief compression: flush data received so far (after all data
+	 *     received so far was processed)
+	 */
+	void flush();
+
+	/** @brief error which aborted the stream */
+	std::error_code error() const {
+		return m_error;
+	}
+
+	/** @brief number of input bytes processed */
+	std::uint64_t bytes_in() const {
+		return m_consumed;
+	}
+
+	/** @brief number of output bytes produced */
+	std::uint64_t bytes_out() const {
+		return m_produced;
+	}
+
+private:
+	// the transform is the origin for the following stages
+	void on_new_origin(std::shared_ptr<streams::origin> const& new_origin) override;
+	void on_pause() override;
+	void on_resume() override;
+	void on_connected_sink() override;
+
+	void on_receive(streams::chunk_queue&& chunks) override;
+	void on_end(streams::StreamEnd end) override;
+
+	// process pending input while not paused
+	void process();
+	// feed input from the first non-empty chunk; returns false if interrupted
+	bool feed();
+	// run pending flush / finish; returns false if interrupted
+	bool finish_op();
+	// run codec until the input is consumed (and `op` is done); returns false if interrupted (pause or error)
+	bool run(impl::codec_op op, unsigned char const* data, std::size_t size, std::size_t& consumed);
+	void emit(std::size_t produced);
+	void send_output();
+	void end_stream();
+	void fail(std::error_code ec);
+
+	std::unique_ptr<impl::codec> m_codec;
+	bool const m_compress;
+	std::size_t const m_flush_bytes;
+	memory::intrusive_buffer_pool<> m_pool;
+	memory::unique_buf m_out_buffer;
+	streams::chunk_queue m_output;
+
+	streams::chunk_queue m_input;
+	std::uint64_t m_received{0}; // input bytes received
+	std::uint64_t m_consumed{0}; // input bytes processed
+	std::uint64_t m_produced{0};
+	std::uint64_t m_last_flush{0}; // input position of last flush
+	std::uint64_t m_flush_at{0}; // input position of requested flush
+	bool m_flush_requested{false};
+	impl::codec_op m_pending_op{impl::codec_op::run}; // flush or finish in progress
+	bool m_processing{false};
+	bool m_end_pending{false};
+	bool m_done{false};
+	std::error_code m_error;
+};
+
+__CANEY_COMPRESSV1_END
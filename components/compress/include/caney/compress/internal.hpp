@@ -0,0 +1,66 @@
+/** @file */
+// clang-format off
+
+#pragma once
+
+/**
+  * @brief start compress module for doxygen
+  * @internal
+  */
+#define __CANEY_DOXYGEN_GROUP_COMPRESSV1_BEGIN \
+	/** @addtogroup compress */ \
+	/** @{ */
+
+/**
+  * @brief end compress module for doxygen
+  * @internal
+  */
+#define __CANEY_DOXYGEN_GROUP_COMPRESSV1_END \
+	/** @} */
+
+/* don't use inline namespace when generating docs */
+
+/**
+ * @brief basically `namespace caney { namespace compress { inline namespace v1 {` + some doxygen handling
+ * @internal
+ */
+#if defined(DOXYGEN)
+	#define __CANEY_COMPRESSV1_BEGIN \
+		/** @namespace caney */ \
+		namespace caney { \
+			/** @namespace caney::compress */ \
+			namespace compress { \
+				__CANEY_DOXYGEN_GROUP_COMPRESSV1_BEGIN
+#else
+	#define __CANEY_COMPRESSV1_BEGIN \
+		/** @namespace caney */ \
+		namespace caney { \
+			/** @namespace caney::compress */ \
+			namespace compress { \
+				__CANEY_DOXYGEN_GROUP_COMPRESSV1_BEGIN \
+				/** @namespace caney::compress::v1 */ \
+				inline namespace v1 {
+#endif
+
+/**
+ * @brief basically `} } }` + some doxygen handling
+ * @internal
+ */
+#if defined(DOXYGEN)
+	#define __CANEY_COMPRESSV1_END \
+				__CANEY_DOXYGEN_GROUP_COMPRESSV1_END \
+			} /* namespace caney::compress */ \
+		} /* namespace caney */
+#else
+	#define __CANEY_COMPRESSV1_END \
+				__CANEY_DOXYGEN_GROUP_COMPRESSV1_END \
+				} /* inline namespace caney::compress::v1 */ \
+			} /* namespace caney::compress */ \
+		} /* namespace caney */
+#endif
+
+/**
+ * @defgroup compress caney compress component
+ *
+ * @brief The caney `compress` component lives in the namespace @ref caney::compress .
+ */
@@ -0,0 +1,275 @@
+#include "caney/compress/codec.hpp"
+
+#include <algorithm>
+
+#include <boost/asio/buffer.hpp>
+
+__CANEY_COMPRESSV1_BEGIN
+
+bool is_supported(algorithm algo) {
+	switch (algo) {
+	case algorithm::zlib:
+	case algorithm::gzip:
+		return 0 != CANEY_COMPRESS_HAVE_ZLIB;
+	case algorithm::zstd:
+		return 0 != CANEY_COMPRESS_HAVE_ZSTD;
+	case algorithm::lz4:
+		return 0 != CANEY_COMPRESS_HAVE_LZ4;
+	}
+	return false;
+}
+
+namespace impl {
+	std::unique_ptr<codec> make_compressor(algorithm algo, int level, std::error_code& ec) {
+		ec.clear();
+		switch (algo) {
+#if CANEY_COMPRESS_HAVE_ZLIB
+		case algorithm::zlib:
+			return make_zlib_compressor(false, level, ec);
+		case algorithm::gzip:
+			return make_zlib_compressor(true, level, ec);
+#endif
+#if CANEY_COMPRESS_HAVE_ZSTD
+		case algorithm::zstd:
+			return make_zstd_compressor(level, ec);
+#endif
+#if CANEY_COMPRESS_HAVE_LZ4
+		case algorithm::lz4:
+			return make_lz4_compressor(level, ec);
+#endif
+		default:
+			break;
+		}
+		(void)level;
+		ec = std::make_error_code(std::errc::function_not_supported);
+		return nullptr;
+	}
+
+	std::unique_ptr<codec> make_decompressor(algorithm algo, std::error_code& ec) {
+		ec.clear();
+		switch (algo) {
+#if CANEY_COMPRESS_HAVE_ZLIB
+		case algorithm::zlib:
+			return make_zlib_decompressor(false, ec);
+		case algorithm::gzip:
+			return make_zlib_decompressor(true, ec);
+#endif
+#if CANEY_COMPRESS_HAVE_ZSTD
+		case algorithm::zstd:
+			return make_zstd_decompressor(ec);
+#endif
+#if CANEY_COMPRESS_HAVE_LZ4
+		case algorithm::lz4:
+			return make_lz4_decompressor(ec);
+#endif
+		default:
+			break;
+		}
+		ec = std::make_error_code(std::errc::function_not_supported);
+		return nullptr;
+	}
+} // namespace impl
+
+// static
+std::shared_ptr<codec_transform> codec_transform::compressor(algorithm algo, compress_options options, std::error_code& ec) {
+	std::unique_ptr<impl::codec> codec = impl::make_compressor(algo, options.level, ec);
+	if (!codec) return nullptr;
+	std::shared_ptr<codec_transform> self =
+		std::make_shared<codec_transform>(private_tag, std::move(codec), true, options.flush_bytes, options.output_buffer_size);
+	self->set_origin(self);
+	return self;
+}
+
+// static
+std::shared_ptr<codec_transform> codec_transform::decompressor(algorithm algo, decompress_options options, std::error_code& ec) {
+	std::unique_ptr<impl::codec> codec = impl::make_decompressor(algo, ec);
+	if (!codec) return nullptr;
+	std::shared_ptr<codec_transform> self = std::make_shared<codec_transform>(private_tag, std::move(codec), false, 0, options.output_buffer_size);
+	self->set_origin(self);
+	return self;
+}
+
+codec_transform::codec_transform(private_tag_t, std::unique_ptr<impl::codec> codec, bool compress, std::size_t flush_bytes, std::size_t output_buffer_size)
+: m_codec(std::move(codec)), m_compress(compress), m_flush_bytes(flush_bytes), m_pool(std::max<std::size_t>(output_buffer_size, 1024)) {}
+
+void codec_transform::flush() {
+	if (!m_compress || m_done) return;
+	m_flush_requested = true;
+	m_flush_at = m_received;
+	process();
+}
+
+void codec_transform::on_new_origin(std::shared_ptr<streams::origin> const&) {
+	// the transform stays the origin for the following stages
+}
+
+void codec_transform::on_pause() {
+	sink_t::pause();
+}
+
+void codec_transform::on_resume() {
+	process();
+	if (!origin::is_paused()) sink_t::resume();
+}
+
+void codec_transform::on_connected_sink() {
+	process();
+	if (!origin::is_paused()) sink_t::resume();
+}
+
+void codec_transform::on_receive(streams::chunk_queue&& chunks) {
+	if (m_done) return;
+	m_received += chunks.bytes().get();
+	m_input.append(std::move(chunks));
+	process();
+}
+
+void codec_transform::on_end(streams::StreamEnd end) {
+	if (m_done) return;
+	if (streams::StreamEnd::Aborted == end) {
+		m_done = true;
+		m_input.clear();
+		send_output();
+		source_t::send_end(end);
+		return;
+	}
+	m_end_pending = true;
+	process();
+}
+
+void codec_transform::process() {
+	if (m_processing || m_done) return;
+	m_processing = true;
+	while (!m_done && !origin::is_paused()) {
+		if (impl::codec_op::run != m_pending_op) {
+			if (!finish_op()) break;
+			continue;
+		}
+		if (m_compress) {
+			if (m_flush_requested && m_consumed >= m_flush_at) {
+				m_flush_requested = false;
+				m_pending_op = impl::codec_op::flush;
+				continue;
+			}
+			if (m_flush_bytes > 0 && m_consumed - m_last_flush >= m_flush_bytes) {
+				m_pending_op = impl::codec_op::flush;
+				continue;
+			}
+		}
+		if (streams::file_size{0} == m_input.bytes()) {
+			// only empty chunks left (if any)
+			m_input.clear();
+			if (!m_end_pending) break;
+			if (m_compress) {
+				m_pending_op = impl::codec_op::finish;
+			} else if (m_codec->at_stream_boundary()) {
+				end_stream();
+			} else {
+				// compressed data ended in the middle of a stream
+				fail(std::make_error_code(std::errc::no_message_available));
+			}
+			continue;
+		}
+		if (!feed()) break;
+	}
+	m_processing = false;
+	if (!m_done) send_output();
+}
+
+bool codec_transform::feed() {
+	// remove() drops leading empty chunks only together with following data: skip them here
+	for (streams::chunk const& c : m_input.queue()) {
+		caney::optional<boost::asio::const_buffer> const buf = c.get_const_buffer();
+		if (!buf) std::terminate(); // only memory chunks supported
+		std::size_t size = buf->size();
+		if (0 == size) continue;
+
+		if (m_compress) {
+			// stop at flush points
+			if (m_flush_requested) size = std::min<std::uint64_t>(size, m_flush_at - m_consumed);
+			if (m_flush_bytes > 0) size = std::min<std::uint64_t>(size, m_last_flush + m_flush_bytes - m_consumed);
+		}
+
+		std::size_t consumed = 0;
+		bool const complete = run(impl::codec_op::run, static_cast<unsigned char const*>(buf->data()), size, consumed);
+		m_consumed += consumed;
+		if (!m_done) m_input.remove(streams::file_size{consumed});
+		return complete;
+	}
+	std::terminate(); // process() only calls feed() with non-empty input
+}
+
+bool codec_transform::finish_op() {
+	impl::codec_op const op = m_pending_op;
+	std::size_t consumed = 0;
+	if (!run(op, nullptr, 0, consumed)) return false;
+	m_pending_op = impl::codec_op::run;
+	m_last_flush = m_consumed;
+	if (impl::codec_op::finish == op) {
+		end_stream();
+	} else {
+		send_output();
+	}
+	return true;
+}
+
+bool codec_transform::run(impl::codec_op op, unsigned char const* data, std::size_t size, std::size_t& consumed) {
+	consumed = 0;
+	for (;;) {
+		if (m_out_buffer.size() < m_pool.size() / 4) m_out_buffer = memory::unique_buf::allocate(m_pool);
+		std::size_t const out_size = m_out_buffer.size();
+
+		std::error_code ec;
+		impl::codec_result const result = m_codec->step(data + consumed, size - consumed, m_out_buffer.data(), out_size, op, ec);
+		consumed += result.consumed;
+		if (ec) {
+			fail(ec);
+			return false;
+		}
+		if (result.produced > 0) emit(result.produced);
+
+		bool const input_done = (consumed == size);
+		// a full output buffer might leave more output pending in the codec: keep going
+		bool const output_full = (result.produced == out_size);
+		if (input_done && !output_full && (impl::codec_op::run == op || result.done)) return true;
+		if (0 == result.consumed && 0 == result.produced) {
+			// codec needs more input
+			if (input_done && impl::codec_op::run == op) return true;
+			// neither room in the output buffer nor any input was the problem: codec is stuck
+			fail(std::make_error_code(m_compress ? std::errc::io_error : std::errc::bad_message));
+			return false;
+		}
+		if (m_done || origin::is_paused()) return false;
+	}
+}
+
+void codec_transform::emit(std::size_t produced) {
+	m_produced += produced;
+	m_output.append(streams::chunk(m_out_buffer.freeze(produced)));
+	if (m_output.bytes() >= streams::file_size{m_pool.size()}) send_output();
+}
+
+void codec_transform::send_output() {
+	if (m_output.empty()) return;
+	streams::chunk_queue output = std::move(m_output);
+	m_output.clear();
+	source_t::send(std::move(output));
+}
+
+void codec_transform::end_stream() {
+	m_done = true;
+	send_output();
+	source_t::send_end(streams::StreamEnd::EndOfStream);
+}
+
+void codec_transform::fail(std::error_code ec) {
+	m_error = ec;
+	m_done = true;
+	m_input.clear();
+	// pass on what was decoded before the error
+	send_output();
+	source_t::send_end(streams::StreamEnd::Aborted);
+	sink_t::disconnect();
+}
+
+__CANEY_COMPRESSV1_END
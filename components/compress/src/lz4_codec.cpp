@@ -0,0 +1,159 @@
+#include "caney/compress/codec.hpp"
+
+#if CANEY_COMPRESS_HAVE_LZ4
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <lz4frame.h>
+
+__CANEY_COMPRESSV1_BEGIN
+
+namespace impl {
+	namespace {
+		// input passed to a single LZ4F_compressUpdate call
+		constexpr std::size_t lz4_block_input = 64 * 1024;
+
+		class lz4_compressor final : public codec {
+		public:
+			explicit lz4_compressor() = default;
+
+			~lz4_compressor() override {
+				if (m_ctx) ::LZ4F_freeCompressionContext(m_ctx);
+			}
+
+			void init(int level, std::error_code& ec) {
+				if (::LZ4F_isError(::LZ4F_createCompressionContext(&m_ctx, LZ4F_VERSION))) {
+					m_ctx = nullptr;
+					ec = std::make_error_code(std::errc::not_enough_memory);
+					return;
+				}
+				m_prefs.compressionLevel = level;
+				// LZ4F output functions need a destination of (at least) the worst case size
+				m_staging.resize(std::max<std::size_t>(::LZ4F_compressBound(lz4_block_input, &m_prefs), LZ4F_HEADER_SIZE_MAX));
+			}
+
+			codec_result step(unsigned char const* in, std::size_t in_size, unsigned char* out, std::size_t out_size, codec_op op, std::error_code& ec) override {
+				codec_result result;
+				for (;;) {
+					// copy staged output
+					std::size_t const n = std::min(m_staged_end - m_staged_pos, out_size - result.produced);
+					std::memcpy(out + result.produced, m_staging.data() + m_staged_pos, n);
+					m_staged_pos += n;
+					result.produced += n;
+					if (m_staged_pos < m_staged_end) return result; // output full
+
+					if (m_op_staged) {
+						m_op_staged = false;
+						result.done = true;
+						return result;
+					}
+					if (!m_started) {
+						if (!stage(::LZ4F_compressBegin(m_ctx, m_staging.data(), m_staging.size(), &m_prefs), ec)) return result;
+						m_started = true;
+						continue;
+					}
+					if (result.consumed < in_size) {
+						std::size_t const chunk = std::min(in_size - result.consumed, lz4_block_input);
+						if (!stage(::LZ4F_compressUpdate(m_ctx, m_staging.data(), m_staging.size(), in + result.consumed, chunk, nullptr), ec)) return result;
+						result.consumed += chunk;
+						continue;
+					}
+					if (codec_op::run == op) return result;
+					if (codec_op::flush == op) {
+						if (!stage(::LZ4F_flush(m_ctx, m_staging.data(), m_staging.size(), nullptr), ec)) return result;
+					} else {
+						if (!stage(::LZ4F_compressEnd(m_ctx, m_staging.data(), m_staging.size(), nullptr), ec)) return result;
+						// next input starts a new frame
+						m_started = false;
+					}
+					m_op_staged = true;
+				}
+			}
+
+		private:
+			bool stage(std::size_t rc, std::error_code& ec) {
+				if (::LZ4F_isError(rc)) {
+					ec = std::make_error_code(std::errc::io_error);
+					return false;
+				}
+				m_staged_pos = 0;
+				m_staged_end = rc;
+				return true;
+			}
+
+			LZ4F_cctx* m_ctx{nullptr};
+			LZ4F_preferences_t m_prefs{};
+			std::vector<unsigned char> m_staging;
+			std::size_t m_staged_pos{0};
+			std::size_t m_staged_end{0};
+			bool m_started{false};
+			bool m_op_staged{false}; // flush / end was staged
+		};
+
+		class lz4_decompressor final : public codec {
+		public:
+			explicit lz4_decompressor() = default;
+
+			~lz4_decompressor() override {
+				if (m_ctx) ::LZ4F_freeDecompressionContext(m_ctx);
+			}
+
+			void init(std::error_code& ec) {
+				if (::LZ4F_isError(::LZ4F_createDecompressionContext(&m_ctx, LZ4F_VERSION))) {
+					m_ctx = nullptr;
+					ec = std::make_error_code(std::errc::not_enough_memory);
+				}
+			}
+
+			codec_result step(unsigned char const* in, std::size_t in_size, unsigned char* out, std::size_t out_size, codec_op, std::error_code& ec) override {
+				std::size_t src_size = in_size;
+				std::size_t dst_size = out_size;
+				// returns 0 when a frame was completely decoded; the context is ready for the next frame then
+				std::size_t const rc = ::LZ4F_decompress(m_ctx, out, &dst_size, in, &src_size, nullptr);
+
+				codec_result result;
+				result.consumed = src_size;
+				result.produced = dst_size;
+				if (::LZ4F_isError(rc)) {
+					ec = std::make_error_code(std::errc::bad_message);
+				} else if (0 == rc) {
+					result.done = true;
+					m_in_stream = false;
+				} else if (result.consumed > 0) {
+					m_in_stream = true;
+				}
+				return result;
+			}
+
+			bool at_stream_boundary() const override {
+				return !m_in_stream;
+			}
+
+		private:
+			LZ4F_dctx* m_ctx{nullptr};
+			bool m_in_stream{false};
+		};
+	} // anonymous namespace
+
+	std::unique_ptr<codec> make_lz4_compressor(int level, std::error_code& ec) {
+		ec.clear();
+		std::unique_ptr<lz4_compressor> c(new lz4_compressor());
+		c->init(level, ec);
+		if (ec) return nullptr;
+		return std::unique_ptr<codec>(std::move(c));
+	}
+
+	std::unique_ptr<codec> make_lz4_decompressor(std::error_code& ec) {
+		ec.clear();
+		std::unique_ptr<lz4_decompressor> c(new lz4_decompressor());
+		c->init(ec);
+		if (ec) return nullptr;
+		return std::unique_ptr<codec>(std::move(c));
+	}
+} // namespace impl
+
+__CANEY_COMPRESSV1_END
+
+#endif /* CANEY_COMPRESS_HAVE_LZ4 */
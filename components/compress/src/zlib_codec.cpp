@@ -0,0 +1,161 @@
+#include "caney/compress/codec.hpp"
+
+#if CANEY_COMPRESS_HAVE_ZLIB
+
+#include <zlib.h>
+
+__CANEY_COMPRESSV1_BEGIN
+
+namespace impl {
+	namespace {
+		// windowBits: +16 selects the gzip wrapper
+		int window_bits(bool gzip) {
+			return gzip ? 15 + 16 : 15;
+		}
+
+		std::error_code zlib_error(int rc) {
+			switch (rc) {
+			case Z_MEM_ERROR:
+				return std::make_error_code(std::errc::not_enough_memory);
+			case Z_NEED_DICT:
+			case Z_DATA_ERROR:
+				return std::make_error_code(std::errc::bad_message);
+			default:
+				return std::make_error_code(std::errc::io_error);
+			}
+		}
+
+		class zlib_compressor final : public codec {
+		public:
+			explicit zlib_compressor() = default;
+
+			~zlib_compressor() override {
+				if (m_initialized) ::deflateEnd(&m_stream);
+			}
+
+			void init(bool gzip, int level, std::error_code& ec) {
+				int const rc = ::deflateInit2(&m_stream, 0 == level ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED, window_bits(gzip), 8, Z_DEFAULT_STRATEGY);
+				if (Z_OK != rc) {
+					ec = (Z_STREAM_ERROR == rc) ? std::make_error_code(std::errc::invalid_argument) : zlib_error(rc);
+					return;
+				}
+				m_initialized = true;
+			}
+
+			codec_result step(unsigned char const* in, std::size_t in_size, unsigned char* out, std::size_t out_size, codec_op op, std::error_code& ec) override {
+				m_stream.next_in = const_cast<Bytef*>(in);
+				m_stream.avail_in = static_cast<uInt>(in_size);
+				m_stream.next_out = out;
+				m_stream.avail_out = static_cast<uInt>(out_size);
+
+				int const flush = (codec_op::run == op) ? Z_NO_FLUSH : (codec_op::flush == op) ? Z_SYNC_FLUSH : Z_FINISH;
+				int const rc = ::deflate(&m_stream, flush);
+
+				codec_result result;
+				result.consumed = in_size - m_stream.avail_in;
+				result.produced = out_size - m_stream.avail_out;
+				switch (rc) {
+				case Z_OK:
+					// flush is complete once deflate doesn't fill the output buffer anymore
+					result.done = (codec_op::flush == op) && 0 == m_stream.avail_in && 0 != m_stream.avail_out;
+					break;
+				case Z_BUF_ERROR:
+					// no progress possible: nothing left to flush
+					result.done = (codec_op::run != op) && 0 == m_stream.avail_in;
+					break;
+				case Z_STREAM_END:
+					result.done = true;
+					// next input starts a new stream
+					::deflateReset(&m_stream);
+					break;
+				default:
+					ec = zlib_error(rc);
+					break;
+				}
+				return result;
+			}
+
+		private:
+			z_stream m_stream{};
+			bool m_initialized{false};
+		};
+
+		class zlib_decompressor final : public codec {
+		public:
+			explicit zlib_decompressor() = default;
+
+			~zlib_decompressor() override {
+				if (m_initialized) ::inflateEnd(&m_stream);
+			}
+
+			void init(bool gzip, std::error_code& ec) {
+				int const rc = ::inflateInit2(&m_stream, window_bits(gzip));
+				if (Z_OK != rc) {
+					ec = zlib_error(rc);
+					return;
+				}
+				m_initialized = true;
+			}
+
+			codec_result step(unsigned char const* in, std::size_t in_size, unsigned char* out, std::size_t out_size, codec_op, std::error_code& ec) override {
+				m_stream.next_in = const_cast<Bytef*>(in);
+				m_stream.avail_in = static_cast<uInt>(in_size);
+				m_stream.next_out = out;
+				m_stream.avail_out = static_cast<uInt>(out_size);
+
+				int const rc = ::inflate(&m_stream, Z_NO_FLUSH);
+
+				codec_result result;
+				result.consumed = in_size - m_stream.avail_in;
+				result.produced = out_size - m_stream.avail_out;
+				switch (rc) {
+				case Z_OK:
+					if (result.consumed > 0) m_in_stream = true;
+					break;
+				case Z_BUF_ERROR:
+					// no progress possible
+					break;
+				case Z_STREAM_END:
+					result.done = true;
+					m_in_stream = false;
+					// accept concatenated streams
+					::inflateReset(&m_stream);
+					break;
+				default:
+					ec = zlib_error(rc);
+					break;
+				}
+				return result;
+			}
+
+			bool at_stream_boundary() const override {
+				return !m_in_stream;
+			}
+
+		private:
+			z_stream m_stream{};
+			bool m_initialized{false};
+			bool m_in_stream{false};
+		};
+	} // anonymous namespace
+
+	std::unique_ptr<codec> make_zlib_compressor(bool gzip, int level, std::error_code& ec) {
+		ec.clear();
+		std::unique_ptr<zlib_compressor> c(new zlib_compressor());
+		c->init(gzip, level, ec);
+		if (ec) return nullptr;
+		return std::unique_ptr<codec>(std::move(c));
+	}
+
+	std::unique_ptr<codec> make_zlib_decompressor(bool gzip, std::error_code& ec) {
+		ec.clear();
+		std::unique_ptr<zlib_decompressor> c(new zlib_decompressor());
+		c->init(gzip, ec);
+		if (ec) return nullptr;
+		return std::unique_ptr<codec>(std::move(c));
+	}
+} // namespace impl
+
+__CANEY_COMPRESSV1_END
+
+#endif /* CANEY_COMPRESS_HAVE_ZLIB */
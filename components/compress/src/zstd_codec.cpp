@@ -0,0 +1,112 @@
+#include "caney/compress/codec.hpp"
+
+#if CANEY_COMPRESS_HAVE_ZSTD
+
+#include <zstd.h>
+
+__CANEY_COMPRESSV1_BEGIN
+
+namespace impl {
+	namespace {
+		class zstd_compressor final : public codec {
+		public:
+			explicit zstd_compressor() : m_ctx(::ZSTD_createCCtx()) {}
+
+			~zstd_compressor() override {
+				::ZSTD_freeCCtx(m_ctx);
+			}
+
+			void init(int level, std::error_code& ec) {
+				if (!m_ctx) {
+					ec = std::make_error_code(std::errc::not_enough_memory);
+					return;
+				}
+				if (0 != level && ::ZSTD_isError(::ZSTD_CCtx_setParameter(m_ctx, ZSTD_c_compressionLevel, level))) {
+					ec = std::make_error_code(std::errc::invalid_argument);
+				}
+			}
+
+			codec_result step(unsigned char const* in, std::size_t in_size, unsigned char* out, std::size_t out_size, codec_op op, std::error_code& ec) override {
+				ZSTD_inBuffer input{in, in_size, 0};
+				ZSTD_outBuffer output{out, out_size, 0};
+				ZSTD_EndDirective const mode = (codec_op::run == op) ? ZSTD_e_continue : (codec_op::flush == op) ? ZSTD_e_flush : ZSTD_e_end;
+				// returns the number of bytes still to flush for ZSTD_e_flush / ZSTD_e_end; ZSTD_e_end starts a new frame afterwards
+				std::size_t const rc = ::ZSTD_compressStream2(m_ctx, &output, &input, mode);
+
+				codec_result result;
+				result.consumed = input.pos;
+				result.produced = output.pos;
+				if (::ZSTD_isError(rc)) {
+					ec = std::make_error_code(std::errc::io_error);
+				} else {
+					result.done = (codec_op::run != op) && 0 == rc;
+				}
+				return result;
+			}
+
+		private:
+			ZSTD_CCtx* m_ctx;
+		};
+
+		class zstd_decompressor final : public codec {
+		public:
+			explicit zstd_decompressor() : m_ctx(::ZSTD_createDCtx()) {}
+
+			~zstd_decompressor() override {
+				::ZSTD_freeDCtx(m_ctx);
+			}
+
+			void init(std::error_code& ec) {
+				if (!m_ctx) ec = std::make_error_code(std::errc::not_enough_memory);
+			}
+
+			codec_result step(unsigned char const* in, std::size_t in_size, unsigned char* out, std::size_t out_size, codec_op, std::error_code& ec) override {
+				ZSTD_inBuffer input{in, in_size, 0};
+				ZSTD_outBuffer output{out, out_size, 0};
+				// returns 0 when a frame was completely decoded and flushed
+				std::size_t const rc = ::ZSTD_decompressStream(m_ctx, &output, &input);
+
+				codec_result result;
+				result.consumed = input.pos;
+				result.produced = output.pos;
+				if (::ZSTD_isError(rc)) {
+					ec = std::make_error_code(std::errc::bad_message);
+				} else if (0 == rc) {
+					result.done = true;
+					m_in_stream = false;
+				} else if (result.consumed > 0) {
+					m_in_stream = true;
+				}
+				return result;
+			}
+
+			bool at_stream_boundary() const override {
+				return !m_in_stream;
+			}
+
+		private:
+			ZSTD_DCtx* m_ctx;
+			bool m_in_stream{false};
+		};
+	} // anonymous namespace
+
+	std::unique_ptr<codec> make_zstd_compressor(int level, std::error_code& ec) {
+		ec.clear();
+		std::unique_ptr<zstd_compressor> c(new zstd_compressor());
+		c->init(level, ec);
+		if (ec) return nullptr;
+		return std::unique_ptr<codec>(std::move(c));
+	}
+
+	std::unique_ptr<codec> make_zstd_decompressor(std::error_code& ec) {
+		ec.clear();
+		std::unique_ptr<zstd_decompressor> c(new zstd_decompressor());
+		c->init(ec);
+		if (ec) return nullptr;
+		return std::unique_ptr<codec>(std::move(c));
+	}
+} // namespace impl
+
+__CANEY_COMPRESSV1_END
+
+#endif /* CANEY_COMPRESS_HAVE_ZSTD */
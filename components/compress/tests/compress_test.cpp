@@ -0,0 +1,260 @@
+#include "caney/compress/codec.hpp"
+
+#include "streams/tests/test_helpers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+namespace {
+	using test_helpers::collect_sink;
+	using test_helpers::test_source;
+
+	std::string test_data(std::size_t size) {
+		std::string data;
+		data.reserve(size + 16);
+		std::uint32_t x = 0x12345678;
+		while (data.size() < size) {
+			x = x * 1103515245 + 12345;
+			// random words from a limited set: compressible (also without entropy coding), but not trivially
+			std::uint32_t word = (x >> 20) % 256;
+			std::size_t const length = 3 + word % 8;
+			for (std::size_t i = 0; i < length; ++i, word = word * 7 + 3) data.push_back(static_cast<char>('a' + word % 16));
+			data.push_back(' ');
+		}
+		data.resize(size);
+		return data;
+	}
+
+	// compress data in one go
+	std::string compress(caney::compress::algorithm algo, std::string const& data) {
+		std::error_code ec;
+		auto compressor = caney::compress::codec_transform::compressor(algo, caney::compress::compress_options(), ec);
+		BOOST_REQUIRE(!ec);
+		auto source = std::make_shared<test_source>();
+		auto sink = std::make_shared<collect_sink>();
+		caney::streams::connect(source, compressor);
+		caney::streams::connect(compressor, sink);
+		source->push(data);
+		source->end();
+		BOOST_REQUIRE(sink->ended);
+		return sink->data;
+	}
+
+	caney::compress::algorithm const all_algorithms[] = {
+		caney::compress::algorithm::zlib,
+		caney::compress::algorithm::gzip,
+		caney::compress::algorithm::zstd,
+		caney::compress::algorithm::lz4,
+	};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(compress_test)
+
+BOOST_AUTO_TEST_CASE(supported_algorithms) {
+	// backends found at configure time must be used: the other tests skip unsupported algorithms
+#if CANEY_COMPRESS_HAVE_ZLIB
+	BOOST_CHECK(caney::compress::is_supported(caney::compress::algorithm::zlib));
+	BOOST_CHECK(caney::compress::is_supported(caney::compress::algorithm::gzip));
+#endif
+#if CANEY_COMPRESS_HAVE_ZSTD
+	BOOST_CHECK(caney::compress::is_supported(caney::compress::algorithm::zstd));
+#else
+	BOOST_CHECK(!caney::compress::is_supported(caney::compress::algorithm::zstd));
+#endif
+#if CANEY_COMPRESS_HAVE_LZ4
+	BOOST_CHECK(caney::compress::is_supported(caney::compress::algorithm::lz4));
+#else
+	BOOST_CHECK(!caney::compress::is_supported(caney::compress::algorithm::lz4));
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(roundtrip) {
+	std::string const data = test_data(300000);
+	for (auto algo : all_algorithms) {
+		std::error_code ec;
+		if (!caney::compress::is_supported(algo)) {
+			BOOST_CHECK(!caney::compress::codec_transform::decompressor(algo, caney::compress::decompress_options(), ec));
+			BOOST_CHECK(ec == std::errc::function_not_supported);
+			continue;
+		}
+
+		caney::compress::compress_options options;
+		options.flush_bytes = 50000;
+		options.output_buffer_size = 4096;
+		auto compressor = caney::compress::codec_transform::compressor(algo, options, ec);
+		BOOST_REQUIRE(!ec);
+		auto decompressor = caney::compress::codec_transform::decompressor(algo, caney::compress::decompress_options(), ec);
+		BOOST_REQUIRE(!ec);
+		auto source = std::make_shared<test_source>();
+		auto sink = std::make_shared<collect_sink>();
+		caney::streams::connect(source, compressor);
+		caney::streams::connect(compressor, decompressor);
+		caney::streams::connect(decompressor, sink);
+
+		source->push(std::string());
+		for (std::size_t pos = 0; pos < data.size(); pos += 77777) source->push(data.substr(pos, 77777));
+		source->push(std::string());
+		source->end();
+
+		BOOST_CHECK(sink->ended);
+		BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == sink->end);
+		BOOST_CHECK(sink->data == data);
+		BOOST_CHECK_EQUAL(compressor->bytes_in(), data.size());
+		BOOST_CHECK_LT(compressor->bytes_out(), data.size());
+		BOOST_CHECK_EQUAL(decompressor->bytes_in(), compressor->bytes_out());
+		BOOST_CHECK_EQUAL(decompressor->bytes_out(), data.size());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(small_output_buffers) {
+	// output of single codec steps spans many buffers; codecs keep the rest buffered
+	std::string data = test_data(200000);
+	std::uint32_t x = 0x9abcdef0;
+	for (std::size_t i = 0; i < 100000; ++i) {
+		x = x * 1103515245 + 12345;
+		data.push_back(static_cast<char>(x >> 24));
+	}
+	std::size_t const half = data.size() / 2;
+	for (auto algo : all_algorithms) {
+		if (!caney::compress::is_supported(algo)) continue;
+		BOOST_TEST_CONTEXT("algorithm " << static_cast<int>(algo)) {
+			std::error_code ec;
+			caney::compress::compress_options options;
+			options.output_buffer_size = 1024;
+			auto compressor = caney::compress::codec_transform::compressor(algo, options, ec);
+			BOOST_REQUIRE(!ec);
+			auto source = std::make_shared<test_source>();
+			auto compressed = std::make_shared<collect_sink>();
+			caney::streams::connect(source, compressor);
+			caney::streams::connect(compressor, compressed);
+			source->push(data.substr(0, half));
+			compressor->flush();
+			std::size_t const flushed = compressed->data.size();
+			source->push(data.substr(half));
+			source->end();
+			BOOST_CHECK(compressed->ended);
+			BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == compressed->end);
+			BOOST_CHECK_GT(flushed, 1024u);
+
+			caney::compress::decompress_options doptions;
+			doptions.output_buffer_size = 1024;
+			auto decompressor = caney::compress::codec_transform::decompressor(algo, doptions, ec);
+			BOOST_REQUIRE(!ec);
+			auto input = std::make_shared<test_source>();
+			auto sink = std::make_shared<collect_sink>();
+			caney::streams::connect(input, decompressor);
+			caney::streams::connect(decompressor, sink);
+			// all input up to the flush point consumed: everything before it must come out
+			input->push(compressed->data.substr(0, flushed));
+			BOOST_CHECK(sink->data == data.substr(0, half));
+			input->push(compressed->data.substr(flushed));
+			input->end();
+			BOOST_CHECK(sink->ended);
+			BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == sink->end);
+			BOOST_CHECK(sink->data == data);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(flush) {
+	for (auto algo : all_algorithms) {
+		if (!caney::compress::is_supported(algo)) continue;
+		std::error_code ec;
+		auto compressor = caney::compress::codec_transform::compressor(algo, caney::compress::compress_options(), ec);
+		auto decompressor = caney::compress::codec_transform::decompressor(algo, caney::compress::decompress_options(), ec);
+		auto source = std::make_shared<test_source>();
+		auto sink = std::make_shared<collect_sink>();
+		caney::streams::connect(source, compressor);
+		caney::streams::connect(compressor, decompressor);
+		caney::streams::connect(decompressor, sink);
+
+		source->push("hello ");
+		BOOST_CHECK(sink->data.empty());
+		compressor->flush();
+		BOOST_CHECK_EQUAL(sink->data, "hello ");
+		source->push("world");
+		compressor->flush();
+		BOOST_CHECK_EQUAL(sink->data, "hello world");
+		BOOST_CHECK(!sink->ended);
+		source->end();
+		BOOST_CHECK(sink->ended);
+		BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == sink->end);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(backpressure) {
+	for (auto algo : all_algorithms) {
+		if (!caney::compress::is_supported(algo)) continue;
+		std::string const data(4 * 1024 * 1024, 'x');
+		std::string const compressed = compress(algo, data);
+
+		std::error_code ec;
+		caney::compress::decompress_options options;
+		options.output_buffer_size = 16 * 1024;
+		auto decompressor = caney::compress::codec_transform::decompressor(algo, options, ec);
+		auto source = std::make_shared<test_source>();
+		auto sink = std::make_shared<collect_sink>();
+		caney::streams::connect(source, decompressor);
+		caney::streams::connect(decompressor, sink);
+		sink->hold();
+
+		source->push(compressed);
+		source->end();
+		// paused sink stops decompression
+		BOOST_CHECK_EQUAL(sink->batches.size(), 1u);
+		BOOST_CHECK_LE(decompressor->bytes_out(), 2 * options.output_buffer_size);
+		BOOST_CHECK(!sink->ended);
+
+		std::size_t rounds = 0;
+		while (!sink->ended && rounds < 1000) {
+			++rounds;
+			std::size_t const before = sink->data.size();
+			sink->next();
+			BOOST_REQUIRE(sink->data.size() > before || sink->ended);
+		}
+		BOOST_CHECK_GT(rounds, 10u);
+		BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == sink->end);
+		BOOST_CHECK(sink->data == data);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(corrupt_input) {
+	for (auto algo : all_algorithms) {
+		if (!caney::compress::is_supported(algo)) continue;
+		std::string const compressed = compress(algo, test_data(10000));
+
+		{
+			std::error_code ec;
+			auto decompressor = caney::compress::codec_transform::decompressor(algo, caney::compress::decompress_options(), ec);
+			auto source = std::make_shared<test_source>();
+			auto sink = std::make_shared<collect_sink>();
+			caney::streams::connect(source, decompressor);
+			caney::streams::connect(decompressor, sink);
+			std::string broken = compressed;
+			for (std::size_t i = 0; i < 64; ++i) broken[i] = static_cast<char>(0xff - i);
+			source->push(broken);
+			BOOST_CHECK(sink->ended);
+			BOOST_CHECK(caney::streams::StreamEnd::Aborted == sink->end);
+			BOOST_CHECK(decompressor->error() == std::errc::bad_message);
+			BOOST_CHECK(!decompressor->get_source());
+		}
+
+		{
+			// truncated stream
+			std::error_code ec;
+			auto decompressor = caney::compress::codec_transform::decompressor(algo, caney::compress::decompress_options(), ec);
+			auto source = std::make_shared<test_source>();
+			auto sink = std::make_shared<collect_sink>();
+			caney::streams::connect(source, decompressor);
+			caney::streams::connect(decompressor, sink);
+			source->push(compressed.substr(0, compressed.size() / 2));
+			source->end();
+			BOOST_CHECK(sink->ended);
+			BOOST_CHECK(caney::streams::StreamEnd::Aborted == sink->end);
+			BOOST_CHECK(decompressor->error() == std::errc::no_message_available);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,53 @@
+/* throughput of the checksum kernels in GB/s
+ *
+ * usage: caney-bench-digest-checksum_bench [total megabytes per run, default 256]
+ */
+
+#include "caney/digest/checksum.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+	char const* implementation_name(caney::digest::checksum_implementation impl) {
+		switch (impl) {
+		case caney::digest::checksum_implementation::automatic:
+			return "automatic";
+		case caney::digest::checksum_implementation::scalar:
+			return "scalar";
+		case caney::digest::checksum_implementation::hardware:
+			return "hardware";
+		}
+		return "unknown";
+	}
+
+	template <typename Checksum>
+	void run(char const* name, std::vector<unsigned char> const& data, std::size_t total) {
+		std::size_t const sizes[] = {64, 1024, 16384, 1024 * 1024};
+		for (auto impl : {caney::digest::checksum_implementation::scalar, caney::digest::checksum_implementation::hardware}) {
+			if (!Checksum::is_available(impl)) continue;
+			for (std::size_t size : sizes) {
+				std::size_t const rounds = total / size;
+				Checksum c(impl);
+				auto const start = std::chrono::steady_clock::now();
+				for (std::size_t i = 0; i < rounds; ++i) c.update(data.data(), size);
+				auto const end = std::chrono::steady_clock::now();
+				double const seconds = std::chrono::duration<double>(end - start).count();
+				double const gbps = static_cast<double>(rounds * size) / seconds / 1e9;
+				std::printf("%-8s %-9s %8zu bytes/update: %6.2f GB/s (checksum %08x)\n", name, implementation_name(impl), size, gbps, c.value());
+			}
+		}
+	}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+	std::size_t const total = std::size_t{1024 * 1024} * static_cast<std::size_t>(argc > 1 ? std::atoi(argv[1]) : 256);
+	std::vector<unsigned char> data(1024 * 1024);
+	for (std::size_t i = 0; i < data.size(); ++i) data[i] = static_cast<unsigned char>(i * 7 + (i >> 8));
+
+	run<caney::digest::crc32c>("crc32c", data, total);
+	run<caney::digest::adler32>("adler32", data, total);
+	return 0;
+}
@@ -0,0 +1,130 @@
+/** @file */
+
+#pragma once
+
+#include "caney/memory/buffer.hpp"
+#include "caney/streams/chunks.hpp"
+
+#include "internal.hpp"
+
+#include <cstdint>
+
+__CANEY_DIGESTV1_BEGIN
+
+/**
+ * @brief selects the code path used to compute checksums
+ */
+enum class checksum_implementation {
+	automatic, //!< best implementation available on the current CPU
+	scalar, //!< portable C++ implementation
+	hardware, //!< CPU specific: SSE 4.2 `crc32` + `pclmulqdq` for @ref crc32c, SSSE3 for @ref adler32
+};
+
+namespace impl {
+	using crc32c_fn = std::uint32_t (*)(std::uint32_t crc, unsigned char const* data, std::size_t size);
+	using adler32_fn = std::uint32_t (*)(std::uint32_t adler, unsigned char const* data, std::size_t size);
+
+	// raw kernels; crc32c kernels work on the register value (no pre- and post-inversion)
+	std::uint32_t crc32c_scalar(std::uint32_t crc, unsigned char const* data, std::size_t size);
+	std::uint32_t crc32c_hardware(std::uint32_t crc, unsigned char const* data, std::size_t size);
+	std::uint32_t adler32_scalar(std::uint32_t adler, unsigned char const* data, std::size_t size);
+	std::uint32_t adler32_hardware(std::uint32_t adler, unsigned char const* data, std::size_t size);
+} // namespace impl
+
+/**
+ * @brief CRC-32C (Castagnoli polynomial, as used by iSCSI, SCTP, ext4, ...)
+ *
+ * Computed incrementally: data can be passed in arbitrary pieces.
+ */
+class crc32c {
+public:
+	/** @brief start new checksum computation */
+	explicit crc32c(checksum_implementation impl = checksum_implementation::automatic);
+
+	/** @brief whether the given implementation can be used on the current CPU */
+	static bool is_available(checksum_implementation impl);
+
+	/** @brief checksum more data */
+	void update(unsigned char const* data, std::size_t size) {
+		m_crc = m_kernel(m_crc, data, size);
+	}
+
+	/** @brief checksum more data */
+	void update(memory::byte_view buf) {
+		update(buf.data(), buf.size());
+	}
+
+	/**
+	 * @brief checksum all data in a @ref streams::chunk_queue
+	 *
+	 * only memory chunks are supported; terminates on other chunk types.
+	 */
+	void update(streams::chunk_queue const& queue);
+
+	/** @brief checksum of the data passed so far */
+	std::uint32_t value() const {
+		return ~m_crc;
+	}
+
+	/** @brief start new checksum computation */
+	void reset() {
+		m_crc = ~std::uint32_t{0};
+	}
+
+	/** @brief checksum a single buffer */
+	static std::uint32_t checksum(memory::byte_view buf);
+
+private:
+	impl::crc32c_fn m_kernel;
+	std::uint32_t m_crc{~std::uint32_t{0}};
+};
+
+/**
+ * @brief Adler-32 (as used by zlib)
+ *
+ * Computed incrementally: data can be passed in arbitrary pieces.
+ */
+class adler32 {
+public:
+	/** @brief start new checksum computation */
+	explicit adler32(checksum_implementation impl = checksum_implementation::automatic);
+
+	/** @brief whether the given implementation can be used on the current CPU */
+	static bool is_available(checksum_implementation impl);
+
+	/** @brief checksum more data */
+	void update(unsigned char const* data, std::size_t size) {
+		m_adler = m_kernel(m_adler, data, size);
+	}
+
+	/** @brief checksum more data */
+	void update(memory::byte_view buf) {
+		update(buf.data(), buf.size());
+	}
+
+	/**
+	 * @brief checksum all data in a @ref streams::chunk_queue
+	 *
+	 * only memory chunks are supported; terminates on other chunk types.
+	 */
+	void update(streams::chunk_queue const& queue);
+
+	/** @brief checksum of the data passed so far */
+	std::uint32_t value() const {
+		return m_adler;
+	}
+
+	/** @brief start new checksum computation */
+	void reset() {
+		m_adler = 1;
+	}
+
+	/** @brief checksum a single buffer */
+	static std::uint32_t checksum(memory::byte_view buf);
+
+private:
+	impl::adler32_fn m_kernel;
+	std::uint32_t m_adler{1};
+};
+
+__CANEY_DIGESTV1_END
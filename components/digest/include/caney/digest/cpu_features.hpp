@@ -0,0 +1,28 @@
+/** @file */
+
+#pragma once
+
+#include "internal.hpp"
+
+__CANEY_DIGESTV1_BEGIN
+
+/**
+ * @brief instruction set extensions the hash kernels can make use of
+ *
+ * Detected once at runtime (using `cpuid` on x86); on other
+ * architectures all flags are `false` and only the portable kernels
+ * are used.
+ */
+struct cpu_features {
+	bool ssse3{false}; //!< SSSE3 (`pshufb`)
+	bool sse41{false}; //!< SSE 4.1
+	bool sse42{false}; //!< SSE 4.2 (`crc32`)
+	bool pclmul{false}; //!< carry-less multiplication (`pclmulqdq`)
+	bool avx2{false}; //!< AVX2 (256-bit integer vectors)
+	bool sha{false}; //!< SHA extensions (`sha1rnds4`, `sha256rnds2`, ...)
+
+	/** @brief features of the CPU the process is running on */
+	static cpu_features const& get();
+};
+
+__CANEY_DIGESTV1_END
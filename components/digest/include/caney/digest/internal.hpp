@@ -0,0 +1,66 @@
+/** @file */
+// clang-format off
+
+#pragma once
+
+/**
+  * @brief start digest module for doxygen
+  * @internal
+  */
+#define __CANEY_DOXYGEN_GROUP_DIGESTV1_BEGIN \
+	/** @addtogroup digest */ \
+	/** @{ */
+
+/**
+  * @brief end digest module for doxygen
+  * @internal
+  */
+#define __CANEY_DOXYGEN_GROUP_DIGESTV1_END \
+	/** @} */
+
+/* don't use inline namespace when generating docs */
+
+/**
+ * @brief basically `namespace caney { namespace digest { inline namespace v1 {` + some doxygen handling
+ * @internal
+ */
+#if defined(DOXYGEN)
+	#define __CANEY_DIGESTV1_BEGIN \
+		/** @namespace caney */ \
+		namespace caney { \
+			/** @namespace caney::digest */ \
+			namespace digest { \
+				__CANEY_DOXYGEN_GROUP_DIGESTV1_BEGIN
+#else
+	#define __CANEY_DIGESTV1_BEGIN \
+		/** @namespace caney */ \
+		namespace caney { \
+			/** @namespace caney::digest */ \
+			namespace digest { \
+				__CANEY_DOXYGEN_GROUP_DIGESTV1_BEGIN \
+				/** @namespace caney::digest::v1 */ \
+				inline namespace v1 {
+#endif
+
+/**
+ * @brief basically `} } }` + some doxygen handling
+ * @internal
+ */
+#if defined(DOXYGEN)
+	#define __CANEY_DIGESTV1_END \
+				__CANEY_DOXYGEN_GROUP_DIGESTV1_END \
+			} /* namespace caney::digest */ \
+		} /* namespace caney */
+#else
+	#define __CANEY_DIGESTV1_END \
+				__CANEY_DOXYGEN_GROUP_DIGESTV1_END \
+				} /* inline namespace caney::digest::v1 */ \
+			} /* namespace caney::digest */ \
+		} /* namespace caney */
+#endif
+
+/**
+ * @defgroup digest caney digest component
+ *
+ * @brief The caney `digest` component lives in the namespace @ref caney::digest .
+ */
@@ -0,0 +1,205 @@
+/** @file */
+
+#pragma once
+
+#include "caney/memory/buffer.hpp"
+#include "caney/streams/chunks.hpp"
+
+#include "internal.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+__CANEY_DIGESTV1_BEGIN
+
+/**
+ * @brief selects the code path used to compute SHA hashes
+ */
+enum class sha_implementation {
+	automatic, //!< best implementation available on the current CPU
+	scalar, //!< portable C++ implementation
+	sha_ni, //!< x86 SHA extensions (single message)
+	simd_x4, //!< multi-buffer: 4 messages in parallel using 128-bit vectors
+	simd_x8, //!< multi-buffer: 8 messages in parallel using AVX2
+};
+
+/**
+ * @brief whether the given implementation can be used on the current CPU
+ *
+ * @ref sha_implementation::automatic and @ref sha_implementation::scalar
+ * are always available.
+ */
+bool is_available(sha_implementation impl);
+
+namespace impl {
+	// contiguous part of a message; the data is not owned
+	struct segment {
+		unsigned char const* data;
+		std::size_t size;
+	};
+
+	using message_t = std::vector<segment>;
+
+	// append all memory chunks in `queue` to `message`; terminates on other chunk types
+	void append_segments(message_t& message, streams::chunk_queue const& queue);
+
+	// kernels process `blocks` consecutive 64-byte blocks
+	using compress_fn = void (*)(std::uint32_t* state, unsigned char const* data, std::size_t blocks);
+	// multi-buffer kernels process one 64-byte block per lane; the state is stored word-major:
+	// `state[word * lanes + lane]`
+	using compress_multi_fn = void (*)(std::uint32_t* state, unsigned char const* const* blocks);
+
+	struct sha1_traits {
+		static constexpr std::size_t state_words = 5;
+		static constexpr std::size_t digest_size = 20;
+		static std::uint32_t const initial_state[state_words];
+
+		static void compress_scalar(std::uint32_t* state, unsigned char const* data, std::size_t blocks);
+		static void compress_sha_ni(std::uint32_t* state, unsigned char const* data, std::size_t blocks);
+		static void compress_x4(std::uint32_t* state, unsigned char const* const* blocks);
+		static void compress_x8(std::uint32_t* state, unsigned char const* const* blocks);
+	};
+
+	struct sha256_traits {
+		static constexpr std::size_t state_words = 8;
+		static constexpr std::size_t digest_size = 32;
+		static std::uint32_t const initial_state[state_words];
+
+		static void compress_scalar(std::uint32_t* state, unsigned char const* data, std::size_t blocks);
+		static void compress_sha_ni(std::uint32_t* state, unsigned char const* data, std::size_t blocks);
+		static void compress_x4(std::uint32_t* state, unsigned char const* const* blocks);
+		static void compress_x8(std::uint32_t* state, unsigned char const* const* blocks);
+	};
+} // namespace impl
+
+/**
+ * @brief incremental SHA hash computation (see @ref sha1 and @ref sha256)
+ *
+ * Full blocks are hashed directly from the passed buffers; only
+ * partial blocks at buffer boundaries are copied into an internal
+ * block buffer.
+ *
+ * @tparam Traits algorithm description
+ */
+template <typename Traits>
+class basic_sha {
+public:
+	/** @brief size of the resulting digest in bytes */
+	static constexpr std::size_t digest_size = Traits::digest_size;
+	/** @brief internal block size in bytes */
+	static constexpr std::size_t block_size = 64;
+	/** @brief digest type */
+	using digest_t = std::array<unsigned char, digest_size>;
+	/** @internal @brief algorithm description */
+	using traits_t = Traits;
+
+	/**
+	 * @brief start new hash computation
+	 * @param impl code path to use; multi-buffer implementations are
+	 *     not useful for a single message and fall back to the best
+	 *     single message implementation
+	 */
+	explicit basic_sha(sha_implementation impl = sha_implementation::automatic);
+
+	/** @brief hash more data */
+	void update(unsigned char const* data, std::size_t size);
+
+	/** @brief hash more data */
+	void update(memory::byte_view buf);
+
+	/**
+	 * @brief hash all data in a @ref streams::chunk_queue
+	 *
+	 * only memory chunks are supported; terminates on other chunk types.
+	 */
+	void update(streams::chunk_queue const& queue);
+
+	/**
+	 * @brief finish hash computation and return the digest. resets the
+	 *     state to start a new computation.
+	 */
+	digest_t finish();
+
+	/** @brief hash a single buffer */
+	static digest_t hash(memory::byte_view buf);
+
+private:
+	impl::compress_fn m_compress;
+	std::uint32_t m_state[Traits::state_words];
+	std::uint64_t m_length{0};
+	std::size_t m_buffered{0};
+	unsigned char m_buffer[block_size];
+};
+
+/** @brief SHA-1 hash */
+using sha1 = basic_sha<impl::sha1_traits>;
+/** @brief SHA-256 hash */
+using sha256 = basic_sha<impl::sha256_traits>;
+
+/**
+ * @brief hash many independent messages (e.g. BitTorrent pieces) at once
+ *
+ * Pieces are only referenced, not copied: all data passed to `add()`
+ * must stay valid until @ref run() returns.
+ *
+ * Without SHA extensions multiple pieces are hashed in parallel in the
+ * lanes of SIMD vectors ("multi-buffer"); pieces don't need to have the
+ * same length.
+ *
+ * @tparam Hash @ref sha1 or @ref sha256
+ */
+template <typename Hash>
+class piece_hasher {
+public:
+	/** @brief digest type */
+	using digest_t = typename Hash::digest_t;
+
+	/** @brief create empty hasher */
+	explicit piece_hasher(sha_implementation impl = sha_implementation::automatic);
+
+	/** @brief add a piece stored in a single buffer */
+	void add(memory::byte_view piece);
+
+	/**
+	 * @brief add a piece stored in a @ref streams::chunk_queue
+	 *
+	 * only memory chunks are supported; terminates on other chunk types.
+	 */
+	void add(streams::chunk_queue const& piece);
+
+	/**
+	 * @brief add a piece stored in a sequence of buffers (anything
+	 *     iterable with elements providing `data()` and `size()`)
+	 */
+	template <typename BufferSequence>
+	void add_sequence(BufferSequence const& piece) {
+		impl::message_t message;
+		for (auto const& buf : piece) {
+			message.push_back(impl::segment{reinterpret_cast<unsigned char const*>(buf.data()), buf.size()});
+		}
+		m_pieces.emplace_back(std::move(message));
+	}
+
+	/** @brief number of pieces waiting for @ref run() */
+	std::size_t size() const {
+		return m_pieces.size();
+	}
+
+	/**
+	 * @brief hash all added pieces; returns the digests in the order
+	 *     the pieces were added and removes the pieces from the hasher.
+	 */
+	std::vector<digest_t> run();
+
+private:
+	sha_implementation m_impl;
+	std::vector<impl::message_t> m_pieces;
+};
+
+__CANEY_DIGESTV1_END
+
+extern template class caney::digest::basic_sha<caney::digest::impl::sha1_traits>;
+extern template class caney::digest::basic_sha<caney::digest::impl::sha256_traits>;
+extern template class caney::digest::piece_hasher<caney::digest::sha1>;
+extern template class caney::digest::piece_hasher<caney::digest::sha256>;
@@ -0,0 +1,144 @@
+#include "caney/digest/checksum.hpp"
+
+#include "caney/digest/cpu_features.hpp"
+
+#include <algorithm>
+#include <exception>
+
+#include <boost/asio/buffer.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+__CANEY_DIGESTV1_BEGIN
+
+namespace {
+	// largest prime smaller than 65536
+	constexpr std::uint32_t adler_base = 65521;
+	// largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1; sums can't overflow before taking the modulo
+	constexpr std::size_t adler_nmax = 5552;
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CANEY_DIGEST_TARGET_SSSE3 __attribute__((target("ssse3")))
+
+	CANEY_DIGEST_TARGET_SSSE3 inline std::uint32_t horizontal_sum(__m128i v) {
+		v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return static_cast<std::uint32_t>(_mm_cvtsi128_si32(v));
+	}
+#endif
+} // anonymous namespace
+
+std::uint32_t impl::adler32_scalar(std::uint32_t adler, unsigned char const* data, std::size_t size) {
+	std::uint32_t s1 = adler & 0xffff, s2 = adler >> 16;
+	while (size > 0) {
+		std::size_t n = std::min(size, adler_nmax);
+		size -= n;
+		for (; n >= 8; n -= 8, data += 8) {
+			s1 += data[0];
+			s2 += s1;
+			s1 += data[1];
+			s2 += s1;
+			s1 += data[2];
+			s2 += s1;
+			s1 += data[3];
+			s2 += s1;
+			s1 += data[4];
+			s2 += s1;
+			s1 += data[5];
+			s2 += s1;
+			s1 += data[6];
+			s2 += s1;
+			s1 += data[7];
+			s2 += s1;
+		}
+		for (; n > 0; --n) {
+			s1 += *data++;
+			s2 += s1;
+		}
+		s1 %= adler_base;
+		s2 %= adler_base;
+	}
+	return (s2 << 16) | s1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/* 32 bytes per iteration: s1 is the plain byte sum (psadbw), the
+ * weighted sum for s2 uses pmaddubsw with weights 32..1; the s1 values
+ * from previous iterations contribute 32 * s1 each.
+ */
+CANEY_DIGEST_TARGET_SSSE3 std::uint32_t impl::adler32_hardware(std::uint32_t adler, unsigned char const* data, std::size_t size) {
+	constexpr std::size_t block_size = 32;
+	std::uint32_t s1 = adler & 0xffff, s2 = adler >> 16;
+
+	__m128i const weights_lo = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+	__m128i const weights_hi = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	__m128i const zero = _mm_setzero_si128();
+	__m128i const ones = _mm_set1_epi16(1);
+
+	std::size_t blocks = size / block_size;
+	size -= blocks * block_size;
+	while (blocks > 0) {
+		std::size_t n = std::min(blocks, adler_nmax / block_size);
+		blocks -= n;
+
+		__m128i v_prev_s1 = _mm_cvtsi32_si128(static_cast<int>(s1 * n));
+		__m128i v_s1 = zero;
+		__m128i v_s2 = _mm_cvtsi32_si128(static_cast<int>(s2));
+		for (; n > 0; --n, data += block_size) {
+			__m128i const lo = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data));
+			__m128i const hi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16));
+			v_prev_s1 = _mm_add_epi32(v_prev_s1, v_s1);
+			v_s1 = _mm_add_epi32(v_s1, _mm_add_epi32(_mm_sad_epu8(lo, zero), _mm_sad_epu8(hi, zero)));
+			v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(lo, weights_lo), ones));
+			v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(hi, weights_hi), ones));
+		}
+		v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_prev_s1, 5));
+
+		s1 = (s1 + horizontal_sum(v_s1)) % adler_base;
+		s2 = horizontal_sum(v_s2) % adler_base;
+	}
+
+	return adler32_scalar((s2 << 16) | s1, data, size);
+}
+#else
+std::uint32_t impl::adler32_hardware(std::uint32_t adler, unsigned char const* data, std::size_t size) {
+	std::terminate();
+}
+#endif
+
+adler32::adler32(checksum_implementation implementation) : m_kernel(&impl::adler32_scalar) {
+	if (checksum_implementation::scalar != implementation && is_available(checksum_implementation::hardware)) m_kernel = &impl::adler32_hardware;
+}
+
+bool adler32::is_available(checksum_implementation impl) {
+	switch (impl) {
+	case checksum_implementation::automatic:
+	case checksum_implementation::scalar:
+		return true;
+	case checksum_implementation::hardware:
+#if defined(__x86_64__) || defined(__i386__)
+		return cpu_features::get().ssse3;
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+void adler32::update(streams::chunk_queue const& queue) {
+	for (streams::chunk const& c : queue.queue()) {
+		caney::optional<boost::asio::const_buffer> buf = c.get_const_buffer();
+		if (!buf) std::terminate();
+		update(boost::asio::buffer_cast<unsigned char const*>(*buf), boost::asio::buffer_size(*buf));
+	}
+}
+
+std::uint32_t adler32::checksum(memory::byte_view buf) {
+	adler32 a;
+	a.update(buf);
+	return a.value();
+}
+
+__CANEY_DIGESTV1_END
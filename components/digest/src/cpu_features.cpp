@@ -0,0 +1,34 @@
+#include "caney/digest/cpu_features.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+__CANEY_DIGESTV1_BEGIN
+
+namespace {
+	cpu_features detect_cpu_features() {
+		cpu_features result;
+#if defined(__x86_64__) || defined(__i386__)
+		unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+		if (0 == __get_cpuid(1, &eax, &ebx, &ecx, &edx)) return result;
+		result.ssse3 = (0 != (ecx & bit_SSSE3));
+		result.sse41 = (0 != (ecx & bit_SSE4_1));
+		result.sse42 = (0 != (ecx & bit_SSE4_2));
+		result.pclmul = (0 != (ecx & bit_PCLMUL));
+
+		if (0 == __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return result;
+		result.sha = (0 != (ebx & bit_SHA));
+		// also checks whether the OS saves the AVX registers
+		result.avx2 = __builtin_cpu_supports("avx2");
+#endif
+		return result;
+	}
+} // anonymous namespace
+
+cpu_features const& cpu_features::get() {
+	static cpu_features const features = detect_cpu_features();
+	return features;
+}
+
+__CANEY_DIGESTV1_END
@@ -0,0 +1,180 @@
+#include "caney/digest/checksum.hpp"
+
+#include "caney/digest/cpu_features.hpp"
+
+#include <cstring>
+#include <exception>
+
+#include <boost/asio/buffer.hpp>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+__CANEY_DIGESTV1_BEGIN
+
+namespace {
+	// reflected Castagnoli polynomial
+	constexpr std::uint32_t crc32c_poly = 0x82f63b78;
+
+	/* slicing-by-8 tables: table[0] is the classic bytewise table,
+	 * table[k][i] is the crc of byte i followed by k zero bytes
+	 */
+	struct crc32c_tables {
+		std::uint32_t table[8][256];
+
+		crc32c_tables() {
+			for (std::uint32_t i = 0; i < 256; ++i) {
+				std::uint32_t crc = i;
+				for (unsigned int bit = 0; bit < 8; ++bit) crc = (crc & 1) ? (crc >> 1) ^ crc32c_poly : crc >> 1;
+				table[0][i] = crc;
+			}
+			for (std::uint32_t i = 0; i < 256; ++i) {
+				for (std::size_t k = 1; k < 8; ++k) table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+			}
+		}
+
+		static crc32c_tables const& get() {
+			static crc32c_tables const tables;
+			return tables;
+		}
+	};
+
+#if defined(__x86_64__)
+	// a(x) * b(x) mod P; bit 31 represents x^0 (reflected representation)
+	constexpr std::uint32_t multmodp(std::uint32_t a, std::uint32_t b) {
+		std::uint32_t p = 0;
+		for (std::uint32_t m = std::uint32_t{1} << 31; m != 0; m >>= 1) {
+			if (a & m) p ^= b;
+			b = (b & 1) ? (b >> 1) ^ crc32c_poly : b >> 1;
+		}
+		return p;
+	}
+
+	// x^n mod P
+	constexpr std::uint32_t xpow(std::uint64_t n) {
+		std::uint32_t result = std::uint32_t{1} << 31; // x^0
+		std::uint32_t square = std::uint32_t{1} << 30; // x^1
+		for (; n != 0; n >>= 1) {
+			if (n & 1) result = multmodp(result, square);
+			square = multmodp(square, square);
+		}
+		return result;
+	}
+
+	/* constant to "shift" a crc over `bytes` zero bytes with a carry-less
+	 * multiplication followed by a crc32 instruction over the 64-bit
+	 * product: clmul adds a factor x, crc32 over 8 bytes another x^32.
+	 */
+	constexpr std::uint64_t shift_constant(std::size_t bytes) {
+		return xpow(8 * std::uint64_t{bytes} - 33);
+	}
+
+	constexpr std::size_t long_block = 8192;
+	constexpr std::size_t short_block = 256;
+
+#define CANEY_DIGEST_TARGET_CRC __attribute__((target("sse4.2,pclmul")))
+
+	CANEY_DIGEST_TARGET_CRC inline std::uint64_t load_u64(unsigned char const* p) {
+		std::uint64_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	/* the crc32 instruction has a latency of 3 cycles but a throughput
+	 * of one per cycle: run three independent streams over adjacent
+	 * blocks and merge them afterwards.
+	 */
+	template <std::size_t Block>
+	CANEY_DIGEST_TARGET_CRC inline std::uint64_t crc32c_3way(std::uint64_t crc0, unsigned char const*& data, std::size_t& size) {
+		static constexpr std::uint64_t k_block = shift_constant(Block);
+		static constexpr std::uint64_t k_double_block = shift_constant(2 * Block);
+		__m128i const k = _mm_set_epi64x(static_cast<long long>(k_block), static_cast<long long>(k_double_block));
+
+		while (size >= 3 * Block) {
+			std::uint64_t crc1 = 0, crc2 = 0;
+			for (std::size_t i = 0; i < Block; i += 8) {
+				crc0 = _mm_crc32_u64(crc0, load_u64(data + i));
+				crc1 = _mm_crc32_u64(crc1, load_u64(data + Block + i));
+				crc2 = _mm_crc32_u64(crc2, load_u64(data + 2 * Block + i));
+			}
+			__m128i const a = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(crc0)), k, 0x00);
+			__m128i const b = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(crc1)), k, 0x10);
+			crc0 = _mm_crc32_u64(0, static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_xor_si128(a, b)))) ^ crc2;
+			data += 3 * Block;
+			size -= 3 * Block;
+		}
+		return crc0;
+	}
+#endif // x86_64
+} // anonymous namespace
+
+std::uint32_t impl::crc32c_scalar(std::uint32_t crc, unsigned char const* data, std::size_t size) {
+	auto const& t = crc32c_tables::get().table;
+	for (; size >= 8; size -= 8, data += 8) {
+		std::uint32_t const lo = crc ^ (std::uint32_t(data[0]) | (std::uint32_t(data[1]) << 8) | (std::uint32_t(data[2]) << 16) | (std::uint32_t(data[3]) << 24));
+		crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+	}
+	while (size > 0) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xff];
+		--size;
+	}
+	return crc;
+}
+
+#if defined(__x86_64__)
+CANEY_DIGEST_TARGET_CRC std::uint32_t impl::crc32c_hardware(std::uint32_t crc, unsigned char const* data, std::size_t size) {
+	std::uint64_t crc0 = crc;
+	while (size > 0 && 0 != (reinterpret_cast<std::uintptr_t>(data) & 7)) {
+		crc0 = _mm_crc32_u8(static_cast<std::uint32_t>(crc0), *data++);
+		--size;
+	}
+	crc0 = crc32c_3way<long_block>(crc0, data, size);
+	crc0 = crc32c_3way<short_block>(crc0, data, size);
+	for (; size >= 8; size -= 8, data += 8) crc0 = _mm_crc32_u64(crc0, load_u64(data));
+	while (size > 0) {
+		crc0 = _mm_crc32_u8(static_cast<std::uint32_t>(crc0), *data++);
+		--size;
+	}
+	return static_cast<std::uint32_t>(crc0);
+}
+#else
+std::uint32_t impl::crc32c_hardware(std::uint32_t crc, unsigned char const* data, std::size_t size) {
+	std::terminate();
+}
+#endif
+
+crc32c::crc32c(checksum_implementation implementation) : m_kernel(&impl::crc32c_scalar) {
+	if (checksum_implementation::scalar != implementation && is_available(checksum_implementation::hardware)) m_kernel = &impl::crc32c_hardware;
+}
+
+bool crc32c::is_available(checksum_implementation impl) {
+	switch (impl) {
+	case checksum_implementation::automatic:
+	case checksum_implementation::scalar:
+		return true;
+	case checksum_implementation::hardware:
+#if defined(__x86_64__)
+		return cpu_features::get().sse42 && cpu_features::get().pclmul;
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+void crc32c::update(streams::chunk_queue const& queue) {
+	for (streams::chunk const& c : queue.queue()) {
+		caney::optional<boost::asio::const_buffer> buf = c.get_const_buffer();
+		if (!buf) std::terminate();
+		update(boost::asio::buffer_cast<unsigned char const*>(*buf), boost::asio::buffer_size(*buf));
+	}
+}
+
+std::uint32_t crc32c::checksum(memory::byte_view buf) {
+	crc32c c;
+	c.update(buf);
+	return c.value();
+}
+
+__CANEY_DIGESTV1_END
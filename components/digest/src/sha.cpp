@@ -0,0 +1,354 @@
+#include "caney/digest/sha.hpp"
+
+#include "caney/digest/cpu_features.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/asio/buffer.hpp>
+
+__CANEY_DIGESTV1_BEGIN
+
+namespace {
+	void store_be32(unsigned char* out, std::uint32_t value) {
+		out[0] = static_cast<unsigned char>(value >> 24);
+		out[1] = static_cast<unsigned char>(value >> 16);
+		out[2] = static_cast<unsigned char>(value >> 8);
+		out[3] = static_cast<unsigned char>(value);
+	}
+
+	void store_be64(unsigned char* out, std::uint64_t value) {
+		store_be32(out, static_cast<std::uint32_t>(value >> 32));
+		store_be32(out + 4, static_cast<std::uint32_t>(value));
+	}
+
+	sha_implementation resolve_single(sha_implementation impl) {
+		switch (impl) {
+		case sha_implementation::automatic:
+		case sha_implementation::simd_x4:
+		case sha_implementation::simd_x8:
+			return is_available(sha_implementation::sha_ni) ? sha_implementation::sha_ni : sha_implementation::scalar;
+		case sha_implementation::sha_ni:
+			return is_available(impl) ? impl : sha_implementation::scalar;
+		case sha_implementation::scalar:
+			break;
+		}
+		return sha_implementation::scalar;
+	}
+
+	template <typename Traits>
+	impl::compress_fn select_compress(sha_implementation impl) {
+		if (sha_implementation::sha_ni == resolve_single(impl)) return &Traits::compress_sha_ni;
+		return &Traits::compress_scalar;
+	}
+
+	// number of lanes for multi-buffer hashing; 0 if single message kernels should be used
+	std::size_t resolve_lanes(sha_implementation impl) {
+		switch (impl) {
+		case sha_implementation::automatic:
+			// SHA extensions beat multi-buffer SIMD
+			if (is_available(sha_implementation::sha_ni)) return 0;
+			return is_available(sha_implementation::simd_x8) ? 8 : 4;
+		case sha_implementation::simd_x8:
+			if (is_available(impl)) return 8;
+			return 4;
+		case sha_implementation::simd_x4:
+			return 4;
+		case sha_implementation::scalar:
+		case sha_implementation::sha_ni:
+			break;
+		}
+		return 0;
+	}
+
+	/* iterates over the padded 64-byte blocks of a message; full blocks
+	 * within a segment are returned directly, blocks crossing segment
+	 * boundaries and the padding are assembled in a scratch buffer
+	 */
+	class block_reader {
+	public:
+		block_reader() = default;
+
+		explicit block_reader(impl::message_t const* message) : m_message(message) {
+			for (auto const& seg : *message) m_length += seg.size;
+		}
+
+		// next block or nullptr if all blocks were returned
+		unsigned char const* next() {
+			switch (m_phase) {
+			case phase::data:
+				break;
+			case phase::length_block:
+				std::memset(m_scratch, 0, 56);
+				store_be64(m_scratch + 56, m_length * 8);
+				m_phase = phase::done;
+				return m_scratch;
+			case phase::done:
+				return nullptr;
+			}
+
+			skip_empty();
+			if (m_segment < m_message->size()) {
+				impl::segment const& seg = (*m_message)[m_segment];
+				if (seg.size - m_offset >= 64) {
+					unsigned char const* block = seg.data + m_offset;
+					m_offset += 64;
+					return block;
+				}
+			}
+
+			std::size_t filled = 0;
+			while (filled < 64) {
+				skip_empty();
+				if (m_segment >= m_message->size()) break;
+				impl::segment const& seg = (*m_message)[m_segment];
+				std::size_t const n = std::min<std::size_t>(64 - filled, seg.size - m_offset);
+				std::memcpy(m_scratch + filled, seg.data + m_offset, n);
+				filled += n;
+				m_offset += n;
+			}
+			if (64 == filled) return m_scratch;
+
+			// end of data: append padding
+			m_scratch[filled++] = 0x80;
+			if (filled <= 56) {
+				std::memset(m_scratch + filled, 0, 56 - filled);
+				store_be64(m_scratch + 56, m_length * 8);
+				m_phase = phase::done;
+			} else {
+				std::memset(m_scratch + filled, 0, 64 - filled);
+				m_phase = phase::length_block;
+			}
+			return m_scratch;
+		}
+
+	private:
+		void skip_empty() {
+			while (m_segment < m_message->size() && m_offset == (*m_message)[m_segment].size) {
+				++m_segment;
+				m_offset = 0;
+			}
+		}
+
+		enum class phase {
+			data,
+			length_block,
+			done,
+		};
+
+		impl::message_t const* m_message{nullptr};
+		std::uint64_t m_length{0};
+		std::size_t m_segment{0};
+		std::size_t m_offset{0};
+		phase m_phase{phase::data};
+		unsigned char m_scratch[64];
+	};
+
+	template <typename Digest>
+	Digest extract_digest(std::uint32_t const* state, std::size_t stride) {
+		Digest result;
+		for (std::size_t i = 0; 4 * i < result.size(); ++i) store_be32(result.data() + 4 * i, state[i * stride]);
+		return result;
+	}
+
+	template <typename Traits, typename Digest>
+	Digest hash_single(impl::compress_fn compress, impl::message_t const& message) {
+		std::uint32_t state[Traits::state_words];
+		std::copy(Traits::initial_state, Traits::initial_state + Traits::state_words, state);
+		block_reader reader(&message);
+		while (unsigned char const* block = reader.next()) compress(state, block, 1);
+		return extract_digest<Digest>(state, 1);
+	}
+
+	template <typename Traits, typename Digest, std::size_t Lanes>
+	void hash_multi(impl::compress_multi_fn compress, impl::compress_fn single, std::vector<impl::message_t> const& pieces, std::vector<Digest>& result) {
+		static unsigned char const idle_block[64] = {0};
+
+		std::uint32_t state[Traits::state_words * Lanes];
+		block_reader readers[Lanes];
+		std::size_t lane_piece[Lanes];
+		bool active[Lanes];
+		unsigned char const* blocks[Lanes];
+		std::size_t active_count = 0;
+		std::size_t next_piece = 0;
+
+		auto start_lane = [&](std::size_t lane) {
+			active[lane] = next_piece < pieces.size();
+			if (!active[lane]) return;
+			lane_piece[lane] = next_piece;
+			readers[lane] = block_reader(&pieces[next_piece]);
+			++next_piece;
+			++active_count;
+			for (std::size_t w = 0; w < Traits::state_words; ++w) state[w * Lanes + lane] = Traits::initial_state[w];
+		};
+
+		for (std::size_t lane = 0; lane < Lanes; ++lane) start_lane(lane);
+
+		// stop using the vector kernel once less than half of the lanes have work left
+		while (2 * active_count > Lanes || (active_count > 0 && next_piece < pieces.size())) {
+			for (std::size_t lane = 0; lane < Lanes; ++lane) {
+				blocks[lane] = active[lane] ? readers[lane].next() : idle_block;
+				if (nullptr == blocks[lane]) {
+					// finished message in previous round
+					result[lane_piece[lane]] = extract_digest<Digest>(state + lane, Lanes);
+					--active_count;
+					start_lane(lane);
+					blocks[lane] = active[lane] ? readers[lane].next() : idle_block;
+				}
+			}
+			if (0 == active_count) break;
+			compress(state, blocks);
+		}
+
+		// finish remaining lanes with the single message kernel
+		for (std::size_t lane = 0; lane < Lanes; ++lane) {
+			if (!active[lane]) continue;
+			std::uint32_t lane_state[Traits::state_words];
+			for (std::size_t w = 0; w < Traits::state_words; ++w) lane_state[w] = state[w * Lanes + lane];
+			while (unsigned char const* block = readers[lane].next()) single(lane_state, block, 1);
+			result[lane_piece[lane]] = extract_digest<Digest>(lane_state, 1);
+		}
+	}
+} // anonymous namespace
+
+bool is_available(sha_implementation impl) {
+	cpu_features const& cpu = cpu_features::get();
+	switch (impl) {
+	case sha_implementation::automatic:
+	case sha_implementation::scalar:
+	case sha_implementation::simd_x4:
+		return true;
+	case sha_implementation::sha_ni:
+		return cpu.sha && cpu.ssse3 && cpu.sse41;
+	case sha_implementation::simd_x8:
+		return cpu.avx2;
+	}
+	return false;
+}
+
+void impl::append_segments(message_t& message, streams::chunk_queue const& queue) {
+	for (streams::chunk const& c : queue.queue()) {
+		caney::optional<boost::asio::const_buffer> buf = c.get_const_buffer();
+		if (!buf) std::terminate();
+		message.push_back(segment{boost::asio::buffer_cast<unsigned char const*>(*buf), boost::asio::buffer_size(*buf)});
+	}
+}
+
+/* basic_sha */
+
+template <typename Traits>
+basic_sha<Traits>::basic_sha(sha_implementation impl) : m_compress(select_compress<Traits>(impl)) {
+	std::copy(Traits::initial_state, Traits::initial_state + Traits::state_words, m_state);
+}
+
+template <typename Traits>
+void basic_sha<Traits>::update(unsigned char const* data, std::size_t size) {
+	m_length += size;
+	if (m_buffered > 0) {
+		std::size_t const n = std::min(size, block_size - m_buffered);
+		std::memcpy(m_buffer + m_buffered, data, n);
+		m_buffered += n;
+		data += n;
+		size -= n;
+		if (m_buffered < block_size) return;
+		m_compress(m_state, m_buffer, 1);
+		m_buffered = 0;
+	}
+	if (size >= block_size) {
+		std::size_t const blocks = size / block_size;
+		m_compress(m_state, data, blocks);
+		data += blocks * block_size;
+		size -= blocks * block_size;
+	}
+	if (size > 0) {
+		std::memcpy(m_buffer, data, size);
+		m_buffered = size;
+	}
+}
+
+template <typename Traits>
+void basic_sha<Traits>::update(memory::byte_view buf) {
+	update(buf.data(), buf.size());
+}
+
+template <typename Traits>
+void basic_sha<Traits>::update(streams::chunk_queue const& queue) {
+	impl::message_t message;
+	impl::append_segments(message, queue);
+	for (impl::segment const& seg : message) update(seg.data, seg.size);
+}
+
+template <typename Traits>
+auto basic_sha<Traits>::finish() -> digest_t {
+	std::uint64_t const bit_length = m_length * 8;
+	m_buffer[m_buffered++] = 0x80;
+	if (m_buffered > 56) {
+		std::memset(m_buffer + m_buffered, 0, block_size - m_buffered);
+		m_compress(m_state, m_buffer, 1);
+		m_buffered = 0;
+	}
+	std::memset(m_buffer + m_buffered, 0, 56 - m_buffered);
+	store_be64(m_buffer + 56, bit_length);
+	m_compress(m_state, m_buffer, 1);
+
+	digest_t const result = extract_digest<digest_t>(m_state, 1);
+
+	std::copy(Traits::initial_state, Traits::initial_state + Traits::state_words, m_state);
+	m_length = 0;
+	m_buffered = 0;
+	return result;
+}
+
+template <typename Traits>
+/* static */
+auto basic_sha<Traits>::hash(memory::byte_view buf) -> digest_t {
+	basic_sha h;
+	h.update(buf);
+	return h.finish();
+}
+
+/* piece_hasher */
+
+template <typename Hash>
+piece_hasher<Hash>::piece_hasher(sha_implementation impl) : m_impl(impl) {}
+
+template <typename Hash>
+void piece_hasher<Hash>::add(memory::byte_view piece) {
+	m_pieces.emplace_back(impl::message_t{impl::segment{piece.data(), piece.size()}});
+}
+
+template <typename Hash>
+void piece_hasher<Hash>::add(streams::chunk_queue const& piece) {
+	impl::message_t message;
+	impl::append_segments(message, piece);
+	m_pieces.emplace_back(std::move(message));
+}
+
+template <typename Hash>
+auto piece_hasher<Hash>::run() -> std::vector<digest_t> {
+	using traits_t = typename Hash::traits_t;
+	std::vector<impl::message_t> pieces;
+	pieces.swap(m_pieces);
+	std::vector<digest_t> result(pieces.size());
+
+	impl::compress_fn const single = select_compress<traits_t>(m_impl);
+	switch (pieces.size() > 1 ? resolve_lanes(m_impl) : 0) {
+	case 8:
+		hash_multi<traits_t, digest_t, 8>(&traits_t::compress_x8, single, pieces, result);
+		break;
+	case 4:
+		hash_multi<traits_t, digest_t, 4>(&traits_t::compress_x4, single, pieces, result);
+		break;
+	default:
+		for (std::size_t i = 0; i < pieces.size(); ++i) result[i] = hash_single<traits_t, digest_t>(single, pieces[i]);
+		break;
+	}
+	return result;
+}
+
+__CANEY_DIGESTV1_END
+
+template class caney::digest::basic_sha<caney::digest::impl::sha1_traits>;
+template class caney::digest::basic_sha<caney::digest::impl::sha256_traits>;
+template class caney::digest::piece_hasher<caney::digest::sha1>;
+template class caney::digest::piece_hasher<caney::digest::sha256>;
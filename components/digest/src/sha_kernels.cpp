@@ -0,0 +1,182 @@
+#include "caney/digest/sha.hpp"
+
+#include <cstring>
+
+__CANEY_DIGESTV1_BEGIN
+
+/* portable kernels; the multi-buffer kernels use the GCC vector
+ * extension, so the compiler maps them to whatever SIMD instructions
+ * are available (SSE2 on x86-64, NEON on arm64, ...), and AVX2 for the
+ * 8-lane variant on x86.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CANEY_DIGEST_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CANEY_DIGEST_TARGET_AVX2
+#endif
+
+#define CANEY_DIGEST_ALWAYS_INLINE inline __attribute__((always_inline))
+
+/* works for scalars and vectors */
+#define CANEY_DIGEST_ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define CANEY_DIGEST_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+namespace {
+	typedef std::uint32_t u32x4 __attribute__((vector_size(16)));
+	typedef std::uint32_t u32x8 __attribute__((vector_size(32)));
+
+	CANEY_DIGEST_ALWAYS_INLINE std::uint32_t load_be32(unsigned char const* p) {
+		return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+	}
+
+	std::uint32_t const sha256_k[64] = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be,
+		0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa,
+		0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85,
+		0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+		0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+		0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+	};
+
+	/* Word is either std::uint32_t (one message) or a vector of
+	 * std::uint32_t (one message per lane); `w` must already contain
+	 * the first 16 message words.
+	 */
+	struct sha1_rounds {
+		template <typename Word>
+		static CANEY_DIGEST_ALWAYS_INLINE void apply(Word (&s)[5], Word (&w)[16]) {
+			Word a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+			for (unsigned int t = 0; t < 80; ++t) {
+				if (t >= 16) {
+					Word const x = w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15];
+					w[t & 15] = CANEY_DIGEST_ROL(x, 1);
+				}
+				Word f;
+				std::uint32_t k;
+				if (t < 20) {
+					f = d ^ (b & (c ^ d));
+					k = 0x5a827999;
+				} else if (t < 40) {
+					f = b ^ c ^ d;
+					k = 0x6ed9eba1;
+				} else if (t < 60) {
+					f = (b & c) | (d & (b | c));
+					k = 0x8f1bbcdc;
+				} else {
+					f = b ^ c ^ d;
+					k = 0xca62c1d6;
+				}
+				Word const tmp = CANEY_DIGEST_ROL(a, 5) + f + e + k + w[t & 15];
+				e = d;
+				d = c;
+				c = CANEY_DIGEST_ROL(b, 30);
+				b = a;
+				a = tmp;
+			}
+			s[0] += a;
+			s[1] += b;
+			s[2] += c;
+			s[3] += d;
+			s[4] += e;
+		}
+	};
+
+	struct sha256_rounds {
+		template <typename Word>
+		static CANEY_DIGEST_ALWAYS_INLINE void apply(Word (&s)[8], Word (&w)[16]) {
+			Word a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+			for (unsigned int t = 0; t < 64; ++t) {
+				if (t >= 16) {
+					Word const w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+					Word const s0 = CANEY_DIGEST_ROR(w15, 7) ^ CANEY_DIGEST_ROR(w15, 18) ^ (w15 >> 3);
+					Word const s1 = CANEY_DIGEST_ROR(w2, 17) ^ CANEY_DIGEST_ROR(w2, 19) ^ (w2 >> 10);
+					w[t & 15] += s0 + w[(t - 7) & 15] + s1;
+				}
+				Word const S1 = CANEY_DIGEST_ROR(e, 6) ^ CANEY_DIGEST_ROR(e, 11) ^ CANEY_DIGEST_ROR(e, 25);
+				Word const ch = g ^ (e & (f ^ g));
+				Word const t1 = h + S1 + ch + sha256_k[t] + w[t & 15];
+				Word const S0 = CANEY_DIGEST_ROR(a, 2) ^ CANEY_DIGEST_ROR(a, 13) ^ CANEY_DIGEST_ROR(a, 22);
+				Word const maj = (a & b) | (c & (a | b));
+				Word const t2 = S0 + maj;
+				h = g;
+				g = f;
+				f = e;
+				e = d + t1;
+				d = c;
+				c = b;
+				b = a;
+				a = t1 + t2;
+			}
+			s[0] += a;
+			s[1] += b;
+			s[2] += c;
+			s[3] += d;
+			s[4] += e;
+			s[5] += f;
+			s[6] += g;
+			s[7] += h;
+		}
+	};
+
+	template <std::size_t StateWords, typename Rounds>
+	CANEY_DIGEST_ALWAYS_INLINE void compress_scalar(std::uint32_t* state, unsigned char const* data, std::size_t blocks) {
+		std::uint32_t s[StateWords];
+		std::memcpy(s, state, sizeof(s));
+		for (; blocks > 0; --blocks, data += 64) {
+			std::uint32_t w[16];
+			for (std::size_t t = 0; t < 16; ++t) w[t] = load_be32(data + 4 * t);
+			Rounds::apply(s, w);
+		}
+		std::memcpy(state, s, sizeof(s));
+	}
+
+	template <typename Vector, std::size_t Lanes, std::size_t StateWords, typename Rounds>
+	CANEY_DIGEST_ALWAYS_INLINE void compress_multi(std::uint32_t* state, unsigned char const* const* blocks) {
+		static_assert(sizeof(Vector) == Lanes * sizeof(std::uint32_t), "lane count doesn't match vector size");
+		Vector s[StateWords];
+		std::memcpy(s, state, sizeof(s));
+		Vector w[16];
+		for (std::size_t t = 0; t < 16; ++t) {
+			for (std::size_t lane = 0; lane < Lanes; ++lane) w[t][lane] = load_be32(blocks[lane] + 4 * t);
+		}
+		Rounds::apply(s, w);
+		std::memcpy(state, s, sizeof(s));
+	}
+} // anonymous namespace
+
+/* SHA-1 */
+
+std::uint32_t const impl::sha1_traits::initial_state[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+
+void impl::sha1_traits::compress_scalar(std::uint32_t* state, unsigned char const* data, std::size_t blocks) {
+	digest::compress_scalar<5, sha1_rounds>(state, data, blocks);
+}
+
+void impl::sha1_traits::compress_x4(std::uint32_t* state, unsigned char const* const* blocks) {
+	compress_multi<u32x4, 4, 5, sha1_rounds>(state, blocks);
+}
+
+CANEY_DIGEST_TARGET_AVX2 void impl::sha1_traits::compress_x8(std::uint32_t* state, unsigned char const* const* blocks) {
+	compress_multi<u32x8, 8, 5, sha1_rounds>(state, blocks);
+}
+
+/* SHA-256 */
+
+std::uint32_t const impl::sha256_traits::initial_state[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+void impl::sha256_traits::compress_scalar(std::uint32_t* state, unsigned char const* data, std::size_t blocks) {
+	digest::compress_scalar<8, sha256_rounds>(state, data, blocks);
+}
+
+void impl::sha256_traits::compress_x4(std::uint32_t* state, unsigned char const* const* blocks) {
+	compress_multi<u32x4, 4, 8, sha256_rounds>(state, blocks);
+}
+
+CANEY_DIGEST_TARGET_AVX2 void impl::sha256_traits::compress_x8(std::uint32_t* state, unsigned char const* const* blocks) {
+	compress_multi<u32x8, 8, 8, sha256_rounds>(state, blocks);
+}
+
+__CANEY_DIGESTV1_END
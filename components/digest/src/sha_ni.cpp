@@ -0,0 +1,145 @@
+#include "caney/digest/sha.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#else
+#include <exception>
+#endif
+
+__CANEY_DIGESTV1_BEGIN
+
+/* kernels using the x86 SHA extensions; only called after checking
+ * is_available(sha_implementation::sha_ni)
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#define CANEY_DIGEST_TARGET_SHA_NI __attribute__((target("sha,sse4.1,ssse3")))
+
+namespace {
+	// the 4-round function of sha1rnds4 must be an immediate
+	CANEY_DIGEST_TARGET_SHA_NI inline __m128i sha1_rnds4(__m128i abcd, __m128i e, unsigned int group) {
+		switch (group / 5) {
+		case 0:
+			return _mm_sha1rnds4_epu32(abcd, e, 0);
+		case 1:
+			return _mm_sha1rnds4_epu32(abcd, e, 1);
+		case 2:
+			return _mm_sha1rnds4_epu32(abcd, e, 2);
+		default:
+			return _mm_sha1rnds4_epu32(abcd, e, 3);
+		}
+	}
+} // anonymous namespace
+
+CANEY_DIGEST_TARGET_SHA_NI void impl::sha1_traits::compress_sha_ni(std::uint32_t* state, unsigned char const* data, std::size_t blocks) {
+	__m128i const mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+	__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(state)), 0x1b);
+	__m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+	for (; blocks > 0; --blocks, data += 64) {
+		__m128i const abcd_save = abcd;
+		__m128i const e0_save = e0;
+
+		__m128i msg[4];
+		for (unsigned int i = 0; i < 4; ++i) {
+			msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16 * i)), mask);
+		}
+
+		/* each group computes 4 rounds; message schedule for later
+		 * groups is computed along the way
+		 */
+		__m128i e1;
+		e0 = _mm_add_epi32(e0, msg[0]);
+		e1 = abcd;
+		abcd = sha1_rnds4(abcd, e0, 0);
+
+#pragma GCC unroll 19
+		for (unsigned int g = 1; g < 20; ++g) {
+			__m128i& cur = msg[g & 3];
+			__m128i& e_next = (g & 1) ? e1 : e0;
+			__m128i& e_other = (g & 1) ? e0 : e1;
+			e_next = _mm_sha1nexte_epu32(e_next, cur);
+			e_other = abcd;
+			if (g >= 3 && g < 19) msg[(g + 1) & 3] = _mm_sha1msg2_epu32(msg[(g + 1) & 3], cur);
+			abcd = sha1_rnds4(abcd, e_next, g);
+			if (g < 17) msg[(g + 3) & 3] = _mm_sha1msg1_epu32(msg[(g + 3) & 3], cur);
+			if (g >= 2 && g < 18) msg[(g + 2) & 3] = _mm_xor_si128(msg[(g + 2) & 3], cur);
+		}
+
+		// 20 groups: e0 is "next" for even groups, so after group 19 e0 holds E for the next block
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1b));
+	state[4] = static_cast<std::uint32_t>(_mm_extract_epi32(e0, 3));
+}
+
+CANEY_DIGEST_TARGET_SHA_NI void impl::sha256_traits::compress_sha_ni(std::uint32_t* state, unsigned char const* data, std::size_t blocks) {
+	static std::uint32_t const k[64] = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be,
+		0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa,
+		0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85,
+		0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+		0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+		0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+	};
+	__m128i const mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	// state is kept as ABEF / CDGH
+	__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(state)), 0xb1); // CDAB
+	__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(state + 4)), 0x1b); // EFGH
+	__m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0); // CDGH
+
+	for (; blocks > 0; --blocks, data += 64) {
+		__m128i const abef_save = state0;
+		__m128i const cdgh_save = state1;
+
+		__m128i msg[4];
+		for (unsigned int i = 0; i < 4; ++i) {
+			msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + 16 * i)), mask);
+		}
+
+#pragma GCC unroll 16
+		for (unsigned int g = 0; g < 16; ++g) {
+			__m128i& cur = msg[g & 3];
+			__m128i m = _mm_add_epi32(cur, _mm_loadu_si128(reinterpret_cast<__m128i const*>(k + 4 * g)));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+			if (g >= 3 && g < 15) {
+				__m128i& next = msg[(g + 1) & 3];
+				next = _mm_add_epi32(next, _mm_alignr_epi8(cur, msg[(g + 3) & 3], 4));
+				next = _mm_sha256msg2_epu32(next, cur);
+			}
+			m = _mm_shuffle_epi32(m, 0x0e);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+			if (g >= 1 && g < 13) msg[(g + 3) & 3] = _mm_sha256msg1_epu32(msg[(g + 3) & 3], cur);
+		}
+
+		state0 = _mm_add_epi32(state0, abef_save);
+		state1 = _mm_add_epi32(state1, cdgh_save);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b); // FEBA
+	state1 = _mm_shuffle_epi32(state1, 0xb1); // DCHG
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0); // DCBA
+	state1 = _mm_alignr_epi8(state1, tmp, 8); // ABEF
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+#else // x86
+
+void impl::sha1_traits::compress_sha_ni(std::uint32_t*, unsigned char const*, std::size_t) {
+	std::terminate();
+}
+
+void impl::sha256_traits::compress_sha_ni(std::uint32_t*, unsigned char const*, std::size_t) {
+	std::terminate();
+}
+
+#endif // x86
+
+__CANEY_DIGESTV1_END
@@ -0,0 +1,110 @@
+#include "caney/digest/checksum.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+	caney::memory::raw_const_buf as_buf(std::string const& s) {
+		return caney::memory::raw_const_buf(reinterpret_cast<unsigned char const*>(s.data()), s.size());
+	}
+
+	std::vector<unsigned char> test_data(std::size_t size) {
+		std::vector<unsigned char> data(size);
+		std::uint32_t x = 0x12345678;
+		for (auto& c : data) {
+			x = x * 1103515245 + 12345;
+			c = static_cast<unsigned char>(x >> 23);
+		}
+		return data;
+	}
+
+	// compare hardware and scalar kernels for various lengths and alignments
+	template <typename Checksum>
+	void compare_kernels() {
+		if (!Checksum::is_available(caney::digest::checksum_implementation::hardware)) return;
+		std::vector<unsigned char> const data = test_data(3 * 8192 * 2 + 1000);
+		std::size_t const sizes[] = {0, 1, 7, 8, 31, 32, 33, 767, 768, 769, 5552, 5600, 24576, 24577, 3 * 8192 * 2 + 999};
+		for (std::size_t offset = 0; offset < 8; ++offset) {
+			for (std::size_t size : sizes) {
+				if (offset + size > data.size()) continue;
+				caney::memory::raw_const_buf const buf(data.data() + offset, size);
+				Checksum scalar(caney::digest::checksum_implementation::scalar);
+				Checksum hardware(caney::digest::checksum_implementation::hardware);
+				scalar.update(buf);
+				hardware.update(buf);
+				BOOST_CHECK_EQUAL(scalar.value(), hardware.value());
+			}
+		}
+	}
+
+	// feeding data in pieces must give the same result as a single update
+	template <typename Checksum>
+	void check_incremental() {
+		std::vector<unsigned char> const data = test_data(100000);
+		std::uint32_t const expected = Checksum::checksum(caney::memory::raw_const_buf(data.data(), data.size()));
+
+		for (std::size_t step : {1u, 13u, 64u, 5553u, 30000u}) {
+			Checksum c;
+			caney::streams::chunk_queue queue;
+			for (std::size_t pos = 0; pos < data.size(); pos += step) {
+				std::size_t const n = std::min(step, data.size() - pos);
+				c.update(caney::memory::raw_const_buf(data.data() + pos, n));
+				queue.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(data.data() + pos, n)));
+			}
+			BOOST_CHECK_EQUAL(c.value(), expected);
+
+			Checksum q;
+			q.update(queue);
+			BOOST_CHECK_EQUAL(q.value(), expected);
+		}
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(checksum_test)
+
+BOOST_AUTO_TEST_CASE(crc32c_known_answers) {
+	for (auto impl : {caney::digest::checksum_implementation::scalar, caney::digest::checksum_implementation::hardware}) {
+		if (!caney::digest::crc32c::is_available(impl)) continue;
+		caney::digest::crc32c c(impl);
+		BOOST_CHECK_EQUAL(c.value(), 0u);
+		c.update(as_buf("123456789"));
+		BOOST_CHECK_EQUAL(c.value(), 0xe3069283u);
+		c.reset();
+		c.update(as_buf(std::string(32, '\0')));
+		BOOST_CHECK_EQUAL(c.value(), 0x8a9136aau);
+		c.reset();
+		c.update(as_buf(std::string(32, '\xff')));
+		BOOST_CHECK_EQUAL(c.value(), 0x62a8ab43u);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(adler32_known_answers) {
+	for (auto impl : {caney::digest::checksum_implementation::scalar, caney::digest::checksum_implementation::hardware}) {
+		if (!caney::digest::adler32::is_available(impl)) continue;
+		caney::digest::adler32 a(impl);
+		BOOST_CHECK_EQUAL(a.value(), 1u);
+		a.update(as_buf("Wikipedia"));
+		BOOST_CHECK_EQUAL(a.value(), 0x11e60398u);
+		a.reset();
+		a.update(as_buf("123456789"));
+		BOOST_CHECK_EQUAL(a.value(), 0x091e01deu);
+		a.reset();
+		// large enough to require the modulo multiple times
+		a.update(as_buf(std::string(100000, '\xff')));
+		BOOST_CHECK_EQUAL(a.value(), 0x149a302cu);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(kernels_match) {
+	compare_kernels<caney::digest::crc32c>();
+	compare_kernels<caney::digest::adler32>();
+}
+
+BOOST_AUTO_TEST_CASE(incremental) {
+	check_incremental<caney::digest::crc32c>();
+	check_incremental<caney::digest::adler32>();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+#include "caney/digest/sha.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+namespace {
+	caney::digest::sha_implementation const all_implementations[] = {
+		caney::digest::sha_implementation::automatic,
+		caney::digest::sha_implementation::scalar,
+		caney::digest::sha_implementation::sha_ni,
+		caney::digest::sha_implementation::simd_x4,
+		caney::digest::sha_implementation::simd_x8,
+	};
+
+	template <typename Digest>
+	std::string to_hex(Digest const& digest) {
+		static char const hex[] = "0123456789abcdef";
+		std::string result;
+		for (unsigned char c : digest) {
+			result += hex[c >> 4];
+			result += hex[c & 0xf];
+		}
+		return result;
+	}
+
+	caney::memory::raw_const_buf as_buf(std::string const& s) {
+		return caney::memory::raw_const_buf(reinterpret_cast<unsigned char const*>(s.data()), s.size());
+	}
+
+	struct known_answer {
+		std::string message;
+		char const* sha1;
+		char const* sha256;
+	};
+
+	std::vector<known_answer> known_answers() {
+		return {
+			{"", "da39a3ee5e6b4b0d3255bfef95601890afd80709", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+			{"abc", "a9993e364706816aba3e25717850c26c9cd0d89d", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+			{"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+				"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+			{std::string(1000000, 'a'), "34aa973cd4c4daa4f61eeb2bdbad27316534016f", "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+		};
+	}
+
+	// pieces of various sizes around the block and padding boundaries
+	std::vector<std::string> test_pieces() {
+		std::vector<std::string> pieces;
+		std::size_t const sizes[] = {0, 1, 55, 56, 63, 64, 65, 119, 120, 127, 128, 1000, 16384, 3, 77, 4096, 200, 31};
+		unsigned char x = 7;
+		for (std::size_t size : sizes) {
+			std::string piece(size, '\0');
+			for (auto& c : piece) c = static_cast<char>(x += 13);
+			pieces.push_back(std::move(piece));
+		}
+		return pieces;
+	}
+
+	template <typename Hash>
+	void check_pieces(caney::digest::sha_implementation impl) {
+		std::vector<std::string> const pieces = test_pieces();
+		caney::digest::piece_hasher<Hash> hasher(impl);
+		for (auto const& piece : pieces) hasher.add(as_buf(piece));
+		BOOST_CHECK_EQUAL(hasher.size(), pieces.size());
+		auto const digests = hasher.run();
+		BOOST_CHECK_EQUAL(hasher.size(), 0u);
+		BOOST_REQUIRE_EQUAL(digests.size(), pieces.size());
+		for (std::size_t i = 0; i < pieces.size(); ++i) {
+			Hash reference(caney::digest::sha_implementation::scalar);
+			reference.update(as_buf(pieces[i]));
+			BOOST_CHECK_EQUAL(to_hex(digests[i]), to_hex(reference.finish()));
+		}
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(sha_test)
+
+BOOST_AUTO_TEST_CASE(known_answers_single) {
+	for (auto impl : all_implementations) {
+		if (!caney::digest::is_available(impl)) continue;
+		for (auto const& kat : known_answers()) {
+			caney::digest::sha1 h1(impl);
+			h1.update(as_buf(kat.message));
+			BOOST_CHECK_EQUAL(to_hex(h1.finish()), kat.sha1);
+
+			caney::digest::sha256 h256(impl);
+			h256.update(as_buf(kat.message));
+			BOOST_CHECK_EQUAL(to_hex(h256.finish()), kat.sha256);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(incremental) {
+	std::string const message(1000, 'x');
+	std::string const expected = to_hex(caney::digest::sha256::hash(as_buf(message)));
+	for (std::size_t step : {1u, 3u, 63u, 64u, 65u, 200u}) {
+		caney::digest::sha256 h;
+		for (std::size_t pos = 0; pos < message.size(); pos += step) {
+			h.update(as_buf(message.substr(pos, step)));
+		}
+		BOOST_CHECK_EQUAL(to_hex(h.finish()), expected);
+		// finish() resets the state
+		BOOST_CHECK_EQUAL(to_hex(h.finish()), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	}
+}
+
+BOOST_AUTO_TEST_CASE(known_answers_pieces) {
+	for (auto impl : all_implementations) {
+		if (!caney::digest::is_available(impl)) continue;
+		caney::digest::piece_hasher<caney::digest::sha1> h1(impl);
+		caney::digest::piece_hasher<caney::digest::sha256> h256(impl);
+		auto const kats = known_answers();
+		for (auto const& kat : kats) {
+			h1.add(as_buf(kat.message));
+			h256.add(as_buf(kat.message));
+		}
+		auto const d1 = h1.run();
+		auto const d256 = h256.run();
+		for (std::size_t i = 0; i < kats.size(); ++i) {
+			BOOST_CHECK_EQUAL(to_hex(d1[i]), kats[i].sha1);
+			BOOST_CHECK_EQUAL(to_hex(d256[i]), kats[i].sha256);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(mixed_pieces) {
+	for (auto impl : all_implementations) {
+		if (!caney::digest::is_available(impl)) continue;
+		check_pieces<caney::digest::sha1>(impl);
+		check_pieces<caney::digest::sha256>(impl);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(segmented_pieces) {
+	// same message split at different (non block aligned) positions
+	std::string const message(5000, 'q');
+	std::string const expected = to_hex(caney::digest::sha1::hash(as_buf(message)));
+	for (auto impl : all_implementations) {
+		if (!caney::digest::is_available(impl)) continue;
+		caney::digest::piece_hasher<caney::digest::sha1> hasher(impl);
+		std::vector<std::vector<caney::memory::raw_const_buf>> sequences;
+		for (std::size_t split : {1u, 37u, 64u, 100u, 4999u}) {
+			sequences.push_back({
+				caney::memory::raw_const_buf(reinterpret_cast<unsigned char const*>(message.data()), split),
+				caney::memory::raw_const_buf(reinterpret_cast<unsigned char const*>(message.data()) + split, message.size() - split),
+			});
+			hasher.add_sequence(sequences.back());
+		}
+
+		caney::streams::chunk_queue queue;
+		queue.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(message.data(), 17)));
+		queue.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(message.data() + 17, message.size() - 17)));
+		hasher.add(queue);
+
+		for (auto const& digest : hasher.run()) BOOST_CHECK_EQUAL(to_hex(digest), expected);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,13 +5,24 @@
 #include "caney/std/synchronized.hpp"
 
 #include "internal.hpp"
+#include "reclaimable.hpp"
 
+#include <atomic>
 #include <memory>
+#include <thread>
 
 #include <boost/noncopyable.hpp>
 
 __CANEY_MEMORYV1_BEGIN
 
+/**
+ * @brief how an @ref allocator_pool synchronizes access to its cache
+ */
+enum class allocator_pool_mode {
+	shared, //!< all threads use the same mutex protected cache
+	owned, //!< the thread creating the pool owns the cache (see @ref allocator_pool)
+};
+
 /**
  * @brief An allocator which keeps allocations of a given size in a pool for later reuse.
  *
@@ -38,6 +49,19 @@ __CANEY_MEMORYV1_BEGIN
  * @ref allocator_pool allocator is not directly compatible to `std::allocator`.
  * Also the pool size should be at least sizeof(void*), otherwise it won't cache
  * anything.
+ *
+ * With @ref allocator_pool_mode::owned the thread creating the pool owns
+ * the cache: it allocates from and frees into it without locking. Other
+ * threads don't allocate from the cache, and push freed allocations
+ * onto a lock-free "remote free" inbox; the owner takes over the whole
+ * inbox in one go when its own cache runs empty. This is useful when
+ * buffers are allocated on an I/O thread but released on workers.
+ *
+ * The cache can be shrunk with @ref reclaim (e.g. under memory pressure,
+ * see @ref memory_pressure_watcher); @ref as_reclaimable returns a weak
+ * reference for a @ref reclaim_registry. In owned mode only the inbox
+ * is released immediately; the owner trims its own cache on its next
+ * allocation or deallocation.
  */
 class allocator_pool : private boost::noncopyable {
 private:
@@ -45,9 +69,9 @@ private:
 		chunk_link* next{nullptr};
 	};
 
-	class pool : private boost::noncopyable {
+	class pool final : public reclaimable, private boost::noncopyable {
 	public:
-		explicit pool(std::size_t size) : m_size{size} {}
+		explicit pool(std::size_t size, allocator_pool_mode mode);
 		~pool();
 
 		/** @brief allocate object from (possible nullptr) pool */
@@ -59,9 +83,41 @@ private:
 			return m_size;
 		}
 
+		allocator_pool_mode mode() const {
+			return m_mode;
+		}
+
+		std::size_t reclaim(pressure_level level) override;
+
+		/** @brief number of cached entries (approximate in owned mode) */
+		std::size_t cached() const;
+
 	private:
+		struct free_entries {
+			// no default member initializers: synchronized<> needs to see
+			// it default constructible while the pool is still incomplete
+			free_entries() : front(nullptr), count(0) {}
+
+			chunk_link* front;
+			std::size_t count;
+		};
+
+		void free_list(chunk_link* list);
+		std::size_t trim(free_entries& entries, pressure_level level);
+		void trim_local();
+		char* allocate_owned();
+		void deallocate_owned(chunk_link* elem);
+
 		const std::size_t m_size{0};
-		caney::synchronized<chunk_link*> m_front{nullptr};
+		const allocator_pool_mode m_mode{allocator_pool_mode::shared};
+		// allocator_pool_mode::shared
+		caney::synchronized<free_entries> m_shared;
+		// allocator_pool_mode::owned
+		const std::thread::id m_owner;
+		free_entries m_local; // only accessed by owner
+		std::atomic<std::size_t> m_local_count{0}; // copy of m_local.count for cached()
+		std::atomic<chunk_link*> m_remote{nullptr};
+		std::atomic<pressure_level> m_local_trim{pressure_level::none}; // requested by reclaim()
 	};
 
 	class allocator_base {
@@ -138,8 +194,10 @@ public:
 	/**
 	 * @brief initialize @ref allocator_pool
 	 * @param size the size of objects the pool should cache allocations for
+	 * @param mode how to synchronize access to the cache; with
+	 *     @ref allocator_pool_mode::owned the calling thread becomes the owner
 	 */
-	explicit allocator_pool(std::size_t size);
+	explicit allocator_pool(std::size_t size, allocator_pool_mode mode = allocator_pool_mode::shared);
 
 	/**
 	 * @brief return the object size the pool caches allocation for
@@ -147,6 +205,11 @@ public:
 	 */
 	std::size_t size() const;
 
+	/**
+	 * @brief return the mode the pool was created with
+	 */
+	allocator_pool_mode mode() const;
+
 	/**
 	 * @brief create an allocator for the pool; you need to rebind it to a
 	 * specific value_type to actually use it.
@@ -155,6 +218,25 @@ public:
 	 */
 	allocator<void> alloc() const;
 
+	/**
+	 * @brief release cached allocations
+	 * @param level @ref pressure_level::moderate releases half of the cache,
+	 *     @ref pressure_level::critical all of it
+	 * @return number of bytes released (in owned mode the owner might
+	 *     release more later)
+	 */
+	std::size_t reclaim(pressure_level level);
+
+	/**
+	 * @brief number of allocations currently cached (approximate in owned mode)
+	 */
+	std::size_t cached() const;
+
+	/**
+	 * @brief weak reference to the pool to register in a @ref reclaim_registry
+	 */
+	std::weak_ptr<reclaimable> as_reclaimable() const;
+
 private:
 	std::shared_ptr<pool> m_pool;
 };
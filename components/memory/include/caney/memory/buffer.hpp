@@ -1,5 +1,6 @@
 #pragma once
 
+#include "byte_view.hpp"
 #include "const_buf.hpp"
 #include "mutable_buf.hpp"
 #include "shared_const_buf.hpp"
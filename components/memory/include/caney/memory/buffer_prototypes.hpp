@@ -11,6 +11,7 @@ namespace boost {
 
 __CANEY_MEMORYV1_BEGIN
 
+class byte_view;
 class const_buf;
 class shared_const_buf;
 class raw_const_buf;
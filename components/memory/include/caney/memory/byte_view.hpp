@@ -0,0 +1,147 @@
+/** @file */
+
+#pragma once
+
+#include "const_buf.hpp"
+#include "mutable_buf.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+__CANEY_MEMORYV1_BEGIN
+
+/**
+ * @brief non-owning, read-only view of a contiguous byte range
+ *
+ * Unlike @ref const_buf this has no virtual methods: it is trivially
+ * copyable and only holds a pointer and a size, so it can be passed by
+ * value in registers. Use it for parameters of parsers and checksum /
+ * hash kernels; the caller has to keep the data alive.
+ *
+ * All buffer types convert implicitly to a @ref byte_view; use
+ * @ref raw() to get a @ref raw_const_buf back.
+ */
+class byte_view {
+public:
+	/**
+	 * @{
+	 * @brief standard container typedef
+	 */
+	typedef unsigned char const* iterator;
+	typedef unsigned char const* const_iterator;
+	typedef unsigned char value_type;
+	typedef size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+	/** @} */
+
+	/** @brief empty view */
+	constexpr byte_view() noexcept = default;
+
+	/** @brief view of raw memory */
+	constexpr byte_view(unsigned char const* data, std::size_t size) noexcept : m_data(data), m_size(size) {}
+
+	/** @brief view of raw memory */
+	byte_view(char const* data, std::size_t size) noexcept : m_data(reinterpret_cast<unsigned char const*>(data)), m_size(size) {}
+
+	/** @brief view of the data in a buffer (doesn't keep the buffer alive) */
+	byte_view(const_buf const& buf) noexcept : m_data(buf.data()), m_size(buf.size()) {}
+
+	/** @brief view of the data in a buffer (doesn't keep the buffer alive) */
+	byte_view(mutable_buf const& buf) noexcept : m_data(buf.data()), m_size(buf.size()) {}
+
+	/** @brief size of view (length in bytes) */
+	constexpr std::size_t size() const noexcept {
+		return m_size;
+	}
+
+	/** @brief whether view is empty (i.e. zero length) */
+	constexpr bool empty() const noexcept {
+		return 0 == m_size;
+	}
+
+	/** @brief pointer to first byte of data */
+	constexpr unsigned char const* data() const noexcept {
+		return m_data;
+	}
+
+	/**
+	 @{
+	 * @brief standard iterator getter
+	 */
+	constexpr const_iterator begin() const noexcept {
+		return m_data;
+	}
+	constexpr const_iterator end() const noexcept {
+		return m_data + m_size;
+	}
+	constexpr const_iterator cbegin() const noexcept {
+		return m_data;
+	}
+	constexpr const_iterator cend() const noexcept {
+		return m_data + m_size;
+	}
+	/** @} */
+
+	/** @brief similar to begin() but for `char` access */
+	char const* char_begin() const noexcept {
+		return reinterpret_cast<char const*>(m_data);
+	}
+
+	/** @brief similar to end() but for `char` access */
+	char const* char_end() const noexcept {
+		return reinterpret_cast<char const*>(m_data) + m_size;
+	}
+
+	/**
+	 * @brief return byte value at position `ndx` (terminates if range
+	 *     check fails)
+	 */
+	unsigned char operator[](std::size_t ndx) const {
+		if (ndx >= m_size) std::terminate();
+		return m_data[ndx];
+	}
+
+	/**
+	 * @brief view of a part of the data
+	 *
+	 * @param from index of first byte (gets range clipped)
+	 * @param size length of the slice (gets range clipped)
+	 */
+	byte_view slice(std::size_t from, std::size_t size) const noexcept {
+		from = std::min(from, m_size);
+		return byte_view(m_data + from, std::min(m_size - from, size));
+	}
+
+	/** @brief alias for `slice(from, size())` */
+	byte_view slice(std::size_t from) const noexcept {
+		from = std::min(from, m_size);
+		return byte_view(m_data + from, m_size - from);
+	}
+
+	/** @brief drop first `n` bytes (terminates if `n > size()`) */
+	void remove_prefix(std::size_t n) {
+		if (n > m_size) std::terminate();
+		m_data += n;
+		m_size -= n;
+	}
+
+	/** @brief drop last `n` bytes (terminates if `n > size()`) */
+	void remove_suffix(std::size_t n) {
+		if (n > m_size) std::terminate();
+		m_size -= n;
+	}
+
+	/** @brief convert to @ref raw_const_buf */
+	raw_const_buf raw() const {
+		return raw_const_buf(m_data, m_size);
+	}
+
+private:
+	unsigned char const* m_data{nullptr};
+	std::size_t m_size{0};
+};
+
+static_assert(std::is_trivially_copyable<byte_view>::value, "byte_view must be trivially copyable");
+static_assert(sizeof(byte_view) == sizeof(void*) + sizeof(std::size_t), "byte_view must only contain pointer and size");
+
+__CANEY_MEMORYV1_END
@@ -23,8 +23,10 @@ public:
 	/**
 	 * @brief initialize pool
 	 * @param size size of buffers the pool will allocate
+	 * @param mode see @ref allocator_pool_mode; use @ref allocator_pool_mode::owned
+	 *     if buffers are allocated in one thread but might be released in others
 	 */
-	explicit intrusive_buffer_pool(std::size_t size) : m_pool(sizeof(buffer_t) + size) {}
+	explicit intrusive_buffer_pool(std::size_t size, allocator_pool_mode mode = allocator_pool_mode::shared) : m_pool(sizeof(buffer_t) + size, mode) {}
 
 	/**
 	 * @brief size of buffers this pool will allocate
@@ -41,8 +43,26 @@ public:
 		return buffer_t::allocate(m_pool.alloc(), size());
 	}
 
+	/**
+	 * @brief release cached buffers (see @ref allocator_pool::reclaim)
+	 * @return number of bytes released
+	 */
+	std::size_t reclaim(pressure_level level) {
+		return m_pool.reclaim(level);
+	}
+
+	/**
+	 * @brief weak reference to the pool to register in a @ref reclaim_registry
+	 */
+	std::weak_ptr<reclaimable> as_reclaimable() const {
+		return m_pool.as_reclaimable();
+	}
+
 private:
 	allocator_pool m_pool;
 };
 
+/** pointer to a buffer allocated from the default @ref intrusive_buffer_pool */
+using pooled_buffer_ptr = intrusive_buffer_pool<>::buffer_ptr_t;
+
 __CANEY_MEMORYV1_END
@@ -0,0 +1,204 @@
+/** @file */
+
+#pragma once
+
+#include "internal.hpp"
+#include "reclaimable.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/noncopyable.hpp>
+
+__CANEY_MEMORYV1_BEGIN
+
+/**
+ * @brief source for the current memory pressure (see @ref memory_pressure_watcher)
+ *
+ * Sources are only polled by one thread at a time.
+ */
+class pressure_source {
+public:
+	virtual ~pressure_source() = default;
+
+	/** @brief current pressure level */
+	virtual pressure_level poll() = 0;
+};
+
+/**
+ * @brief `avg10` percentages at which @ref psi_pressure_source reports pressure
+ */
+struct psi_thresholds {
+	double moderate_some{10.0}; //!< "some" tasks stalled this often: @ref pressure_level::moderate
+	double critical_full{5.0}; //!< "full" (all tasks) stalled this often: @ref pressure_level::critical
+};
+
+/**
+ * @brief usage ratios (relative to the limit) at which @ref cgroup_pressure_source reports pressure
+ */
+struct cgroup_thresholds {
+	double moderate_ratio{0.8}; //!< @ref pressure_level::moderate at this usage
+	double critical_ratio{0.95}; //!< @ref pressure_level::critical at this usage
+};
+
+/**
+ * @brief pressure source reading Linux PSI ("pressure stall information", `/proc/pressure/memory`)
+ *
+ * Uses the `avg10` values: the percentage of time in the last 10 seconds
+ * some (or all) tasks were stalled waiting for memory.
+ */
+class psi_pressure_source final : public pressure_source {
+public:
+	/** @brief thresholds type */
+	using thresholds = psi_thresholds;
+
+	/**
+	 * @param path path of the PSI file; cgroup v2 provides the same format in `memory.pressure`
+	 * @param limits thresholds for pressure levels
+	 */
+	explicit psi_pressure_source(std::string path = "/proc/pressure/memory", thresholds limits = thresholds());
+
+	/** @brief reports @ref pressure_level::none if the file can't be read */
+	pressure_level poll() override;
+
+	/** @brief whether PSI data can be read from `path` */
+	static bool is_available(std::string const& path = "/proc/pressure/memory");
+
+	/** @brief evaluate PSI file content */
+	static pressure_level parse(std::string const& content, thresholds limits = thresholds());
+
+private:
+	std::string const m_path;
+	thresholds const m_limits;
+};
+
+/**
+ * @brief pressure source reading cgroup v2 memory controller files
+ *
+ * Reports pressure if the `high`, `max` or `oom` counters in
+ * `memory.events` increased since the last poll, or if `memory.current`
+ * gets close to the limit in `memory.high` (or `memory.max`).
+ */
+class cgroup_pressure_source final : public pressure_source {
+public:
+	/** @brief thresholds type */
+	using thresholds = cgroup_thresholds;
+
+	/**
+	 * @param directory cgroup directory (usually the cgroup of the process,
+	 *     which is mounted at `/sys/fs/cgroup` inside containers)
+	 * @param limits thresholds for pressure levels
+	 */
+	explicit cgroup_pressure_source(std::string directory = "/sys/fs/cgroup", thresholds limits = thresholds());
+
+	/** @brief reports @ref pressure_level::none if no file can be read */
+	pressure_level poll() override;
+
+	/** @brief whether `directory` contains a cgroup v2 `memory.events` file */
+	static bool is_available(std::string const& directory = "/sys/fs/cgroup");
+
+private:
+	std::string const m_directory;
+	thresholds const m_limits;
+	std::uint64_t m_high_events{0};
+	std::uint64_t m_max_events{0};
+	bool m_have_events{false};
+};
+
+/**
+ * @brief pressure source to be set manually (useful for tests)
+ */
+class simulated_pressure_source final : public pressure_source {
+public:
+	/** @brief set level returned by the next @ref poll */
+	void set(pressure_level level) {
+		m_level.store(level, std::memory_order_relaxed);
+	}
+
+	pressure_level poll() override {
+		return m_level.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<pressure_level> m_level{pressure_level::none};
+};
+
+/**
+ * @brief polls a @ref pressure_source and shrinks registered caches under pressure
+ *
+ *     caney::memory::memory_pressure_watcher watcher(caney::memory::memory_pressure_watcher::system_source());
+ *     watcher.add(pool.as_reclaimable());
+ *     watcher.start(std::chrono::seconds(1));
+ *
+ * Either call @ref check regularly (e.g. from a timer in an event loop) or
+ * let @ref start run a background thread.
+ */
+class memory_pressure_watcher : private boost::noncopyable {
+public:
+	/** @param source pressure source; without source no pressure is ever reported */
+	explicit memory_pressure_watcher(std::unique_ptr<pressure_source> source);
+	~memory_pressure_watcher();
+
+	/**
+	 * @brief detect pressure source of the system: PSI if available,
+	 *     otherwise the cgroup v2 memory controller; nullptr if neither
+	 *     is available
+	 */
+	static std::unique_ptr<pressure_source> system_source();
+
+	/** @brief register cache to shrink under pressure */
+	void add(std::weak_ptr<reclaimable> entry);
+
+	/** @brief registered caches */
+	reclaim_registry& registry() {
+		return m_registry;
+	}
+
+	/**
+	 * @brief poll pressure source and reclaim memory if under pressure
+	 * @return current pressure level
+	 */
+	pressure_level check();
+
+	/** @brief level returned by the last @ref check */
+	pressure_level level() const {
+		return m_level.load(std::memory_order_relaxed);
+	}
+
+	/** @brief total number of bytes released by all checks */
+	std::size_t reclaimed() const {
+		return m_reclaimed.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief run @ref check every `interval` in a background thread
+	 *
+	 * Must not be called again without @ref stop in between.
+	 */
+	void start(std::chrono::milliseconds interval);
+
+	/** @brief stop background thread (if running) */
+	void stop();
+
+private:
+	void run(std::chrono::milliseconds interval);
+
+	std::unique_ptr<pressure_source> const m_source;
+	reclaim_registry m_registry;
+	std::mutex m_check_mutex;
+	std::atomic<pressure_level> m_level{pressure_level::none};
+	std::atomic<std::size_t> m_reclaimed{0};
+
+	std::mutex m_thread_mutex;
+	std::condition_variable m_thread_cond;
+	bool m_stopping{false};
+	std::thread m_thread;
+};
+
+__CANEY_MEMORYV1_END
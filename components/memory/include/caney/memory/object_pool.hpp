@@ -0,0 +1,351 @@
+/** @file */
+
+#pragma once
+
+#include "caney/std/synchronized.hpp"
+
+#include "intrusive_base.hpp"
+#include "internal.hpp"
+#include "reclaimable.hpp"
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+__CANEY_MEMORYV1_BEGIN
+
+/**
+ * @brief what @ref object_pool does with objects released to the pool
+ */
+enum class object_pool_mode {
+	destroy, //!< destruct objects when released; only the memory is reused
+	keep_constructed, //!< call `reset()` (if the object type has one) and keep the object constructed
+};
+
+namespace impl {
+	// detect `void T::reset()`
+	template <typename T, typename = void>
+	struct has_reset_hook : std::false_type {};
+
+	template <typename T>
+	struct has_reset_hook<T, decltype(std::declval<T&>().reset(), void())> : std::true_type {};
+
+	template <typename T>
+	void call_reset_hook(T* obj, std::true_type) {
+		obj->reset();
+	}
+
+	template <typename T>
+	void call_reset_hook(T*, std::false_type) {}
+} // namespace impl
+
+/**
+ * @brief pool of objects of type `Object` (derived from @ref intrusive_base)
+ *
+ * `Object` needs to use the pool allocator in its @ref intrusive_base:
+ *
+ *     class foo : public caney::memory::intrusive_base<foo, boost::thread_safe_counter, caney::memory::object_pool_allocator<foo>> {
+ *     public:
+ *         void reset(); // optional; called for object_pool_mode::keep_constructed
+ *     };
+ *
+ *     caney::memory::object_pool<foo> pool(caney::memory::object_pool_mode::keep_constructed);
+ *     pool.reserve(64);
+ *     boost::intrusive_ptr<foo> p = pool.create();
+ *
+ * When the last `boost::intrusive_ptr` to an object is released the
+ * object goes back to the pool instead of being deallocated; the next
+ * allocation of an `Object` through the pool allocator reuses it.
+ *
+ * With @ref object_pool_mode::keep_constructed released objects are not
+ * destructed; instead `reset()` is called. Reused objects are only
+ * constructed again if constructor arguments are passed (by destructing
+ * the old object first).
+ *
+ * Objects of other types (e.g. classes derived from `Object`) are
+ * allocated with `std::allocator`.
+ *
+ * Like @ref allocator_pool the allocators only keep a weak reference to
+ * the pool; if the pool is gone objects are simply freed.
+ *
+ * Available objects can be released with @ref reclaim (e.g. under
+ * memory pressure, see @ref as_reclaimable).
+ */
+template <typename Object>
+class object_pool : private boost::noncopyable {
+private:
+	class pool final : public reclaimable, private boost::noncopyable {
+	public:
+		explicit pool(object_pool_mode mode) : m_mode(mode) {}
+
+		~pool() {
+			auto free = m_free.synchronize();
+			for (Object* obj : *free) release_storage(obj);
+		}
+
+		object_pool_mode mode() const {
+			return m_mode;
+		}
+
+		// nullptr if freelist is empty
+		Object* pop() {
+			auto free = m_free.synchronize();
+			if (free->empty()) return nullptr;
+			Object* obj = free->back();
+			free->pop_back();
+			return obj;
+		}
+
+		void push(Object* obj) {
+			m_free.synchronize()->push_back(obj);
+		}
+
+		std::size_t size() const {
+			return m_free.shared_synchronize()->size();
+		}
+
+		void reserve(std::size_t count) {
+			std::vector<Object*> objects;
+			objects.reserve(count);
+			try {
+				for (std::size_t i = 0; i < count; ++i) objects.push_back(make_storage());
+			} catch (...) {
+				for (Object* obj : objects) release_storage(obj);
+				throw;
+			}
+			auto free = m_free.synchronize();
+			free->insert(free->end(), objects.begin(), objects.end());
+		}
+
+		std::size_t reclaim(pressure_level level) override {
+			if (pressure_level::none == level) return 0;
+			std::vector<Object*> released;
+			{
+				auto free = m_free.synchronize();
+				// the front of the freelist was used least recently
+				auto const drop = static_cast<std::ptrdiff_t>(pressure_level::moderate == level ? free->size() - free->size() / 2 : free->size());
+				released.assign(free->begin(), free->begin() + drop);
+				free->erase(free->begin(), free->begin() + drop);
+				if (free->empty()) free->shrink_to_fit();
+			}
+			// destruct outside the lock
+			for (Object* obj : released) release_storage(obj);
+			return released.size() * sizeof(Object);
+		}
+
+	private:
+		Object* make_storage() {
+			Object* obj = std::allocator<Object>().allocate(1);
+			if (object_pool_mode::keep_constructed == m_mode) {
+				try {
+					::new (static_cast<void*>(obj)) Object();
+				} catch (...) {
+					std::allocator<Object>().deallocate(obj, 1);
+					throw;
+				}
+			}
+			return obj;
+		}
+
+		void release_storage(Object* obj) {
+			if (object_pool_mode::keep_constructed == m_mode) obj->~Object();
+			std::allocator<Object>().deallocate(obj, 1);
+		}
+
+		object_pool_mode const m_mode;
+		caney::synchronized<std::vector<Object*>> m_free;
+	};
+
+public:
+	/**
+	 * @brief allocator implementing the C++ Allocator concept
+	 *
+	 * Usable with `std::allocator_traits`. Only allocations of a single
+	 * `Object` use the pool.
+	 */
+	template <typename Value>
+	class allocator {
+	public:
+		/** the object type to allocate (required by Allocator concept) */
+		typedef Value value_type;
+
+		/**
+		 * @brief internal constructor to create initial allocator instance from pool
+		 * @internal
+		 */
+		explicit allocator(std::weak_ptr<pool> p) : m_pool(std::move(p)) {}
+
+		/** @brief copy allocator (doesn't copy pending construct / destroy state) */
+		allocator(allocator const& other) : m_pool(other.m_pool) {}
+
+		/** @brief copy allocator (doesn't copy pending construct / destroy state) */
+		allocator& operator=(allocator const& other) {
+			m_pool = other.m_pool;
+			m_constructed = nullptr;
+			m_kept = nullptr;
+			return *this;
+		}
+
+		/**
+		 * @brief constructor to change value_type (required by Allocator concept for rebind)
+		 * @param other other constructor to share the pool from
+		 */
+		template <typename Other>
+		allocator(allocator<Other> const& other) : m_pool(other.m_pool) {}
+
+		/** @brief allocate `n` objects of type @ref value_type (required by Allocator concept) */
+		value_type* allocate(std::size_t n) {
+			if (is_pooled::value && 1 == n) {
+				if (std::shared_ptr<pool> p = m_pool.lock()) {
+					if (Object* obj = p->pop()) {
+						if (object_pool_mode::keep_constructed == p->mode()) m_constructed = obj;
+						return reinterpret_cast<value_type*>(obj);
+					}
+				}
+			}
+			return std::allocator<value_type>().allocate(n);
+		}
+
+		/** @brief free `n` objects of type @ref value_type (required by Allocator concept) */
+		void deallocate(value_type* obj, std::size_t n) {
+			if (is_pooled::value && 1 == n) {
+				void* const kept = m_kept;
+				m_kept = nullptr;
+				std::shared_ptr<pool> p = m_pool.lock();
+				if (p && (object_pool_mode::destroy == p->mode() || kept == obj)) {
+					p->push(reinterpret_cast<Object*>(obj));
+					return;
+				}
+				// pool is gone: really destroy objects `destroy()` kept alive
+				if (kept == obj) reinterpret_cast<Object*>(obj)->~Object();
+			}
+			std::allocator<value_type>().deallocate(obj, n);
+		}
+
+		/**
+		 * @brief construct object; a constructed object taken from a pool
+		 *     in @ref object_pool_mode::keep_constructed mode is only
+		 *     reconstructed if `args` are not empty.
+		 */
+		template <typename U, typename... Args>
+		void construct(U* obj, Args&&... args) {
+			if (nullptr != m_constructed && static_cast<void*>(obj) == m_constructed) {
+				m_constructed = nullptr;
+				if (0 == sizeof...(Args)) return;
+				obj->~U();
+			}
+			::new (static_cast<void*>(obj)) U(std::forward<Args>(args)...);
+		}
+
+		/**
+		 * @brief destroy object; in @ref object_pool_mode::keep_constructed
+		 *     mode `Object`s are only reset
+		 */
+		template <typename U>
+		void destroy(U* obj) {
+			if (std::is_same<U, Object>::value) {
+				std::shared_ptr<pool> p = m_pool.lock();
+				if (p && object_pool_mode::keep_constructed == p->mode()) {
+					impl::call_reset_hook(obj, impl::has_reset_hook<U>());
+					m_kept = obj;
+					return;
+				}
+			}
+			obj->~U();
+		}
+
+		/**
+		 * @{
+		 * @brief compare two allocators; all allocators of the same pool type are compatible
+		 */
+		template <typename Other>
+		friend bool operator==(allocator const&, allocator<Other> const&) {
+			return true;
+		}
+		template <typename Other>
+		friend bool operator!=(allocator const&, allocator<Other> const&) {
+			return false;
+		}
+		/** @} */
+
+	private:
+		using is_pooled = std::is_same<Value, Object>;
+
+		std::weak_ptr<pool> m_pool;
+		// object returned by allocate() which is still constructed
+		void* m_constructed{nullptr};
+		// object passed to destroy() which was only reset
+		void* m_kept{nullptr};
+
+		template <typename Other>
+		friend class allocator;
+	};
+
+	/**
+	 * @brief initialize empty pool
+	 * @param mode what to do with objects released to the pool
+	 */
+	explicit object_pool(object_pool_mode mode = object_pool_mode::destroy) : m_pool(std::make_shared<pool>(mode)) {}
+
+	/** @brief mode the pool was created with */
+	object_pool_mode mode() const {
+		return m_pool->mode();
+	}
+
+	/** @brief number of objects (or memory slots) available for reuse */
+	std::size_t available() const {
+		return m_pool->size();
+	}
+
+	/**
+	 * @brief preallocate `count` objects; in
+	 *     @ref object_pool_mode::keep_constructed mode they are default
+	 *     constructed.
+	 */
+	void reserve(std::size_t count) {
+		m_pool->reserve(count);
+	}
+
+	/**
+	 * @brief release available objects
+	 * @param level @ref pressure_level::moderate releases half of them,
+	 *     @ref pressure_level::critical all
+	 * @return number of bytes released
+	 */
+	std::size_t reclaim(pressure_level level) {
+		return m_pool->reclaim(level);
+	}
+
+	/**
+	 * @brief weak reference to the pool to register in a @ref reclaim_registry
+	 */
+	std::weak_ptr<reclaimable> as_reclaimable() const {
+		return m_pool;
+	}
+
+	/**
+	 * @brief create an allocator for the pool; pass it to
+	 *     @ref allocate_intrusive
+	 */
+	allocator<void> alloc() const {
+		return allocator<void>(m_pool);
+	}
+
+	/** @brief allocate an object from the pool */
+	template <typename... Args>
+	boost::intrusive_ptr<Object> create(Args&&... args) const {
+		return allocate_intrusive<Object>(alloc(), std::forward<Args>(args)...);
+	}
+
+private:
+	std::shared_ptr<pool> m_pool;
+};
+
+/** @brief allocator type to use in the @ref intrusive_base of `Object` to use @ref object_pool */
+template <typename Object>
+using object_pool_allocator = typename object_pool<Object>::template allocator<void>;
+
+__CANEY_MEMORYV1_END
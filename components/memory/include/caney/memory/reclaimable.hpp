@@ -0,0 +1,68 @@
+/** @file */
+
+#pragma once
+
+#include "caney/std/synchronized.hpp"
+
+#include "internal.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+__CANEY_MEMORYV1_BEGIN
+
+/**
+ * @brief how urgently memory should be released
+ */
+enum class pressure_level {
+	none, //!< no pressure; nothing to release
+	moderate, //!< release (at least) half of the cached memory
+	critical, //!< release all cached memory
+};
+
+/**
+ * @brief interface for caches (pools) which can release cached memory on demand
+ *
+ * Usually registered (by weak reference) in a @ref reclaim_registry;
+ * @ref reclaim may be called from any thread.
+ */
+class reclaimable {
+public:
+	virtual ~reclaimable() = default;
+
+	/**
+	 * @brief release cached memory
+	 * @param level how much memory to release
+	 * @return (approximate) number of bytes released
+	 */
+	virtual std::size_t reclaim(pressure_level level) = 0;
+};
+
+/**
+ * @brief collection of weak references to @ref reclaimable objects
+ *
+ * Entries don't need to be removed explicitly; expired entries get
+ * dropped on the next @ref reclaim.
+ */
+class reclaim_registry : private boost::noncopyable {
+public:
+	/** @brief register a cache */
+	void add(std::weak_ptr<reclaimable> entry);
+
+	/**
+	 * @brief call @ref reclaimable::reclaim on all (still alive) registered caches
+	 * @return sum of bytes released
+	 */
+	std::size_t reclaim(pressure_level level);
+
+	/** @brief number of registered entries (including expired ones not dropped yet) */
+	std::size_t size() const;
+
+private:
+	caney::synchronized<std::vector<std::weak_ptr<reclaimable>>> m_entries;
+};
+
+__CANEY_MEMORYV1_END
@@ -4,6 +4,7 @@
 
 #include "const_buf.hpp"
 #include "intrusive_buffer.hpp"
+#include "intrusive_buffer_pool.hpp"
 
 #include <memory>
 
@@ -19,7 +20,7 @@ __CANEY_MEMORYV1_BEGIN
 class shared_const_buf final : public const_buf {
 public:
 	/** @brief various underlying types that can keep a buffer alive */
-	typedef boost::variant<std::shared_ptr<void>, intrusive_buffer_ptr> storage_t;
+	typedef boost::variant<std::shared_ptr<void>, intrusive_buffer_ptr, pooled_buffer_ptr> storage_t;
 
 	/** @brief default construct empty buffer */
 	explicit shared_const_buf() = default;
@@ -3,7 +3,9 @@
 #pragma once
 
 #include "intrusive_buffer.hpp"
+#include "intrusive_buffer_pool.hpp"
 #include "mutable_buf.hpp"
+#include "shared_const_buf.hpp"
 
 #include <memory>
 
@@ -49,6 +51,12 @@ public:
 	 */
 	static unique_buf allocate(std::size_t size);
 
+	/**
+	 * @brief allocate new buffer from pool; the memory returns to the
+	 *     pool when the buffer (and all buffers frozen from it) are gone
+	 */
+	static unique_buf allocate(intrusive_buffer_pool<>& pool);
+
 	/**
 	 * @brief create new buffer and copy given data to it
 	 */
@@ -91,8 +99,9 @@ public:
 
 private:
 	explicit unique_buf(intrusive_buffer_ptr buffer);
+	explicit unique_buf(pooled_buffer_ptr buffer);
 
-	intrusive_buffer_ptr m_storage;
+	shared_const_buf::storage_t m_storage;
 };
 
 __CANEY_MEMORYV1_END
@@ -12,12 +12,107 @@ namespace {
 	}
 } // anonymous namespace
 
+allocator_pool::pool::pool(std::size_t size, allocator_pool_mode mode)
+: m_size{size}, m_mode{mode}, m_owner{allocator_pool_mode::owned == mode ? std::this_thread::get_id() : std::thread::id()} {}
+
 allocator_pool::pool::~pool() {
-	auto front = m_front.synchronize();
-	while (nullptr != *front) {
-		chunk_link* elem = *front;
-		*front = elem->next;
+	// the last reference might be dropped in any thread, but then no one else can access the lists anymore
+	free_list(m_shared.synchronize()->front);
+	free_list(m_local.front);
+	free_list(m_remote.load(std::memory_order_acquire));
+}
+
+void allocator_pool::pool::free_list(chunk_link* list) {
+	while (nullptr != list) {
+		chunk_link* elem = list;
+		list = elem->next;
+		mem_free(reinterpret_cast<char*>(elem), m_size);
+	}
+}
+
+std::size_t allocator_pool::pool::trim(free_entries& entries, pressure_level level) {
+	std::size_t const keep = (pressure_level::moderate == level) ? entries.count / 2 : 0;
+	std::size_t released = 0;
+	while (entries.count > keep) {
+		chunk_link* elem = entries.front;
+		entries.front = elem->next;
+		--entries.count;
 		mem_free(reinterpret_cast<char*>(elem), m_size);
+		released += m_size;
+	}
+	return released;
+}
+
+void allocator_pool::pool::trim_local() {
+	pressure_level const level = m_local_trim.exchange(pressure_level::none, std::memory_order_relaxed);
+	if (pressure_level::none == level) return;
+	trim(m_local, level);
+	m_local_count.store(m_local.count, std::memory_order_relaxed);
+}
+
+std::size_t allocator_pool::pool::reclaim(pressure_level level) {
+	if (pressure_level::none == level) return 0;
+
+	if (allocator_pool_mode::shared == m_mode) {
+		return trim(*m_shared.synchronize(), level);
+	}
+
+	// the inbox isn't used by the owner until its cache runs empty: release all of it
+	std::size_t released = 0;
+	chunk_link* inbox = m_remote.exchange(nullptr, std::memory_order_acquire);
+	while (nullptr != inbox) {
+		chunk_link* elem = inbox;
+		inbox = elem->next;
+		mem_free(reinterpret_cast<char*>(elem), m_size);
+		released += m_size;
+	}
+
+	// only the owner may touch its cache
+	pressure_level requested = m_local_trim.load(std::memory_order_relaxed);
+	while (requested < level && !m_local_trim.compare_exchange_weak(requested, level, std::memory_order_relaxed)) {
+	}
+	if (std::this_thread::get_id() == m_owner) {
+		std::size_t const before = m_local.count;
+		trim_local();
+		released += (before - m_local.count) * m_size;
+	}
+	return released;
+}
+
+std::size_t allocator_pool::pool::cached() const {
+	if (allocator_pool_mode::shared == m_mode) return m_shared.shared_synchronize()->count;
+	return m_local_count.load(std::memory_order_relaxed);
+}
+
+char* allocator_pool::pool::allocate_owned() {
+	if (pressure_level::none != m_local_trim.load(std::memory_order_relaxed)) trim_local();
+	if (nullptr == m_local.front) {
+		// take all remote frees at once
+		chunk_link* inbox = m_remote.exchange(nullptr, std::memory_order_acquire);
+		if (nullptr == inbox) return nullptr;
+		m_local.front = inbox;
+		m_local.count = 0;
+		for (chunk_link* elem = inbox; nullptr != elem; elem = elem->next) ++m_local.count;
+	}
+	chunk_link* elem = m_local.front;
+	m_local.front = elem->next;
+	--m_local.count;
+	m_local_count.store(m_local.count, std::memory_order_relaxed);
+	return reinterpret_cast<char*>(elem);
+}
+
+void allocator_pool::pool::deallocate_owned(chunk_link* elem) {
+	if (std::this_thread::get_id() == m_owner) {
+		elem->next = m_local.front;
+		m_local.front = elem;
+		++m_local.count;
+		m_local_count.store(m_local.count, std::memory_order_relaxed);
+		if (pressure_level::none != m_local_trim.load(std::memory_order_relaxed)) trim_local();
+	} else {
+		chunk_link* head = m_remote.load(std::memory_order_relaxed);
+		do {
+			elem->next = head;
+		} while (!m_remote.compare_exchange_weak(head, elem, std::memory_order_release, std::memory_order_relaxed));
 	}
 }
 
@@ -26,10 +121,18 @@ char* allocator_pool::pool::allocate(pool* p, std::size_t n) {
 	n = std::max(n, sizeof(chunk_link));
 
 	if (nullptr != p && p->m_size == n) {
-		auto front = p->m_front.synchronize();
-		if (nullptr != *front) {
-			chunk_link* elem = *front;
-			*front = elem->next;
+		if (allocator_pool_mode::owned == p->m_mode) {
+			// other threads don't allocate from the cache
+			if (std::this_thread::get_id() == p->m_owner) {
+				if (char* obj = p->allocate_owned()) return obj;
+			}
+			return mem_alloc(n);
+		}
+		auto shared = p->m_shared.synchronize();
+		if (nullptr != shared->front) {
+			chunk_link* elem = shared->front;
+			shared->front = elem->next;
+			--shared->count;
 			return reinterpret_cast<char*>(elem);
 		}
 	}
@@ -42,24 +145,45 @@ void allocator_pool::pool::deallocate(pool* p, char* obj, std::size_t n) {
 
 	if (nullptr != p && p->m_size == n) {
 		chunk_link* elem = reinterpret_cast<chunk_link*>(obj);
-		auto front = p->m_front.synchronize();
-		elem->next = *front;
-		*front = elem;
+		if (allocator_pool_mode::owned == p->m_mode) {
+			p->deallocate_owned(elem);
+			return;
+		}
+		auto shared = p->m_shared.synchronize();
+		elem->next = shared->front;
+		shared->front = elem;
+		++shared->count;
 	} else {
 		mem_free(obj, n);
 	}
 }
 
-allocator_pool::allocator_pool(std::size_t size) {
-	m_pool = std::make_shared<pool>(size);
+allocator_pool::allocator_pool(std::size_t size, allocator_pool_mode mode) {
+	m_pool = std::make_shared<pool>(size, mode);
 }
 
 std::size_t allocator_pool::size() const {
 	return m_pool->size();
 }
 
+allocator_pool_mode allocator_pool::mode() const {
+	return m_pool->mode();
+}
+
 allocator_pool::allocator<void> allocator_pool::alloc() const {
 	return allocator<void>(allocator_base(m_pool));
 }
 
+std::size_t allocator_pool::reclaim(pressure_level level) {
+	return m_pool->reclaim(level);
+}
+
+std::size_t allocator_pool::cached() const {
+	return m_pool->cached();
+}
+
+std::weak_ptr<reclaimable> allocator_pool::as_reclaimable() const {
+	return m_pool;
+}
+
 __CANEY_MEMORYV1_END
@@ -0,0 +1,191 @@
+#include "caney/memory/memory_pressure.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+__CANEY_MEMORYV1_BEGIN
+
+namespace {
+	bool read_file(std::string const& path, std::string& content) {
+		std::ifstream file(path);
+		if (!file) return false;
+		std::ostringstream buf;
+		buf << file.rdbuf();
+		if (file.bad()) return false;
+		content = buf.str();
+		return true;
+	}
+
+	// read single number; "max" (no limit) is returned as max uint64
+	bool read_limit(std::string const& path, std::uint64_t& value) {
+		std::string content;
+		if (!read_file(path, content)) return false;
+		if (0 == content.compare(0, 3, "max")) {
+			value = std::numeric_limits<std::uint64_t>::max();
+			return true;
+		}
+		char* end = nullptr;
+		value = std::strtoull(content.c_str(), &end, 10);
+		return end != content.c_str();
+	}
+
+	// value of "<key> <value>" line in flat keyed files like memory.events
+	std::uint64_t keyed_value(std::string const& content, std::string const& key) {
+		std::istringstream lines(content);
+		std::string name;
+		std::uint64_t value = 0;
+		while (lines >> name >> value) {
+			if (name == key) return value;
+		}
+		return 0;
+	}
+
+	pressure_level max_level(pressure_level a, pressure_level b) {
+		return a < b ? b : a;
+	}
+} // anonymous namespace
+
+psi_pressure_source::psi_pressure_source(std::string path, thresholds limits) : m_path(std::move(path)), m_limits(limits) {}
+
+pressure_level psi_pressure_source::poll() {
+	std::string content;
+	if (!read_file(m_path, content)) return pressure_level::none;
+	return parse(content, m_limits);
+}
+
+// static
+bool psi_pressure_source::is_available(std::string const& path) {
+	std::string content;
+	return read_file(path, content) && std::string::npos != content.find("avg10=");
+}
+
+// static
+pressure_level psi_pressure_source::parse(std::string const& content, thresholds limits) {
+	// lines: "some avg10=0.00 avg60=0.00 avg300=0.00 total=0", same for "full"
+	pressure_level level = pressure_level::none;
+	std::istringstream lines(content);
+	std::string line;
+	while (std::getline(lines, line)) {
+		std::string::size_type const pos = line.find(" avg10=");
+		if (std::string::npos == pos) continue;
+		double const avg10 = std::strtod(line.c_str() + pos + 7, nullptr);
+		if (0 == line.compare(0, pos, "some") && avg10 >= limits.moderate_some) {
+			level = max_level(level, pressure_level::moderate);
+		} else if (0 == line.compare(0, pos, "full") && avg10 >= limits.critical_full) {
+			level = max_level(level, pressure_level::critical);
+		}
+	}
+	return level;
+}
+
+cgroup_pressure_source::cgroup_pressure_source(std::string directory, thresholds limits) : m_directory(std::move(directory)), m_limits(limits) {}
+
+pressure_level cgroup_pressure_source::poll() {
+	pressure_level level = pressure_level::none;
+
+	std::string events;
+	if (read_file(m_directory + "/memory.events", events)) {
+		std::uint64_t const high = keyed_value(events, "high");
+		std::uint64_t const max = keyed_value(events, "max") + keyed_value(events, "oom");
+		if (m_have_events) {
+			if (max > m_max_events) {
+				level = pressure_level::critical;
+			} else if (high > m_high_events) {
+				level = pressure_level::moderate;
+			}
+		}
+		m_high_events = high;
+		m_max_events = max;
+		m_have_events = true;
+	}
+
+	std::uint64_t current = 0;
+	std::uint64_t high = std::numeric_limits<std::uint64_t>::max();
+	std::uint64_t max = std::numeric_limits<std::uint64_t>::max();
+	if (read_limit(m_directory + "/memory.current", current)) {
+		read_limit(m_directory + "/memory.high", high);
+		read_limit(m_directory + "/memory.max", max);
+		std::uint64_t const limit = std::min(high, max);
+		if (limit != std::numeric_limits<std::uint64_t>::max() && limit > 0) {
+			double const ratio = static_cast<double>(current) / static_cast<double>(limit);
+			if (ratio >= m_limits.critical_ratio) {
+				level = max_level(level, pressure_level::critical);
+			} else if (ratio >= m_limits.moderate_ratio) {
+				level = max_level(level, pressure_level::moderate);
+			}
+		}
+	}
+
+	return level;
+}
+
+// static
+bool cgroup_pressure_source::is_available(std::string const& directory) {
+	std::string content;
+	return read_file(directory + "/memory.events", content);
+}
+
+memory_pressure_watcher::memory_pressure_watcher(std::unique_ptr<pressure_source> source) : m_source(std::move(source)) {}
+
+memory_pressure_watcher::~memory_pressure_watcher() {
+	stop();
+}
+
+// static
+std::unique_ptr<pressure_source> memory_pressure_watcher::system_source() {
+	if (psi_pressure_source::is_available()) return std::unique_ptr<pressure_source>(new psi_pressure_source());
+	if (cgroup_pressure_source::is_available()) return std::unique_ptr<pressure_source>(new cgroup_pressure_source());
+	return nullptr;
+}
+
+void memory_pressure_watcher::add(std::weak_ptr<reclaimable> entry) {
+	m_registry.add(std::move(entry));
+}
+
+pressure_level memory_pressure_watcher::check() {
+	pressure_level level = pressure_level::none;
+	{
+		std::lock_guard<std::mutex> lock(m_check_mutex);
+		if (m_source) level = m_source->poll();
+	}
+	m_level.store(level, std::memory_order_relaxed);
+	if (pressure_level::none != level) {
+		m_reclaimed.fetch_add(m_registry.reclaim(level), std::memory_order_relaxed);
+	}
+	return level;
+}
+
+void memory_pressure_watcher::start(std::chrono::milliseconds interval) {
+	if (m_thread.joinable()) std::terminate();
+	{
+		std::lock_guard<std::mutex> lock(m_thread_mutex);
+		m_stopping = false;
+	}
+	m_thread = std::thread([this, interval]() { run(interval); });
+}
+
+void memory_pressure_watcher::stop() {
+	if (!m_thread.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(m_thread_mutex);
+		m_stopping = true;
+	}
+	m_thread_cond.notify_all();
+	m_thread.join();
+}
+
+void memory_pressure_watcher::run(std::chrono::milliseconds interval) {
+	std::unique_lock<std::mutex> lock(m_thread_mutex);
+	while (!m_stopping) {
+		lock.unlock();
+		check();
+		lock.lock();
+		m_thread_cond.wait_for(lock, interval, [this]() { return m_stopping; });
+	}
+}
+
+__CANEY_MEMORYV1_END
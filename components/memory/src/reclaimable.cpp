@@ -0,0 +1,36 @@
+#include "caney/memory/reclaimable.hpp"
+
+__CANEY_MEMORYV1_BEGIN
+
+void reclaim_registry::add(std::weak_ptr<reclaimable> entry) {
+	m_entries.synchronize()->push_back(std::move(entry));
+}
+
+std::size_t reclaim_registry::reclaim(pressure_level level) {
+	if (pressure_level::none == level) return 0;
+
+	// don't hold the lock while calling into the caches
+	std::vector<std::shared_ptr<reclaimable>> alive;
+	{
+		auto entries = m_entries.synchronize();
+		std::size_t keep = 0;
+		for (std::weak_ptr<reclaimable>& entry : *entries) {
+			if (std::shared_ptr<reclaimable> p = entry.lock()) {
+				alive.push_back(std::move(p));
+				if (&(*entries)[keep] != &entry) (*entries)[keep] = std::move(entry);
+				++keep;
+			}
+		}
+		entries->resize(keep);
+	}
+
+	std::size_t released = 0;
+	for (std::shared_ptr<reclaimable> const& p : alive) released += p->reclaim(level);
+	return released;
+}
+
+std::size_t reclaim_registry::size() const {
+	return m_entries.shared_synchronize()->size();
+}
+
+__CANEY_MEMORYV1_END
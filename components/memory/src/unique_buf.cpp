@@ -21,6 +21,12 @@ unique_buf unique_buf::allocate(std::size_t size) {
 	return unique_buf(intrusive_buffer::create(size));
 }
 
+/* static */
+unique_buf unique_buf::allocate(intrusive_buffer_pool<>& pool) {
+	if (0 == pool.size()) return unique_buf();
+	return unique_buf(pool.allocate());
+}
+
 /* static */
 unique_buf unique_buf::copy(unsigned char const* data, std::size_t size) {
 	if (0 == size) return unique_buf();
@@ -45,7 +51,7 @@ shared_const_buf unique_buf::freeze(std::size_t size) {
 
 shared_const_buf unique_buf::freeze() {
 	shared_const_buf result = shared_const_buf::unsafe_use(m_storage, raw_copy());
-	m_storage.reset();
+	m_storage = shared_const_buf::storage_t();
 	raw_reset();
 	return result;
 }
@@ -63,4 +69,7 @@ unique_buf unique_buf::slice(size_t from)&& {
 unique_buf::unique_buf(intrusive_buffer_ptr buffer)
 : mutable_buf(buffer ? buffer->data() : nullptr, buffer ? buffer->size() : 0), m_storage(std::move(buffer)) {}
 
+unique_buf::unique_buf(pooled_buffer_ptr buffer)
+: mutable_buf(buffer ? buffer->data() : nullptr, buffer ? buffer->size() : 0), m_storage(std::move(buffer)) {}
+
 __CANEY_MEMORYV1_END
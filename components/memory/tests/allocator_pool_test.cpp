@@ -0,0 +1,62 @@
+#include "caney/memory/allocator_pool.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+	struct entry {
+		char data[64];
+	};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(allocator_pool_test)
+
+BOOST_AUTO_TEST_CASE(shared_reuse) {
+	caney::memory::allocator_pool pool(sizeof(entry));
+	caney::memory::allocator_pool::allocator<entry> alloc(pool.alloc());
+	entry* e = alloc.allocate(1);
+	alloc.deallocate(e, 1);
+	BOOST_CHECK(alloc.allocate(1) == e);
+	alloc.deallocate(e, 1);
+}
+
+BOOST_AUTO_TEST_CASE(owned_remote_free) {
+	caney::memory::allocator_pool pool(sizeof(entry), caney::memory::allocator_pool_mode::owned);
+	BOOST_CHECK(caney::memory::allocator_pool_mode::owned == pool.mode());
+	caney::memory::allocator_pool::allocator<entry> alloc(pool.alloc());
+
+	std::vector<entry*> entries;
+	for (int i = 0; i < 16; ++i) entries.push_back(alloc.allocate(1));
+
+	// release on other threads; they end up in the remote inbox
+	std::thread t1([alloc, &entries]() mutable {
+		for (std::size_t i = 0; i < 8; ++i) alloc.deallocate(entries[i], 1);
+	});
+	std::thread t2([alloc, &entries]() mutable {
+		for (std::size_t i = 8; i < 16; ++i) alloc.deallocate(entries[i], 1);
+	});
+	t1.join();
+	t2.join();
+
+	// owner drains the inbox and reuses all entries
+	std::vector<entry*> reused;
+	for (int i = 0; i < 16; ++i) reused.push_back(alloc.allocate(1));
+	std::sort(entries.begin(), entries.end());
+	std::sort(reused.begin(), reused.end());
+	BOOST_CHECK(entries == reused);
+
+	// other threads don't take entries from the owner's cache
+	alloc.deallocate(reused[0], 1);
+	entry* foreign = nullptr;
+	std::thread t3([alloc, &foreign]() mutable { foreign = alloc.allocate(1); });
+	t3.join();
+	BOOST_CHECK(foreign != reused[0]);
+	alloc.deallocate(foreign, 1);
+
+	for (std::size_t i = 1; i < reused.size(); ++i) alloc.deallocate(reused[i], 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,44 @@
+#include "caney/memory/buffer.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(byte_view_test)
+
+BOOST_AUTO_TEST_CASE(conversions) {
+	std::string const data("hello world");
+	caney::memory::raw_const_buf const raw(data);
+	caney::memory::byte_view view = raw;
+	BOOST_CHECK(view.data() == raw.data());
+	BOOST_CHECK_EQUAL(view.size(), raw.size());
+
+	caney::memory::shared_const_buf const shared = caney::memory::shared_const_buf::copy(data);
+	view = shared;
+	BOOST_CHECK(view.data() == shared.data());
+
+	caney::memory::unique_buf unique = caney::memory::unique_buf::copy(data.data(), data.size());
+	view = unique;
+	BOOST_CHECK(view.data() == unique.data());
+	BOOST_CHECK_EQUAL(view.size(), data.size());
+
+	caney::memory::raw_const_buf const back = view.raw();
+	BOOST_CHECK(back.data() == unique.data());
+	BOOST_CHECK_EQUAL(back.size(), data.size());
+}
+
+BOOST_AUTO_TEST_CASE(slicing) {
+	caney::memory::byte_view view("0123456789", 10);
+	BOOST_CHECK_EQUAL(view[3], '3');
+	BOOST_CHECK_EQUAL(view.slice(2, 3).size(), 3u);
+	BOOST_CHECK_EQUAL(view.slice(2, 3)[0], '2');
+	BOOST_CHECK_EQUAL(view.slice(8, 5).size(), 2u);
+	BOOST_CHECK(view.slice(20).empty());
+
+	view.remove_prefix(4);
+	BOOST_CHECK_EQUAL(view[0], '4');
+	view.remove_suffix(4);
+	BOOST_CHECK_EQUAL(std::string(view.char_begin(), view.char_end()), "45");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
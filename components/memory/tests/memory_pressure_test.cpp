@@ -0,0 +1,176 @@
+#include "caney/memory/intrusive_buffer_pool.hpp"
+#include "caney/memory/memory_pressure.hpp"
+#include "caney/memory/object_pool.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace {
+	class pooled_object : public caney::memory::intrusive_base<pooled_object, boost::thread_safe_counter, caney::memory::object_pool_allocator<pooled_object>> {};
+
+	// fill allocator_pool with `count` cached entries
+	void fill_pool(caney::memory::allocator_pool& pool, std::size_t count) {
+		caney::memory::allocator_pool::allocator<char> alloc(pool.alloc());
+		std::vector<char*> entries;
+		for (std::size_t i = 0; i < count; ++i) entries.push_back(alloc.allocate(pool.size()));
+		for (char* entry : entries) alloc.deallocate(entry, pool.size());
+	}
+
+	class temp_dir {
+	public:
+		temp_dir() {
+			char name[] = "/tmp/caney-memory-pressure-XXXXXX";
+			if (nullptr == ::mkdtemp(name)) throw std::runtime_error("mkdtemp failed");
+			m_path = name;
+		}
+
+		~temp_dir() {
+			for (std::string const& file : m_files) std::remove(file.c_str());
+			::rmdir(m_path.c_str());
+		}
+
+		void write(std::string const& name, std::string const& content) {
+			std::string const file = m_path + "/" + name;
+			std::ofstream(file) << content;
+			m_files.push_back(file);
+		}
+
+		std::string const& path() const {
+			return m_path;
+		}
+
+	private:
+		std::string m_path;
+		std::vector<std::string> m_files;
+	};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(memory_pressure_test)
+
+BOOST_AUTO_TEST_CASE(allocator_pool_reclaim) {
+	caney::memory::allocator_pool pool(64);
+	fill_pool(pool, 8);
+	BOOST_CHECK_EQUAL(pool.cached(), 8u);
+	BOOST_CHECK_EQUAL(pool.reclaim(caney::memory::pressure_level::none), 0u);
+	BOOST_CHECK_EQUAL(pool.reclaim(caney::memory::pressure_level::moderate), 4u * 64u);
+	BOOST_CHECK_EQUAL(pool.cached(), 4u);
+	BOOST_CHECK_EQUAL(pool.reclaim(caney::memory::pressure_level::critical), 4u * 64u);
+	BOOST_CHECK_EQUAL(pool.cached(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(owned_allocator_pool_reclaim) {
+	caney::memory::allocator_pool pool(64, caney::memory::allocator_pool_mode::owned);
+	fill_pool(pool, 8);
+	BOOST_CHECK_EQUAL(pool.cached(), 8u);
+	// called in the owner thread: trims immediately
+	BOOST_CHECK_EQUAL(pool.reclaim(caney::memory::pressure_level::critical), 8u * 64u);
+	BOOST_CHECK_EQUAL(pool.cached(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(watcher_simulated_pressure) {
+	auto source = new caney::memory::simulated_pressure_source();
+	caney::memory::memory_pressure_watcher watcher{std::unique_ptr<caney::memory::pressure_source>(source)};
+
+	caney::memory::intrusive_buffer_pool<> buffers(1024);
+	caney::memory::object_pool<pooled_object> objects;
+	watcher.add(buffers.as_reclaimable());
+	watcher.add(objects.as_reclaimable());
+	{
+		// expired entries get dropped
+		caney::memory::allocator_pool temporary(32);
+		watcher.add(temporary.as_reclaimable());
+	}
+	BOOST_CHECK_EQUAL(watcher.registry().size(), 3u);
+
+	{
+		std::vector<caney::memory::intrusive_buffer_pool<>::buffer_ptr_t> held;
+		for (int i = 0; i < 4; ++i) held.push_back(buffers.allocate());
+	}
+	objects.reserve(4);
+
+	BOOST_CHECK(caney::memory::pressure_level::none == watcher.check());
+	BOOST_CHECK_EQUAL(watcher.reclaimed(), 0u);
+	BOOST_CHECK_EQUAL(objects.available(), 4u);
+
+	source->set(caney::memory::pressure_level::moderate);
+	BOOST_CHECK(caney::memory::pressure_level::moderate == watcher.check());
+	BOOST_CHECK_EQUAL(objects.available(), 2u);
+	BOOST_CHECK_EQUAL(watcher.registry().size(), 2u);
+	BOOST_CHECK(watcher.reclaimed() > 2 * 1024u);
+
+	source->set(caney::memory::pressure_level::critical);
+	watcher.check();
+	BOOST_CHECK_EQUAL(objects.available(), 0u);
+	BOOST_CHECK(caney::memory::pressure_level::critical == watcher.level());
+
+	// pool still works after reclaiming
+	BOOST_CHECK(objects.create());
+	BOOST_CHECK(buffers.allocate());
+}
+
+BOOST_AUTO_TEST_CASE(watcher_background_thread) {
+	auto source = new caney::memory::simulated_pressure_source();
+	caney::memory::memory_pressure_watcher watcher{std::unique_ptr<caney::memory::pressure_source>(source)};
+	caney::memory::allocator_pool pool(64);
+	fill_pool(pool, 4);
+	watcher.add(pool.as_reclaimable());
+
+	source->set(caney::memory::pressure_level::critical);
+	watcher.start(std::chrono::milliseconds(1));
+	for (int i = 0; i < 5000 && pool.cached() > 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	watcher.stop();
+	BOOST_CHECK_EQUAL(pool.cached(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(psi_parse) {
+	using caney::memory::psi_pressure_source;
+	std::string const idle = "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n";
+	std::string const some = "some avg10=12.50 avg60=3.00 avg300=1.00 total=1000\nfull avg10=1.00 avg60=0.00 avg300=0.00 total=10\n";
+	std::string const full = "some avg10=40.00 avg60=3.00 avg300=1.00 total=1000\nfull avg10=20.00 avg60=0.00 avg300=0.00 total=10\n";
+	BOOST_CHECK(caney::memory::pressure_level::none == psi_pressure_source::parse(idle));
+	BOOST_CHECK(caney::memory::pressure_level::moderate == psi_pressure_source::parse(some));
+	BOOST_CHECK(caney::memory::pressure_level::critical == psi_pressure_source::parse(full));
+
+	psi_pressure_source::thresholds strict;
+	strict.moderate_some = 50.0;
+	strict.critical_full = 50.0;
+	BOOST_CHECK(caney::memory::pressure_level::none == psi_pressure_source::parse(full, strict));
+
+	BOOST_CHECK(caney::memory::pressure_level::none == psi_pressure_source("/nonexistent/pressure").poll());
+}
+
+BOOST_AUTO_TEST_CASE(cgroup_source) {
+	temp_dir dir;
+	dir.write("memory.events", "low 0\nhigh 3\nmax 0\noom 0\noom_kill 0\n");
+	dir.write("memory.current", "100\n");
+	dir.write("memory.high", "max\n");
+	dir.write("memory.max", "1000\n");
+	BOOST_CHECK(caney::memory::cgroup_pressure_source::is_available(dir.path()));
+
+	caney::memory::cgroup_pressure_source source(dir.path());
+	BOOST_CHECK(caney::memory::pressure_level::none == source.poll());
+
+	dir.write("memory.events", "low 0\nhigh 4\nmax 0\noom 0\noom_kill 0\n");
+	BOOST_CHECK(caney::memory::pressure_level::moderate == source.poll());
+	BOOST_CHECK(caney::memory::pressure_level::none == source.poll());
+
+	dir.write("memory.events", "low 0\nhigh 4\nmax 1\noom 0\noom_kill 0\n");
+	BOOST_CHECK(caney::memory::pressure_level::critical == source.poll());
+
+	dir.write("memory.current", "850\n");
+	BOOST_CHECK(caney::memory::pressure_level::moderate == source.poll());
+	dir.write("memory.high", "800\n");
+	BOOST_CHECK(caney::memory::pressure_level::critical == source.poll());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
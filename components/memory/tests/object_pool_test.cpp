@@ -0,0 +1,103 @@
+#include "caney/memory/object_pool.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+namespace {
+	struct counters {
+		int constructed{0};
+		int destructed{0};
+		int reset{0};
+	};
+
+	counters g_counters;
+
+	class pooled_object : public caney::memory::intrusive_base<pooled_object, boost::thread_safe_counter, caney::memory::object_pool_allocator<pooled_object>> {
+	public:
+		pooled_object() {
+			++g_counters.constructed;
+		}
+
+		explicit pooled_object(std::string value) : m_value(std::move(value)) {
+			++g_counters.constructed;
+		}
+
+		~pooled_object() {
+			++g_counters.destructed;
+		}
+
+		void reset() {
+			++g_counters.reset;
+			m_value.clear();
+		}
+
+		std::string m_value;
+	};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(object_pool_test)
+
+BOOST_AUTO_TEST_CASE(destroy_mode) {
+	g_counters = counters();
+	caney::memory::object_pool<pooled_object> pool;
+	pooled_object* first_address;
+	{
+		boost::intrusive_ptr<pooled_object> p = pool.create("first");
+		first_address = p.get();
+		BOOST_CHECK_EQUAL(pool.available(), 0u);
+	}
+	BOOST_CHECK_EQUAL(g_counters.destructed, 1);
+	BOOST_CHECK_EQUAL(pool.available(), 1u);
+
+	boost::intrusive_ptr<pooled_object> p = pool.create("second");
+	BOOST_CHECK(p.get() == first_address);
+	BOOST_CHECK_EQUAL(p->m_value, "second");
+	BOOST_CHECK_EQUAL(g_counters.constructed, 2);
+	BOOST_CHECK_EQUAL(g_counters.reset, 0);
+}
+
+BOOST_AUTO_TEST_CASE(keep_constructed_mode) {
+	g_counters = counters();
+	{
+		caney::memory::object_pool<pooled_object> pool(caney::memory::object_pool_mode::keep_constructed);
+		pool.reserve(4);
+		BOOST_CHECK_EQUAL(pool.available(), 4u);
+		BOOST_CHECK_EQUAL(g_counters.constructed, 4);
+
+		{
+			boost::intrusive_ptr<pooled_object> a = pool.create();
+			boost::intrusive_ptr<pooled_object> b = pool.create();
+			a->m_value = "dirty";
+			BOOST_CHECK_EQUAL(pool.available(), 2u);
+		}
+		// released objects were only reset
+		BOOST_CHECK_EQUAL(pool.available(), 4u);
+		BOOST_CHECK_EQUAL(g_counters.constructed, 4);
+		BOOST_CHECK_EQUAL(g_counters.reset, 2);
+		BOOST_CHECK_EQUAL(g_counters.destructed, 0);
+
+		// arguments force a reconstruction
+		boost::intrusive_ptr<pooled_object> c = pool.create("value");
+		BOOST_CHECK_EQUAL(c->m_value, "value");
+		BOOST_CHECK_EQUAL(g_counters.constructed, 5);
+		BOOST_CHECK_EQUAL(g_counters.destructed, 1);
+	}
+	// pool is gone: all pooled objects got destructed
+	BOOST_CHECK_EQUAL(g_counters.constructed, g_counters.destructed);
+}
+
+BOOST_AUTO_TEST_CASE(pool_released_first) {
+	g_counters = counters();
+	boost::intrusive_ptr<pooled_object> p;
+	{
+		caney::memory::object_pool<pooled_object> pool(caney::memory::object_pool_mode::keep_constructed);
+		p = pool.create();
+	}
+	p.reset();
+	BOOST_CHECK_EQUAL(g_counters.constructed, 1);
+	BOOST_CHECK_EQUAL(g_counters.destructed, 1);
+	BOOST_CHECK_EQUAL(g_counters.reset, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,428 @@
+/** @file */
+
+#pragma once
+
+#include "internal.hpp"
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+__CANEY_STDV1_BEGIN
+
+/**
+ * @brief double-ended ring buffer which stores the first few elements inline
+ *
+ * Elements are appended at the back and removed from the front (or back);
+ * until more than `InlineCapacity` elements are stored at the same time no
+ * memory is allocated. After that the ring grows (doubling its capacity)
+ * in a single heap allocation, which is kept until the ring is destroyed,
+ * so a queue in steady state doesn't allocate at all.
+ *
+ * Iterators and references are invalidated by any insertion; removing
+ * elements only invalidates iterators and references to the removed
+ * elements.
+ *
+ * @tparam Value          element type
+ * @tparam InlineCapacity number of elements stored without heap allocation; must be a power of two
+ */
+template <typename Value, std::size_t InlineCapacity = 4>
+class small_ring {
+	static_assert(InlineCapacity > 0 && 0 == (InlineCapacity & (InlineCapacity - 1)), "InlineCapacity must be a power of two");
+
+public:
+	/** element type */
+	using value_type = Value;
+	/** size type */
+	using size_type = std::size_t;
+	/** difference type */
+	using difference_type = std::ptrdiff_t;
+	/** reference type */
+	using reference = value_type&;
+	/** const reference type */
+	using const_reference = value_type const&;
+
+	/** @brief random access iterator; `Const` selects a const_iterator */
+	template <bool Const>
+	class basic_iterator {
+	private:
+		using ring_t = typename std::conditional<Const, small_ring const, small_ring>::type;
+
+	public:
+		/** iterator category */
+		using iterator_category = std::random_access_iterator_tag;
+		/** element type */
+		using value_type = typename small_ring::value_type;
+		/** difference type */
+		using difference_type = typename small_ring::difference_type;
+		/** pointer type */
+		using pointer = typename std::conditional<Const, value_type const*, value_type*>::type;
+		/** reference type */
+		using reference = typename std::conditional<Const, value_type const&, value_type&>::type;
+
+		/** @brief singular iterator */
+		basic_iterator() = default;
+
+		/** @brief convert iterator to const_iterator */
+		template <bool OtherConst, typename std::enable_if<Const && !OtherConst>::type* = nullptr>
+		basic_iterator(basic_iterator<OtherConst> const& other) : m_ring(other.m_ring), m_index(other.m_index) {}
+
+		/** dereference */
+		reference operator*() const {
+			return (*m_ring)[m_index];
+		}
+		/** member access */
+		pointer operator->() const {
+			return &(*m_ring)[m_index];
+		}
+		/** indexed access */
+		reference operator[](difference_type n) const {
+			return (*m_ring)[static_cast<size_type>(static_cast<difference_type>(m_index) + n)];
+		}
+
+		/** @{ move iterator */
+		basic_iterator& operator++() {
+			++m_index;
+			return *this;
+		}
+		basic_iterator operator++(int) {
+			basic_iterator tmp(*this);
+			++m_index;
+			return tmp;
+		}
+		basic_iterator& operator--() {
+			--m_index;
+			return *this;
+		}
+		basic_iterator operator--(int) {
+			basic_iterator tmp(*this);
+			--m_index;
+			return tmp;
+		}
+		basic_iterator& operator+=(difference_type n) {
+			m_index = static_cast<size_type>(static_cast<difference_type>(m_index) + n);
+			return *this;
+		}
+		basic_iterator& operator-=(difference_type n) {
+			m_index = static_cast<size_type>(static_cast<difference_type>(m_index) - n);
+			return *this;
+		}
+		friend basic_iterator operator+(basic_iterator it, difference_type n) {
+			return it += n;
+		}
+		friend basic_iterator operator+(difference_type n, basic_iterator it) {
+			return it += n;
+		}
+		friend basic_iterator operator-(basic_iterator it, difference_type n) {
+			return it -= n;
+		}
+		/** @} */
+
+		/** distance between iterators */
+		friend difference_type operator-(basic_iterator const& a, basic_iterator const& b) {
+			return static_cast<difference_type>(a.m_index) - static_cast<difference_type>(b.m_index);
+		}
+
+		/** @{ compare iterators */
+		friend bool operator==(basic_iterator const& a, basic_iterator const& b) {
+			return a.m_index == b.m_index;
+		}
+		friend bool operator!=(basic_iterator const& a, basic_iterator const& b) {
+			return a.m_index != b.m_index;
+		}
+		friend bool operator<(basic_iterator const& a, basic_iterator const& b) {
+			return a.m_index < b.m_index;
+		}
+		friend bool operator>(basic_iterator const& a, basic_iterator const& b) {
+			return a.m_index > b.m_index;
+		}
+		friend bool operator<=(basic_iterator const& a, basic_iterator const& b) {
+			return a.m_index <= b.m_index;
+		}
+		friend bool operator>=(basic_iterator const& a, basic_iterator const& b) {
+			return a.m_index >= b.m_index;
+		}
+		/** @} */
+
+	private:
+		friend class small_ring;
+		template <bool OtherConst>
+		friend class basic_iterator;
+
+		explicit basic_iterator(ring_t* ring, size_type index) : m_ring(ring), m_index(index) {}
+
+		ring_t* m_ring{nullptr};
+		size_type m_index{0};
+	};
+
+	/** iterator type */
+	using iterator = basic_iterator<false>;
+	/** const iterator type */
+	using const_iterator = basic_iterator<true>;
+
+	/** @brief empty ring */
+	small_ring() noexcept : m_data(inline_data()) {}
+
+	/** @brief copy elements */
+	small_ring(small_ring const& other) : small_ring() {
+		reserve(other.m_size);
+		for (const_reference value : other) emplace_back(value);
+	}
+
+	/** @brief take over elements (the heap buffer if there is one) */
+	small_ring(small_ring&& other) noexcept(std::is_nothrow_move_constructible<Value>::value) : small_ring() {
+		take(other);
+	}
+
+	/** @brief copy elements */
+	small_ring& operator=(small_ring const& other) {
+		if (this != &other) {
+			clear();
+			reserve(other.m_size);
+			for (const_reference value : other) emplace_back(value);
+		}
+		return *this;
+	}
+
+	/** @brief take over elements (the heap buffer if there is one) */
+	small_ring& operator=(small_ring&& other) noexcept(std::is_nothrow_move_constructible<Value>::value) {
+		if (this != &other) {
+			clear();
+			release_heap();
+			take(other);
+		}
+		return *this;
+	}
+
+	~small_ring() {
+		clear();
+		release_heap();
+	}
+
+	/** @brief whether ring is empty */
+	bool empty() const noexcept {
+		return 0 == m_size;
+	}
+
+	/** @brief number of elements */
+	size_type size() const noexcept {
+		return m_size;
+	}
+
+	/** @brief number of elements the ring can store without allocating */
+	size_type capacity() const noexcept {
+		return m_capacity;
+	}
+
+	/** @brief whether elements are stored inline (no heap buffer allocated) */
+	bool is_inline() const noexcept {
+		return m_data == inline_data();
+	}
+
+	/** @{ access element (no range check) */
+	reference operator[](size_type i) {
+		return *slot(i);
+	}
+	const_reference operator[](size_type i) const {
+		return *slot(i);
+	}
+	/** @} */
+
+	/** @{ first element; ring must not be empty */
+	reference front() {
+		if (empty()) std::terminate();
+		return *slot(0);
+	}
+	const_reference front() const {
+		if (empty()) std::terminate();
+		return *slot(0);
+	}
+	/** @} */
+
+	/** @{ last element; ring must not be empty */
+	reference back() {
+		if (empty()) std::terminate();
+		return *slot(m_size - 1);
+	}
+	const_reference back() const {
+		if (empty()) std::terminate();
+		return *slot(m_size - 1);
+	}
+	/** @} */
+
+	/** @{ iterators */
+	iterator begin() noexcept {
+		return iterator(this, 0);
+	}
+	iterator end() noexcept {
+		return iterator(this, m_size);
+	}
+	const_iterator begin() const noexcept {
+		return const_iterator(this, 0);
+	}
+	const_iterator end() const noexcept {
+		return const_iterator(this, m_size);
+	}
+	const_iterator cbegin() const noexcept {
+		return begin();
+	}
+	const_iterator cend() const noexcept {
+		return end();
+	}
+	/** @} */
+
+	/** @brief construct new element at the end */
+	template <typename... Args>
+	reference emplace_back(Args&&... args) {
+		if (m_size == m_capacity) {
+			// args might refer to an element in the ring: construct before moving elements
+			value_type value(std::forward<Args>(args)...);
+			grow(m_size + 1);
+			::new (static_cast<void*>(slot(m_size))) value_type(std::move(value));
+		} else {
+			::new (static_cast<void*>(slot(m_size))) value_type(std::forward<Args>(args)...);
+		}
+		++m_size;
+		return back();
+	}
+
+	/** @brief append copy of value */
+	void push_back(value_type const& value) {
+		emplace_back(value);
+	}
+
+	/** @brief append value */
+	void push_back(value_type&& value) {
+		emplace_back(std::move(value));
+	}
+
+	/**
+	 * @brief move all elements of `other` to the end; `other` is empty
+	 *     afterwards
+	 *
+	 * Takes over the heap buffer of `other` if this ring is empty and
+	 * inline; otherwise the elements are moved one by one, growing the
+	 * capacity by doubling (amortized constant time per element).
+	 */
+	void append(small_ring&& other) {
+		if (this == &other || other.empty()) return;
+		if (empty() && is_inline() && !other.is_inline()) {
+			take(other);
+			return;
+		}
+		reserve(m_size + other.m_size);
+		for (size_type i = 0; i < other.m_size; ++i) {
+			::new (static_cast<void*>(slot(m_size))) value_type(std::move(*other.slot(i)));
+			++m_size;
+		}
+		other.clear();
+	}
+
+	/** @brief remove first element; ring must not be empty */
+	void pop_front() {
+		if (empty()) std::terminate();
+		slot(0)->~value_type();
+		--m_size;
+		m_head = (0 == m_size) ? 0 : ((m_head + 1) & (m_capacity - 1));
+	}
+
+	/** @brief remove last element; ring must not be empty */
+	void pop_back() {
+		if (empty()) std::terminate();
+		slot(m_size - 1)->~value_type();
+		--m_size;
+		if (0 == m_size) m_head = 0;
+	}
+
+	/** @brief remove all elements (keeps the heap buffer) */
+	void clear() noexcept {
+		for (size_type i = 0; i < m_size; ++i) slot(i)->~value_type();
+		m_size = 0;
+		m_head = 0;
+	}
+
+	/** @brief make sure at least `count` elements fit without further allocation */
+	void reserve(size_type count) {
+		if (count > m_capacity) grow(count);
+	}
+
+private:
+	using storage_t = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+
+	value_type* inline_data() noexcept {
+		return reinterpret_cast<value_type*>(m_inline);
+	}
+	value_type const* inline_data() const noexcept {
+		return reinterpret_cast<value_type const*>(m_inline);
+	}
+
+	value_type* slot(size_type i) noexcept {
+		return m_data + ((m_head + i) & (m_capacity - 1));
+	}
+	value_type const* slot(size_type i) const noexcept {
+		return m_data + ((m_head + i) & (m_capacity - 1));
+	}
+
+	void grow(size_type min_capacity) {
+		size_type capacity = m_capacity;
+		while (capacity < min_capacity) capacity *= 2;
+
+		std::allocator<value_type> alloc;
+		value_type* data = alloc.allocate(capacity);
+		size_type moved = 0;
+		try {
+			for (; moved < m_size; ++moved) ::new (static_cast<void*>(data + moved)) value_type(std::move_if_noexcept(*slot(moved)));
+		} catch (...) {
+			for (size_type i = 0; i < moved; ++i) data[i].~value_type();
+			alloc.deallocate(data, capacity);
+			throw;
+		}
+		size_type const size = m_size;
+		clear();
+		release_heap();
+		m_data = data;
+		m_capacity = capacity;
+		m_size = size;
+	}
+
+	void release_heap() noexcept {
+		if (!is_inline()) {
+			std::allocator<value_type>().deallocate(m_data, m_capacity);
+			m_data = inline_data();
+			m_capacity = InlineCapacity;
+			m_head = 0;
+		}
+	}
+
+	// requires *this to be empty and inline
+	void take(small_ring& other) {
+		if (other.is_inline()) {
+			for (size_type i = 0; i < other.m_size; ++i) {
+				::new (static_cast<void*>(inline_data() + i)) value_type(std::move(*other.slot(i)));
+				++m_size;
+			}
+			other.clear();
+		} else {
+			m_data = other.m_data;
+			m_capacity = other.m_capacity;
+			m_head = other.m_head;
+			m_size = other.m_size;
+			other.m_data = other.inline_data();
+			other.m_capacity = InlineCapacity;
+			other.m_head = 0;
+			other.m_size = 0;
+		}
+	}
+
+	storage_t m_inline[InlineCapacity];
+	value_type* m_data;
+	size_type m_capacity{InlineCapacity};
+	size_type m_head{0};
+	size_type m_size{0};
+};
+
+__CANEY_STDV1_END
@@ -0,0 +1,115 @@
+#include "caney/std/small_ring.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(small_ring)
+
+BOOST_AUTO_TEST_CASE(inline_fifo) {
+	caney::small_ring<int, 4> ring;
+	BOOST_CHECK(ring.empty());
+	for (int round = 0; round < 10; ++round) {
+		// wraps around the inline storage without allocating
+		ring.push_back(3 * round);
+		ring.push_back(3 * round + 1);
+		ring.push_back(3 * round + 2);
+		BOOST_CHECK_EQUAL(ring.front(), 3 * round);
+		ring.pop_front();
+		ring.pop_front();
+		BOOST_CHECK_EQUAL(ring.size(), 1u);
+		BOOST_CHECK_EQUAL(ring.front(), 3 * round + 2);
+		ring.pop_front();
+	}
+	BOOST_CHECK(ring.is_inline());
+}
+
+BOOST_AUTO_TEST_CASE(grow_keeps_order) {
+	caney::small_ring<std::string, 2> ring;
+	ring.push_back("skip");
+	ring.pop_front(); // head not at start of storage
+	for (int i = 0; i < 100; ++i) ring.push_back(std::to_string(i));
+	BOOST_CHECK(!ring.is_inline());
+	BOOST_CHECK_EQUAL(ring.size(), 100u);
+	BOOST_CHECK_EQUAL(ring.capacity(), 128u);
+	for (std::size_t i = 0; i < ring.size(); ++i) BOOST_CHECK_EQUAL(ring[i], std::to_string(i));
+	BOOST_CHECK_EQUAL(ring.back(), "99");
+	ring.pop_back();
+	BOOST_CHECK_EQUAL(ring.back(), "98");
+
+	// self-referencing emplace while full
+	caney::small_ring<std::string, 2> full;
+	full.push_back("a");
+	full.push_back("b");
+	full.push_back(full.front());
+	BOOST_CHECK_EQUAL(full.back(), "a");
+}
+
+BOOST_AUTO_TEST_CASE(iterators) {
+	caney::small_ring<int, 4> ring;
+	for (int i = 0; i < 3; ++i) ring.push_back(i);
+	ring.pop_front();
+	for (int i = 3; i < 6; ++i) ring.push_back(i);
+
+	std::vector<int> const expected{1, 2, 3, 4, 5};
+	BOOST_CHECK_EQUAL_COLLECTIONS(ring.begin(), ring.end(), expected.begin(), expected.end());
+	BOOST_CHECK_EQUAL(ring.end() - ring.begin(), 5);
+	BOOST_CHECK(std::find(ring.cbegin(), ring.cend(), 4) == ring.begin() + 3);
+	caney::small_ring<int, 4>::const_iterator it = ring.begin();
+	BOOST_CHECK_EQUAL(it[4], 5);
+}
+
+BOOST_AUTO_TEST_CASE(copy_and_move) {
+	caney::small_ring<std::unique_ptr<int>, 2> small;
+	small.push_back(std::unique_ptr<int>(new int(1)));
+	caney::small_ring<std::unique_ptr<int>, 2> moved(std::move(small));
+	BOOST_CHECK(small.empty());
+	BOOST_CHECK_EQUAL(*moved.front(), 1);
+
+	caney::small_ring<std::unique_ptr<int>, 2> large;
+	for (int i = 0; i < 5; ++i) large.push_back(std::unique_ptr<int>(new int(i)));
+	int const* first = large.front().get();
+	moved = std::move(large);
+	// heap buffer is taken over
+	BOOST_CHECK_EQUAL(moved.front().get(), first);
+	BOOST_CHECK_EQUAL(moved.size(), 5u);
+	BOOST_CHECK(large.empty() && large.is_inline());
+
+	caney::small_ring<std::string, 2> strings;
+	for (int i = 0; i < 5; ++i) strings.push_back(std::to_string(i));
+	caney::small_ring<std::string, 2> copy(strings);
+	BOOST_CHECK_EQUAL_COLLECTIONS(copy.begin(), copy.end(), strings.begin(), strings.end());
+	copy = caney::small_ring<std::string, 2>();
+	BOOST_CHECK(copy.empty());
+}
+
+BOOST_AUTO_TEST_CASE(append) {
+	caney::small_ring<std::string, 2> ring;
+	caney::small_ring<std::string, 2> other;
+	ring.append(std::move(other));
+	BOOST_CHECK(ring.empty());
+
+	other.push_back("a");
+	ring.append(std::move(other));
+	BOOST_CHECK(other.empty());
+	BOOST_CHECK(ring.is_inline());
+	other.push_back("b");
+	other.push_back("c");
+	ring.append(std::move(other));
+	std::vector<std::string> const expected{"a", "b", "c"};
+	BOOST_CHECK_EQUAL_COLLECTIONS(ring.begin(), ring.end(), expected.begin(), expected.end());
+	BOOST_CHECK_EQUAL(ring.capacity(), 4u);
+
+	// empty inline ring takes over the heap buffer
+	caney::small_ring<std::string, 2> empty;
+	std::string const* first = &ring.front();
+	empty.append(std::move(ring));
+	BOOST_CHECK_EQUAL(&empty.front(), first);
+	BOOST_CHECK_EQUAL_COLLECTIONS(empty.begin(), empty.end(), expected.begin(), expected.end());
+	BOOST_CHECK(ring.empty() && ring.is_inline());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+/* heap allocations and throughput of generic chunks passed through a chain of filter<>s
+ *
+ * compares the default chunk queue (small_ring) with a std::list queue.
+ *
+ * usage: caney-bench-streams-filter_bench [number of sends in thousands, default 1000]
+ */
+
+#include "caney/streams/streams.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <new>
+
+namespace {
+	std::atomic<std::size_t> allocations{0};
+} // anonymous namespace
+
+void* operator new(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+namespace {
+	struct message {
+		std::size_t value;
+	};
+
+	// same payload, but queued in a std::list (the previous default)
+	struct list_message {
+		std::size_t value;
+	};
+} // anonymous namespace
+
+__CANEY_STREAMSV1_BEGIN
+
+template <>
+struct chunk_traits_t<list_message> {
+	using chunks_t = std::list<list_message>;
+
+	static void append(chunks_t& to, chunks_t&& chunks) {
+		to.splice(to.end(), std::move(chunks));
+	}
+
+	static bool empty(chunks_t const& chunks) {
+		return chunks.empty();
+	}
+
+	static void clear(chunks_t& chunks) {
+		chunks.clear();
+	}
+
+	static std::size_t count(chunks_t const& chunks) {
+		return chunks.size();
+	}
+
+	static std::size_t bytes(chunks_t const& chunks) {
+		return chunks.size();
+	}
+
+	using end_t = StreamEnd;
+};
+
+__CANEY_STREAMSV1_END
+
+namespace {
+	template <typename Chunk>
+	class bench_source : public caney::streams::source<Chunk> {
+	public:
+		void push(std::size_t value) {
+			typename caney::streams::source<Chunk>::chunks_t chunks;
+			chunks.push_back(Chunk{value});
+			this->send(std::move(chunks));
+		}
+
+	protected:
+		void on_disconnect() override {}
+	};
+
+	template <typename Chunk>
+	class pass_filter : public caney::streams::filter<Chunk> {};
+
+	template <typename Chunk>
+	class bench_sink : public caney::streams::sink<Chunk> {
+	public:
+		std::size_t sum{0};
+
+	protected:
+		void on_receive(typename caney::streams::sink<Chunk>::chunks_t&& chunks) override {
+			for (Chunk const& c : chunks) sum += c.value;
+		}
+
+		void on_end(caney::streams::StreamEnd) override {}
+	};
+
+	template <typename Chunk>
+	void run(char const* name, std::size_t sends) {
+		std::size_t const stages = 4;
+		auto source = std::make_shared<bench_source<Chunk>>();
+		auto sink = std::make_shared<bench_sink<Chunk>>();
+		std::shared_ptr<pass_filter<Chunk>> filters[stages];
+		for (auto& f : filters) f = std::make_shared<pass_filter<Chunk>>();
+		caney::streams::connect(source, filters[0]);
+		for (std::size_t i = 1; i < stages; ++i) caney::streams::connect(filters[i - 1], filters[i]);
+		caney::streams::connect(filters[stages - 1], sink);
+
+		std::size_t const allocations_before = allocations.load();
+		auto const start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < sends; ++i) source->push(i);
+		auto const end = std::chrono::steady_clock::now();
+		std::size_t const allocated = allocations.load() - allocations_before;
+
+		double const seconds = std::chrono::duration<double>(end - start).count();
+		std::printf("%-10s %zu filters: %6.2f allocations/send, %7.2f M sends/s (sum %zu)\n", name, stages, static_cast<double>(allocated) / static_cast<double>(sends),
+			static_cast<double>(sends) / seconds / 1e6, sink->sum);
+	}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+	std::size_t const sends = std::size_t{1000} * static_cast<std::size_t>(argc > 1 ? std::atoi(argv[1]) : 1000);
+	run<message>("small_ring", sends);
+	run<list_message>("std::list", sends);
+	return 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "asio.hpp"
+#include "internal.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+
+__CANEY_STREAMSV1_BEGIN
+
+/**
+ * @brief configuration for @ref sharded_acceptor
+ */
+struct acceptor_options {
+	std::size_t threads{0}; //!< number of shards (each running an `io_context` in its own thread); 0: one per hardware thread
+	bool pin_threads{true}; //!< pin shard threads to a CPU each (where supported)
+	bool reuse_port{true}; //!< one `SO_REUSEPORT` listener per shard; otherwise (or if not supported) a single listener hands connections round-robin
+	int backlog{boost::asio::socket_base::max_listen_connections}; //!< listen backlog per listener
+	std::chrono::milliseconds error_backoff{100}; //!< pause accepting after running out of file descriptors or memory
+	/**
+	 * @brief endpoints receive through an @ref io_uring_reactor per shard
+	 *     (if io_uring is available; otherwise the `boost::asio` reactor is
+	 *     used)
+	 */
+	bool io_uring{false};
+	io_uring_options ring; //!< configuration for the io_uring engines
+	asio_endpoint_options endpoint; //!< configuration for created endpoints (@ref asio_endpoint_options::io_uring is set per shard)
+};
+
+/**
+ * @brief accept TCP connections on multiple reactors
+ *
+ * Runs an `io_context` per shard in its own thread. New connections get an
+ * @ref asio_endpoint bound to the strand of the shard that accepted them
+ * (or the shard they were handed to), and are passed to the handler in
+ * that strand.
+ *
+ * The `io_context`-s are owned by the acceptor: endpoints must not be used
+ * after the acceptor was stopped, and must be released before the acceptor
+ * is destroyed.
+ */
+class sharded_acceptor : private boost::noncopyable {
+public:
+	/** @brief endpoint type for accepted connections */
+	using endpoint_t = asio_endpoint<boost::asio::ip::tcp>;
+	/** @brief handler for new connections; called in the strand of the endpoint */
+	using handler_t = std::function<void(std::shared_ptr<endpoint_t> endpoint, std::size_t shard)>;
+
+	/** @brief create shards (threads are started by @ref listen) */
+	explicit sharded_acceptor(acceptor_options options = acceptor_options());
+
+	/** @brief stops the shards */
+	~sharded_acceptor();
+
+	/**
+	 * @brief bind listener(s) and start the shard threads
+	 *
+	 * Port 0 binds a random port (shared by all listeners); see
+	 * @ref local_endpoint. Can only be called once.
+	 *
+	 * @param address address to listen on
+	 * @param handler handler for new connections
+	 * @param ec set on error
+	 */
+	void listen(boost::asio::ip::tcp::endpoint const& address, handler_t handler, std::error_code& ec);
+
+	/** @brief close listeners (waits for the shards to close them), stop `io_context`-s and join threads */
+	void stop();
+
+	/** @brief number of shards */
+	std::size_t shards() const {
+		return m_shards.size();
+	}
+
+	/** @brief whether endpoints created by the shard receive through io_uring */
+	bool uses_io_uring(std::size_t shard) const;
+
+	/** @brief whether every shard has its own `SO_REUSEPORT` listener */
+	bool uses_reuse_port() const {
+		return m_reuse_port;
+	}
+
+	/** @brief address the listeners are bound to */
+	boost::asio::ip::tcp::endpoint local_endpoint() const {
+		return m_local_endpoint;
+	}
+
+	/** @brief `io_context` of a shard */
+	boost::asio::io_context& context(std::size_t shard);
+
+	/** @brief number of connections passed to the handler in a shard */
+	std::uint64_t accepted(std::size_t shard) const;
+
+	/** @brief number of failed accepts in a shard */
+	std::uint64_t accept_errors(std::size_t shard) const;
+
+private:
+	struct shard;
+
+	bool open_listener(shard& s, boost::asio::ip::tcp::endpoint const& address, bool reuse_port, std::error_code& ec);
+	void start_accept(shard& s);
+	void start_thread(std::size_t index);
+
+	acceptor_options const m_options;
+	handler_t m_handler;
+	std::vector<std::unique_ptr<shard>> m_shards;
+	std::vector<std::thread> m_threads;
+	std::atomic<std::size_t> m_next_shard{0};
+	bool m_reuse_port{false};
+	bool m_listening{false};
+	boost::asio::ip::tcp::endpoint m_local_endpoint;
+};
+
+__CANEY_STREAMSV1_END
@@ -1,32 +1,233 @@
 #pragma once
 
 #include "caney/memory/buffer.hpp"
+#include "caney/memory/intrusive_buffer_pool.hpp"
 #include "caney/std/tags.hpp"
 
 #include "chunks.hpp"
 #include "internal.hpp"
+#include "io_uring.hpp"
+#include "read_buffers.hpp"
+#include "splice.hpp"
 #include "streams.hpp"
 
-#include <list>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <netinet/tcp.h>
 
 __CANEY_STREAMSV1_BEGIN
 
+/**
+ * @brief configuration for @ref asio_endpoint
+ */
+struct asio_endpoint_options {
+	std::size_t max_write_bytes{256 * 1024}; //!< max number of bytes passed to a single write
+	/**
+	 * @brief runs of memory chunks smaller than this are copied into one
+	 *     pooled buffer before writing (limited to the size of the pooled
+	 *     buffers)
+	 */
+	std::size_t coalesce_threshold{512};
+	std::size_t write_high_watermark{4 * 1024 * 1024}; //!< pause origin of the data to write while more bytes are queued (0: unlimited)
+	std::size_t write_low_watermark{1024 * 1024}; //!< resume origin when queued data dropped to this size
+	std::size_t max_reads_per_wakeup{16}; //!< max number of reads before other handlers get a chance to run
+	std::size_t max_read_bytes_per_wakeup{1024 * 1024}; //!< stop reading after this many bytes per wakeup
+	bool splice_relay{true}; //!< relay data to a connected socket endpoint with `splice(2)` (see @ref asio_endpoint)
+	std::size_t splice_pipe_size{splice_pipe::default_size}; //!< requested size of the pipe for `splice(2)`
+	/**
+	 * @brief receive with multishot io_uring receives through this reactor
+	 *     (must use the strand of the endpoint) instead of the `boost::asio`
+	 *     reactor; disables @ref splice_relay
+	 */
+	std::shared_ptr<io_uring_reactor> io_uring;
+};
+
+namespace impl {
+#if defined(IOV_MAX) && IOV_MAX < 64
+	/** @brief max number of buffers gathered for a single write */
+	constexpr std::size_t asio_max_write_buffers = IOV_MAX;
+#else
+	/** @brief max number of buffers gathered for a single write (asio doesn't pass more than 64 to `writev(2)`) */
+	constexpr std::size_t asio_max_write_buffers = 64;
+#endif
+
+	/** @brief pool for the buffers small chunks are coalesced into */
+	memory::intrusive_buffer_pool<>& asio_coalesce_pool();
+
+	/** @brief observer of handler allocations falling back to the heap */
+	using handler_heap_hook_t = void (*)(std::size_t size);
+
+	/** @brief hook called by @ref handler_memory for heap allocations (nullptr: none); meant for tests */
+	extern std::atomic<handler_heap_hook_t> handler_heap_hook;
+
+	/** @brief buffer sequence referencing a part of an array */
+	struct const_buffer_range {
+		boost::asio::const_buffer const* first; //!< first buffer
+		boost::asio::const_buffer const* last; //!< behind last buffer
+
+		/** @brief begin of range */
+		boost::asio::const_buffer const* begin() const {
+			return first;
+		}
+
+		/** @brief end of range */
+		boost::asio::const_buffer const* end() const {
+			return last;
+		}
+	};
+
+	/**
+	 * @brief memory block reused for the handlers of one kind of
+	 *     asynchronous operation (only one of them is running at a time)
+	 *
+	 * Falls back to the heap for larger handlers or if the block is in use.
+	 * Shared by the owner and the @ref handler_with_memory wrappers, so an
+	 * operation still pending when the owner is destroyed can release its
+	 * memory.
+	 */
+	class handler_memory : private boost::noncopyable {
+	public:
+		/** @brief allocate memory for handler */
+		void* allocate(std::size_t size) {
+			if (!m_in_use && size <= sizeof(m_storage)) {
+				m_in_use = true;
+				return &m_storage;
+			}
+			if (handler_heap_hook_t const hook = handler_heap_hook.load(std::memory_order_relaxed)) hook(size);
+			return ::operator new(size);
+		}
+
+		/** @brief release memory allocated by @ref allocate */
+		void deallocate(void* pointer) {
+			if (pointer == &m_storage) {
+				m_in_use = false;
+			} else {
+				::operator delete(pointer);
+			}
+		}
+
+	private:
+		std::aligned_storage<512>::type m_storage;
+		bool m_in_use = false;
+	};
+
+	/** @brief handler allocating asio operations through the allocation hooks from a @ref handler_memory */
+	template <typename Handler>
+	class handler_with_memory {
+	public:
+		/** @brief wrap handler */
+		explicit handler_with_memory(std::shared_ptr<handler_memory> memory, Handler handler) : m_memory(std::move(memory)), m_handler(std::move(handler)) {}
+
+		/** @brief call wrapped handler */
+		template <typename... Args>
+		void operator()(Args&&... args) {
+			m_handler(std::forward<Args>(args)...);
+		}
+
+		/** @brief allocation hook */
+		friend void* asio_handler_allocate(std::size_t size, handler_with_memory* self) {
+			return self->m_memory->allocate(size);
+		}
+
+		/** @brief deallocation hook */
+		friend void asio_handler_deallocate(void* pointer, std::size_t, handler_with_memory* self) {
+			self->m_memory->deallocate(pointer);
+		}
+
+	private:
+		std::shared_ptr<handler_memory> m_memory;
+		Handler m_handler;
+	};
+
+	/** @brief create @ref handler_with_memory */
+	template <typename Handler>
+	handler_with_memory<Handler> make_handler_with_memory(std::shared_ptr<handler_memory> const& memory, Handler handler) {
+		return handler_with_memory<Handler>(memory, std::move(handler));
+	}
+
+	/** @brief set `TCP_CORK`; only supported for TCP sockets */
+	template <typename Socket>
+	void set_cork(Socket&, bool, boost::system::error_code& ec) {
+		ec.clear();
+	}
+
+#if defined(TCP_CORK)
+	/** @brief set `TCP_CORK` */
+	inline void set_cork(boost::asio::ip::tcp::socket& sock, bool enable, boost::system::error_code& ec) {
+		sock.set_option(boost::asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_CORK>(enable), ec);
+	}
+#endif
+} // namespace impl
+
 /**
  * @brief An endpoint for some stream-oriented boost protocol.
  *
  * Provides a sink (to send data over the socket), a source (to receive data), an origin (to pause receiving data).
  *
- * Uses @ref chunk as chunk type.
+ * Uses @ref chunk as chunk type. Memory chunks are sent with gathered
+ * writes; @ref file_chunk -s are sent with @ref file_chunk::send_to
+ * (`sendfile(2)`), i.e. file data is never copied through user space.
+ *
+ * Data is read into buffers from a @ref read_buffer_provider (by default
+ * @ref adaptive_read_buffers). The endpoint waits for the socket to get
+ * readable and then reads (without blocking) until the socket has no more
+ * data or a per wakeup limit is reached, passing all chunks to the sink at
+ * once. While the origin is paused nothing is read; the data stays in the
+ * kernel socket buffer.
+ *
+ * Writes gather at most @ref impl::asio_max_write_buffers buffers and
+ * @ref asio_endpoint_options::max_write_bytes bytes; runs of small chunks
+ * are coalesced into pooled buffers first. With @ref cork writes are
+ * batched until @ref flush.
+ *
+ * The queue of data to write is limited by watermarks (see
+ * @ref sink::set_watermarks); while it is full the origin of the data is
+ * paused.
+ *
+ * Handlers of asynchronous operations are allocated from memory blocks
+ * owned by the endpoint, so steady state reading and writing doesn't
+ * allocate.
+ *
+ * If the sink connected to the endpoint is another socket endpoint (in the
+ * same strand) and has nothing queued, data is relayed kernel-side with
+ * `splice(2)` through a @ref splice_pipe instead of reading it into
+ * buffers (see @ref asio_endpoint_options::splice_relay). Pausing works
+ * the same way: nothing is read while the origin is paused, and no more
+ * than the pipe can hold is moved before the other socket takes it. Data
+ * already in the pipe is still passed on while paused; if the sink can't
+ * take spliced data anymore (e.g. after @ref cork) it is copied into its
+ * queue instead.
+ *
+ * With @ref asio_endpoint_options::io_uring the endpoint receives through
+ * a multishot io_uring receive into buffers provided to the kernel instead;
+ * pausing cancels the receive (data the kernel received before it saw the
+ * cancel request is still passed on). If the engine fails, the endpoint
+ * continues with the `boost::asio` reactor.
  *
- * @tparam the (byte stream) protocol this endpoint is for. ``boost::asio::ip::tcp`` or ``boost::asio::local::stream_protocol``
+ * An @ref StreamEnd::EndOfStream received by the sink shuts the sending
+ * side down after all queued data was sent.
+ *
+ * @tparam Protocol the (byte stream) protocol this endpoint is for. ``boost::asio::ip::tcp`` or ``boost::asio::local::stream_protocol``
  */
-template <typename Protocol, typename StreamSocketService = boost::asio::stream_socket_service<Protocol>>
+template <typename Protocol>
 class asio_endpoint : public sink<chunk>,
 					  public source<chunk>,
 					  public origin,
-					  public std::enable_shared_from_this<asio_endpoint<Protocol, StreamSocketService>> {
+					  public impl::splice_sink,
+					  public std::enable_shared_from_this<asio_endpoint<Protocol>> {
 public:
 	/** @brief the endpoints sink type */
 	using sink_t = sink<chunk>;
@@ -38,67 +239,348 @@ public:
 	using end_t = chunk_traits_t<chunk>::end_t;
 
 	/** @brief share strands with this type */
-	using shared_strand_t = std::shared_ptr<boost::asio::strand>;
+	using shared_strand_t = std::shared_ptr<boost::asio::io_context::strand>;
 	/** @brief boost socket type */
-	using socket_t = boost::asio::basic_stream_socket<Protocol, StreamSocketService>;
+	using socket_t = typename Protocol::socket;
 
 	/** @brief shared_from_this */
-	using std::enable_shared_from_this<asio_endpoint<Protocol, StreamSocketService>>::shared_from_this;
+	using std::enable_shared_from_this<asio_endpoint<Protocol>>::shared_from_this;
 
 	/** @brief create instance */
-	static std::shared_ptr<asio_endpoint> create(shared_strand_t strand, socket_t&& sock) {
-		std::shared_ptr<asio_endpoint> self = std::make_shared<asio_endpoint>(private_tag, std::move(strand), std::move(sock));
+	static std::shared_ptr<asio_endpoint> create(shared_strand_t strand, socket_t&& sock, asio_endpoint_options options = asio_endpoint_options()) {
+		std::shared_ptr<asio_endpoint> self = std::make_shared<asio_endpoint>(private_tag, std::move(strand), std::move(sock), options);
 		self->set_origin(self);
 		return self;
 	}
 
 	//! @nowarn
 	/** @internal @brief private constructor */
-	asio_endpoint(private_tag_t, shared_strand_t strand, socket_t&& sock) : m_strand(std::move(strand)), m_socket(std::move(sock)) {}
+	asio_endpoint(private_tag_t, shared_strand_t strand, socket_t&& sock, asio_endpoint_options options)
+	: m_read_buffers(new adaptive_read_buffers()), m_options(options), m_strand(std::move(strand)), m_socket(std::move(sock)) {
+		m_options.coalesce_threshold = std::min(m_options.coalesce_threshold, impl::asio_coalesce_pool().size());
+		if (0 == m_options.max_write_bytes) std::terminate();
+		if (m_options.io_uring && m_options.io_uring->error()) m_options.io_uring.reset();
+		if (m_options.io_uring) {
+			// the engine may only be used in its strand
+			if (m_options.io_uring->strand() != m_strand) std::terminate();
+			m_options.splice_relay = false;
+		}
+		sink_t::set_watermarks(m_options.write_high_watermark, m_options.write_low_watermark);
+	}
 	//! @endnowarn
 
+	~asio_endpoint() {
+		cancel_uring_read(true);
+	}
+
+	/** @brief replace provider for read buffers (call in the strand) */
+	void set_read_buffers(std::unique_ptr<read_buffer_provider> provider) {
+		if (!provider) std::terminate();
+		m_read_buffers = std::move(provider);
+		m_read_buffer = memory::unique_buf();
+	}
+
+	/**
+	 * @brief batch writes: queued data is only written once
+	 *     @ref asio_endpoint_options::max_write_bytes are queued, on
+	 *     @ref flush, @ref uncork or at the end of the stream
+	 *
+	 * TCP sockets also set `TCP_CORK`, so the kernel doesn't send partial
+	 * segments until @ref flush.
+	 *
+	 * Like @ref flush and @ref uncork this must be called in the strand.
+	 */
+	void cork() {
+		if (m_corked) return;
+		m_corked = true;
+		boost::system::error_code ec;
+		impl::set_cork(m_socket, true, ec);
+	}
+
+	/** @brief stop batching writes and write queued data */
+	void uncork() {
+		if (!m_corked) return;
+		m_corked = false;
+		m_flush_bytes = 0;
+		boost::system::error_code ec;
+		impl::set_cork(m_socket, false, ec);
+		start_write();
+	}
+
+	/** @brief number of bytes relayed to the sink with `splice(2)` */
+	std::uint64_t spliced_bytes() const {
+		return m_spliced_bytes;
+	}
+
+	/** @brief write all currently queued data; pushes partial segments out when done */
+	void flush() {
+		if (!m_corked) return;
+		m_flush_bytes = static_cast<std::size_t>(m_write_queue.bytes().get());
+		if (0 == m_flush_bytes) {
+			push_corked();
+		} else {
+			start_write();
+		}
+	}
+
 private:
 	// source events
 	void on_pause() override {
-		// could only cancel all socket operations, not the read alone
+		// a pending wait for readability doesn't consume any data, and reads check the pause state; io_uring receives have to be stopped
+		cancel_uring_read(false);
+	}
+
+	void prepare_read_buffer() {
+		if (m_read_buffer.size() < m_read_buffers->preferred_size() / 4) m_read_buffer = m_read_buffers->allocate();
+	}
+
+	// record read and take data from read buffer
+	chunk finish_read(std::size_t bytes) {
+		m_read_buffers->record(bytes, m_read_buffer.size());
+		return chunk(m_read_buffer.freeze(bytes));
 	}
 
 	void start_read() {
 		if (origin::is_paused() || m_is_reading || m_got_fin || !m_socket.is_open()) return;
+		if (m_options.io_uring) {
+			start_uring_read();
+			return;
+		}
 		m_is_reading = true;
 
-		if (m_read_buffer.size() < 1024) { m_read_buffer = memory::unique_buf::allocate(16 * 1024); }
+		// only wait for data: while paused the data stays in the kernel (and TCP flow control pushes back on the peer)
+		boost::system::error_code ec;
+		if (!m_socket.non_blocking()) m_socket.non_blocking(true, ec);
 
 		std::weak_ptr<asio_endpoint> weak_self{shared_from_this()};
 
-		m_socket.async_read_some(
-			boost::asio::mutable_buffers_1(m_read_buffer),
-			m_strand->wrap([weak_self, this](const boost::system::error_code& error, std::size_t bytes_transferred) {
-				std::shared_ptr<asio_endpoint> self = weak_self.lock();
-				if (!self) return;
-				m_is_reading = false;
-				if (error == boost::asio::error::eof) {
-					m_got_fin = true;
-					source_t::send_end(StreamEnd::EndOfStream);
-				} else if (error) {
-					boost::system::error_code ec;
-					m_socket.close(ec);
-					source_t::send_end(StreamEnd::Aborted);
-					sink_t::disconnect();
-				} else if (bytes_transferred > 0) {
-					source_t::send(chunk(m_read_buffer.freeze(bytes_transferred)));
-					on_resume();
-				}
-			}));
+		m_socket.async_wait(socket_t::wait_read, m_strand->wrap(impl::make_handler_with_memory(m_read_handler_memory, [weak_self, this](const boost::system::error_code& error) {
+			std::shared_ptr<asio_endpoint> self = weak_self.lock();
+			if (!self) return;
+			m_is_reading = false;
+			if (error) {
+				on_read_error();
+			} else {
+				read_available();
+			}
+		})));
 	}
 
-	void on_resume() override {
-		start_read();
+	void start_uring_read() {
+		if (0 != m_uring_recv) return; // still running; a canceled receive restarts reading after its final completion
+		std::weak_ptr<asio_endpoint> weak_self{shared_from_this()};
+		m_uring_recv = m_options.io_uring->engine().recv_multishot(m_socket.native_handle(), [weak_self, this](std::error_code ec, memory::shared_const_buf data) {
+			std::shared_ptr<asio_endpoint> self = weak_self.lock();
+			if (!self) return;
+			uring_read(ec, std::move(data));
+		});
+		m_options.io_uring->submit_later();
 	}
 
-	void on_disconnect() override {
+	void uring_read(std::error_code const& ec, memory::shared_const_buf data) {
+		if (!ec && !data.empty()) {
+			source_t::send(chunks_t(chunk(std::move(data))));
+			return;
+		}
+
+		// final completion
+		m_uring_recv = 0;
+		m_uring_canceled = false;
+		if (ec == std::errc::operation_canceled) {
+			// paused (or closed): continues when resumed
+			start_read();
+		} else if (ec && m_options.io_uring->error()) {
+			// engine failed: continue with the boost::asio reactor
+			m_options.io_uring.reset();
+			start_read();
+		} else if (ec) {
+			on_read_error();
+		} else {
+			m_got_fin = true;
+			source_t::send_end(StreamEnd::EndOfStream);
+		}
+	}
+
+	// stop the io_uring receive; `now`: pass the request to the kernel right away (before the socket gets closed)
+	void cancel_uring_read(bool now) {
+		if (0 == m_uring_recv) return;
+		io_uring_engine& engine = m_options.io_uring->engine();
+		if (!m_uring_canceled) {
+			m_uring_canceled = true;
+			engine.cancel(m_uring_recv);
+		}
+		if (now) {
+			std::error_code ec;
+			engine.submit(ec);
+		} else {
+			m_options.io_uring->submit_later();
+		}
+	}
+
+	// an io_uring receive keeps the socket open: cancel it first
+	void close_socket() {
+		cancel_uring_read(true);
 		boost::system::error_code ec;
 		m_socket.close(ec);
+	}
+
+	// read until the socket would block (or the per wakeup limits are reached), send data and wait for more
+	void read_available() {
+		if (!m_socket.is_open() || m_splice_waiting) return;
+
+		std::shared_ptr<sink_t> const target_sink = source_t::get_sink();
+		impl::splice_sink* const target = splice_target(target_sink.get());
+		// data already in the pipe was read from the socket: pass it on even while paused
+		if (!move_splice_pipe(target)) return;
+		if (origin::is_paused() || m_got_fin) return;
+		if (target) {
+			splice_available(*target);
+			return;
+		}
+
+		chunks_t chunks;
+		bool failed = false;
+		std::size_t bytes = 0;
+		for (std::size_t reads = 0; reads < m_options.max_reads_per_wakeup && bytes < m_options.max_read_bytes_per_wakeup; ++reads) {
+			if (origin::is_paused()) break;
+			prepare_read_buffer();
+			boost::system::error_code ec;
+			std::size_t const got = m_socket.read_some(boost::asio::mutable_buffer(m_read_buffer), ec);
+			if (ec == boost::asio::error::would_block || ec == boost::asio::error::try_again) break;
+			if (ec == boost::asio::error::eof) {
+				m_got_fin = true;
+				break;
+			}
+			if (ec) {
+				failed = true;
+				break;
+			}
+			bool const filled = got == m_read_buffer.size();
+			chunks.append(finish_read(got));
+			bytes += got;
+			// a short read drained the socket
+			if (!filled) break;
+		}
+
+		if (!chunks.empty()) source_t::send(std::move(chunks));
+		if (failed) {
+			on_read_error();
+		} else if (m_got_fin) {
+			source_t::send_end(StreamEnd::EndOfStream);
+		} else {
+			on_resume();
+		}
+	}
+
+	// sink to relay data to with splice(), if possible right now
+	impl::splice_sink* splice_target(sink_t* target_sink) {
+		if (!m_options.splice_relay || !target_sink) return nullptr;
+		impl::splice_sink* const target = dynamic_cast<impl::splice_sink*>(target_sink);
+		if (!target || !target->splice_ready()) return nullptr;
+		if (!m_splice_pipe) {
+			std::error_code ec;
+			m_splice_pipe = splice_pipe::create(m_options.splice_pipe_size, ec);
+			if (ec) {
+				m_options.splice_relay = false;
+				return nullptr;
+			}
+		}
+		return target;
+	}
+
+	// move data left in the pipe to the sink; returns false if that has to wait (or failed)
+	bool move_splice_pipe(impl::splice_sink* target) {
+		if (!m_splice_pipe || m_splice_pipe->empty()) return true;
+		if (target) return splice_pipe_to(*target);
+
+		// sink can't take spliced data right now (corked, data queued, end pending or not a socket): pass it through its queue
+		chunks_t chunks;
+		while (!m_splice_pipe->empty()) {
+			prepare_read_buffer();
+			std::error_code ec;
+			std::size_t const got = m_splice_pipe->read(m_read_buffer.data(), m_read_buffer.size(), ec);
+			if (ec) {
+				on_read_error();
+				return false;
+			}
+			chunks.append(finish_read(got));
+		}
+		source_t::send(std::move(chunks));
+		return true;
+	}
+
+	// empty the pipe into the sink; returns false if the sink is full (continues once it is writable) or failed
+	bool splice_pipe_to(impl::splice_sink& target) {
+		std::error_code ec;
+		target.splice_write(*m_splice_pipe, ec);
+		if (ec == std::errc::operation_would_block || ec == std::errc::resource_unavailable_try_again) {
+			wait_for_splice_target(target);
+			return false;
+		}
+		if (ec) {
+			// the sink already aborted its side; data in the pipe is lost
+			on_read_error();
+			return false;
+		}
+		return true;
+	}
+
+	// relay data through the pipe until the socket would block (or the per wakeup limits are reached)
+	void splice_available(impl::splice_sink& target) {
+		std::size_t bytes = 0;
+		for (std::size_t reads = 0;; ++reads) {
+			// the pipe always gets emptied before reading more
+			if (!m_splice_pipe->empty() && !splice_pipe_to(target)) return;
+			if (origin::is_paused() || !m_socket.is_open()) return;
+			if (reads >= m_options.max_reads_per_wakeup || bytes >= m_options.max_read_bytes_per_wakeup) break;
+
+			std::error_code ec;
+			std::size_t const got = m_splice_pipe->fill(m_socket.native_handle(), m_options.max_read_bytes_per_wakeup - bytes, ec);
+			if (ec == std::errc::operation_would_block || ec == std::errc::resource_unavailable_try_again) break;
+			if (ec) {
+				on_read_error();
+				return;
+			}
+			if (0 == got) {
+				m_got_fin = true;
+				source_t::send_end(StreamEnd::EndOfStream);
+				return;
+			}
+			bytes += got;
+			m_spliced_bytes += got;
+		}
+		on_resume();
+	}
+
+	// continue relaying once the sink can take more data
+	void wait_for_splice_target(impl::splice_sink& target) {
+		m_splice_waiting = true;
+		std::weak_ptr<asio_endpoint> weak_self{shared_from_this()};
+		target.splice_wait([weak_self, this]() {
+			std::shared_ptr<asio_endpoint> self = weak_self.lock();
+			if (!self) return;
+			m_splice_waiting = false;
+			read_available();
+		});
+	}
+
+	void on_read_error() {
+		close_socket();
+		source_t::send_end(StreamEnd::Aborted);
+		sink_t::disconnect();
+	}
+
+	void on_resume() override {
+		if (m_splice_pipe && !m_splice_pipe->empty()) {
+			// doesn't wait for the socket: the peer might wait for the data in the pipe
+			read_available();
+		} else {
+			start_read();
+		}
+	}
+
+	void on_disconnect() override {
+		close_socket();
 		source_t::send_end(StreamEnd::Aborted);
 		sink_t::disconnect();
 	}
@@ -119,75 +601,265 @@ private:
 	}
 
 	void on_end(end_t end) override {
-		boost::system::error_code ec;
-
 		switch (end) {
 		case StreamEnd::EndOfStream:
-			m_socket.shutdown(Protocol::socket::shutdown_send, ec);
-			if (ec) {
-				m_socket.close();
-				source_t::send_end(StreamEnd::Aborted);
-			}
+			// shutdown after the queue was sent
+			m_end_pending = true;
+			start_write();
 			break;
 		case StreamEnd::Aborted:
-			m_socket.close(ec);
+			close_socket();
 			source_t::send_end(StreamEnd::Aborted);
 			break;
 		}
 	}
 
-	void start_write() {
-		if (m_is_writing || m_write_queue.empty() || !m_socket.is_open()) return;
-		m_is_writing = true;
+	void on_write_error() {
+		close_socket();
+		source_t::send_end(StreamEnd::Aborted);
+		sink_t::disconnect();
+	}
 
-		std::vector<boost::asio::const_buffer> data;
-		for (chunk const& c : m_write_queue.queue()) {
-			caney::optional<boost::asio::const_buffer> c_buffer = c.get_const_buffer();
-			if (c_buffer) {
-				data.emplace_back(c_buffer.get());
-			} else {
-				break;
+	// send out partial segments held back by TCP_CORK
+	void push_corked() {
+		boost::system::error_code ec;
+		impl::set_cork(m_socket, false, ec);
+		impl::set_cork(m_socket, true, ec);
+	}
+
+	// remove written data from queue
+	void consume(std::size_t bytes) {
+		m_write_queue.remove(file_size{bytes});
+		if (m_flush_bytes > 0) {
+			m_flush_bytes -= std::min(m_flush_bytes, bytes);
+			if (0 == m_flush_bytes) push_corked();
+		}
+		// might receive new data
+		sink_t::buffered_remove(bytes);
+	}
+
+	void start_write() {
+		if (m_is_writing || !m_socket.is_open()) return;
+		if (m_write_queue.empty()) {
+			if (m_end_pending) {
+				m_end_pending = false;
+				boost::system::error_code ec;
+				m_socket.shutdown(socket_t::shutdown_send, ec);
+				if (ec) on_write_error();
 			}
+			return;
 		}
+		if (m_corked && !m_end_pending && 0 == m_flush_bytes && m_write_queue.bytes().get() < m_options.max_write_bytes) return;
+		m_is_writing = true;
 
-		if (data.empty()) {
-			// can't handle file chunks yet
-			std::terminate();
+		if (m_write_queue.queue().front().get_file_chunk()) {
+			start_write_file();
+			return;
 		}
 
+		std::size_t const count = gather_write_buffers();
+
 		std::weak_ptr<asio_endpoint> weak_self{shared_from_this()};
 
-		m_socket.async_write_some(data, m_strand->wrap([weak_self, this](const boost::system::error_code& error, std::size_t bytes_transferred) {
-			std::shared_ptr<asio_endpoint> self = weak_self.lock();
-			if (!self) return;
+		impl::const_buffer_range const buffers{m_write_buffers.data(), m_write_buffers.data() + count};
+		m_socket.async_write_some(
+			buffers, m_strand->wrap(impl::make_handler_with_memory(m_write_handler_memory, [weak_self, this](const boost::system::error_code& error, std::size_t bytes_transferred) {
+				std::shared_ptr<asio_endpoint> self = weak_self.lock();
+				if (!self) return;
+				m_is_writing = false;
+				if (error) {
+					on_write_error();
+				} else {
+					m_write_prepared.remove(file_size{bytes_transferred});
+					consume(bytes_transferred);
+					start_write();
+				}
+			})));
+	}
+
+	// fill m_write_buffers from the prepared data; returns number of buffers
+	std::size_t gather_write_buffers() {
+		// after a partial write the rest of the prepared data goes first: coalesced runs are only copied once
+		if (m_write_prepared.empty()) prepare_write();
+		std::size_t const max_bytes = m_options.max_write_bytes;
+		std::size_t count = 0, total = 0;
+		for (chunk const& c : m_write_prepared.queue()) {
+			if (count == m_write_buffers.size() || total >= max_bytes) break;
+			boost::asio::const_buffer const buffer = *c.get_const_buffer();
+			std::size_t const size = std::min(buffer.size(), max_bytes - total);
+			m_write_buffers[count++] = boost::asio::buffer(buffer, size);
+			total += size;
+		}
+		return count;
+	}
+
+	// take the memory chunks for the next write from the front of the queue into m_write_prepared, coalescing runs of small chunks
+	void prepare_write() {
+		auto const& queue = m_write_queue.queue();
+		std::size_t const max_bytes = m_options.max_write_bytes;
+		std::size_t const max_chunks = m_write_buffers.size();
+		std::size_t total = 0;
+
+		memory::unique_buf merged;
+		std::size_t merged_used = 0;
+		auto finish_merged = [&]() {
+			if (0 == merged_used) return;
+			m_write_prepared.append(chunk(merged.freeze(merged_used)));
+			total += merged_used;
+			merged_used = 0;
+		};
+
+		std::size_t i = 0;
+		while (i < queue.size() && m_write_prepared.queue().size() < max_chunks && total < max_bytes) {
+			caney::optional<boost::asio::const_buffer> const c_buffer = queue[i].get_const_buffer();
+			if (!c_buffer) break;
+
+			// find run of small chunks
+			std::size_t run_end = i, run_bytes = 0;
+			while (run_end < queue.size() && total + run_bytes < max_bytes) {
+				caney::optional<boost::asio::const_buffer> const next = queue[run_end].get_const_buffer();
+				if (!next || next->size() >= m_options.coalesce_threshold) break;
+				run_bytes += next->size();
+				++run_end;
+			}
+
+			if (run_end - i < 2) {
+				// might be larger than a single write
+				if (c_buffer->size() > 0) m_write_prepared.append(chunk(queue[i]));
+				total += c_buffer->size();
+				++i;
+				continue;
+			}
+
+			// copy run into pooled buffers
+			for (; i < run_end; ++i) {
+				boost::asio::const_buffer const small = *queue[i].get_const_buffer();
+				if (merged.size() - merged_used < small.size()) {
+					finish_merged();
+					if (m_write_prepared.queue().size() == max_chunks) break;
+					merged = memory::unique_buf::allocate(impl::asio_coalesce_pool());
+				}
+				std::memcpy(merged.data() + merged_used, small.data(), small.size());
+				merged_used += small.size();
+			}
+			finish_merged();
+		}
+	}
+
+	// send file chunks at the front of the queue with sendfile() until the socket would block
+	void start_write_file() {
+		boost::system::error_code bec;
+		if (!m_socket.non_blocking()) m_socket.non_blocking(true, bec);
+		if (bec) {
 			m_is_writing = false;
-			if (error) {
-				boost::system::error_code ec;
-				m_socket.close(ec);
-				source_t::send_end(StreamEnd::Aborted);
-				sink_t::disconnect();
-			} else {
-				m_write_queue.remove(file_size{bytes_transferred});
-				start_write();
+			on_write_error();
+			return;
+		}
+
+		while (!m_write_queue.empty()) {
+			file_chunk const* fc = m_write_queue.queue().front().get_file_chunk();
+			if (!fc) break;
+
+			std::error_code ec;
+			std::size_t const sent = fc->send_to(m_socket.native_handle(), ec);
+			if (ec == std::errc::operation_would_block || ec == std::errc::resource_unavailable_try_again) {
+				std::weak_ptr<asio_endpoint> weak_self{shared_from_this()};
+				m_socket.async_wait(socket_t::wait_write, m_strand->wrap(impl::make_handler_with_memory(m_write_handler_memory, [weak_self, this](const boost::system::error_code& error) {
+					std::shared_ptr<asio_endpoint> self = weak_self.lock();
+					if (!self) return;
+					if (error) {
+						m_is_writing = false;
+						on_write_error();
+					} else {
+						start_write_file();
+					}
+				})));
+				return;
+			} else if (ec) {
+				m_is_writing = false;
+				on_write_error();
+				return;
 			}
-		}));
+			consume(sent);
+		}
+
+		m_is_writing = false;
+		start_write();
+	}
+
+	// splice_sink
+	bool splice_ready() const override {
+		return !m_is_writing && m_write_queue.empty() && !m_corked && !m_end_pending && m_socket.is_open();
+	}
+
+	void splice_write(splice_pipe& pipe, std::error_code& ec) override {
+		boost::system::error_code bec;
+		if (!m_socket.non_blocking()) m_socket.non_blocking(true, bec);
+		if (!bec) pipe.drain(m_socket.native_handle(), ec);
+		if (bec || (ec && ec != std::errc::operation_would_block && ec != std::errc::resource_unavailable_try_again)) {
+			if (!ec) ec = std::make_error_code(std::errc::io_error);
+			on_write_error();
+		}
+	}
+
+	void splice_wait(std::function<void()> handler) override {
+		m_is_writing = true;
+		std::weak_ptr<asio_endpoint> weak_self{shared_from_this()};
+		m_socket.async_wait(
+			socket_t::wait_write, m_strand->wrap(impl::make_handler_with_memory(m_write_handler_memory, [weak_self, this, handler](const boost::system::error_code& error) {
+				std::shared_ptr<asio_endpoint> self = weak_self.lock();
+				if (!self) return;
+				m_is_writing = false;
+				if (error) {
+					on_write_error();
+				} else {
+					handler();
+				}
+			})));
 	}
 
 	void on_receive(chunks_t&& chunks) override {
+		sink_t::buffered_add(chunks);
+		// empty chunks would never be consumed by a write (and stall the queue)
+		auto const& queue = chunks.queue();
+		auto const is_empty = [](chunk const& c) { return file_size{0} == c.bytes(); };
+		if (std::any_of(queue.begin(), queue.end(), is_empty)) {
+			chunks_t filtered;
+			for (chunk const& c : queue) {
+				if (!is_empty(c)) filtered.append(chunk(c));
+			}
+			chunks = std::move(filtered);
+		}
 		m_write_queue.append(std::move(chunks));
 		start_write();
 	}
 
+	// handler memory is released before the handler runs, i.e. before the next operation of the same kind starts
+	std::shared_ptr<impl::handler_memory> m_read_handler_memory = std::make_shared<impl::handler_memory>();
+	std::shared_ptr<impl::handler_memory> m_write_handler_memory = std::make_shared<impl::handler_memory>();
+
+	std::unique_ptr<read_buffer_provider> m_read_buffers;
 	memory::unique_buf m_read_buffer;
 	bool m_is_reading = false, m_got_fin = false;
+	std::uint64_t m_uring_recv = 0; // id of the io_uring receive (0: none)
+	bool m_uring_canceled = false;
+
+	std::unique_ptr<splice_pipe> m_splice_pipe; // created when first relaying to a socket endpoint
+	bool m_splice_waiting = false; // waiting for the sink to take data from the pipe
+	std::uint64_t m_spliced_bytes = 0;
 
 	chunks_t m_write_queue;
-	bool m_is_writing = false;
+	bool m_is_writing = false, m_end_pending = false;
+	std::array<boost::asio::const_buffer, impl::asio_max_write_buffers> m_write_buffers;
+	chunks_t m_write_prepared; // front of the write queue for the next writes, runs of small chunks coalesced
+	bool m_corked = false;
+	std::size_t m_flush_bytes = 0; // bytes to write before the flush is complete
 
+	asio_endpoint_options m_options;
 	shared_strand_t m_strand;
 	socket_t m_socket;
 };
 
-template class asio_endpoint<boost::asio::ip::tcp>;
+extern template class asio_endpoint<boost::asio::ip::tcp>;
 
 __CANEY_STREAMSV1_END
@@ -1,13 +1,12 @@
 #pragma once
 
 #include "caney/memory/buffer.hpp"
+#include "caney/std/small_ring.hpp"
 
 #include "file_chunk.hpp"
 #include "generic_chunks.hpp"
 #include "internal.hpp"
 
-#include <list>
-
 #include <boost/variant.hpp>
 
 __CANEY_STREAMSV1_BEGIN
@@ -33,6 +32,11 @@ public:
 	/** @brief access underlying storage */
 	boost::asio::const_buffer get_const_buffer() const;
 
+	/** @brief underlying storage (to share slices of it without copying) */
+	memory::shared_const_buf const& buffer() const {
+		return m_buffer;
+	}
+
 private:
 	memory::shared_const_buf m_buffer;
 };
@@ -40,17 +44,21 @@ private:
 /**
  * @brief stores a chunk and provides convenient access to it.
  *
- * right now only @ref memory_chunk is supported.
- * TODO: support @ref file_chunk
+ * Either a @ref memory_chunk or a @ref file_chunk; the latter doesn't
+ * provide direct memory access (@ref get_const_buffer), use
+ * @ref get_file_chunk to send it with @ref file_chunk::send_to.
  */
 class chunk {
 public:
 	/** @brief underlying value type storing the actual chunk */
-	using value_t = boost::variant<memory_chunk>;
+	using value_t = boost::variant<memory_chunk, file_chunk>;
 
 	/** @brief construct a @ref chunk from a @ref memory_chunk */
 	explicit chunk(memory_chunk&& chunk);
 
+	/** @brief construct a @ref chunk from a @ref file_chunk */
+	explicit chunk(file_chunk&& chunk);
+
 	/** @brief construct a @ref chunk using @ref memory_chunk from @ref memory::shared_const_buf */
 	explicit chunk(memory::shared_const_buf&& buffer);
 
@@ -69,6 +77,16 @@ public:
 	 */
 	caney::optional<boost::asio::const_buffer> get_const_buffer() const;
 
+	/** @brief @ref memory_chunk if the chunk is stored in memory, nullptr otherwise */
+	memory_chunk const* get_memory_chunk() const {
+		return boost::get<memory_chunk>(&m_value);
+	}
+
+	/** @brief @ref file_chunk if the chunk is stored in a file, nullptr otherwise */
+	file_chunk const* get_file_chunk() const {
+		return boost::get<file_chunk>(&m_value);
+	}
+
 	/** @brief get underlying chunk value */
 	value_t const& get() const {
 		return m_value;
@@ -81,11 +99,15 @@ private:
 /**
  * @brief A queue of @ref chunk.
  * Also keeps track of how may bytes there are in the queue.
+ *
+ * Chunks are stored in a @ref caney::small_ring: the first few chunks
+ * don't need any allocation, and a queue in steady state reuses its
+ * buffer.
  */
 class chunk_queue {
 public:
 	/** @brief container to manage list of chunks */
-	using container_t = std::list<chunk>;
+	using container_t = caney::small_ring<chunk, 4>;
 
 	chunk_queue() = default;
 	/** @brief construct container containing one chunk */
@@ -99,6 +121,10 @@ public:
 	bool empty() const;
 	/** @brief drop all chunks */
 	void clear();
+	/** @brief total size of all chunks in bytes */
+	file_size bytes() const {
+		return m_bytes;
+	}
 
 	/** @brief read-only view of the underlying queue */
 	container_t const& queue() const;
@@ -134,6 +160,16 @@ struct chunk_traits_t<chunk> {
 		return chunks.clear();
 	}
 
+	/** @brief number of chunks */
+	static std::size_t count(chunks_t const& chunks) {
+		return chunks.queue().size();
+	}
+
+	/** @brief size of chunks in bytes */
+	static std::size_t bytes(chunks_t const& chunks) {
+		return static_cast<std::size_t>(chunks.bytes().get());
+	}
+
 	/** @brief reasons a stream could end for */
 	using end_t = StreamEnd;
 };
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "caney/memory/buffer.hpp"
+#include "caney/memory/intrusive_buffer_pool.hpp"
+#include "caney/std/tags.hpp"
+
+#include "asio.hpp"
+#include "internal.hpp"
+#include "streams.hpp"
+
+#include <cstdint>
+#include <memory>
+
+#include <boost/asio.hpp>
+
+__CANEY_STREAMSV1_BEGIN
+
+/**
+ * @brief a single UDP datagram (the chunk type of @ref datagram_endpoint)
+ */
+struct datagram {
+	/**
+	 * @brief sender of a received datagram / destination of a datagram to
+	 *     send (port 0: the peer of a connected socket)
+	 */
+	boost::asio::ip::udp::endpoint peer;
+	memory::shared_const_buf data; //!< payload
+};
+
+/**
+ * @brief configuration for @ref datagram_endpoint
+ */
+struct datagram_endpoint_options {
+	std::size_t batch_size{32}; //!< max number of messages per `recvmmsg(2)` / `sendmmsg(2)` call
+	std::size_t max_datagram_size{2048}; //!< larger datagrams are dropped (without GRO)
+	std::size_t receive_buffer_size{64 * 1024}; //!< size of the pooled buffers datagrams are received into
+	std::size_t max_batches_per_wakeup{4}; //!< max number of receive calls before other handlers get a chance to run
+	/**
+	 * @brief datagrams up to this size are copied if the receive buffer
+	 *     couldn't hold another datagram afterwards, so small datagrams
+	 *     don't take (and pin) a whole receive buffer each
+	 */
+	std::size_t copy_threshold{2048};
+	/**
+	 * @brief use UDP generic receive offload if supported; every receive
+	 *     slot needs 64 KiB then (datagrams not coalesced by GRO are copied
+	 *     up to @ref copy_threshold)
+	 */
+	bool gro{false};
+	bool gso{true}; //!< use UDP generic segmentation offload if supported
+	std::size_t write_high_watermark{1024}; //!< pause origin of the datagrams to send while more are queued (0: unlimited)
+	std::size_t write_low_watermark{256}; //!< resume origin when the queue dropped to this many datagrams
+};
+
+/**
+ * @brief counters of a @ref datagram_endpoint
+ */
+struct datagram_endpoint_stats {
+	std::uint64_t received{0}; //!< datagrams received
+	std::uint64_t receive_calls{0}; //!< receive syscalls returning data
+	std::uint64_t truncated{0}; //!< datagrams dropped because they didn't fit the receive buffer
+	std::uint64_t copied{0}; //!< received datagrams copied out of the receive buffers (see @ref datagram_endpoint_options::copy_threshold)
+	std::uint64_t sent{0}; //!< datagrams sent
+	std::uint64_t send_calls{0}; //!< successful send syscalls
+	std::uint64_t send_errors{0}; //!< datagrams dropped because sending them failed
+};
+
+namespace impl {
+	struct datagram_batch;
+} // namespace impl
+
+/**
+ * @brief An endpoint for UDP sockets.
+ *
+ * Provides a sink (to send datagrams), a source (to receive datagrams), an
+ * origin (to pause receiving datagrams).
+ *
+ * Datagrams are received in batches with `recvmmsg(2)` into buffers from a
+ * @ref memory::intrusive_buffer_pool, and sent in batches with
+ * `sendmmsg(2)`. If supported by the kernel, runs of equally sized
+ * datagrams to the same peer are sent as a single message with UDP GSO
+ * (`UDP_SEGMENT`), and (with @ref datagram_endpoint_options::gro) UDP GRO
+ * coalesced datagrams are split again when received.
+ *
+ * Like @ref asio_endpoint the endpoint waits for readability and then
+ * receives until the socket has no more data (or
+ * @ref datagram_endpoint_options::max_batches_per_wakeup is reached); while
+ * the origin is paused datagrams stay in the kernel (and are dropped by it
+ * if its buffer is full).
+ *
+ * Failing to send a datagram (e.g. no route to the peer) drops it; only
+ * fatal socket errors end the streams.
+ */
+class datagram_endpoint : public sink<datagram>,
+						  public source<datagram>,
+						  public origin,
+						  public std::enable_shared_from_this<datagram_endpoint> {
+public:
+	/** @brief the endpoints sink type */
+	using sink_t = sink<datagram>;
+	/** @brief the endpoints source type */
+	using source_t = source<datagram>;
+	/** @brief the endpoints chunkqueue type */
+	using chunks_t = chunk_traits_t<datagram>::chunks_t;
+	/** @brief the endpoints stream end type */
+	using end_t = chunk_traits_t<datagram>::end_t;
+
+	/** @brief share strands with this type */
+	using shared_strand_t = std::shared_ptr<boost::asio::io_context::strand>;
+	/** @brief boost socket type */
+	using socket_t = boost::asio::ip::udp::socket;
+
+	/** @brief create instance */
+	static std::shared_ptr<datagram_endpoint> create(shared_strand_t strand, socket_t&& sock, datagram_endpoint_options options = datagram_endpoint_options());
+
+	//! @nowarn
+	/** @internal @brief private constructor */
+	datagram_endpoint(private_tag_t, shared_strand_t strand, socket_t&& sock, datagram_endpoint_options options);
+	//! @endnowarn
+
+	~datagram_endpoint();
+
+	/** @brief whether received datagrams can be coalesced by UDP GRO */
+	bool uses_gro() const {
+		return m_gro;
+	}
+
+	/** @brief whether datagrams are sent with UDP GSO */
+	bool uses_gso() const {
+		return m_gso;
+	}
+
+	/** @brief counters (only access in the strand) */
+	datagram_endpoint_stats const& stats() const {
+		return m_stats;
+	}
+
+private:
+	// source events
+	void on_pause() override;
+	void on_resume() override;
+	void on_disconnect() override;
+	void on_connected_sink() override;
+
+	// sink events
+	void on_connected_source() override;
+	void on_end(end_t end) override;
+	void on_receive(chunks_t&& chunks) override;
+
+	void start_read();
+	void read_available();
+	void start_write();
+	void write_available();
+	void on_error();
+
+	// handler memory is released before the handler runs, i.e. before the next operation of the same kind starts
+	std::shared_ptr<impl::handler_memory> m_read_handler_memory = std::make_shared<impl::handler_memory>();
+	std::shared_ptr<impl::handler_memory> m_write_handler_memory = std::make_shared<impl::handler_memory>();
+
+	std::unique_ptr<impl::datagram_batch> m_batch;
+	memory::intrusive_buffer_pool<> m_receive_pool;
+	bool m_is_reading = false;
+
+	chunks_t m_write_queue;
+	bool m_is_writing = false;
+
+	bool m_gro = false, m_gso = false;
+	datagram_endpoint_stats m_stats;
+	datagram_endpoint_options m_options;
+	shared_strand_t m_strand;
+	socket_t m_socket;
+};
+
+__CANEY_STREAMSV1_END
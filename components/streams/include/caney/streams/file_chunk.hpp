@@ -3,16 +3,22 @@
 #include "caney/memory/buffer.hpp"
 #include "caney/std/optional.hpp"
 
+#include "file_handle.hpp"
 #include "file_size.hpp"
 #include "internal.hpp"
 
+#include <functional>
 #include <system_error>
 
+#include <boost/asio/executor.hpp>
+
 __CANEY_STREAMSV1_BEGIN
 
-class file_handle;
+class chunk_queue;
+class file_io_pool;
 
-// TODO: this probably requires some log concept. use boost logging?
+/** @brief completion handler for asynchronous file reads; receives memory chunks */
+using file_read_handler = std::function<void(std::error_code ec, chunk_queue data)>;
 
 /**
  * @brief represents a chunk of a file on disk
@@ -48,8 +54,32 @@ public:
 		return m_handle;
 	}
 
-	/** @brief (possibly asynchronous???) read some data from the chunk. TBD. */
-	void read(std::size_t max_size, std::function<void(std::error_code ec, std::shared_ptr<memory::unique_buf> buffer)> callback);
+	/**
+	 * @brief send (some of) the chunk to a socket or pipe without copying it through user space
+	 *
+	 * Uses `sendfile(2)`; doesn't modify the chunk (call @ref remove with the
+	 * returned number of bytes). A non-blocking `fd` reports
+	 * `std::errc::operation_would_block` if it isn't ready for writing.
+	 * If the file got truncated `std::errc::no_message_available` is reported.
+	 *
+	 * @param fd destination file descriptor
+	 * @param ec set on error
+	 * @return number of bytes sent
+	 */
+	std::size_t send_to(int fd, std::error_code& ec) const;
+
+	/**
+	 * @brief asynchronously read (the start of) the chunk into memory
+	 *
+	 * Doesn't modify the chunk (call @ref remove with the number of bytes
+	 * received). See @ref file_io_pool::read.
+	 *
+	 * @param pool     I/O thread pool to read in
+	 * @param executor executor to run `handler` on
+	 * @param max_size max number of bytes to read
+	 * @param handler  completion handler
+	 */
+	void read(file_io_pool& pool, boost::asio::executor executor, std::size_t max_size, file_read_handler handler) const;
 
 private:
 	std::shared_ptr<file_handle> m_handle;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "file_size.hpp"
+#include "internal.hpp"
+
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <boost/noncopyable.hpp>
+
+__CANEY_STREAMSV1_BEGIN
+
+/**
+ * @brief owns a (read-only) file descriptor for @ref file_chunk
+ *
+ * Shared by all chunks referring to (parts of) the same file; the
+ * descriptor is closed when the last chunk is gone.
+ */
+class file_handle : private boost::noncopyable {
+public:
+	/** @brief take ownership of file descriptor `fd` */
+	explicit file_handle(int fd) noexcept;
+	~file_handle();
+
+	/**
+	 * @brief open file for reading
+	 * @param path file to open
+	 * @param ec set on error
+	 * @return handle or nullptr on error
+	 */
+	static std::shared_ptr<file_handle> open(std::string const& path, std::error_code& ec);
+
+	/** @brief underlying file descriptor */
+	int native_handle() const {
+		return m_fd;
+	}
+
+	/**
+	 * @brief current size of the file
+	 * @param ec set on error
+	 */
+	file_size size(std::error_code& ec) const;
+
+private:
+	int const m_fd;
+};
+
+__CANEY_STREAMSV1_END
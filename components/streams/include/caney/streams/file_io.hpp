@@ -0,0 +1,150 @@
+#pragma once
+
+#include "caney/memory/intrusive_buffer_pool.hpp"
+
+#include "chunks.hpp"
+#include "file_chunk.hpp"
+#include "file_handle.hpp"
+#include "internal.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/executor.hpp>
+#include <boost/noncopyable.hpp>
+
+__CANEY_STREAMSV1_BEGIN
+
+class io_uring_engine;
+
+/**
+ * @brief configuration for @ref file_io_pool
+ */
+struct file_io_options {
+	std::size_t threads{2}; //!< number of I/O threads
+	std::size_t max_queue_depth{128}; //!< max number of queued (not yet started) reads; further reads are rejected
+	std::size_t buffer_size{64 * 1024}; //!< size of the pooled buffers reads are filled into
+	bool io_uring{true}; //!< read through an @ref io_uring_engine (in a single thread, instead of the thread pool) if available
+};
+
+/**
+ * @brief statistics of a @ref file_io_pool
+ *
+ * Latency is measured per request from submission until the data was read
+ * (not including the time the completion handler waits in its executor).
+ */
+struct file_io_metrics {
+	std::uint64_t submitted{0}; //!< number of accepted reads
+	std::uint64_t completed{0}; //!< number of finished reads (including failed ones)
+	std::uint64_t failed{0}; //!< number of reads which failed with an error
+	std::uint64_t rejected{0}; //!< number of reads rejected because the queue was full
+	std::uint64_t bytes{0}; //!< number of bytes read
+	std::size_t queue_depth{0}; //!< current number of queued reads
+	std::size_t max_queue_depth{0}; //!< highest number of queued reads seen
+	std::chrono::nanoseconds total_latency{0}; //!< sum of latencies of completed reads
+	std::chrono::nanoseconds max_latency{0}; //!< max latency of completed reads
+	/** @brief log2 latency histogram: entry `i` counts reads taking [2^i, 2^(i+1)) microseconds (first and last bucket open) */
+	std::array<std::uint64_t, 24> latency_histogram{{}};
+
+	/** @brief average latency of completed reads */
+	std::chrono::nanoseconds average_latency() const {
+		return 0 == completed ? std::chrono::nanoseconds{0} : total_latency / static_cast<std::int64_t>(completed);
+	}
+};
+
+/**
+ * @brief thread pool to read files asynchronously
+ *
+ * Reads use `preadv(2)` to fill (one or more) buffers from an
+ * @ref memory::intrusive_buffer_pool at once; the data is passed as
+ * @ref chunk_queue of memory chunks to the completion handler, which is
+ * posted to the executor passed with the request.
+ *
+ * At most @ref file_io_options::max_queue_depth reads wait for a thread;
+ * further requests complete immediately with
+ * `std::errc::resource_unavailable_try_again`. Destroying the pool cancels
+ * queued requests (`std::errc::operation_canceled`) and waits for running
+ * reads to finish.
+ *
+ * If io_uring is available (see @ref file_io_options::io_uring) a single
+ * thread passes all queued reads to an @ref io_uring_engine in batches
+ * (reading into registered buffers) instead; should the kernel reject
+ * submissions, that thread falls back to `preadv(2)`.
+ */
+class file_io_pool : private boost::noncopyable {
+public:
+	/** @brief start I/O threads */
+	explicit file_io_pool(file_io_options options = file_io_options());
+	~file_io_pool();
+
+	/**
+	 * @brief read from file
+	 *
+	 * Reads stop early at the end of the file; at (or after) the end of
+	 * the file an empty @ref chunk_queue is returned without error.
+	 *
+	 * @param handle   file to read from
+	 * @param offset   position in file to read at
+	 * @param size     max number of bytes to read
+	 * @param executor executor to run `handler` on
+	 * @param handler  completion handler
+	 */
+	void read(std::shared_ptr<file_handle> handle, file_size offset, std::size_t size, boost::asio::executor executor, file_read_handler handler);
+
+	/** @brief snapshot of statistics */
+	file_io_metrics metrics() const;
+
+	/** @brief whether reads go through io_uring */
+	bool uses_io_uring() const {
+		return bool(m_ring);
+	}
+
+	/** @brief size of buffers reads are filled into */
+	std::size_t buffer_size() const {
+		return m_options.buffer_size;
+	}
+
+private:
+	using clock_t = std::chrono::steady_clock;
+
+	struct request {
+		std::shared_ptr<file_handle> handle;
+		file_size offset;
+		std::size_t size;
+		boost::asio::executor executor;
+		file_read_handler handler;
+		clock_t::time_point submitted;
+	};
+
+	static void complete(request& req, std::error_code ec, chunk_queue data);
+	void run();
+	void run_ring();
+	void wakeup_ring();
+	void process(request& req);
+	chunk_queue execute(request const& req, std::error_code& ec);
+	void record(clock_t::duration latency, std::size_t bytes, bool failed);
+
+	file_io_options const m_options;
+	memory::intrusive_buffer_pool<> m_buffers;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::deque<request> m_queue;
+	bool m_stopping{false};
+	file_io_metrics m_metrics;
+
+	std::unique_ptr<io_uring_engine> m_ring; // only used by the ring thread
+	int m_wakeup_fd{-1}; // eventfd waking the ring thread for new requests
+
+	std::vector<std::thread> m_threads;
+};
+
+__CANEY_STREAMSV1_END
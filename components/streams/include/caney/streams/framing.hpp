@@ -0,0 +1,185 @@
+#pragma once
+
+#include "caney/std/tags.hpp"
+
+#include "chunks.hpp"
+#include "internal.hpp"
+#include "streams.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <system_error>
+
+__CANEY_STREAMSV1_BEGIN
+
+/**
+ * @brief a message cut out of a byte stream by a @ref framing_transform
+ */
+struct frame {
+	/**
+	 * @brief frame content without length prefix / delimiter
+	 *
+	 * Slices of the received chunks (no copy); contains several slices if
+	 * the frame was spread over several received chunks.
+	 */
+	chunk_queue payload;
+	/** @brief format specific kind of frame (see @ref peer_wire_format::handshake_tag) */
+	std::uint32_t tag{0};
+};
+
+/** @brief location of the next frame in the buffered input (see @ref frame_format::next) */
+struct frame_bounds {
+	std::size_t header{0}; //!< bytes before the payload (dropped)
+	std::uint64_t payload{0}; //!< payload size
+	std::size_t trailer{0}; //!< bytes after the payload (dropped)
+	std::uint32_t tag{0}; //!< @ref frame::tag
+};
+
+/**
+ * @brief determines where frames start and end
+ */
+class frame_format {
+public:
+	virtual ~frame_format() = default;
+
+	/**
+	 * @brief find the next frame at the start of the buffered input
+	 *
+	 * Returns false if more input is needed (or on error, setting `ec`).
+	 * Called again with more input appended or the found frame removed.
+	 */
+	virtual bool next(chunk_queue const& input, frame_bounds& bounds, std::error_code& ec) = 0;
+};
+
+/** @brief byte order of integers in frame headers */
+enum class byte_order {
+	big, //!< network byte order
+	little,
+};
+
+/**
+ * @brief frames prefixed with their length as unsigned integer of 1, 2
+ *     or 4 bytes
+ */
+class length_prefix_format final : public frame_format {
+public:
+	/**
+	 * @brief create format; terminates if `width` is not 1, 2 or 4
+	 *
+	 * Frames larger than `max_frame_size` abort the stream with
+	 * `std::errc::message_size`.
+	 */
+	explicit length_prefix_format(std::size_t width, byte_order order = byte_order::big, std::uint64_t max_frame_size = 16 * 1024 * 1024);
+
+	bool next(chunk_queue const& input, frame_bounds& bounds, std::error_code& ec) override;
+
+private:
+	std::size_t const m_width;
+	byte_order const m_order;
+	std::uint64_t const m_max_frame_size;
+};
+
+/**
+ * @brief frames terminated by a delimiter (like "\r\n")
+ *
+ * Remembers how far it searched, so data is scanned only once even if a
+ * frame arrives in many small chunks.
+ */
+class delimiter_format final : public frame_format {
+public:
+	/**
+	 * @brief create format; terminates if `delimiter` is empty
+	 *
+	 * Frames larger than `max_frame_size` (without delimiter) abort the
+	 * stream with `std::errc::message_size`.
+	 */
+	explicit delimiter_format(std::string delimiter, std::uint64_t max_frame_size = 64 * 1024);
+
+	bool next(chunk_queue const& input, frame_bounds& bounds, std::error_code& ec) override;
+
+private:
+	std::string const m_delimiter;
+	std::uint64_t const m_max_frame_size;
+	std::uint64_t m_scanned{0}; // no delimiter starts before this offset
+};
+
+/**
+ * @brief BitTorrent peer wire protocol (BEP 3)
+ *
+ * The first frame is the handshake (`<pstrlen><pstr><reserved><info_hash><peer_id>`,
+ * tagged with @ref handshake_tag, complete including `pstrlen`); all other
+ * frames are messages prefixed with a 4-byte big endian length (payload
+ * is `<id><data>`, empty for keep-alive).
+ */
+class peer_wire_format final : public frame_format {
+public:
+	/** @brief @ref frame::tag of the handshake */
+	static constexpr std::uint32_t handshake_tag = 1;
+
+	/**
+	 * @brief create format
+	 *
+	 * @param expect_handshake whether the stream starts with the handshake
+	 * @param max_message_size larger messages abort the stream with `std::errc::message_size`
+	 */
+	explicit peer_wire_format(bool expect_handshake = true, std::uint64_t max_message_size = 1024 * 1024);
+
+	bool next(chunk_queue const& input, frame_bounds& bounds, std::error_code& ec) override;
+
+private:
+	bool m_expect_handshake;
+	length_prefix_format m_messages;
+};
+
+/**
+ * @brief split a byte stream into @ref frame -s
+ *
+ * Only memory chunks are supported; terminates on other chunk types.
+ *
+ * Framing errors and streams ending in the middle of a frame end the
+ * output with @ref StreamEnd::Aborted; see @ref error.
+ */
+class framing_transform : public transform<chunk, frame> {
+public:
+	/** @brief create transform */
+	static std::shared_ptr<framing_transform> create(std::unique_ptr<frame_format> format);
+
+	/** @brief create transform for @ref length_prefix_format */
+	static std::shared_ptr<framing_transform> length_prefixed(std::size_t width, byte_order order = byte_order::big, std::uint64_t max_frame_size = 16 * 1024 * 1024);
+
+	/** @brief create transform for @ref delimiter_format */
+	static std::shared_ptr<framing_transform> delimited(std::string delimiter, std::uint64_t max_frame_size = 64 * 1024);
+
+	/** @brief create transform for @ref peer_wire_format */
+	static std::shared_ptr<framing_transform> peer_wire(bool expect_handshake = true, std::uint64_t max_message_size = 1024 * 1024);
+
+	//! @nowarn
+	/** @internal @brief private constructor */
+	explicit framing_transform(private_tag_t, std::unique_ptr<frame_format> format);
+	//! @endnowarn
+
+	/** @brief error which aborted the stream */
+	std::error_code error() const {
+		return m_error;
+	}
+
+	/** @brief number of bytes received but not part of a complete frame yet */
+	file_size buffered_bytes() const {
+		return m_input.bytes();
+	}
+
+protected:
+	void on_receive(chunk_queue&& chunks) override;
+	void on_end(StreamEnd end) override;
+
+private:
+	void fail(std::error_code ec);
+
+	std::unique_ptr<frame_format> m_format;
+	chunk_queue m_input;
+	std::error_code m_error;
+	bool m_failed{false};
+};
+
+__CANEY_STREAMSV1_END
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "caney/std/small_ring.hpp"
+
 #include "internal.hpp"
 
-#include <list>
+#include <cstddef>
 
 __CANEY_STREAMSV1_BEGIN
 
@@ -12,15 +14,20 @@ enum class StreamEnd {
 	Aborted, //! aborted (user, IO error, ...)
 };
 
-/** @brief declare ''std::list<Chunk>'' as the default queue type for any @tparam Chunk */
+/**
+ * @brief declare ''small_ring<Chunk, 4>'' as the default queue type for any @tparam Chunk
+ *
+ * A few chunks are stored inline, so sending single chunks doesn't
+ * allocate; specialize chunk_traits_t for a different queue type.
+ */
 template <typename Chunk>
 struct chunk_traits_t {
 	/** @brief generic queue type */
-	using chunks_t = std::list<Chunk>;
+	using chunks_t = small_ring<Chunk, 4>;
 
 	/** @brief move @param chunks to another queue @param to */
 	static void append(chunks_t& to, chunks_t&& chunks) {
-		to.splice(to.end(), std::move(chunks));
+		to.append(std::move(chunks));
 	}
 
 	/** @brief whether there are no chunks (doesn't care whether the chunks itself are empty or not) */
@@ -33,6 +40,16 @@ struct chunk_traits_t {
 		chunks.clear();
 	}
 
+	/** @brief number of chunks */
+	static std::size_t count(chunks_t const& chunks) {
+		return chunks.size();
+	}
+
+	/** @brief size of chunks for watermarks (see @ref sink_base::set_watermarks); generic chunks count as one unit each */
+	static std::size_t bytes(chunks_t const& chunks) {
+		return chunks.size();
+	}
+
 	/** @brief reasons a stream could end for */
 	using end_t = StreamEnd;
 };
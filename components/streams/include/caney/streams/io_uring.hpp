@@ -0,0 +1,284 @@
+#pragma once
+
+#include "caney/memory/buffer.hpp"
+#include "caney/memory/intrusive_buffer_pool.hpp"
+#include "caney/std/tags.hpp"
+
+#include "chunks.hpp"
+#include "file_chunk.hpp"
+#include "file_handle.hpp"
+#include "internal.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+
+struct io_uring_sqe; // <linux/io_uring.h>
+
+__CANEY_STREAMSV1_BEGIN
+
+/**
+ * @brief configuration for @ref io_uring_engine
+ */
+struct io_uring_options {
+	unsigned entries{256}; //!< submission queue size
+	std::size_t buffer_size{16 * 1024}; //!< size of pooled buffers reads and receives are filled into
+	unsigned fixed_buffers{16}; //!< number of pooled buffers registered as fixed buffers for file reads (0: disable)
+	unsigned recv_buffers{64}; //!< number of buffers provided to the kernel for (multishot) receives
+};
+
+/**
+ * @brief counters of an @ref io_uring_engine
+ */
+struct io_uring_stats {
+	std::uint64_t submitted{0}; //!< submission queue entries passed to the kernel
+	std::uint64_t completed{0}; //!< completion queue entries handled
+	std::uint64_t enter_calls{0}; //!< `io_uring_enter(2)` system calls
+};
+
+/**
+ * @brief I/O engine based on Linux io_uring (using the raw system calls)
+ *
+ * Requests are queued in the submission ring and passed to the kernel in
+ * batches by @ref submit, @ref poll or @ref run_once; completion handlers
+ * are called from @ref poll / @ref run_once in the calling thread. The
+ * engine is not thread-safe; it is meant to be driven by a single event
+ * loop thread, e.g. by waiting for @ref event_fd to become readable in a
+ * `boost::asio` reactor.
+ *
+ * - file reads are split into requests of @ref io_uring_options::buffer_size
+ *   bytes, read into registered (fixed) buffers if one is free, or into
+ *   pooled buffers otherwise
+ * - receives use buffers provided to the kernel (buffer selection); the
+ *   data is passed to the handler without copying
+ * - @ref recv_multishot uses a single multishot receive if the kernel
+ *   supports it and falls back to re-arming single receives
+ *
+ * @ref create fails if io_uring isn't available (old kernel, disabled by
+ * seccomp or the `CANEY_NO_IO_URING` environment variable); callers should
+ * fall back to `preadv(2)` and the `boost::asio` (epoll) reactor, like
+ * @ref file_io_pool and @ref asio_endpoint (through @ref io_uring_reactor)
+ * do.
+ *
+ * Destroying the engine cancels all pending requests and waits until the
+ * kernel finished them before the buffers are released; their handlers are
+ * not called.
+ *
+ * If the kernel rejects a submission (other than temporarily) the error is
+ * returned by @ref submit, @ref poll and @ref run_once, and requests which
+ * couldn't be queued complete with it; the engine should be replaced then.
+ */
+class io_uring_engine : private boost::noncopyable {
+public:
+	/** @brief handler for writes: number of bytes written */
+	using handler_t = std::function<void(std::error_code ec, std::size_t bytes)>;
+	/** @brief handler for receives: received data; empty data signals end of stream */
+	using recv_handler_t = std::function<void(std::error_code ec, memory::shared_const_buf data)>;
+
+	/** @brief whether io_uring can be used */
+	static bool is_available();
+
+	/**
+	 * @brief create engine
+	 * @param options configuration
+	 * @param ec set if io_uring isn't available
+	 * @return engine or nullptr on error
+	 */
+	static std::unique_ptr<io_uring_engine> create(io_uring_options options, std::error_code& ec);
+
+	~io_uring_engine();
+
+	/**
+	 * @brief read from file; see @ref file_io_pool::read for semantics
+	 *
+	 * The handler is called from @ref poll / @ref run_once.
+	 */
+	void read(std::shared_ptr<file_handle> handle, file_size offset, std::size_t size, file_read_handler handler);
+
+	/** @brief read (the start of) a file chunk */
+	void read(file_chunk const& chunk, std::size_t max_size, file_read_handler handler);
+
+	/** @brief write (some of) `data` to `fd`; the buffer is kept alive until the write finished */
+	void write(int fd, memory::shared_const_buf data, handler_t handler);
+
+	/**
+	 * @brief receive once from socket `fd`
+	 * @return id for @ref cancel
+	 */
+	std::uint64_t recv(int fd, recv_handler_t handler);
+
+	/**
+	 * @brief receive from socket `fd` until end of stream or an error
+	 *
+	 * The handler is called for each received buffer; after an error or
+	 * end of stream (empty data) it isn't called again.
+	 *
+	 * @return id for @ref cancel
+	 */
+	std::uint64_t recv_multishot(int fd, recv_handler_t handler);
+
+	/**
+	 * @brief cancel a receive; its handler gets `operation_canceled` (unless
+	 *     it completed before the kernel saw the cancel request)
+	 *
+	 * Only call this while the receive is pending: ids get reused after the
+	 * final completion. Cancel receives before closing their socket; the
+	 * kernel keeps the socket open while a request is using it.
+	 */
+	void cancel(std::uint64_t id);
+
+	/**
+	 * @brief pass queued requests to the kernel
+	 * @param ec set if the kernel rejected the requests
+	 * @return number of submitted requests
+	 */
+	std::size_t submit(std::error_code& ec);
+
+	/**
+	 * @brief submit queued requests and handle available completions
+	 * @param ec set if the kernel rejected the requests
+	 * @return number of handled completions
+	 */
+	std::size_t poll(std::error_code& ec);
+
+	/**
+	 * @brief submit queued requests, wait for at least one completion (if
+	 *     there are pending requests) and handle available completions
+	 * @param ec set if the kernel rejected the requests
+	 * @return number of handled completions
+	 */
+	std::size_t run_once(std::error_code& ec);
+
+	/** @brief number of requests (including active multishot receives) waiting for completion */
+	std::size_t pending() const {
+		return m_pending;
+	}
+
+	/** @brief eventfd signaled on completions; call @ref poll when it gets readable */
+	int event_fd() const {
+		return m_event_fd;
+	}
+
+	/** @brief whether file reads can use fixed buffers */
+	bool uses_fixed_buffers() const;
+
+	/** @brief whether multishot receives are used (false after the kernel rejected one) */
+	bool multishot_recv_supported() const {
+		return m_multishot_recv;
+	}
+
+	/** @brief counters */
+	io_uring_stats stats() const {
+		return m_stats;
+	}
+
+private:
+	struct ring;
+	struct fixed_buffers;
+	struct read_request;
+	struct operation;
+
+	explicit io_uring_engine(io_uring_options const& options);
+	bool init(std::error_code& ec);
+
+	std::uint64_t add_operation(std::unique_ptr<operation> op);
+	void release_operation(std::uint64_t user_data);
+	std::uint64_t queue_operation(std::unique_ptr<operation> op, ::io_uring_sqe* sqe);
+	::io_uring_sqe* next_sqe();
+	void provide_buffer(unsigned bid);
+	void provided_buffer(unsigned bid, int result);
+	void start_read_piece(std::shared_ptr<read_request> const& request, std::size_t piece);
+	void start_recv(std::uint64_t user_data);
+	void handle_completion(std::uint64_t user_data, int result, unsigned flags);
+	void drop_completion(std::uint64_t user_data, unsigned flags);
+	void finish_read(read_request& request);
+	std::size_t fail_unqueued();
+	std::size_t submit_queued();
+	void drop_queued();
+	std::size_t reap();
+	bool enter(unsigned to_submit, unsigned min_complete);
+	void shutdown();
+
+	io_uring_options const m_options;
+	std::unique_ptr<ring> m_ring;
+	int m_event_fd{-1};
+	memory::intrusive_buffer_pool<> m_buffers;
+	std::shared_ptr<fixed_buffers> m_fixed;
+	std::vector<memory::unique_buf> m_provided; // indexed by buffer id
+	std::vector<std::unique_ptr<operation>> m_operations; // user_data - 1 is the index
+	std::vector<std::uint64_t> m_free_operations;
+	std::vector<std::uint64_t> m_unqueued; // operations which didn't get a submission queue entry (after m_error)
+	std::size_t m_pending{0};
+	bool m_multishot_recv{true};
+	bool m_closing{false}; // dropping completions in the destructor
+	std::error_code m_error; // kernel rejected submissions
+	std::error_code m_provide_error; // kernel rejected provided buffers
+	io_uring_stats m_stats;
+};
+
+/**
+ * @brief drives an @ref io_uring_engine from a strand (see
+ *     @ref asio_endpoint_options::io_uring)
+ *
+ * Waits for the @ref io_uring_engine::event_fd of the engine with the
+ * `boost::asio` reactor and handles completions in the strand. Requests
+ * queued while strand handlers run are submitted together by a single
+ * handler posted with @ref submit_later, so a wakeup receiving on many
+ * sockets needs only one `io_uring_enter(2)` to re-arm them.
+ *
+ * The engine must only be used in the strand.
+ */
+class io_uring_reactor : public std::enable_shared_from_this<io_uring_reactor>, private boost::noncopyable {
+public:
+	/** @brief share strands with this type */
+	using shared_strand_t = std::shared_ptr<boost::asio::io_context::strand>;
+
+	/**
+	 * @brief create reactor
+	 * @param strand  strand to handle completions in
+	 * @param options configuration for the engine
+	 * @param ec      set if io_uring isn't available
+	 * @return reactor or nullptr on error (use the `boost::asio` reactor then)
+	 */
+	static std::shared_ptr<io_uring_reactor> create(shared_strand_t strand, io_uring_options options, std::error_code& ec);
+
+	//! @nowarn
+	/** @internal @brief private constructor */
+	io_uring_reactor(private_tag_t, shared_strand_t strand, std::unique_ptr<io_uring_engine> engine, int event_fd);
+	//! @endnowarn
+
+	/** @brief the engine */
+	io_uring_engine& engine() {
+		return *m_engine;
+	}
+
+	/** @brief the strand */
+	shared_strand_t const& strand() const {
+		return m_strand;
+	}
+
+	/** @brief submit queued requests (and handle completions) from a handler posted to the strand */
+	void submit_later();
+
+	/** @brief error reported by the engine; requests shouldn't be started anymore */
+	std::error_code const& error() const {
+		return m_error;
+	}
+
+private:
+	void start_wait();
+	void run();
+
+	shared_strand_t m_strand;
+	std::unique_ptr<io_uring_engine> m_engine;
+	boost::asio::posix::stream_descriptor m_event; // duplicate of the eventfd of the engine
+	bool m_submit_posted{false};
+	std::error_code m_error;
+};
+
+__CANEY_STREAMSV1_END
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "caney/std/optional.hpp"
+#include "caney/std/small_ring.hpp"
+#include "caney/std/tags.hpp"
+
+#include "internal.hpp"
+#include "streams.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <boost/asio.hpp>
+
+__CANEY_STREAMSV1_BEGIN
+
+/**
+ * @brief configuration for @ref parallel_transform
+ */
+struct parallel_options {
+	/**
+	 * @brief pause the origin while this many batches are being processed
+	 *     or waiting for earlier batches to finish
+	 */
+	std::size_t max_in_flight{16};
+};
+
+/**
+ * @brief transform running a function on a worker pool, keeping the order
+ *
+ * Each batch of chunks received (i.e. each `on_receive` call) is processed
+ * by the function on one of the workers; batches may be processed
+ * concurrently, but the results are sent in the order the input was
+ * received. The function is called concurrently from several threads and
+ * must not throw.
+ *
+ * The origin is paused while @ref parallel_options::max_in_flight batches
+ * are in flight. A regular stream end is forwarded after all results were
+ * sent; an aborted stream drops results still in flight.
+ *
+ * Everything but the function runs in the strand of the pipeline, which
+ * must be the strand passed to @ref create.
+ */
+template <typename ChunkIn, typename ChunkOut>
+class parallel_transform : public transform<ChunkIn, ChunkOut>, public std::enable_shared_from_this<parallel_transform<ChunkIn, ChunkOut>> {
+public:
+	using transform_t = transform<ChunkIn, ChunkOut>; //!< base transform type
+	using sink_t = sink<ChunkIn>; //!< own sink type
+	using source_t = source<ChunkOut>; //!< own source type
+	using chunks_in_t = typename sink_t::chunks_t; //!< chunk queue type for incoming chunks
+	using chunks_out_t = typename source_t::chunks_t; //!< chunk queue type for outgoing chunks
+	using end_t = typename sink_t::end_t; //!< end stream type
+	using function_t = std::function<chunks_out_t(chunks_in_t chunks)>; //!< function run on the workers
+	using shared_strand_t = std::shared_ptr<boost::asio::io_context::strand>; //!< strand of the pipeline
+	using worker_executor_t = boost::asio::thread_pool::executor_type; //!< executor of the worker pool
+
+	/** @brief create transform */
+	static std::shared_ptr<parallel_transform> create(shared_strand_t strand, worker_executor_t workers, function_t function, parallel_options options = parallel_options()) {
+		return std::make_shared<parallel_transform>(private_tag, std::move(strand), std::move(workers), std::move(function), options);
+	}
+
+	//! @nowarn
+	/** @internal @brief private constructor */
+	parallel_transform(private_tag_t, shared_strand_t strand, worker_executor_t workers, function_t function, parallel_options options)
+	: m_strand(std::move(strand)), m_workers(std::move(workers)), m_function(std::move(function)), m_options(options) {
+		if (0 == m_options.max_in_flight) std::terminate();
+	}
+	//! @endnowarn
+
+	/** @brief number of batches being processed or waiting to be sent */
+	std::size_t in_flight() const {
+		return m_slots.size();
+	}
+
+protected:
+	/** @brief dispatch batch to a worker */
+	void on_receive(chunks_in_t&& chunks) override {
+		if (m_aborted) return;
+		std::uint64_t const seq = m_next_seq++;
+		m_slots.emplace_back();
+		update_pause();
+
+		std::shared_ptr<parallel_transform> self = this->shared_from_this();
+		boost::asio::post(m_workers, [self, seq, chunks = std::move(chunks)]() mutable {
+			chunks_out_t result = self->m_function(std::move(chunks));
+			self->m_strand->post([self, seq, result = std::move(result)]() mutable { self->complete(seq, std::move(result)); });
+		});
+	}
+
+	/** @brief forward stream end after the pending results */
+	void on_end(end_t end) override {
+		if (m_aborted) return;
+		if (StreamEnd::Aborted == end) {
+			m_aborted = true;
+			m_slots.clear();
+			source_t::send_end(end);
+			return;
+		}
+		m_end = std::move(end);
+		finish();
+	}
+
+	/** @brief only resume when there is room for more batches */
+	void on_connected_sink() override {
+		update_pause();
+	}
+
+private:
+	void complete(std::uint64_t seq, chunks_out_t&& result) {
+		if (m_aborted) return;
+		m_slots[static_cast<std::size_t>(seq - m_first_seq)] = std::move(result);
+
+		// send results in order; sending might lead to new batches being appended
+		while (!m_slots.empty() && m_slots.front()) {
+			chunks_out_t out = std::move(*m_slots.front());
+			m_slots.pop_front();
+			++m_first_seq;
+			source_t::send(std::move(out));
+			if (m_aborted) return;
+		}
+		update_pause();
+		finish();
+	}
+
+	void finish() {
+		if (!m_end || !m_slots.empty()) return;
+		end_t end = std::move(*m_end);
+		m_end = caney::nullopt;
+		source_t::send_end(std::move(end));
+	}
+
+	void update_pause() {
+		if (m_slots.size() >= m_options.max_in_flight || !source_t::get_sink()) {
+			sink_t::pause();
+		} else {
+			sink_t::resume();
+		}
+	}
+
+	shared_strand_t m_strand;
+	worker_executor_t m_workers;
+	function_t const m_function;
+	parallel_options const m_options;
+
+	// results by sequence number, starting with m_first_seq
+	caney::small_ring<caney::optional<chunks_out_t>, 16> m_slots;
+	std::uint64_t m_first_seq{0};
+	std::uint64_t m_next_seq{0};
+	caney::optional<end_t> m_end;
+	bool m_aborted{false};
+};
+
+__CANEY_STREAMSV1_END
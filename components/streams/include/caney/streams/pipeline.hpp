@@ -0,0 +1,45 @@
+#pragma once
+
+#include "internal.hpp"
+#include "stats.hpp"
+#include "streams.hpp"
+
+#include <string>
+#include <vector>
+
+__CANEY_STREAMSV1_BEGIN
+
+/**
+ * @brief a stage in a pipeline (see @ref walk_pipeline)
+ */
+struct stage_info {
+	std::string name; //!< (demangled) type of the stage
+	sink_base const* sink{nullptr}; //!< sink side of the stage (nullptr for the first stage)
+	source_base const* source{nullptr}; //!< source side of the stage (nullptr for the last stage)
+	sink_stats in; //!< statistics of the sink side
+	source_stats out; //!< statistics of the source side
+};
+
+/**
+ * @brief collect all stages of the pipeline a source is part of, from the
+ *     first source to the last sink
+ *
+ * Only @ref transform -s connect their sink and source side; for other
+ * objects (like @ref asio_endpoint) sink and source are independent
+ * pipelines.
+ *
+ * Must be called in the strand of the pipeline.
+ */
+std::vector<stage_info> walk_pipeline(source_base const& stage);
+
+/** @brief collect all stages of the pipeline a sink is part of */
+std::vector<stage_info> walk_pipeline(sink_base const& stage);
+
+/**
+ * @brief format stages with their statistics, one line per stage
+ *
+ * Without @ref stats_enabled only the stage types are listed.
+ */
+std::string dump_pipeline(std::vector<stage_info> const& stages);
+
+__CANEY_STREAMSV1_END
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "caney/std/tags.hpp"
+
+#include "chunks.hpp"
+#include "internal.hpp"
+#include "streams.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+__CANEY_STREAMSV1_BEGIN
+
+class rate_limit_filter;
+
+/**
+ * @brief token bucket refilled with `rate` tokens (bytes) per second up
+ *     to `burst` tokens
+ *
+ * Buckets form a hierarchy (e.g. global -> per torrent -> per peer): data
+ * passing a bucket also takes tokens from all its parents, so it is
+ * limited by the most restrictive bucket on the way to the root.
+ *
+ * A new bucket starts full. Not thread-safe: all buckets of a hierarchy
+ * and the filters using them must run in the same strand.
+ */
+class token_bucket {
+public:
+	using clock_t = std::chrono::steady_clock; //!< clock used for refilling
+
+	/**
+	 * @brief create bucket
+	 * @param rate   tokens per second (0: unlimited)
+	 * @param burst  max tokens stored while idle; must not be 0 for limited buckets
+	 * @param parent bucket to take tokens from as well
+	 */
+	static std::shared_ptr<token_bucket> create(std::uint64_t rate, std::uint64_t burst, std::shared_ptr<token_bucket> parent = nullptr);
+
+	//! @nowarn
+	/** @internal @brief private constructor */
+	explicit token_bucket(private_tag_t, std::uint64_t rate, std::uint64_t burst, std::shared_ptr<token_bucket> parent);
+	//! @endnowarn
+
+	/** @brief change limits; keeps the current tokens (capped at the new burst) */
+	void set_rate(std::uint64_t rate, std::uint64_t burst);
+
+	/** @brief tokens per second (0: unlimited) */
+	std::uint64_t rate() const {
+		return m_rate;
+	}
+
+	/** @brief max tokens stored */
+	std::uint64_t burst() const {
+		return m_burst;
+	}
+
+	/** @brief parent bucket */
+	std::shared_ptr<token_bucket> const& parent() const {
+		return m_parent;
+	}
+
+	/** @brief tokens available in this bucket and all parents (max value if all are unlimited) */
+	std::uint64_t available(clock_t::time_point now = clock_t::now());
+
+	/** @brief take tokens from this bucket and all parents; must not exceed @ref available */
+	void consume(std::uint64_t tokens, clock_t::time_point now = clock_t::now());
+
+private:
+	// add tokens for the time passed since the last refill
+	void refill(clock_t::time_point now);
+
+	std::uint64_t m_rate;
+	std::uint64_t m_burst;
+	std::uint64_t m_tokens;
+	clock_t::time_point m_last_refill;
+	std::shared_ptr<token_bucket> m_parent;
+};
+
+/**
+ * @brief timer shared by many @ref rate_limit_filter s to resume them
+ *     when new tokens should be available
+ *
+ * Only runs while at least one filter is waiting for tokens; each tick
+ * wakes all waiting filters (in rotating order, so filters sharing a
+ * parent bucket take turns being served first).
+ */
+class rate_timer : public std::enable_shared_from_this<rate_timer> {
+public:
+	using shared_strand_t = std::shared_ptr<boost::asio::io_context::strand>; //!< strand of the pipelines
+	using clock_t = token_bucket::clock_t; //!< clock of the timer
+
+	/** @brief create timer; `interval` is the time between ticks */
+	static std::shared_ptr<rate_timer> create(shared_strand_t strand, clock_t::duration interval = std::chrono::milliseconds(10));
+
+	//! @nowarn
+	/** @internal @brief private constructor */
+	explicit rate_timer(private_tag_t, shared_strand_t strand, clock_t::duration interval);
+	//! @endnowarn
+
+	/** @brief time between ticks */
+	clock_t::duration interval() const {
+		return m_interval;
+	}
+
+	/** @brief number of filters waiting for the next tick */
+	std::size_t waiting() const {
+		return m_waiting.size();
+	}
+
+private:
+	friend class rate_limit_filter;
+
+	// wake filter on next tick
+	void wait(std::weak_ptr<rate_limit_filter> filter);
+	void start();
+	void tick();
+
+	shared_strand_t m_strand;
+	clock_t::duration const m_interval;
+	boost::asio::steady_timer m_timer;
+	std::vector<std::weak_ptr<rate_limit_filter>> m_waiting;
+	std::size_t m_rotation{0};
+	bool m_running{false};
+};
+
+/**
+ * @brief filter passing data only as fast as a @ref token_bucket (and
+ *     its parents) allows
+ *
+ * Chunks are split at the token boundary; the remainder is kept and the
+ * origin paused until the @ref rate_timer tick after which tokens are
+ * available again. As the filter doesn't receive anything while paused,
+ * the stream end is forwarded after all data was passed on.
+ *
+ * Must run in the strand of the @ref rate_timer.
+ */
+class rate_limit_filter : public filter<chunk>, public std::enable_shared_from_this<rate_limit_filter> {
+public:
+	/** @brief create filter */
+	static std::shared_ptr<rate_limit_filter> create(std::shared_ptr<rate_timer> timer, std::shared_ptr<token_bucket> bucket);
+
+	//! @nowarn
+	/** @internal @brief private constructor */
+	explicit rate_limit_filter(private_tag_t, std::shared_ptr<rate_timer> timer, std::shared_ptr<token_bucket> bucket);
+	//! @endnowarn
+
+	/** @brief bucket tokens are taken from */
+	std::shared_ptr<token_bucket> const& bucket() const {
+		return m_bucket;
+	}
+
+	/** @brief bytes waiting for tokens */
+	file_size queued_bytes() const {
+		return m_queue.bytes();
+	}
+
+protected:
+	void on_receive(chunk_queue&& chunks) override;
+	/** @brief only resume when not waiting for tokens */
+	void on_connected_sink() override;
+
+private:
+	friend class rate_timer;
+
+	// pass on as much as the tokens allow; pause and wait for the timer with a remainder
+	void process();
+	void on_tick();
+
+	std::shared_ptr<rate_timer> m_timer;
+	std::shared_ptr<token_bucket> m_bucket;
+	chunk_queue m_queue;
+	bool m_throttled{false};
+	bool m_waiting{false};
+};
+
+__CANEY_STREAMSV1_END
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "caney/memory/buffer.hpp"
+#include "caney/memory/intrusive_buffer_pool.hpp"
+
+#include "internal.hpp"
+
+#include <cstddef>
+
+__CANEY_STREAMSV1_BEGIN
+
+/**
+ * @brief provides the buffers an endpoint reads into
+ *
+ * An endpoint asks for a buffer of (about) @ref preferred_size bytes
+ * before reading, and reports the number of bytes each read returned.
+ */
+class read_buffer_provider {
+public:
+	virtual ~read_buffer_provider() = default;
+
+	/** @brief allocate buffer for the next read(s) */
+	virtual memory::unique_buf allocate() = 0;
+
+	/** @brief size of buffers returned by @ref allocate */
+	virtual std::size_t preferred_size() const = 0;
+
+	/**
+	 * @brief report a finished read
+	 * @param bytes number of bytes read
+	 * @param capacity size of the buffer the data was read into
+	 */
+	virtual void record(std::size_t bytes, std::size_t capacity) = 0;
+};
+
+/**
+ * @brief buffers from process-wide @ref memory::intrusive_buffer_pool -s
+ *     sized by recent reads
+ *
+ * Buffer sizes are powers of two between @ref min_size and @ref max_size.
+ * A read filling a buffer of (at least) the current size doubles the size;
+ * @ref shrink_after reads in a row using less than a quarter of it halve
+ * the size.
+ */
+class adaptive_read_buffers final : public read_buffer_provider {
+public:
+	static constexpr std::size_t min_size = 2 * 1024; //!< smallest buffer size
+	static constexpr std::size_t max_size = 256 * 1024; //!< largest buffer size
+	static constexpr unsigned shrink_after = 8; //!< number of small reads before buffers get smaller
+
+	/** @brief start with `initial_size` (rounded up to a power of two within the size limits) */
+	explicit adaptive_read_buffers(std::size_t initial_size = 16 * 1024);
+
+	memory::unique_buf allocate() override;
+
+	std::size_t preferred_size() const override {
+		return min_size << m_size_class;
+	}
+
+	void record(std::size_t bytes, std::size_t capacity) override;
+
+private:
+	static memory::intrusive_buffer_pool<>& pool(std::size_t size_class);
+
+	std::size_t m_size_class{0};
+	unsigned m_small_reads{0};
+};
+
+__CANEY_STREAMSV1_END
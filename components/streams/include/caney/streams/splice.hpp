@@ -0,0 +1,110 @@
+#pragma once
+
+#include "internal.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <system_error>
+
+#include <boost/noncopyable.hpp>
+
+__CANEY_STREAMSV1_BEGIN
+
+/**
+ * @brief pipe to move data between file descriptors with `splice(2)`;
+ *     the data never gets copied to user space
+ *
+ * Both ends of the pipe are non-blocking; the other file descriptors
+ * should be non-blocking too.
+ */
+class splice_pipe : private boost::noncopyable {
+public:
+	/** @brief default size of a new pipe */
+	static constexpr std::size_t default_size = 256 * 1024;
+
+	/**
+	 * @brief create new pipe
+	 * @param size requested size of the pipe buffer (best effort)
+	 * @param ec set on error (`function_not_supported` without `splice(2)`)
+	 * @return new pipe or nullptr on error
+	 */
+	static std::unique_ptr<splice_pipe> create(std::size_t size, std::error_code& ec);
+
+	~splice_pipe();
+
+	/** @brief number of bytes in the pipe */
+	std::size_t size() const {
+		return m_size;
+	}
+
+	/** @brief whether pipe is empty */
+	bool empty() const {
+		return 0 == m_size;
+	}
+
+	/**
+	 * @brief move data from `fd` into the pipe
+	 * @param fd file descriptor to read from
+	 * @param max max number of bytes to move
+	 * @param ec set on error (`operation_would_block` if there is no data or the pipe is full)
+	 * @return number of bytes moved, 0 without error at end of file
+	 */
+	std::size_t fill(int fd, std::size_t max, std::error_code& ec);
+
+	/**
+	 * @brief move data from the pipe to `fd`
+	 * @param fd file descriptor to write to
+	 * @param ec set on error (`operation_would_block` if `fd` can't take more data)
+	 * @return number of bytes moved
+	 */
+	std::size_t drain(int fd, std::error_code& ec);
+
+	/**
+	 * @brief copy data from the pipe into memory (for data that can't be spliced anymore)
+	 * @param data buffer to copy to
+	 * @param size size of the buffer
+	 * @param ec set on error
+	 * @return number of bytes copied
+	 */
+	std::size_t read(void* data, std::size_t size, std::error_code& ec);
+
+private:
+	explicit splice_pipe(int read_fd, int write_fd);
+
+	int m_read_fd{-1};
+	int m_write_fd{-1};
+	std::size_t m_size{0};
+};
+
+namespace impl {
+	/**
+	 * @brief sink writing to a socket which accepts data spliced directly
+	 *     from a @ref splice_pipe (see @ref asio_endpoint)
+	 *
+	 * Spliced data bypasses the queue of the sink, so a source must only
+	 * splice while @ref splice_ready returns true. Source and sink must
+	 * share a strand.
+	 */
+	class splice_sink {
+	public:
+		/** @brief whether data can be spliced now (nothing queued or being written) */
+		virtual bool splice_ready() const = 0;
+
+		/**
+		 * @brief move data from the pipe to the socket
+		 *
+		 * On errors other than `operation_would_block` the sink
+		 * handles the error itself (and disconnects from the source).
+		 */
+		virtual void splice_write(splice_pipe& pipe, std::error_code& ec) = 0;
+
+		/** @brief call `handler` once the socket is writable again (the sink isn't @ref splice_ready until then) */
+		virtual void splice_wait(std::function<void()> handler) = 0;
+
+	protected:
+		~splice_sink() = default;
+	};
+} // namespace impl
+
+__CANEY_STREAMSV1_END
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "internal.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief whether sources and sinks collect per-stage statistics (see
+ *     @ref caney::streams::sink_stats and @ref caney::streams::source_stats)
+ *
+ * Set by the `CANEY_STREAMS_STATS` cmake option; it changes the layout of
+ * sources and sinks, so everything using the streams component must be
+ * built with the same value. Without it the counters are not compiled in
+ * at all.
+ */
+#if !defined(CANEY_STREAMS_STATS)
+#define CANEY_STREAMS_STATS 0
+#endif
+
+__CANEY_STREAMSV1_BEGIN
+
+/** @brief whether per-stage statistics are collected */
+constexpr bool stats_enabled = (0 != CANEY_STREAMS_STATS);
+
+/**
+ * @brief statistics of a sink (all zero unless @ref stats_enabled)
+ */
+struct sink_stats {
+	std::uint64_t chunks_in{0}; //!< number of chunks received
+	std::uint64_t bytes_in{0}; //!< size of chunks received (as determined by `chunk_traits_t<Chunk>::bytes`)
+	std::uint64_t callbacks{0}; //!< number of `on_receive` calls
+	std::chrono::nanoseconds callback_time{0}; //!< total time spent in `on_receive` (includes stages called from it)
+	std::chrono::nanoseconds max_callback_time{0}; //!< longest `on_receive` call
+	std::uint64_t pauses{0}; //!< how often the sink paused its origin
+	std::chrono::nanoseconds paused_time{0}; //!< total time the sink was paused (including a currently running pause)
+};
+
+/**
+ * @brief statistics of a source (all zero unless @ref stats_enabled)
+ */
+struct source_stats {
+	std::uint64_t chunks_out{0}; //!< number of chunks passed to sinks
+	std::uint64_t bytes_out{0}; //!< size of chunks passed to sinks
+	std::size_t pending{0}; //!< number of chunks currently waiting in the pending queue
+	std::size_t max_pending{0}; //!< max number of chunks waiting in the pending queue
+};
+
+__CANEY_STREAMSV1_END
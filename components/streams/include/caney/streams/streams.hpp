@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 
 #include "caney/std/object.hpp"
@@ -8,6 +10,7 @@
 #include "generic_chunks.hpp"
 #include "internal.hpp"
 #include "origin.hpp"
+#include "stats.hpp"
 
 __CANEY_STREAMSV1_BEGIN
 
@@ -26,9 +29,35 @@ class source;
  */
 class sink_base : private caney::object {
 public:
-	/** @brief whether the sink is currently pausing the origin */
+	/** @brief whether the sink is currently pausing the origin (manually or because of the watermarks) */
 	bool is_paused() const;
 
+	/** @brief high watermark (0: disabled) */
+	std::size_t high_watermark() const {
+		return m_high_watermark;
+	}
+
+	/** @brief low watermark */
+	std::size_t low_watermark() const {
+		return m_low_watermark;
+	}
+
+	/** @brief number of bytes received but not processed yet */
+	std::size_t buffered() const {
+		return m_buffered;
+	}
+
+	/** @brief statistics of the sink (see @ref stats_enabled) */
+	sink_stats in_stats() const;
+
+	/** @brief source the sink is connected to (see @ref walk_pipeline) */
+	virtual source_base const* upstream() const = 0;
+
+	/** @brief source side of the same stage if this is a @ref transform */
+	virtual source_base const* transform_source() const {
+		return nullptr;
+	}
+
 protected:
 	/**
 	 * @brief pause the origin. while the origin is paused the sink
@@ -58,7 +87,32 @@ private:
 
 	void resume();
 
+	// return true if the new watermarks resumed the sink
+	bool change_watermarks(std::size_t high, std::size_t low);
+
+	// pause or resume origin as needed
+	void update_origin_pause();
+
+	// return true if the watermarks resumed the sink
+	bool update_watermarks();
+
+#if CANEY_STREAMS_STATS
+	// record chunks passed to on_receive and the time it took
+	void record_receive(std::size_t chunks, std::size_t bytes, std::chrono::steady_clock::duration time);
+
+	// track pause time
+	void record_pause_state();
+
+	sink_stats m_stats;
+	std::chrono::steady_clock::time_point m_paused_since;
+	bool m_stats_paused = false;
+#endif
+
 	bool m_is_paused = false;
+	bool m_watermark_paused = false;
+	std::size_t m_buffered = 0;
+	std::size_t m_high_watermark = 0;
+	std::size_t m_low_watermark = 0;
 	std::shared_ptr<origin> m_origin;
 	origin_pause m_origin_pause;
 };
@@ -80,6 +134,22 @@ public:
 		return m_source;
 	}
 
+	source_base const* upstream() const override {
+		return m_source.get();
+	}
+
+	/**
+	 * @brief pause the origin automatically while more than `high` bytes
+	 *     are buffered, until it drops to `low` bytes or less
+	 *
+	 * Only effective for sinks reporting their buffered data (see
+	 * @ref buffered_add). `high == 0` disables the watermarks. Sizes are
+	 * determined by `chunk_traits_t<Chunk>::bytes`.
+	 */
+	void set_watermarks(std::size_t high, std::size_t low) {
+		if (change_watermarks(high, low) && m_source) m_source->send_pending();
+	}
+
 protected:
 	sink() = default;
 
@@ -92,6 +162,24 @@ protected:
 		if (m_source) m_source->send_pending();
 	}
 
+	/** @brief report data received but not processed yet (e.g. queued for writing); checks the watermarks */
+	void buffered_add(std::size_t bytes) {
+		m_buffered += bytes;
+		update_watermarks();
+	}
+
+	/** @brief report received chunks as buffered */
+	void buffered_add(chunks_t const& chunks) {
+		buffered_add(chunk_traits_t<Chunk>::bytes(chunks));
+	}
+
+	/** @brief report buffered data as processed; fetches pending data if this drops below the low watermark */
+	void buffered_remove(std::size_t bytes) {
+		if (bytes > m_buffered) std::terminate();
+		m_buffered -= bytes;
+		if (update_watermarks() && m_source) m_source->send_pending();
+	}
+
 	/**
 	 * @brief receive data from currently connected source
 	 *
@@ -138,6 +226,17 @@ public:
 	 */
 	std::shared_ptr<origin> get_origin() const;
 
+	/** @brief statistics of the source (see @ref stats_enabled) */
+	source_stats out_stats() const;
+
+	/** @brief sink the source is connected to (see @ref walk_pipeline) */
+	virtual sink_base const* downstream() const = 0;
+
+	/** @brief sink side of the same stage if this is a @ref transform */
+	virtual sink_base const* transform_sink() const {
+		return nullptr;
+	}
+
 protected:
 	/** @brief called when a sink is connected to the source */
 	virtual void on_connected_sink() {}
@@ -151,6 +250,10 @@ private:
 
 	// source might be the origin itself: don't keep itself alive here
 	std::weak_ptr<origin> m_origin;
+
+#if CANEY_STREAMS_STATS
+	source_stats m_stats;
+#endif
 };
 
 /**
@@ -170,6 +273,10 @@ public:
 		return m_sink;
 	}
 
+	sink_base const* downstream() const override {
+		return m_sink.get();
+	}
+
 protected:
 	source() = default;
 
@@ -189,11 +296,12 @@ protected:
 	/** @brief send chunks if possible or store them in the pending queue */
 	void send(chunks_t&& chunks) {
 		if (can_send()) {
-			m_sink->on_receive(std::move(chunks));
+			deliver(m_sink, std::move(chunks));
 		} else {
 			m_out_pending = true;
 			if (m_out_end) std::terminate();
 			chunk_traits_t<Chunk>::append(m_out_queue, std::move(chunks));
+			update_pending();
 		}
 	}
 
@@ -232,9 +340,10 @@ private:
 				chunks_t chunks = std::move(m_out_queue);
 				chunk_traits_t<Chunk>::clear(m_out_queue);
 				m_out_pending = bool(m_out_end);
+				update_pending();
 
 				// can_send() might still return false, send directly
-				sink->on_receive(std::move(chunks));
+				deliver(sink, std::move(chunks));
 				if (sink != m_sink) return;
 			}
 
@@ -256,6 +365,29 @@ private:
 		}
 	}
 
+	// pass chunks to the sink
+	void deliver(std::shared_ptr<sink_t> const& to, chunks_t&& chunks) {
+#if CANEY_STREAMS_STATS
+		std::shared_ptr<sink_t> const sink = to; // `to` might get reset in on_receive
+		std::size_t const count = chunk_traits_t<Chunk>::count(chunks);
+		std::size_t const bytes = chunk_traits_t<Chunk>::bytes(chunks);
+		m_stats.chunks_out += count;
+		m_stats.bytes_out += bytes;
+		std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+		sink->on_receive(std::move(chunks));
+		sink->record_receive(count, bytes, std::chrono::steady_clock::now() - start);
+#else
+		to->on_receive(std::move(chunks));
+#endif
+	}
+
+	void update_pending() {
+#if CANEY_STREAMS_STATS
+		m_stats.pending = chunk_traits_t<Chunk>::count(m_out_queue);
+		m_stats.max_pending = std::max(m_stats.max_pending, m_stats.pending);
+#endif
+	}
+
 	std::shared_ptr<sink_t> m_sink;
 
 	// don't send anything while we have stuff pending.
@@ -282,6 +414,14 @@ public:
 	using chunks_in_t = typename sink_t::chunks_t; //!< chunk queue type for incoming chunks
 	using chunks_out_t = typename source_t::chunks_t; //!< chunk queue type for outgoing chunks
 
+	source_base const* transform_source() const override {
+		return static_cast<source_t const*>(this);
+	}
+
+	sink_base const* transform_sink() const override {
+		return static_cast<sink_t const*>(this);
+	}
+
 protected:
 	/** @brief propagate origin by default */
 	void on_new_origin(std::shared_ptr<origin> const& new_origin) override {
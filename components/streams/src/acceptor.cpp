@@ -0,0 +1,216 @@
+#include "caney/streams/acceptor.hpp"
+
+#include <algorithm>
+#include <future>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+__CANEY_STREAMSV1_BEGIN
+
+namespace {
+#if defined(SO_REUSEPORT)
+	using reuse_port_option = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+	std::error_code to_std(boost::system::error_code const& ec) {
+		return std::error_code(ec.value(), std::generic_category());
+	}
+
+	// errors which won't go away by accepting again right away
+	bool is_resource_exhaustion(boost::system::error_code const& error) {
+		return error == boost::asio::error::no_descriptors || error == boost::asio::error::no_buffer_space || error == boost::asio::error::no_memory
+			|| error == boost::system::errc::too_many_files_open_in_system;
+	}
+
+	void pin_thread(std::thread& t, std::size_t cpu) {
+#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(static_cast<int>(cpu), &set);
+		// best effort; might be restricted by the cpuset of the process
+		::pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+		(void) t;
+		(void) cpu;
+#endif
+	}
+} // anonymous namespace
+
+struct sharded_acceptor::shard {
+	explicit shard(std::size_t index)
+	: index(index), work(boost::asio::make_work_guard(io)), strand(std::make_shared<boost::asio::io_context::strand>(io)), backoff(io) {}
+
+	// close listener and stop waiting for the backoff
+	void close() {
+		boost::system::error_code ec;
+		if (listener) listener->close(ec);
+		backoff.cancel(ec);
+	}
+
+	std::size_t const index;
+	boost::asio::io_context io;
+	boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
+	endpoint_t::shared_strand_t strand;
+	std::unique_ptr<boost::asio::ip::tcp::acceptor> listener;
+	boost::asio::steady_timer backoff;
+	asio_endpoint_options endpoint;
+	std::atomic<std::uint64_t> accepted{0};
+	std::atomic<std::uint64_t> accept_errors{0};
+};
+
+sharded_acceptor::sharded_acceptor(acceptor_options options) : m_options(options) {
+	std::size_t threads = m_options.threads;
+	if (0 == threads) threads = std::max(1u, std::thread::hardware_concurrency());
+	m_shards.reserve(threads);
+	for (std::size_t i = 0; i < threads; ++i) {
+		m_shards.emplace_back(new shard(i));
+		shard& s = *m_shards.back();
+		s.endpoint = m_options.endpoint;
+		s.endpoint.io_uring.reset();
+		if (m_options.io_uring) {
+			// falls back to the boost::asio reactor if io_uring isn't available
+			std::error_code ec;
+			s.endpoint.io_uring = io_uring_reactor::create(s.strand, m_options.ring, ec);
+		}
+	}
+}
+
+sharded_acceptor::~sharded_acceptor() {
+	stop();
+}
+
+boost::asio::io_context& sharded_acceptor::context(std::size_t shard) {
+	return m_shards.at(shard)->io;
+}
+
+std::uint64_t sharded_acceptor::accepted(std::size_t shard) const {
+	return m_shards.at(shard)->accepted.load(std::memory_order_relaxed);
+}
+
+std::uint64_t sharded_acceptor::accept_errors(std::size_t shard) const {
+	return m_shards.at(shard)->accept_errors.load(std::memory_order_relaxed);
+}
+
+bool sharded_acceptor::uses_io_uring(std::size_t shard) const {
+	return bool(m_shards.at(shard)->endpoint.io_uring);
+}
+
+bool sharded_acceptor::open_listener(shard& s, boost::asio::ip::tcp::endpoint const& address, bool reuse_port, std::error_code& ec) {
+	std::unique_ptr<boost::asio::ip::tcp::acceptor> listener(new boost::asio::ip::tcp::acceptor(s.io));
+	boost::system::error_code bec;
+	listener->open(address.protocol(), bec);
+	if (!bec) listener->set_option(boost::asio::socket_base::reuse_address(true), bec);
+#if defined(SO_REUSEPORT)
+	if (!bec && reuse_port) listener->set_option(reuse_port_option(true), bec);
+#else
+	if (!bec && reuse_port) bec = boost::asio::error::operation_not_supported;
+#endif
+	if (!bec) listener->bind(address, bec);
+	if (!bec) listener->listen(m_options.backlog, bec);
+	if (bec) {
+		ec = to_std(bec);
+		return false;
+	}
+	s.listener = std::move(listener);
+	return true;
+}
+
+void sharded_acceptor::listen(boost::asio::ip::tcp::endpoint const& address, handler_t handler, std::error_code& ec) {
+	ec.clear();
+	if (m_listening || !handler) std::terminate();
+	m_handler = std::move(handler);
+
+	// first listener decides the port for the others
+	m_reuse_port = m_options.reuse_port && m_shards.size() > 1 && open_listener(*m_shards[0], address, true, ec);
+	if (m_reuse_port) {
+		m_local_endpoint = m_shards[0]->listener->local_endpoint();
+		for (std::size_t i = 1; i < m_shards.size(); ++i) {
+			if (!open_listener(*m_shards[i], m_local_endpoint, true, ec)) {
+				// fall back to a single listener
+				for (std::unique_ptr<shard>& s : m_shards) s->listener.reset();
+				m_reuse_port = false;
+				break;
+			}
+		}
+	}
+	if (!m_reuse_port) {
+		ec.clear();
+		if (!open_listener(*m_shards[0], address, false, ec)) return;
+		m_local_endpoint = m_shards[0]->listener->local_endpoint();
+	}
+
+	m_listening = true;
+	for (std::unique_ptr<shard>& s : m_shards) {
+		if (s->listener) start_accept(*s);
+	}
+	for (std::size_t i = 0; i < m_shards.size(); ++i) start_thread(i);
+}
+
+void sharded_acceptor::start_thread(std::size_t index) {
+	shard& s = *m_shards[index];
+	m_threads.emplace_back([&s]() { s.io.run(); });
+	if (m_options.pin_threads) {
+		std::size_t const cpus = std::max(1u, std::thread::hardware_concurrency());
+		pin_thread(m_threads.back(), index % cpus);
+	}
+}
+
+void sharded_acceptor::start_accept(shard& s) {
+	// with a single listener hand connections round-robin to all shards
+	shard& target = m_reuse_port ? s : *m_shards[m_next_shard++ % m_shards.size()];
+
+	s.listener->async_accept(target.io, [this, &s, &target](boost::system::error_code const& error, boost::asio::ip::tcp::socket sock) {
+		if (error == boost::asio::error::operation_aborted || !s.listener->is_open()) return;
+		if (!error) {
+			// shared_ptr: handler must be copyable
+			std::shared_ptr<boost::asio::ip::tcp::socket> accepted = std::make_shared<boost::asio::ip::tcp::socket>(std::move(sock));
+			target.strand->post([this, &target, accepted]() {
+				std::shared_ptr<endpoint_t> endpoint = endpoint_t::create(target.strand, std::move(*accepted), target.endpoint);
+				++target.accepted;
+				m_handler(std::move(endpoint), target.index);
+			});
+		} else {
+			++s.accept_errors;
+			if (is_resource_exhaustion(error)) {
+				// pending connections stay in the backlog; retrying right away would spin
+				s.backoff.expires_after(m_options.error_backoff);
+				s.backoff.async_wait([this, &s](boost::system::error_code const& timer_error) {
+					if (timer_error == boost::asio::error::operation_aborted || !s.listener->is_open()) return;
+					start_accept(s);
+				});
+				return;
+			}
+		}
+		// keep accepting after other errors (like aborted connections)
+		start_accept(s);
+	});
+}
+
+void sharded_acceptor::stop() {
+	for (std::unique_ptr<shard>& s : m_shards) {
+		if (!s->listener) continue;
+		if (m_threads.empty()) {
+			s->close();
+			continue;
+		}
+		// the listener belongs to the shard thread: close it there and wait for it
+		std::promise<void> closed;
+		shard* const p = s.get();
+		boost::asio::post(s->io, [p, &closed]() {
+			p->close();
+			closed.set_value();
+		});
+		closed.get_future().wait();
+	}
+	for (std::unique_ptr<shard>& s : m_shards) {
+		s->work.reset();
+		s->io.stop();
+	}
+	for (std::thread& t : m_threads) t.join();
+	m_threads.clear();
+}
+
+__CANEY_STREAMSV1_END
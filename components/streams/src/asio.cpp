@@ -0,0 +1,16 @@
+#include "caney/streams/asio.hpp"
+
+__CANEY_STREAMSV1_BEGIN
+
+namespace impl {
+	memory::intrusive_buffer_pool<>& asio_coalesce_pool() {
+		static memory::intrusive_buffer_pool<> pool(4 * 1024);
+		return pool;
+	}
+
+	std::atomic<handler_heap_hook_t> handler_heap_hook{nullptr};
+} // namespace impl
+
+template class asio_endpoint<boost::asio::ip::tcp>;
+
+__CANEY_STREAMSV1_END
@@ -47,6 +47,13 @@ namespace {
 		}
 	};
 
+	struct chunk_bytes_visitor : public boost::static_visitor<file_size> {
+		template <typename T>
+		file_size operator()(T const& content) const {
+			return content.bytes();
+		}
+	};
+
 	struct chunk_get_const_buffer : public boost::static_visitor<caney::optional<boost::asio::const_buffer>> {
 		template <typename T>
 		caney::optional<boost::asio::const_buffer> operator()(T& content) const {
@@ -57,10 +64,12 @@ namespace {
 
 chunk::chunk(memory_chunk&& chunk) : m_value(std::move(chunk)) {}
 
+chunk::chunk(file_chunk&& chunk) : m_value(std::move(chunk)) {}
+
 chunk::chunk(memory::shared_const_buf&& buffer) : chunk(memory_chunk(std::move(buffer))) {}
 
 file_size chunk::bytes() const {
-	return file_size(boost::get<memory_chunk>(m_value).bytes());
+	return boost::apply_visitor(chunk_bytes_visitor(), m_value);
 }
 
 chunk chunk::split(file_size bytes) {
@@ -76,15 +85,19 @@ caney::optional<boost::asio::const_buffer> chunk::get_const_buffer() const {
 }
 
 chunk_queue::chunk_queue(chunk&& c) {
-	m_queue.emplace_back(std::move(c));
+	append(std::move(c));
 }
 
 void chunk_queue::append(chunk&& c) {
+	m_bytes += c.bytes();
 	m_queue.emplace_back(std::move(c));
 }
 
 void chunk_queue::append(chunk_queue&& other) {
-	m_queue.splice(m_queue.end(), std::move(other.m_queue));
+	// takes over the heap buffer of the other queue only if this one has none
+	m_queue.append(std::move(other.m_queue));
+	m_bytes += other.m_bytes;
+	other.clear();
 }
 
 bool chunk_queue::empty() const {
@@ -93,37 +106,43 @@ bool chunk_queue::empty() const {
 
 void chunk_queue::clear() {
 	m_queue.clear();
+	m_bytes = file_size{0};
 }
 
-std::list<chunk> const& chunk_queue::queue() const {
+chunk_queue::container_t const& chunk_queue::queue() const {
 	return m_queue;
 }
 
 chunk_queue chunk_queue::split(file_size bytes) {
+	if (bytes > m_bytes) std::terminate();
 	chunk_queue result;
 	while (bytes > file_size{0}) {
-		if (m_queue.empty()) std::terminate();
-		if (m_queue.front().bytes() >= bytes) {
-			bytes -= m_queue.front().bytes();
-			// move chunk from m_queue to result.m_queue
-			result.m_queue.splice(result.m_queue.end(), m_queue, m_queue.begin());
+		file_size const front_bytes = m_queue.front().bytes();
+		if (front_bytes <= bytes) {
+			// move complete chunk
+			bytes -= front_bytes;
+			result.append(std::move(m_queue.front()));
+			m_queue.pop_front();
 		} else {
 			result.append(m_queue.front().split(bytes));
-			return result;
+			bytes = file_size{0};
 		}
 	}
+	m_bytes -= result.m_bytes;
 	return result;
 }
 
 void chunk_queue::remove(file_size bytes) {
+	if (bytes > m_bytes) std::terminate();
+	m_bytes -= bytes;
 	while (bytes > file_size{0}) {
-		if (m_queue.empty()) std::terminate();
-		if (m_queue.front().bytes() >= bytes) {
-			bytes -= m_queue.front().bytes();
+		file_size const front_bytes = m_queue.front().bytes();
+		if (front_bytes <= bytes) {
+			bytes -= front_bytes;
 			m_queue.pop_front();
 		} else {
 			m_queue.front().remove(bytes);
-			return;
+			bytes = file_size{0};
 		}
 	}
 }
@@ -0,0 +1,432 @@
+#include "caney/streams/datagram.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+__CANEY_STREAMSV1_BEGIN
+
+namespace {
+	constexpr std::size_t max_gro_size = 65535; // GRO coalesces up to 64 KiB
+	constexpr std::size_t max_gso_segments = 64; // UDP_MAX_SEGMENTS
+	constexpr std::size_t max_gso_bytes = 65000; // payload of a GSO message has to fit into a single IP packet
+
+#if defined(__linux__)
+#if defined(UDP_SEGMENT)
+	constexpr int udp_segment_option = UDP_SEGMENT;
+#else
+	constexpr int udp_segment_option = 103;
+#endif
+#if defined(UDP_GRO)
+	constexpr int udp_gro_option = UDP_GRO;
+#else
+	constexpr int udp_gro_option = 104;
+#endif
+
+	bool enable_gro(int fd) {
+		int const on = 1;
+		return 0 == ::setsockopt(fd, IPPROTO_UDP, udp_gro_option, &on, sizeof(on));
+	}
+
+	bool gso_supported(int fd) {
+		int value = 0;
+		socklen_t len = sizeof(value);
+		return 0 == ::getsockopt(fd, IPPROTO_UDP, udp_segment_option, &value, &len);
+	}
+
+	using ::mmsghdr;
+
+	int receive_messages(int fd, mmsghdr* messages, std::size_t count) {
+		return ::recvmmsg(fd, messages, static_cast<unsigned int>(count), MSG_DONTWAIT, nullptr);
+	}
+
+	int send_messages(int fd, mmsghdr* messages, std::size_t count) {
+		return ::sendmmsg(fd, messages, static_cast<unsigned int>(count), MSG_DONTWAIT | MSG_NOSIGNAL);
+	}
+#else
+	bool enable_gro(int) {
+		return false;
+	}
+
+	bool gso_supported(int) {
+		return false;
+	}
+
+	struct mmsghdr {
+		struct msghdr msg_hdr;
+		unsigned int msg_len;
+	};
+
+	// emulate batches with one syscall per datagram
+	int receive_messages(int fd, mmsghdr* messages, std::size_t count) {
+		std::size_t i = 0;
+		for (; i < count; ++i) {
+			ssize_t const r = ::recvmsg(fd, &messages[i].msg_hdr, MSG_DONTWAIT);
+			if (r < 0) break;
+			messages[i].msg_len = static_cast<unsigned int>(r);
+		}
+		return (0 == i) ? -1 : static_cast<int>(i);
+	}
+
+	int send_messages(int fd, mmsghdr* messages, std::size_t count) {
+		std::size_t i = 0;
+		for (; i < count; ++i) {
+			ssize_t const r = ::sendmsg(fd, &messages[i].msg_hdr, MSG_DONTWAIT);
+			if (r < 0) break;
+			messages[i].msg_len = static_cast<unsigned int>(r);
+		}
+		return (0 == i) ? -1 : static_cast<int>(i);
+	}
+#endif
+
+	// pending ICMP errors reported on the socket; they don't affect other datagrams
+	bool is_transient_error(int error) {
+		switch (error) {
+		case ECONNREFUSED:
+		case EHOSTUNREACH:
+		case ENETUNREACH:
+		case EHOSTDOWN:
+		case ENETDOWN:
+		case EMSGSIZE:
+		case EPERM:
+		case EACCES:
+		case EADDRNOTAVAIL:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	// errors caused by a single message to send (like an invalid destination)
+	bool is_message_error(int error) {
+		switch (error) {
+		case EAFNOSUPPORT:
+		case EDESTADDRREQ:
+		case EINVAL:
+			return true;
+		default:
+			return is_transient_error(error);
+		}
+	}
+
+	union control_t {
+		char buf[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	};
+} // anonymous namespace
+
+namespace impl {
+	// message headers for recvmmsg() and sendmmsg()
+	struct datagram_batch {
+		explicit datagram_batch(std::size_t batch_size, std::size_t max_iovecs)
+		: headers(batch_size), iovecs(max_iovecs), addresses(batch_size), controls(batch_size), receive_buffers(batch_size), send_counts(batch_size) {}
+
+		std::vector<mmsghdr> headers;
+		std::vector<struct iovec> iovecs;
+		std::vector<struct sockaddr_storage> addresses;
+		std::vector<control_t> controls;
+		std::vector<memory::unique_buf> receive_buffers;
+		std::vector<std::size_t> send_counts; // number of datagrams in each message to send
+	};
+} // namespace impl
+
+// static
+std::shared_ptr<datagram_endpoint> datagram_endpoint::create(shared_strand_t strand, socket_t&& sock, datagram_endpoint_options options) {
+	std::shared_ptr<datagram_endpoint> self = std::make_shared<datagram_endpoint>(private_tag, std::move(strand), std::move(sock), options);
+	self->set_origin(self);
+	return self;
+}
+
+datagram_endpoint::datagram_endpoint(private_tag_t, shared_strand_t strand, socket_t&& sock, datagram_endpoint_options options)
+: m_receive_pool(std::max({options.receive_buffer_size, options.max_datagram_size, options.gro ? max_gro_size : std::size_t{0}}))
+, m_options(options)
+, m_strand(std::move(strand))
+, m_socket(std::move(sock)) {
+	if (0 == m_options.batch_size || 0 == m_options.max_datagram_size) std::terminate();
+	if (m_socket.is_open()) {
+		m_gro = m_options.gro && enable_gro(m_socket.native_handle());
+		m_gso = m_options.gso && gso_supported(m_socket.native_handle());
+	}
+	m_batch.reset(new impl::datagram_batch(m_options.batch_size, m_options.batch_size * (m_gso ? max_gso_segments : 1)));
+	sink_t::set_watermarks(m_options.write_high_watermark, m_options.write_low_watermark);
+}
+
+datagram_endpoint::~datagram_endpoint() = default;
+
+void datagram_endpoint::on_pause() {
+	// nothing to do: a pending wait for readability doesn't consume any data, and receiving checks the pause state
+}
+
+void datagram_endpoint::on_resume() {
+	start_read();
+}
+
+void datagram_endpoint::start_read() {
+	if (origin::is_paused() || m_is_reading || !m_socket.is_open()) return;
+	m_is_reading = true;
+
+	std::weak_ptr<datagram_endpoint> weak_self{shared_from_this()};
+
+	m_socket.async_wait(socket_t::wait_read, m_strand->wrap(impl::make_handler_with_memory(m_read_handler_memory, [weak_self, this](const boost::system::error_code& error) {
+		std::shared_ptr<datagram_endpoint> self = weak_self.lock();
+		if (!self) return;
+		m_is_reading = false;
+		if (error) {
+			on_error();
+		} else {
+			read_available();
+		}
+	})));
+}
+
+void datagram_endpoint::read_available() {
+	if (origin::is_paused() || !m_socket.is_open()) return;
+
+	impl::datagram_batch& batch = *m_batch;
+	std::size_t const slot_size = m_gro ? max_gro_size : m_options.max_datagram_size;
+	chunks_t datagrams;
+	bool failed = false;
+
+	for (std::size_t batches = 0; batches < m_options.max_batches_per_wakeup; ++batches) {
+		if (origin::is_paused()) break;
+
+		for (std::size_t i = 0; i < m_options.batch_size; ++i) {
+			// the remainder of a buffer is used for the next datagrams
+			if (batch.receive_buffers[i].size() < slot_size) batch.receive_buffers[i] = memory::unique_buf::allocate(m_receive_pool);
+			batch.iovecs[i].iov_base = batch.receive_buffers[i].data();
+			batch.iovecs[i].iov_len = slot_size;
+			struct msghdr& hdr = batch.headers[i].msg_hdr;
+			hdr = msghdr();
+			hdr.msg_name = &batch.addresses[i];
+			hdr.msg_namelen = sizeof(batch.addresses[i]);
+			hdr.msg_iov = &batch.iovecs[i];
+			hdr.msg_iovlen = 1;
+			if (m_gro) {
+				hdr.msg_control = batch.controls[i].buf;
+				hdr.msg_controllen = sizeof(batch.controls[i].buf);
+			}
+		}
+
+		int const received = receive_messages(m_socket.native_handle(), batch.headers.data(), m_options.batch_size);
+		if (received < 0) {
+			int const error = errno;
+			if (EAGAIN == error || EWOULDBLOCK == error) break;
+			if (EINTR == error || is_transient_error(error)) continue;
+			failed = true;
+			break;
+		}
+		++m_stats.receive_calls;
+
+		for (std::size_t i = 0; i < static_cast<std::size_t>(received); ++i) {
+			struct msghdr const& hdr = batch.headers[i].msg_hdr;
+			std::size_t const length = batch.headers[i].msg_len;
+			if (0 != (hdr.msg_flags & MSG_TRUNC)) {
+				++m_stats.truncated;
+				continue;
+			}
+
+			std::size_t segment_size = 0;
+#if defined(__linux__)
+			for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); m_gro && cmsg; cmsg = CMSG_NXTHDR(const_cast<struct msghdr*>(&hdr), cmsg)) {
+				if (IPPROTO_UDP == cmsg->cmsg_level && udp_gro_option == cmsg->cmsg_type) {
+					int value;
+					std::memcpy(&value, CMSG_DATA(cmsg), sizeof(value));
+					segment_size = static_cast<std::size_t>(value);
+				}
+			}
+#endif
+
+			boost::asio::ip::udp::endpoint peer;
+			std::memcpy(peer.data(), &batch.addresses[i], std::min<std::size_t>(hdr.msg_namelen, peer.capacity()));
+			peer.resize(std::min<std::size_t>(hdr.msg_namelen, peer.capacity()));
+
+			memory::unique_buf& buffer = batch.receive_buffers[i];
+			bool const copy = length <= m_options.copy_threshold && buffer.size() - length < slot_size;
+			// a copy keeps the buffer for the next datagrams instead of allocating a new one
+			memory::shared_const_buf data = copy ? memory::shared_const_buf::copy(buffer.data(), length) : buffer.freeze(length);
+			std::size_t const before = datagrams.size();
+			if (0 == segment_size || segment_size >= length) {
+				datagrams.push_back(datagram{peer, std::move(data)});
+			} else {
+				// split GRO coalesced datagrams
+				for (std::size_t offset = 0; offset < length; offset += segment_size) {
+					datagrams.push_back(datagram{peer, data.shared_slice(offset, std::min(segment_size, length - offset))});
+				}
+			}
+			m_stats.received += datagrams.size() - before;
+			if (copy) m_stats.copied += datagrams.size() - before;
+		}
+
+		// socket drained
+		if (static_cast<std::size_t>(received) < m_options.batch_size) break;
+	}
+
+	if (!datagrams.empty()) source_t::send(std::move(datagrams));
+	if (failed) {
+		on_error();
+	} else {
+		start_read();
+	}
+}
+
+void datagram_endpoint::on_error() {
+	boost::system::error_code ec;
+	m_socket.close(ec);
+	source_t::send_end(StreamEnd::Aborted);
+	sink_t::disconnect();
+}
+
+void datagram_endpoint::on_disconnect() {
+	on_error();
+}
+
+void datagram_endpoint::on_connected_sink() {
+	if (!m_socket.is_open()) {
+		source_t::send_end(StreamEnd::Aborted);
+	} else {
+		start_read();
+	}
+}
+
+void datagram_endpoint::on_connected_source() {
+	if (!m_socket.is_open()) disconnect();
+}
+
+void datagram_endpoint::on_end(end_t end) {
+	boost::system::error_code ec;
+
+	switch (end) {
+	case StreamEnd::EndOfStream:
+		// nothing to shut down for datagrams; queued datagrams still get sent
+		break;
+	case StreamEnd::Aborted:
+		m_socket.close(ec);
+		source_t::send_end(StreamEnd::Aborted);
+		break;
+	}
+}
+
+void datagram_endpoint::on_receive(chunks_t&& chunks) {
+	sink_t::buffered_add(chunks);
+	chunk_traits_t<datagram>::append(m_write_queue, std::move(chunks));
+	start_write();
+}
+
+void datagram_endpoint::start_write() {
+	if (m_is_writing || m_write_queue.empty() || !m_socket.is_open()) return;
+	write_available();
+}
+
+void datagram_endpoint::write_available() {
+	impl::datagram_batch& batch = *m_batch;
+	bool failed = false;
+	// new datagrams received while removing sent ones from the queue are handled by this loop
+	m_is_writing = true;
+
+	while (!m_write_queue.empty()) {
+		// build messages from the front of the queue
+		std::size_t messages = 0, iovecs = 0;
+		auto it = m_write_queue.begin();
+		while (it != m_write_queue.end() && messages < m_options.batch_size && iovecs < batch.iovecs.size()) {
+			datagram const& first = *it;
+			std::size_t const segment_size = first.data.size();
+			std::size_t const first_iovec = iovecs;
+			std::size_t count = 0, total = 0;
+
+			// GSO: following datagrams to the same peer with the same size (the last one might be shorter)
+			do {
+				batch.iovecs[iovecs].iov_base = const_cast<unsigned char*>(it->data.data());
+				batch.iovecs[iovecs].iov_len = it->data.size();
+				++iovecs;
+				++count;
+				total += it->data.size();
+				bool const shorter = it->data.size() < segment_size;
+				++it;
+				if (!m_gso || shorter || 0 == segment_size) break;
+			} while (it != m_write_queue.end() && iovecs < batch.iovecs.size() && count < max_gso_segments && it->peer == first.peer
+					 && 0 < it->data.size() && it->data.size() <= segment_size && total + it->data.size() <= max_gso_bytes);
+
+			struct msghdr& hdr = batch.headers[messages].msg_hdr;
+			hdr = msghdr();
+			if (0 != first.peer.port()) {
+				hdr.msg_name = const_cast<void*>(static_cast<void const*>(first.peer.data()));
+				hdr.msg_namelen = static_cast<socklen_t>(first.peer.size());
+			}
+			hdr.msg_iov = &batch.iovecs[first_iovec];
+			hdr.msg_iovlen = count;
+#if defined(__linux__)
+			if (count > 1) {
+				hdr.msg_control = batch.controls[messages].buf;
+				hdr.msg_controllen = CMSG_SPACE(sizeof(std::uint16_t));
+				struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+				cmsg->cmsg_level = IPPROTO_UDP;
+				cmsg->cmsg_type = udp_segment_option;
+				cmsg->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+				std::uint16_t const gso_size = static_cast<std::uint16_t>(segment_size);
+				std::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+			}
+#endif
+			batch.send_counts[messages] = count;
+			++messages;
+		}
+
+		int const sent = send_messages(m_socket.native_handle(), batch.headers.data(), messages);
+		std::size_t done = 0;
+		if (sent < 0) {
+			int const error = errno;
+			if (EAGAIN == error || EWOULDBLOCK == error || ENOBUFS == error) break;
+			if (EINTR == error) continue;
+			if (batch.send_counts[0] > 1 && (EIO == error || EINVAL == error)) {
+				// segmentation offload not usable for this socket
+				m_gso = false;
+				continue;
+			}
+			if (!is_message_error(error)) {
+				failed = true;
+				break;
+			}
+			// drop first message
+			done = batch.send_counts[0];
+			m_stats.send_errors += done;
+		} else {
+			++m_stats.send_calls;
+			for (std::size_t i = 0; i < static_cast<std::size_t>(sent); ++i) done += batch.send_counts[i];
+			m_stats.sent += done;
+		}
+
+		for (std::size_t i = 0; i < done; ++i) m_write_queue.pop_front();
+		// might receive new datagrams
+		sink_t::buffered_remove(done);
+	}
+
+	if (failed) {
+		m_is_writing = false;
+		on_error();
+		return;
+	}
+	if (m_write_queue.empty() || !m_socket.is_open()) {
+		m_is_writing = false;
+		return;
+	}
+
+	// wait until the socket is writable again
+	std::weak_ptr<datagram_endpoint> weak_self{shared_from_this()};
+	m_socket.async_wait(socket_t::wait_write, m_strand->wrap(impl::make_handler_with_memory(m_write_handler_memory, [weak_self, this](const boost::system::error_code& error) {
+		std::shared_ptr<datagram_endpoint> self = weak_self.lock();
+		if (!self) return;
+		if (error) {
+			m_is_writing = false;
+			on_error();
+		} else {
+			write_available();
+		}
+	})));
+}
+
+__CANEY_STREAMSV1_END
@@ -1,5 +1,17 @@
 #include "caney/streams/file_chunk.hpp"
 
+#include "caney/streams/file_io.hpp"
+
+#include "caney/std/error_code.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <limits>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
 __CANEY_STREAMSV1_BEGIN
 
 file_chunk::file_chunk(std::shared_ptr<file_handle> handle, file_size offset, file_size length) : m_handle(handle), m_offset(offset), m_length(length) {}
@@ -18,11 +30,35 @@ void file_chunk::remove(file_size bytes) {
 	m_length -= bytes;
 }
 
-void file_chunk::read(std::size_t max_size, std::function<void(std::error_code ec, std::shared_ptr<memory::unique_buf> buffer)> callback) {
-	if (file_size{max_size} > m_length) max_size = boost::numeric_cast<std::size_t>(m_length.get());
-	if (0 == max_size) {
-		// callback({}, memory::make_unique_buffer<0>());
+std::size_t file_chunk::send_to(int fd, std::error_code& ec) const {
+	ec.clear();
+	if (m_length == file_size{0}) return 0;
+#if defined(__linux__)
+	// sendfile transfers at most 0x7ffff000 bytes at once anyway
+	std::size_t const count = static_cast<std::size_t>(std::min<std::uint64_t>(m_length.get(), std::numeric_limits<std::int32_t>::max()));
+	off_t offset = boost::numeric_cast<off_t>(m_offset.get());
+	for (;;) {
+		ssize_t const sent = ::sendfile(fd, m_handle->native_handle(), &offset, count);
+		if (sent > 0) return static_cast<std::size_t>(sent);
+		if (0 == sent) {
+			// end of file before end of chunk
+			ec = std::make_error_code(std::errc::no_message_available);
+			return 0;
+		}
+		if (EINTR == errno) continue;
+		ec = caney::errno_error_code();
+		return 0;
 	}
+#else
+	(void)fd;
+	ec = std::make_error_code(std::errc::function_not_supported);
+	return 0;
+#endif
+}
+
+void file_chunk::read(file_io_pool& pool, boost::asio::executor executor, std::size_t max_size, file_read_handler handler) const {
+	if (file_size{max_size} > m_length) max_size = boost::numeric_cast<std::size_t>(m_length.get());
+	pool.read(m_handle, m_offset, max_size, std::move(executor), std::move(handler));
 }
 
 __CANEY_STREAMSV1_END
@@ -0,0 +1,38 @@
+#include "caney/streams/file_handle.hpp"
+
+#include "caney/std/error_code.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+__CANEY_STREAMSV1_BEGIN
+
+file_handle::file_handle(int fd) noexcept : m_fd(fd) {}
+
+file_handle::~file_handle() {
+	if (-1 != m_fd) ::close(m_fd);
+}
+
+// static
+std::shared_ptr<file_handle> file_handle::open(std::string const& path, std::error_code& ec) {
+	int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (-1 == fd) {
+		ec = caney::errno_error_code();
+		return nullptr;
+	}
+	ec.clear();
+	return std::make_shared<file_handle>(fd);
+}
+
+file_size file_handle::size(std::error_code& ec) const {
+	struct stat st;
+	if (0 != ::fstat(m_fd, &st)) {
+		ec = caney::errno_error_code();
+		return file_size{0};
+	}
+	ec.clear();
+	return file_size{static_cast<std::uint64_t>(st.st_size)};
+}
+
+__CANEY_STREAMSV1_END
@@ -0,0 +1,230 @@
+#include "caney/streams/file_io.hpp"
+
+#include "caney/std/error_code.hpp"
+#include "caney/streams/io_uring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+#include <boost/asio/post.hpp>
+
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+__CANEY_STREAMSV1_BEGIN
+
+namespace {
+#if defined(IOV_MAX)
+	constexpr std::size_t max_iovecs = IOV_MAX;
+#else
+	constexpr std::size_t max_iovecs = 1024;
+#endif
+} // anonymous namespace
+
+file_io_pool::file_io_pool(file_io_options options) : m_options(options), m_buffers(options.buffer_size) {
+	if (0 == m_options.threads || 0 == m_options.buffer_size) std::terminate();
+#if defined(__linux__)
+	if (m_options.io_uring && io_uring_engine::is_available()) {
+		io_uring_options ring_options;
+		ring_options.buffer_size = m_options.buffer_size;
+		ring_options.recv_buffers = 0;
+		std::error_code ec;
+		std::unique_ptr<io_uring_engine> ring = io_uring_engine::create(ring_options, ec);
+		int const wakeup_fd = ring ? ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) : -1;
+		if (-1 != wakeup_fd) {
+			m_ring = std::move(ring);
+			m_wakeup_fd = wakeup_fd;
+			m_threads.emplace_back([this]() { run_ring(); });
+			return;
+		}
+	}
+#endif
+	m_threads.reserve(m_options.threads);
+	for (std::size_t i = 0; i < m_options.threads; ++i) m_threads.emplace_back([this]() { run(); });
+}
+
+file_io_pool::~file_io_pool() {
+	std::deque<request> canceled;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+		canceled.swap(m_queue);
+		m_metrics.queue_depth = 0;
+	}
+	m_cond.notify_all();
+	if (m_ring) wakeup_ring();
+	for (std::thread& t : m_threads) t.join();
+	m_ring.reset();
+	if (-1 != m_wakeup_fd) ::close(m_wakeup_fd);
+	for (request& req : canceled) complete(req, std::make_error_code(std::errc::operation_canceled), chunk_queue());
+}
+
+void file_io_pool::read(std::shared_ptr<file_handle> handle, file_size offset, std::size_t size, boost::asio::executor executor, file_read_handler handler) {
+	request req{std::move(handle), offset, size, std::move(executor), std::move(handler), clock_t::now()};
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_stopping && m_queue.size() < m_options.max_queue_depth) {
+			// the ring thread takes the whole queue: it only needs a wakeup if the queue was empty
+			if (m_ring && m_queue.empty()) wakeup_ring();
+			m_queue.push_back(std::move(req));
+			++m_metrics.submitted;
+			m_metrics.queue_depth = m_queue.size();
+			m_metrics.max_queue_depth = std::max(m_metrics.max_queue_depth, m_queue.size());
+			m_cond.notify_one();
+			return;
+		}
+		++m_metrics.rejected;
+	}
+	complete(req, std::make_error_code(std::errc::resource_unavailable_try_again), chunk_queue());
+}
+
+file_io_metrics file_io_pool::metrics() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_metrics;
+}
+
+// static
+void file_io_pool::complete(request& req, std::error_code ec, chunk_queue data) {
+	file_read_handler handler = std::move(req.handler);
+	boost::asio::post(req.executor, [handler = std::move(handler), ec, data = std::move(data)]() mutable { handler(ec, std::move(data)); });
+}
+
+void file_io_pool::run() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;) {
+		while (!m_stopping && m_queue.empty()) m_cond.wait(lock);
+		if (m_stopping) return;
+		request req = std::move(m_queue.front());
+		m_queue.pop_front();
+		m_metrics.queue_depth = m_queue.size();
+		lock.unlock();
+
+		process(req);
+
+		lock.lock();
+	}
+}
+
+void file_io_pool::run_ring() {
+	bool ring_failed = false;
+	for (;;) {
+		std::deque<request> requests;
+		bool stopping;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			requests.swap(m_queue);
+			m_metrics.queue_depth = 0;
+			stopping = m_stopping;
+		}
+		for (request& req : requests) {
+			if (ring_failed) {
+				process(req);
+				continue;
+			}
+			std::shared_ptr<request> shared = std::make_shared<request>(std::move(req));
+			m_ring->read(shared->handle, shared->offset, shared->size, [this, shared](std::error_code ec, chunk_queue data) {
+				record(clock_t::now() - shared->submitted, static_cast<std::size_t>(data.bytes().get()), bool(ec));
+				complete(*shared, ec, std::move(data));
+			});
+		}
+
+		// submits all new reads at once
+		std::error_code ec;
+		m_ring->poll(ec);
+		// reads the kernel didn't take failed with the error; read the rest with preadv()
+		if (ec) ring_failed = true;
+		if (stopping && (0 == m_ring->pending() || ring_failed)) return;
+
+		struct pollfd fds[2];
+		fds[0].fd = m_ring->event_fd();
+		fds[0].events = POLLIN;
+		fds[1].fd = m_wakeup_fd;
+		fds[1].events = POLLIN;
+		// errors (like EINTR) just lead to another round
+		::poll(fds, 2, -1);
+		std::uint64_t counter;
+		while (::read(m_wakeup_fd, &counter, sizeof(counter)) > 0) {
+		}
+	}
+}
+
+void file_io_pool::wakeup_ring() {
+	std::uint64_t const one = 1;
+	ssize_t res;
+	do {
+		res = ::write(m_wakeup_fd, &one, sizeof(one));
+	} while (-1 == res && EINTR == errno);
+	// EAGAIN: the counter is about to overflow, i.e. a wakeup is pending anyway
+}
+
+void file_io_pool::process(request& req) {
+	std::error_code ec;
+	chunk_queue data = execute(req, ec);
+	record(clock_t::now() - req.submitted, static_cast<std::size_t>(data.bytes().get()), bool(ec));
+	complete(req, ec, std::move(data));
+}
+
+chunk_queue file_io_pool::execute(request const& req, std::error_code& ec) {
+	ec.clear();
+	chunk_queue result;
+	std::size_t remaining = req.size;
+	std::uint64_t offset = req.offset.get();
+
+	std::vector<memory::unique_buf> buffers;
+	std::vector<struct iovec> iov;
+	while (remaining > 0) {
+		// (re)fill the iovec list with up to max_iovecs buffers
+		buffers.clear();
+		iov.clear();
+		for (std::size_t planned = 0; planned < remaining && buffers.size() < max_iovecs; planned += m_options.buffer_size) {
+			buffers.push_back(memory::unique_buf::allocate(m_buffers));
+			memory::unique_buf& buf = buffers.back();
+			iov.push_back(iovec{buf.data(), std::min(buf.size(), remaining - planned)});
+		}
+
+		ssize_t n;
+		do {
+			n = ::preadv(req.handle->native_handle(), iov.data(), static_cast<int>(iov.size()), boost::numeric_cast<off_t>(offset));
+		} while (-1 == n && EINTR == errno);
+		if (-1 == n) {
+			ec = caney::errno_error_code();
+			return chunk_queue();
+		}
+
+		std::size_t got = static_cast<std::size_t>(n);
+		offset += got;
+		remaining -= got;
+		for (std::size_t i = 0; i < buffers.size() && got > 0; ++i) {
+			std::size_t const used = std::min(got, iov[i].iov_len);
+			result.append(chunk(buffers[i].freeze(used)));
+			got -= used;
+		}
+
+		// end of file
+		if (0 == n) break;
+	}
+	return result;
+}
+
+void file_io_pool::record(clock_t::duration latency, std::size_t bytes, bool failed) {
+	std::chrono::nanoseconds const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(latency);
+	std::uint64_t const us = static_cast<std::uint64_t>(ns.count() / 1000);
+	std::size_t bucket = 0;
+	while (bucket + 1 < m_metrics.latency_histogram.size() && (us >> (bucket + 1)) > 0) ++bucket;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	++m_metrics.completed;
+	if (failed) ++m_metrics.failed;
+	m_metrics.bytes += bytes;
+	m_metrics.total_latency += ns;
+	m_metrics.max_latency = std::max(m_metrics.max_latency, ns);
+	++m_metrics.latency_histogram[bucket];
+}
+
+__CANEY_STREAMSV1_END
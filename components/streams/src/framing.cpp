@@ -0,0 +1,198 @@
+#include "caney/streams/framing.hpp"
+
+#include <cstring>
+
+#include <boost/asio/buffer.hpp>
+
+__CANEY_STREAMSV1_BEGIN
+
+namespace {
+	// call f(data, size) for the pieces of [offset, offset + size) in the queue; returns false if the queue is too short
+	template <typename F>
+	bool for_range(chunk_queue const& input, std::uint64_t offset, std::size_t size, F&& f) {
+		if (input.bytes().get() < offset + size) return false;
+		for (chunk const& c : input.queue()) {
+			if (0 == size) break;
+			caney::optional<boost::asio::const_buffer> const buf = c.get_const_buffer();
+			if (!buf) std::terminate(); // only memory chunks supported
+			std::size_t const chunk_size = buf->size();
+			if (offset >= chunk_size) {
+				offset -= chunk_size;
+				continue;
+			}
+			std::size_t const n = std::min<std::size_t>(size, chunk_size - static_cast<std::size_t>(offset));
+			if (!f(static_cast<unsigned char const*>(buf->data()) + offset, n)) return false;
+			offset = 0;
+			size -= n;
+		}
+		return true;
+	}
+
+	// copy bytes out of the queue
+	bool peek(chunk_queue const& input, std::uint64_t offset, unsigned char* out, std::size_t size) {
+		return for_range(input, offset, size, [&out](unsigned char const* data, std::size_t n) {
+			std::memcpy(out, data, n);
+			out += n;
+			return true;
+		});
+	}
+
+	bool equal_at(chunk_queue const& input, std::uint64_t offset, std::string const& expected) {
+		unsigned char const* cmp = reinterpret_cast<unsigned char const*>(expected.data());
+		return for_range(input, offset, expected.size(), [&cmp](unsigned char const* data, std::size_t n) {
+			if (0 != std::memcmp(cmp, data, n)) return false;
+			cmp += n;
+			return true;
+		});
+	}
+} // anonymous namespace
+
+length_prefix_format::length_prefix_format(std::size_t width, byte_order order, std::uint64_t max_frame_size)
+: m_width(width), m_order(order), m_max_frame_size(max_frame_size) {
+	if (1 != width && 2 != width && 4 != width) std::terminate();
+}
+
+bool length_prefix_format::next(chunk_queue const& input, frame_bounds& bounds, std::error_code& ec) {
+	unsigned char prefix[4];
+	if (!peek(input, 0, prefix, m_width)) return false;
+	std::uint64_t length = 0;
+	for (std::size_t i = 0; i < m_width; ++i) {
+		length = (length << 8) | prefix[byte_order::big == m_order ? i : m_width - 1 - i];
+	}
+	if (length > m_max_frame_size) {
+		ec = std::make_error_code(std::errc::message_size);
+		return false;
+	}
+	if (input.bytes().get() < m_width + length) return false;
+	bounds.header = m_width;
+	bounds.payload = length;
+	return true;
+}
+
+delimiter_format::delimiter_format(std::string delimiter, std::uint64_t max_frame_size) : m_delimiter(std::move(delimiter)), m_max_frame_size(max_frame_size) {
+	if (m_delimiter.empty()) std::terminate();
+}
+
+bool delimiter_format::next(chunk_queue const& input, frame_bounds& bounds, std::error_code& ec) {
+	std::uint64_t const total = input.bytes().get();
+	unsigned char const first = static_cast<unsigned char>(m_delimiter[0]);
+	std::uint64_t base = 0; // offset of current chunk
+	for (chunk const& c : input.queue()) {
+		caney::optional<boost::asio::const_buffer> const buf = c.get_const_buffer();
+		if (!buf) std::terminate(); // only memory chunks supported
+		std::size_t const size = buf->size();
+		if (base + size <= m_scanned) {
+			base += size;
+			continue;
+		}
+		unsigned char const* const data = static_cast<unsigned char const*>(buf->data());
+		std::size_t pos = static_cast<std::size_t>(m_scanned - base);
+		while (pos < size) {
+			void const* const hit = std::memchr(data + pos, first, size - pos);
+			if (!hit) break;
+			pos = static_cast<std::size_t>(static_cast<unsigned char const*>(hit) - data);
+			std::uint64_t const offset = base + pos;
+			if (offset > m_max_frame_size) break;
+			if (offset + m_delimiter.size() > total) {
+				// might be the start of the delimiter: wait for more data
+				m_scanned = offset;
+				return false;
+			}
+			if (equal_at(input, offset, m_delimiter)) {
+				bounds.payload = offset;
+				bounds.trailer = m_delimiter.size();
+				m_scanned = 0;
+				return true;
+			}
+			++pos;
+		}
+		base += size;
+		m_scanned = base;
+		if (m_scanned > m_max_frame_size) {
+			ec = std::make_error_code(std::errc::message_size);
+			return false;
+		}
+	}
+	return false;
+}
+
+constexpr std::uint32_t peer_wire_format::handshake_tag;
+
+peer_wire_format::peer_wire_format(bool expect_handshake, std::uint64_t max_message_size)
+: m_expect_handshake(expect_handshake), m_messages(4, byte_order::big, max_message_size) {}
+
+bool peer_wire_format::next(chunk_queue const& input, frame_bounds& bounds, std::error_code& ec) {
+	if (!m_expect_handshake) return m_messages.next(input, bounds, ec);
+
+	// <pstrlen><pstr><8 reserved bytes><20 bytes info_hash><20 bytes peer_id>
+	unsigned char pstrlen;
+	if (!peek(input, 0, &pstrlen, 1)) return false;
+	std::uint64_t const size = 1u + pstrlen + 8u + 20u + 20u;
+	if (input.bytes().get() < size) return false;
+	bounds.payload = size;
+	bounds.tag = handshake_tag;
+	m_expect_handshake = false;
+	return true;
+}
+
+// static
+std::shared_ptr<framing_transform> framing_transform::create(std::unique_ptr<frame_format> format) {
+	return std::make_shared<framing_transform>(private_tag, std::move(format));
+}
+
+// static
+std::shared_ptr<framing_transform> framing_transform::length_prefixed(std::size_t width, byte_order order, std::uint64_t max_frame_size) {
+	return create(std::unique_ptr<frame_format>(new length_prefix_format(width, order, max_frame_size)));
+}
+
+// static
+std::shared_ptr<framing_transform> framing_transform::delimited(std::string delimiter, std::uint64_t max_frame_size) {
+	return create(std::unique_ptr<frame_format>(new delimiter_format(std::move(delimiter), max_frame_size)));
+}
+
+// static
+std::shared_ptr<framing_transform> framing_transform::peer_wire(bool expect_handshake, std::uint64_t max_message_size) {
+	return create(std::unique_ptr<frame_format>(new peer_wire_format(expect_handshake, max_message_size)));
+}
+
+framing_transform::framing_transform(private_tag_t, std::unique_ptr<frame_format> format) : m_format(std::move(format)) {}
+
+void framing_transform::on_receive(chunk_queue&& chunks) {
+	if (m_failed) return;
+	m_input.append(std::move(chunks));
+
+	chunks_out_t frames;
+	frame_bounds bounds;
+	std::error_code ec;
+	while (m_format->next(m_input, bounds, ec)) {
+		m_input.remove(file_size{bounds.header});
+		frame f;
+		f.payload = m_input.split(file_size{bounds.payload});
+		f.tag = bounds.tag;
+		m_input.remove(file_size{bounds.trailer});
+		frames.push_back(std::move(f));
+		bounds = frame_bounds();
+	}
+	if (!frames.empty()) send(std::move(frames));
+	if (ec) fail(ec);
+}
+
+void framing_transform::on_end(StreamEnd end) {
+	if (m_failed) return;
+	if (StreamEnd::EndOfStream == end && file_size{0} != m_input.bytes()) {
+		// stream ended in the middle of a frame
+		fail(std::make_error_code(std::errc::no_message_available));
+		return;
+	}
+	send_end(end);
+}
+
+void framing_transform::fail(std::error_code ec) {
+	m_error = ec;
+	m_failed = true;
+	m_input.clear();
+	send_end(StreamEnd::Aborted);
+	sink_t::disconnect();
+}
+
+__CANEY_STREAMSV1_END
@@ -0,0 +1,810 @@
+#include "caney/streams/io_uring.hpp"
+
+#include "caney/std/error_code.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CANEY_STREAMS_HAVE_IO_URING 1
+#endif
+#endif
+
+#if defined(CANEY_STREAMS_HAVE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+__CANEY_STREAMSV1_BEGIN
+
+#if defined(CANEY_STREAMS_HAVE_IO_URING)
+
+namespace {
+	constexpr std::uint16_t recv_buffer_group = 0;
+	// user_data of internal requests; operations use small indices
+	constexpr std::uint64_t provide_tag = std::uint64_t(1) << 63; // PROVIDE_BUFFERS: tag | buffer id
+	constexpr std::uint64_t cancel_tag = std::uint64_t(1) << 62; // ASYNC_CANCEL
+
+	int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+		return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+	}
+
+	int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+		return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+	}
+
+	int sys_io_uring_register(int fd, unsigned opcode, void const* arg, unsigned nr_args) {
+		return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+	}
+
+	bool disabled_by_environment() {
+		char const* const value = std::getenv("CANEY_NO_IO_URING");
+		return value && *value && 0 != std::strcmp(value, "0");
+	}
+
+	std::error_code result_error(int result) {
+		return std::error_code(-result, std::generic_category());
+	}
+} // anonymous namespace
+
+struct io_uring_engine::ring {
+	~ring() {
+		if (sqes) ::munmap(sqes, sqes_size);
+		if (cq_ptr && cq_ptr != sq_ptr) ::munmap(cq_ptr, cq_size);
+		if (sq_ptr) ::munmap(sq_ptr, sq_size);
+		if (-1 != fd) ::close(fd);
+	}
+
+	int fd{-1};
+	void* sq_ptr{nullptr};
+	std::size_t sq_size{0};
+	void* cq_ptr{nullptr};
+	std::size_t cq_size{0};
+	io_uring_sqe* sqes{nullptr};
+	std::size_t sqes_size{0};
+
+	unsigned* sq_head{nullptr};
+	unsigned* sq_tail{nullptr};
+	unsigned sq_mask{0};
+	unsigned sq_entries{0};
+	unsigned* sq_array{nullptr};
+	unsigned* cq_head{nullptr};
+	unsigned* cq_tail{nullptr};
+	unsigned cq_mask{0};
+	io_uring_cqe* cqes{nullptr};
+
+	unsigned sqe_tail{0}; // local tail: entries before it are filled in, but maybe not published
+	unsigned submitted_tail{0}; // published tail
+};
+
+// registered buffers; the slots are returned from the deleter of the data passed to handlers, which might run in any thread
+struct io_uring_engine::fixed_buffers {
+	std::mutex mutex;
+	std::vector<memory::unique_buf> buffers;
+	std::vector<unsigned> free;
+
+	bool acquire(unsigned& index) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (free.empty()) return false;
+		index = free.back();
+		free.pop_back();
+		return true;
+	}
+
+	void release(unsigned index) {
+		std::lock_guard<std::mutex> lock(mutex);
+		free.push_back(index);
+	}
+};
+
+struct io_uring_engine::read_request {
+	struct piece {
+		file_size offset;
+		std::size_t size{0};
+		memory::shared_const_buf data;
+	};
+
+	std::shared_ptr<file_handle> handle;
+	file_read_handler handler;
+	std::vector<piece> pieces;
+	std::size_t outstanding{0};
+	std::error_code ec;
+};
+
+struct io_uring_engine::operation {
+	enum class kind {
+		read_piece,
+		write,
+		recv,
+	};
+
+	explicit operation(kind type) : type(type) {}
+
+	kind type;
+
+	// read_piece
+	std::shared_ptr<read_request> request;
+	std::size_t piece{0};
+	memory::unique_buf buffer; // not fixed
+	unsigned fixed_index{0};
+	bool fixed{false};
+
+	// write
+	memory::shared_const_buf data;
+	handler_t handler;
+
+	// recv
+	int fd{-1};
+	recv_handler_t recv_handler;
+	bool multishot{false}; // keep receiving until end of stream / error
+	bool canceled{false}; // don't re-arm
+};
+
+// static
+bool io_uring_engine::is_available() {
+	static bool const available = []() {
+		if (disabled_by_environment()) return false;
+		io_uring_params params;
+		std::memset(&params, 0, sizeof(params));
+		int const fd = sys_io_uring_setup(2, &params);
+		if (-1 == fd) return false;
+		::close(fd);
+		return true;
+	}();
+	return available;
+}
+
+// static
+std::unique_ptr<io_uring_engine> io_uring_engine::create(io_uring_options options, std::error_code& ec) {
+	ec.clear();
+	if (0 == options.entries || 0 == options.buffer_size) std::terminate();
+	if (disabled_by_environment()) {
+		ec = std::make_error_code(std::errc::function_not_supported);
+		return nullptr;
+	}
+	std::unique_ptr<io_uring_engine> engine(new io_uring_engine(options));
+	if (!engine->init(ec)) return nullptr;
+	return engine;
+}
+
+io_uring_engine::io_uring_engine(io_uring_options const& options) : m_options(options), m_buffers(options.buffer_size) {}
+
+io_uring_engine::~io_uring_engine() {
+	if (m_ring) shutdown();
+	m_ring.reset();
+	if (-1 != m_event_fd) ::close(m_event_fd);
+}
+
+bool io_uring_engine::init(std::error_code& ec) {
+	std::unique_ptr<ring> r(new ring());
+
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	r->fd = sys_io_uring_setup(m_options.entries, &params);
+	if (-1 == r->fd) {
+		ec = caney::errno_error_code();
+		return false;
+	}
+
+	r->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	r->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool const single_mmap = 0 != (params.features & IORING_FEAT_SINGLE_MMAP);
+	if (single_mmap) r->sq_size = r->cq_size = std::max(r->sq_size, r->cq_size);
+
+	void* const sq_ptr = ::mmap(nullptr, r->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (MAP_FAILED == sq_ptr) {
+		ec = caney::errno_error_code();
+		return false;
+	}
+	r->sq_ptr = sq_ptr;
+	if (single_mmap) {
+		r->cq_ptr = sq_ptr;
+	} else {
+		void* const cq_ptr = ::mmap(nullptr, r->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+		if (MAP_FAILED == cq_ptr) {
+			ec = caney::errno_error_code();
+			return false;
+		}
+		r->cq_ptr = cq_ptr;
+	}
+	r->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	void* const sqes = ::mmap(nullptr, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (MAP_FAILED == sqes) {
+		ec = caney::errno_error_code();
+		return false;
+	}
+	r->sqes = static_cast<io_uring_sqe*>(sqes);
+
+	char* const sq = static_cast<char*>(r->sq_ptr);
+	r->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	r->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	r->sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	r->sq_entries = params.sq_entries;
+	r->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	char* const cq = static_cast<char*>(r->cq_ptr);
+	r->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	r->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	r->cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	r->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+	r->sqe_tail = r->submitted_tail = *r->sq_tail;
+
+	m_event_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (-1 == m_event_fd) {
+		ec = caney::errno_error_code();
+		return false;
+	}
+	if (0 != sys_io_uring_register(r->fd, IORING_REGISTER_EVENTFD, &m_event_fd, 1)) {
+		ec = caney::errno_error_code();
+		return false;
+	}
+
+	// fixed buffers are optional: without them (e.g. RLIMIT_MEMLOCK too low) reads use normal pooled buffers
+	if (m_options.fixed_buffers > 0) {
+		std::shared_ptr<fixed_buffers> fixed = std::make_shared<fixed_buffers>();
+		std::vector<struct iovec> iov;
+		for (unsigned i = 0; i < m_options.fixed_buffers; ++i) {
+			fixed->buffers.push_back(memory::unique_buf::allocate(m_buffers));
+			iov.push_back(iovec{fixed->buffers.back().data(), fixed->buffers.back().size()});
+			fixed->free.push_back(m_options.fixed_buffers - 1 - i);
+		}
+		if (0 == sys_io_uring_register(r->fd, IORING_REGISTER_BUFFERS, iov.data(), static_cast<unsigned>(iov.size()))) m_fixed = std::move(fixed);
+	}
+
+	m_ring = std::move(r);
+
+	m_provided.resize(m_options.recv_buffers);
+	for (unsigned bid = 0; bid < m_options.recv_buffers; ++bid) provide_buffer(bid);
+	submit_queued();
+	if (m_error) {
+		ec = m_error;
+		return false;
+	}
+
+	return true;
+}
+
+// cancel pending requests and wait for their completions: until then the kernel might still write into their buffers
+void io_uring_engine::shutdown() {
+	m_closing = true;
+	for (std::uint64_t user_data : m_unqueued) release_operation(user_data);
+	m_unqueued.clear();
+	for (std::size_t i = 0; i < m_operations.size(); ++i) {
+		if (m_operations[i]) cancel(i + 1);
+	}
+	// with a broken ring there is nothing left to wait for
+	while (m_pending > 0 && !m_error) {
+		submit_queued();
+		if (0 == reap() && !m_error) enter(0, 1);
+	}
+}
+
+bool io_uring_engine::uses_fixed_buffers() const {
+	return bool(m_fixed);
+}
+
+std::uint64_t io_uring_engine::add_operation(std::unique_ptr<operation> op) {
+	++m_pending;
+	if (!m_free_operations.empty()) {
+		std::uint64_t const user_data = m_free_operations.back();
+		m_free_operations.pop_back();
+		m_operations[user_data - 1] = std::move(op);
+		return user_data;
+	}
+	m_operations.push_back(std::move(op));
+	return m_operations.size();
+}
+
+void io_uring_engine::release_operation(std::uint64_t user_data) {
+	--m_pending;
+	m_operations[user_data - 1].reset();
+	m_free_operations.push_back(user_data);
+}
+
+// register operation for a submission queue entry; without entry (after m_error) it fails on the next poll / run_once
+std::uint64_t io_uring_engine::queue_operation(std::unique_ptr<operation> op, io_uring_sqe* sqe) {
+	std::uint64_t const user_data = add_operation(std::move(op));
+	if (sqe) {
+		sqe->user_data = user_data;
+	} else {
+		m_unqueued.push_back(user_data);
+	}
+	return user_data;
+}
+
+// fetch next free submission queue entry (cleared); submits queued entries if the queue is full. nullptr after the kernel rejected submissions
+io_uring_sqe* io_uring_engine::next_sqe() {
+	ring& r = *m_ring;
+	while (!m_error && r.sqe_tail - __atomic_load_n(r.sq_head, __ATOMIC_ACQUIRE) >= r.sq_entries) submit_queued();
+	if (m_error) return nullptr;
+	unsigned const index = r.sqe_tail & r.sq_mask;
+	io_uring_sqe* const sqe = &r.sqes[index];
+	std::memset(sqe, 0, sizeof(*sqe));
+	r.sq_array[index] = index;
+	++r.sqe_tail;
+	return sqe;
+}
+
+void io_uring_engine::provide_buffer(unsigned bid) {
+	memory::unique_buf& buf = m_provided[bid];
+	io_uring_sqe* const sqe = next_sqe();
+	if (!sqe) {
+		provided_buffer(bid, -m_error.value());
+		return;
+	}
+	if (buf.empty()) buf = memory::unique_buf::allocate(m_buffers);
+	sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+	sqe->fd = 1; // number of buffers
+	sqe->addr = reinterpret_cast<std::uintptr_t>(buf.data());
+	sqe->len = static_cast<std::uint32_t>(buf.size());
+	sqe->off = bid;
+	sqe->buf_group = recv_buffer_group;
+	sqe->user_data = provide_tag | bid;
+}
+
+void io_uring_engine::provided_buffer(unsigned bid, int result) {
+	if (result >= 0) return;
+	// the kernel doesn't know the buffer; receives run out of buffers eventually and report the error then
+	m_provided[bid] = memory::unique_buf();
+	if (!m_provide_error) m_provide_error = result_error(result);
+}
+
+void io_uring_engine::read(std::shared_ptr<file_handle> handle, file_size offset, std::size_t size, file_read_handler handler) {
+	std::shared_ptr<read_request> request = std::make_shared<read_request>();
+	request->handle = std::move(handle);
+	request->handler = std::move(handler);
+	for (std::size_t planned = 0; planned < size; planned += m_options.buffer_size) {
+		read_request::piece p;
+		p.offset = offset + file_size{planned};
+		p.size = std::min(m_options.buffer_size, size - planned);
+		request->pieces.push_back(std::move(p));
+	}
+	if (request->pieces.empty()) {
+		// nothing to read; still complete asynchronously (from the next poll)
+		read_request::piece p;
+		p.offset = offset;
+		request->pieces.push_back(std::move(p));
+	}
+	request->outstanding = request->pieces.size();
+	for (std::size_t i = 0; i < request->pieces.size(); ++i) start_read_piece(request, i);
+}
+
+void io_uring_engine::read(file_chunk const& chunk, std::size_t max_size, file_read_handler handler) {
+	std::size_t const size = static_cast<std::size_t>(std::min<std::uint64_t>(chunk.bytes().get(), max_size));
+	read(chunk.get_handle(), chunk.get_offset(), size, std::move(handler));
+}
+
+void io_uring_engine::start_read_piece(std::shared_ptr<read_request> const& request, std::size_t piece) {
+	read_request::piece const& p = request->pieces[piece];
+	std::unique_ptr<operation> op(new operation(operation::kind::read_piece));
+	op->request = request;
+	op->piece = piece;
+
+	io_uring_sqe* const sqe = next_sqe();
+	if (!sqe) {
+		queue_operation(std::move(op), nullptr);
+		return;
+	}
+	sqe->fd = request->handle->native_handle();
+	sqe->off = p.offset.get();
+	sqe->len = static_cast<std::uint32_t>(p.size);
+	if (m_fixed && m_fixed->acquire(op->fixed_index)) {
+		op->fixed = true;
+		sqe->opcode = IORING_OP_READ_FIXED;
+		sqe->addr = reinterpret_cast<std::uintptr_t>(m_fixed->buffers[op->fixed_index].data());
+		sqe->buf_index = static_cast<std::uint16_t>(op->fixed_index);
+	} else {
+		op->buffer = memory::unique_buf::allocate(m_buffers);
+		sqe->opcode = IORING_OP_READ;
+		sqe->addr = reinterpret_cast<std::uintptr_t>(op->buffer.data());
+	}
+	queue_operation(std::move(op), sqe);
+}
+
+void io_uring_engine::write(int fd, memory::shared_const_buf data, handler_t handler) {
+	std::unique_ptr<operation> op(new operation(operation::kind::write));
+	op->data = std::move(data);
+	op->handler = std::move(handler);
+
+	io_uring_sqe* const sqe = next_sqe();
+	if (sqe) {
+		sqe->opcode = IORING_OP_WRITE;
+		sqe->fd = fd;
+		sqe->off = static_cast<std::uint64_t>(-1); // current position (ignored for sockets and pipes)
+		sqe->addr = reinterpret_cast<std::uintptr_t>(op->data.data());
+		sqe->len = static_cast<std::uint32_t>(op->data.size());
+	}
+	queue_operation(std::move(op), sqe);
+}
+
+std::uint64_t io_uring_engine::recv(int fd, recv_handler_t handler) {
+	std::unique_ptr<operation> op(new operation(operation::kind::recv));
+	op->fd = fd;
+	op->recv_handler = std::move(handler);
+	std::uint64_t const user_data = add_operation(std::move(op));
+	start_recv(user_data);
+	return user_data;
+}
+
+std::uint64_t io_uring_engine::recv_multishot(int fd, recv_handler_t handler) {
+	std::unique_ptr<operation> op(new operation(operation::kind::recv));
+	op->fd = fd;
+	op->recv_handler = std::move(handler);
+	op->multishot = true;
+	std::uint64_t const user_data = add_operation(std::move(op));
+	start_recv(user_data);
+	return user_data;
+}
+
+void io_uring_engine::cancel(std::uint64_t id) {
+	if (0 == id || id > m_operations.size() || !m_operations[id - 1]) std::terminate();
+	m_operations[id - 1]->canceled = true;
+	io_uring_sqe* const sqe = next_sqe();
+	if (!sqe) return; // request can't be canceled; with a broken ring it might never complete anyway
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->addr = id;
+	sqe->user_data = cancel_tag;
+}
+
+void io_uring_engine::start_recv(std::uint64_t user_data) {
+	operation const& op = *m_operations[user_data - 1];
+	io_uring_sqe* const sqe = next_sqe();
+	if (!sqe) {
+		m_unqueued.push_back(user_data);
+		return;
+	}
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = op.fd;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = recv_buffer_group;
+	if (op.multishot && m_multishot_recv) {
+		sqe->ioprio = IORING_RECV_MULTISHOT;
+	} else {
+		sqe->len = static_cast<std::uint32_t>(m_options.buffer_size);
+	}
+	sqe->user_data = user_data;
+}
+
+std::size_t io_uring_engine::submit(std::error_code& ec) {
+	std::size_t const submitted = submit_queued();
+	ec = m_error;
+	return submitted;
+}
+
+std::size_t io_uring_engine::submit_queued() {
+	ring& r = *m_ring;
+	unsigned const to_submit = r.sqe_tail - r.submitted_tail;
+	if (0 == to_submit || m_error) return 0;
+	__atomic_store_n(r.sq_tail, r.sqe_tail, __ATOMIC_RELEASE);
+	r.submitted_tail = r.sqe_tail;
+	if (!enter(to_submit, 0)) return 0;
+	m_stats.submitted += to_submit;
+	return to_submit;
+}
+
+bool io_uring_engine::enter(unsigned to_submit, unsigned min_complete) {
+	unsigned const flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+	for (;;) {
+		++m_stats.enter_calls;
+		int const res = sys_io_uring_enter(m_ring->fd, to_submit, min_complete, flags);
+		if (res >= 0) {
+			if (static_cast<unsigned>(res) >= to_submit) return true;
+			// kernel didn't take all entries (e.g. memory allocation failure), try again
+			to_submit -= static_cast<unsigned>(res);
+			continue;
+		}
+		if (EINTR == errno) {
+			// waiting got interrupted; return to the caller
+			if (0 == to_submit) return true;
+			continue;
+		}
+		if (EAGAIN == errno || EBUSY == errno) {
+			// completion queue overflowed: make room and try again
+			if (0 == reap() && 0 == to_submit) return true;
+			continue;
+		}
+		m_error = caney::errno_error_code();
+		drop_queued();
+		return false;
+	}
+}
+
+// the kernel rejected submissions: fail the operations of the entries it didn't take
+void io_uring_engine::drop_queued() {
+	ring& r = *m_ring;
+	unsigned const head = __atomic_load_n(r.sq_head, __ATOMIC_ACQUIRE);
+	for (unsigned i = head; i != r.sqe_tail; ++i) {
+		std::uint64_t const user_data = r.sqes[r.sq_array[i & r.sq_mask]].user_data;
+		if (0 != (user_data & provide_tag)) {
+			provided_buffer(static_cast<unsigned>(user_data & ~provide_tag), -m_error.value());
+		} else if (cancel_tag != user_data) {
+			m_unqueued.push_back(user_data);
+		}
+	}
+	r.sqe_tail = r.submitted_tail = head;
+	__atomic_store_n(r.sq_tail, head, __ATOMIC_RELEASE);
+}
+
+// complete operations which didn't reach the kernel with m_error; operations failing in their handlers wait for the next call
+std::size_t io_uring_engine::fail_unqueued() {
+	std::vector<std::uint64_t> unqueued;
+	unqueued.swap(m_unqueued);
+	for (std::uint64_t user_data : unqueued) {
+		m_operations[user_data - 1]->multishot = false; // don't re-arm
+		handle_completion(user_data, -m_error.value(), 0);
+	}
+	return unqueued.size();
+}
+
+std::size_t io_uring_engine::poll(std::error_code& ec) {
+	submit_queued();
+	std::uint64_t counter;
+	while (::read(m_event_fd, &counter, sizeof(counter)) > 0) {
+	}
+	std::size_t const handled = reap() + fail_unqueued();
+	ec = m_error;
+	return handled;
+}
+
+std::size_t io_uring_engine::run_once(std::error_code& ec) {
+	submit_queued();
+	std::size_t handled = reap() + fail_unqueued();
+	if (0 == handled && m_pending > 0 && !m_error) {
+		enter(0, 1);
+		handled = reap();
+	}
+	std::uint64_t counter;
+	while (::read(m_event_fd, &counter, sizeof(counter)) > 0) {
+	}
+	ec = m_error;
+	return handled;
+}
+
+std::size_t io_uring_engine::reap() {
+	ring& r = *m_ring;
+	std::size_t handled = 0;
+	for (;;) {
+		// reload the head for each entry: handlers can reach a nested reap() (through enter() on a full queue) which moves it
+		unsigned const head = *r.cq_head;
+		if (head == __atomic_load_n(r.cq_tail, __ATOMIC_ACQUIRE)) break;
+		io_uring_cqe const cqe = r.cqes[head & r.cq_mask];
+		// release the slot before running the handler, which might submit new requests
+		__atomic_store_n(r.cq_head, head + 1, __ATOMIC_RELEASE);
+		++m_stats.completed;
+		if (cancel_tag == cqe.user_data) continue; // result doesn't matter: the canceled request completes anyway
+		if (0 != (cqe.user_data & provide_tag)) {
+			provided_buffer(static_cast<unsigned>(cqe.user_data & ~provide_tag), cqe.res);
+			continue;
+		}
+		++handled;
+		if (m_closing) {
+			drop_completion(cqe.user_data, cqe.flags);
+		} else {
+			handle_completion(cqe.user_data, cqe.res, cqe.flags);
+		}
+	}
+	return handled;
+}
+
+// completion while closing: release the operation without calling its handler
+void io_uring_engine::drop_completion(std::uint64_t user_data, unsigned flags) {
+	if (0 != (flags & IORING_CQE_F_MORE)) return; // multishot receive still active
+	release_operation(user_data);
+}
+
+void io_uring_engine::handle_completion(std::uint64_t user_data, int result, unsigned flags) {
+	operation& op = *m_operations[user_data - 1];
+	switch (op.type) {
+	case operation::kind::read_piece: {
+		read_request& request = *op.request;
+		read_request::piece& p = request.pieces[op.piece];
+		if (result < 0) {
+			if (!request.ec) request.ec = result_error(result);
+			if (op.fixed) m_fixed->release(op.fixed_index);
+		} else if (op.fixed) {
+			std::shared_ptr<fixed_buffers> fixed = m_fixed;
+			unsigned const index = op.fixed_index;
+			memory::unique_buf& buf = fixed->buffers[index];
+			// the slot can be reused when the last reference to the data is gone
+			std::shared_ptr<void> token(static_cast<void*>(buf.data()), [fixed, index](void*) { fixed->release(index); });
+			p.data = memory::shared_const_buf::unsafe_use(std::move(token), memory::raw_const_buf(buf.data(), static_cast<std::size_t>(result)));
+		} else {
+			p.data = op.buffer.freeze(static_cast<std::size_t>(result));
+		}
+		std::shared_ptr<read_request> keep = std::move(op.request);
+		release_operation(user_data);
+		if (0 == --keep->outstanding) finish_read(*keep);
+		return;
+	}
+	case operation::kind::write: {
+		handler_t handler = std::move(op.handler);
+		release_operation(user_data);
+		if (result < 0) {
+			handler(result_error(result), 0);
+		} else {
+			handler(std::error_code(), static_cast<std::size_t>(result));
+		}
+		return;
+	}
+	case operation::kind::recv: {
+		bool const more = 0 != (flags & IORING_CQE_F_MORE);
+		memory::shared_const_buf data;
+		if (0 != (flags & IORING_CQE_F_BUFFER)) {
+			unsigned const bid = flags >> IORING_CQE_BUFFER_SHIFT;
+			memory::unique_buf buf = std::move(m_provided[bid]);
+			if (result > 0) data = buf.freeze(static_cast<std::size_t>(result));
+			provide_buffer(bid);
+		}
+
+		if (!more && op.multishot && op.canceled) {
+			// the kernel ended the receive before it saw the cancel request: don't re-arm
+			result = -ECANCELED;
+		}
+		if (-EINVAL == result && op.multishot && m_multishot_recv) {
+			// kernel doesn't support multishot receives: emulate it
+			m_multishot_recv = false;
+			start_recv(user_data);
+			return;
+		}
+		if (-ENOBUFS == result && op.multishot && !m_provide_error) {
+			// ran out of provided buffers; they got provided again above
+			if (!more) start_recv(user_data);
+			return;
+		}
+
+		bool const finished = !op.multishot || result <= 0;
+		if (finished) {
+			recv_handler_t handler = std::move(op.recv_handler);
+			if (!more) release_operation(user_data);
+			if (result < 0) {
+				handler(result_error(result), memory::shared_const_buf());
+			} else {
+				handler(std::error_code(), std::move(data));
+			}
+			return;
+		}
+
+		if (!more) start_recv(user_data); // re-arm (single receives or multishot receive terminated by kernel)
+		// handler might start new requests and reallocate the operation table; keep a copy
+		recv_handler_t handler = op.recv_handler;
+		handler(std::error_code(), std::move(data));
+		return;
+	}
+	}
+}
+
+void io_uring_engine::finish_read(read_request& request) {
+	chunk_queue result;
+	if (!request.ec) {
+		for (read_request::piece& p : request.pieces) {
+			std::size_t const got = p.data.size();
+			if (got > 0) result.append(chunk(std::move(p.data)));
+			// short read: end of file
+			if (got < p.size) break;
+		}
+	}
+	file_read_handler handler = std::move(request.handler);
+	handler(request.ec, std::move(result));
+}
+
+#else /* CANEY_STREAMS_HAVE_IO_URING */
+
+struct io_uring_engine::ring {};
+struct io_uring_engine::fixed_buffers {};
+struct io_uring_engine::read_request {};
+struct io_uring_engine::operation {};
+
+// static
+bool io_uring_engine::is_available() {
+	return false;
+}
+
+// static
+std::unique_ptr<io_uring_engine> io_uring_engine::create(io_uring_options, std::error_code& ec) {
+	ec = std::make_error_code(std::errc::function_not_supported);
+	return nullptr;
+}
+
+io_uring_engine::~io_uring_engine() = default;
+
+bool io_uring_engine::uses_fixed_buffers() const {
+	return false;
+}
+
+// an engine can't be created; the remaining members are unreachable
+void io_uring_engine::read(std::shared_ptr<file_handle>, file_size, std::size_t, file_read_handler) {
+	std::terminate();
+}
+
+void io_uring_engine::read(file_chunk const&, std::size_t, file_read_handler) {
+	std::terminate();
+}
+
+void io_uring_engine::write(int, memory::shared_const_buf, handler_t) {
+	std::terminate();
+}
+
+std::uint64_t io_uring_engine::recv(int, recv_handler_t) {
+	std::terminate();
+}
+
+std::uint64_t io_uring_engine::recv_multishot(int, recv_handler_t) {
+	std::terminate();
+}
+
+void io_uring_engine::cancel(std::uint64_t) {
+	std::terminate();
+}
+
+std::size_t io_uring_engine::submit(std::error_code&) {
+	std::terminate();
+}
+
+std::size_t io_uring_engine::poll(std::error_code&) {
+	std::terminate();
+}
+
+std::size_t io_uring_engine::run_once(std::error_code&) {
+	std::terminate();
+}
+
+#endif /* CANEY_STREAMS_HAVE_IO_URING */
+
+// static
+std::shared_ptr<io_uring_reactor> io_uring_reactor::create(shared_strand_t strand, io_uring_options options, std::error_code& ec) {
+	std::unique_ptr<io_uring_engine> engine = io_uring_engine::create(options, ec);
+	if (!engine) return nullptr;
+	// the descriptor object closes its file descriptor; the engine closes the original
+	int const event_fd = ::dup(engine->event_fd());
+	if (-1 == event_fd) {
+		ec = caney::errno_error_code();
+		return nullptr;
+	}
+	std::shared_ptr<io_uring_reactor> self = std::make_shared<io_uring_reactor>(private_tag, std::move(strand), std::move(engine), event_fd);
+	self->start_wait();
+	return self;
+}
+
+io_uring_reactor::io_uring_reactor(private_tag_t, shared_strand_t strand, std::unique_ptr<io_uring_engine> engine, int event_fd)
+: m_strand(std::move(strand)), m_engine(std::move(engine)), m_event(m_strand->context(), event_fd) {}
+
+void io_uring_reactor::submit_later() {
+	if (m_submit_posted) return;
+	m_submit_posted = true;
+	std::weak_ptr<io_uring_reactor> weak_self{shared_from_this()};
+	m_strand->post([weak_self]() {
+		std::shared_ptr<io_uring_reactor> self = weak_self.lock();
+		if (!self) return;
+		self->m_submit_posted = false;
+		self->run();
+	});
+}
+
+void io_uring_reactor::start_wait() {
+	std::weak_ptr<io_uring_reactor> weak_self{shared_from_this()};
+	m_event.async_wait(boost::asio::posix::stream_descriptor::wait_read, m_strand->wrap([weak_self](boost::system::error_code const& error) {
+		std::shared_ptr<io_uring_reactor> self = weak_self.lock();
+		if (!self || error) return;
+		self->run();
+		self->start_wait();
+	}));
+}
+
+// handlers might drop the last other reference to the reactor: callers keep one
+void io_uring_reactor::run() {
+	std::error_code ec;
+	m_engine->poll(ec);
+	// completions queue new requests (re-provided buffers, re-armed receives); nothing else would submit them before the next wakeup
+	if (!ec) m_engine->submit(ec);
+	if (ec) m_error = ec;
+}
+
+__CANEY_STREAMSV1_END
@@ -24,7 +24,11 @@ origin::~origin() {
 
 origin_pause origin::pause() {
 	std::shared_ptr<impl::origin_pause_watcher> p = m_weak_pause.lock();
-	if (!p) p = std::make_shared<impl::origin_pause_watcher>(this);
+	if (!p) {
+		p = std::make_shared<impl::origin_pause_watcher>(this);
+		m_weak_pause = p;
+		on_pause();
+	}
 	return origin_pause(std::move(p));
 }
 
@@ -0,0 +1,90 @@
+#include "caney/streams/pipeline.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <typeinfo>
+
+#include <boost/core/demangle.hpp>
+
+__CANEY_STREAMSV1_BEGIN
+
+namespace {
+	// sides of a single stage
+	struct stage_sides {
+		sink_base const* sink;
+		source_base const* source;
+	};
+
+	stage_sides from_source(source_base const* source) {
+		return stage_sides{source->transform_sink(), source};
+	}
+
+	stage_sides from_sink(sink_base const* sink) {
+		return stage_sides{sink, sink->transform_source()};
+	}
+
+	template <typename T>
+	bool seen(std::vector<T const*> const& visited, T const* p) {
+		return visited.end() != std::find(visited.begin(), visited.end(), p);
+	}
+
+	std::vector<stage_info> walk(stage_sides current) {
+		// find first stage (stop on cycles)
+		std::vector<sink_base const*> visited_sinks;
+		while (current.sink && current.sink->upstream() && !seen(visited_sinks, current.sink)) {
+			visited_sinks.push_back(current.sink);
+			current = from_source(current.sink->upstream());
+		}
+
+		std::vector<stage_info> result;
+		std::vector<source_base const*> visited_sources;
+		for (;;) {
+			stage_info info;
+			// each stage is either a source or a sink
+			info.name = current.source ? boost::core::demangle(typeid(*current.source).name()) : boost::core::demangle(typeid(*current.sink).name());
+			info.sink = current.sink;
+			info.source = current.source;
+			if (current.sink) info.in = current.sink->in_stats();
+			if (current.source) info.out = current.source->out_stats();
+			result.push_back(std::move(info));
+
+			if (!current.source || !current.source->downstream() || seen(visited_sources, current.source)) break;
+			visited_sources.push_back(current.source);
+			current = from_sink(current.source->downstream());
+		}
+		return result;
+	}
+
+	long long micros(std::chrono::nanoseconds ns) {
+		return static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(ns).count());
+	}
+} // anonymous namespace
+
+std::vector<stage_info> walk_pipeline(source_base const& stage) {
+	return walk(from_source(&stage));
+}
+
+std::vector<stage_info> walk_pipeline(sink_base const& stage) {
+	return walk(from_sink(&stage));
+}
+
+std::string dump_pipeline(std::vector<stage_info> const& stages) {
+	std::ostringstream out;
+	for (std::size_t i = 0; i < stages.size(); ++i) {
+		stage_info const& stage = stages[i];
+		out << (0 == i ? "" : "-> ") << stage.name;
+		if (stats_enabled && stage.sink) {
+			out << " [in: chunks=" << stage.in.chunks_in << " bytes=" << stage.in.bytes_in << " callbacks=" << stage.in.callbacks
+				<< " callback_us=" << micros(stage.in.callback_time) << " max_callback_us=" << micros(stage.in.max_callback_time)
+				<< " pauses=" << stage.in.pauses << " paused_us=" << micros(stage.in.paused_time) << "]";
+		}
+		if (stats_enabled && stage.source) {
+			out << " [out: chunks=" << stage.out.chunks_out << " bytes=" << stage.out.bytes_out << " pending=" << stage.out.pending
+				<< " max_pending=" << stage.out.max_pending << "]";
+		}
+		out << "\n";
+	}
+	return out.str();
+}
+
+__CANEY_STREAMSV1_END
@@ -0,0 +1,155 @@
+#include "caney/streams/rate_limit.hpp"
+
+#include <algorithm>
+#include <limits>
+
+__CANEY_STREAMSV1_BEGIN
+
+// static
+std::shared_ptr<token_bucket> token_bucket::create(std::uint64_t rate, std::uint64_t burst, std::shared_ptr<token_bucket> parent) {
+	return std::make_shared<token_bucket>(private_tag, rate, burst, std::move(parent));
+}
+
+token_bucket::token_bucket(private_tag_t, std::uint64_t rate, std::uint64_t burst, std::shared_ptr<token_bucket> parent)
+: m_rate(rate), m_burst(burst), m_tokens(burst), m_last_refill(clock_t::now()), m_parent(std::move(parent)) {
+	if (0 != m_rate && 0 == m_burst) std::terminate();
+}
+
+void token_bucket::set_rate(std::uint64_t rate, std::uint64_t burst) {
+	if (0 != rate && 0 == burst) std::terminate();
+	clock_t::time_point const now = clock_t::now();
+	refill(now);
+	m_rate = rate;
+	m_burst = burst;
+	m_tokens = std::min(m_tokens, burst);
+	m_last_refill = now;
+}
+
+std::uint64_t token_bucket::available(clock_t::time_point now) {
+	std::uint64_t result = std::numeric_limits<std::uint64_t>::max();
+	for (token_bucket* b = this; b; b = b->m_parent.get()) {
+		if (0 == b->m_rate) continue;
+		b->refill(now);
+		result = std::min(result, b->m_tokens);
+	}
+	return result;
+}
+
+void token_bucket::consume(std::uint64_t tokens, clock_t::time_point now) {
+	for (token_bucket* b = this; b; b = b->m_parent.get()) {
+		if (0 == b->m_rate) continue;
+		b->refill(now);
+		if (tokens > b->m_tokens) std::terminate();
+		b->m_tokens -= tokens;
+	}
+}
+
+void token_bucket::refill(clock_t::time_point now) {
+	if (now <= m_last_refill) return;
+	std::uint64_t const missing = m_burst - m_tokens;
+	double const elapsed = std::chrono::duration<double>(now - m_last_refill).count();
+	double const added = elapsed * static_cast<double>(m_rate);
+	if (added >= static_cast<double>(missing)) {
+		m_tokens = m_burst;
+		m_last_refill = now;
+		return;
+	}
+	// only account the time for whole tokens; the fraction carries over to the next refill
+	std::uint64_t const tokens = static_cast<std::uint64_t>(added);
+	m_tokens += tokens;
+	m_last_refill += std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double>(static_cast<double>(tokens) / static_cast<double>(m_rate)));
+}
+
+// static
+std::shared_ptr<rate_timer> rate_timer::create(shared_strand_t strand, clock_t::duration interval) {
+	return std::make_shared<rate_timer>(private_tag, std::move(strand), interval);
+}
+
+rate_timer::rate_timer(private_tag_t, shared_strand_t strand, clock_t::duration interval)
+: m_strand(std::move(strand)), m_interval(interval), m_timer(m_strand->context()) {}
+
+void rate_timer::wait(std::weak_ptr<rate_limit_filter> filter) {
+	m_waiting.push_back(std::move(filter));
+	if (!m_running) start();
+}
+
+void rate_timer::start() {
+	m_running = true;
+	m_timer.expires_after(m_interval);
+	std::weak_ptr<rate_timer> weak_self = shared_from_this();
+	m_timer.async_wait(m_strand->wrap([weak_self](boost::system::error_code const& error) {
+		if (error) return;
+		if (std::shared_ptr<rate_timer> self = weak_self.lock()) self->tick();
+	}));
+}
+
+void rate_timer::tick() {
+	m_running = false;
+	// filters still short of tokens wait again (restarting the timer)
+	std::vector<std::weak_ptr<rate_limit_filter>> waiting;
+	waiting.swap(m_waiting);
+	std::size_t const count = waiting.size();
+	if (0 == count) return;
+	std::size_t const first = m_rotation++ % count;
+	for (std::size_t i = 0; i < count; ++i) {
+		if (std::shared_ptr<rate_limit_filter> filter = waiting[(first + i) % count].lock()) filter->on_tick();
+	}
+}
+
+// static
+std::shared_ptr<rate_limit_filter> rate_limit_filter::create(std::shared_ptr<rate_timer> timer, std::shared_ptr<token_bucket> bucket) {
+	return std::make_shared<rate_limit_filter>(private_tag, std::move(timer), std::move(bucket));
+}
+
+rate_limit_filter::rate_limit_filter(private_tag_t, std::shared_ptr<rate_timer> timer, std::shared_ptr<token_bucket> bucket)
+: m_timer(std::move(timer)), m_bucket(std::move(bucket)) {
+	if (!m_timer || !m_bucket) std::terminate();
+}
+
+void rate_limit_filter::on_receive(chunk_queue&& chunks) {
+	m_queue.append(std::move(chunks));
+	process();
+}
+
+void rate_limit_filter::on_connected_sink() {
+	if (!m_throttled) filter<chunk>::on_connected_sink();
+}
+
+void rate_limit_filter::process() {
+	std::uint64_t const queued = m_queue.bytes().get();
+	std::uint64_t const tokens = std::min(queued, m_bucket->available());
+	bool const remaining = tokens < queued;
+
+	chunk_queue out;
+	if (remaining) {
+		out = m_queue.split(file_size{tokens});
+	} else {
+		out = std::move(m_queue);
+		m_queue.clear();
+	}
+	if (tokens > 0) m_bucket->consume(tokens);
+
+	if (remaining) {
+		if (!m_throttled) {
+			m_throttled = true;
+			sink_t::pause();
+		}
+		if (!m_waiting) {
+			m_waiting = true;
+			m_timer->wait(shared_from_this());
+		}
+	}
+	if (!out.empty()) send(std::move(out));
+	if (!remaining && m_throttled) {
+		m_throttled = false;
+		// might receive more data right away
+		if (source_t::get_sink()) sink_t::resume();
+	}
+}
+
+void rate_limit_filter::on_tick() {
+	m_waiting = false;
+	if (m_throttled) process();
+}
+
+__CANEY_STREAMSV1_END
@@ -0,0 +1,51 @@
+#include "caney/streams/read_buffers.hpp"
+
+#include <array>
+#include <memory>
+
+__CANEY_STREAMSV1_BEGIN
+
+namespace {
+	constexpr std::size_t size_classes = 8; // 2 KiB .. 256 KiB
+	static_assert(adaptive_read_buffers::min_size << (size_classes - 1) == adaptive_read_buffers::max_size, "size classes don't match limits");
+} // anonymous namespace
+
+constexpr std::size_t adaptive_read_buffers::min_size;
+constexpr std::size_t adaptive_read_buffers::max_size;
+constexpr unsigned adaptive_read_buffers::shrink_after;
+
+adaptive_read_buffers::adaptive_read_buffers(std::size_t initial_size) {
+	while (m_size_class + 1 < size_classes && preferred_size() < initial_size) ++m_size_class;
+}
+
+memory::unique_buf adaptive_read_buffers::allocate() {
+	return memory::unique_buf::allocate(pool(m_size_class));
+}
+
+void adaptive_read_buffers::record(std::size_t bytes, std::size_t capacity) {
+	std::size_t const current = preferred_size();
+	if (bytes == capacity && capacity >= current) {
+		m_small_reads = 0;
+		if (m_size_class + 1 < size_classes) ++m_size_class;
+	} else if (bytes < current / 4) {
+		if (++m_small_reads >= shrink_after) {
+			m_small_reads = 0;
+			if (m_size_class > 0) --m_size_class;
+		}
+	} else {
+		m_small_reads = 0;
+	}
+}
+
+// static
+memory::intrusive_buffer_pool<>& adaptive_read_buffers::pool(std::size_t size_class) {
+	using pools_t = std::array<std::unique_ptr<memory::intrusive_buffer_pool<>>, size_classes>;
+	static pools_t const pools = []() {
+		pools_t result;
+		for (std::size_t i = 0; i < size_classes; ++i) result[i].reset(new memory::intrusive_buffer_pool<>(min_size << i));
+		return result;
+	}();
+	return *pools[size_class];
+}
+
+__CANEY_STREAMSV1_END
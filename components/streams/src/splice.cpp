@@ -0,0 +1,98 @@
+#include "caney/streams/splice.hpp"
+
+#include "caney/std/error_code.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+__CANEY_STREAMSV1_BEGIN
+
+constexpr std::size_t splice_pipe::default_size;
+
+// static
+std::unique_ptr<splice_pipe> splice_pipe::create(std::size_t size, std::error_code& ec) {
+	ec.clear();
+#if defined(__linux__)
+	int fds[2];
+	if (0 != ::pipe2(fds, O_NONBLOCK | O_CLOEXEC)) {
+		ec = caney::errno_error_code();
+		return nullptr;
+	}
+	// larger pipes move more data per syscall; might be limited by /proc/sys/fs/pipe-max-size
+	if (size > 0) ::fcntl(fds[1], F_SETPIPE_SZ, static_cast<int>(size));
+	return std::unique_ptr<splice_pipe>(new splice_pipe(fds[0], fds[1]));
+#else
+	(void)size;
+	ec = std::make_error_code(std::errc::function_not_supported);
+	return nullptr;
+#endif
+}
+
+splice_pipe::splice_pipe(int read_fd, int write_fd) : m_read_fd(read_fd), m_write_fd(write_fd) {}
+
+splice_pipe::~splice_pipe() {
+	::close(m_read_fd);
+	::close(m_write_fd);
+}
+
+std::size_t splice_pipe::fill(int fd, std::size_t max, std::error_code& ec) {
+	ec.clear();
+#if defined(__linux__)
+	for (;;) {
+		ssize_t const moved = ::splice(fd, nullptr, m_write_fd, nullptr, max, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if (moved >= 0) {
+			m_size += static_cast<std::size_t>(moved);
+			return static_cast<std::size_t>(moved);
+		}
+		if (EINTR == errno) continue;
+		ec = caney::errno_error_code();
+		return 0;
+	}
+#else
+	(void)fd;
+	(void)max;
+	ec = std::make_error_code(std::errc::function_not_supported);
+	return 0;
+#endif
+}
+
+std::size_t splice_pipe::drain(int fd, std::error_code& ec) {
+	ec.clear();
+#if defined(__linux__)
+	std::size_t total = 0;
+	while (m_size > 0) {
+		ssize_t const moved = ::splice(m_read_fd, nullptr, fd, nullptr, m_size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if (moved < 0) {
+			if (EINTR == errno) continue;
+			ec = caney::errno_error_code();
+			break;
+		}
+		m_size -= std::min(m_size, static_cast<std::size_t>(moved));
+		total += static_cast<std::size_t>(moved);
+	}
+	return total;
+#else
+	(void)fd;
+	ec = std::make_error_code(std::errc::function_not_supported);
+	return 0;
+#endif
+}
+
+std::size_t splice_pipe::read(void* data, std::size_t size, std::error_code& ec) {
+	ec.clear();
+	for (;;) {
+		ssize_t const got = ::read(m_read_fd, data, std::min(size, m_size));
+		if (got >= 0) {
+			m_size -= static_cast<std::size_t>(got);
+			return static_cast<std::size_t>(got);
+		}
+		if (EINTR == errno) continue;
+		ec = caney::errno_error_code();
+		return 0;
+	}
+}
+
+__CANEY_STREAMSV1_END
@@ -1,21 +1,92 @@
 #include "caney/streams/streams.hpp"
 
+#include <algorithm>
+#include <exception>
+
 __CANEY_STREAMSV1_BEGIN
 
 bool sink_base::is_paused() const {
-	return m_is_paused;
+	return m_is_paused || m_watermark_paused;
+}
+
+bool sink_base::change_watermarks(std::size_t high, std::size_t low) {
+	if (low > high) std::terminate();
+	m_high_watermark = high;
+	m_low_watermark = low;
+	return update_watermarks();
 }
 
 void sink_base::pause() {
 	if (m_is_paused) return;
 	m_is_paused = true;
-	if (m_origin) { m_origin_pause = m_origin->pause(); }
+	update_origin_pause();
 }
 
 void sink_base::resume() {
 	if (!m_is_paused) return;
 	m_is_paused = false;
-	m_origin_pause.reset();
+	update_origin_pause();
+}
+
+sink_stats sink_base::in_stats() const {
+#if CANEY_STREAMS_STATS
+	sink_stats result = m_stats;
+	if (m_stats_paused) result.paused_time += std::chrono::steady_clock::now() - m_paused_since;
+	return result;
+#else
+	return sink_stats();
+#endif
+}
+
+#if CANEY_STREAMS_STATS
+void sink_base::record_receive(std::size_t chunks, std::size_t bytes, std::chrono::steady_clock::duration time) {
+	std::chrono::nanoseconds const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time);
+	m_stats.chunks_in += chunks;
+	m_stats.bytes_in += bytes;
+	++m_stats.callbacks;
+	m_stats.callback_time += ns;
+	m_stats.max_callback_time = std::max(m_stats.max_callback_time, ns);
+}
+
+void sink_base::record_pause_state() {
+	bool const paused = is_paused();
+	if (paused == m_stats_paused) return;
+	m_stats_paused = paused;
+	std::chrono::steady_clock::time_point const now = std::chrono::steady_clock::now();
+	if (paused) {
+		++m_stats.pauses;
+		m_paused_since = now;
+	} else {
+		m_stats.paused_time += now - m_paused_since;
+	}
+}
+#endif
+
+void sink_base::update_origin_pause() {
+#if CANEY_STREAMS_STATS
+	record_pause_state();
+#endif
+	if (!is_paused()) {
+		m_origin_pause.reset();
+	} else if (m_origin && !m_origin_pause) {
+		m_origin_pause = m_origin->pause();
+	}
+}
+
+bool sink_base::update_watermarks() {
+	if (!m_watermark_paused) {
+		if (0 != m_high_watermark && m_buffered > m_high_watermark) {
+			m_watermark_paused = true;
+			update_origin_pause();
+		}
+		return false;
+	}
+	if (0 == m_high_watermark || m_buffered <= m_low_watermark) {
+		m_watermark_paused = false;
+		update_origin_pause();
+		return true;
+	}
+	return false;
 }
 
 std::shared_ptr<origin> const& sink_base::get_origin() const {
@@ -30,7 +101,7 @@ void sink_base::set_new_origin(std::shared_ptr<origin> new_origin) {
 	if (m_origin == new_origin) return;
 	m_origin = new_origin;
 
-	if (m_is_paused && new_origin) {
+	if (is_paused() && new_origin) {
 		m_origin_pause = new_origin->pause();
 	} else {
 		m_origin_pause.reset();
@@ -47,4 +118,12 @@ std::shared_ptr<origin> source_base::get_origin() const {
 	return m_origin.lock();
 }
 
+source_stats source_base::out_stats() const {
+#if CANEY_STREAMS_STATS
+	return m_stats;
+#else
+	return source_stats();
+#endif
+}
+
 __CANEY_STREAMSV1_END
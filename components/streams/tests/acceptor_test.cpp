@@ -0,0 +1,222 @@
+#include "caney/streams/acceptor.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	// keeps accepted endpoints (echoing everything back) alive
+	class connections {
+	public:
+		void add(std::shared_ptr<caney::streams::sharded_acceptor::endpoint_t> endpoint, std::size_t shard) {
+			// echo: endpoint writes what it reads; links are released when the client closes
+			caney::streams::connect(endpoint, endpoint);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_endpoints.push_back(std::move(endpoint));
+			m_shards.push_back(shard);
+			m_threads.insert(std::this_thread::get_id());
+			m_cond.notify_all();
+		}
+
+		bool wait(std::size_t count) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			return m_cond.wait_for(lock, std::chrono::seconds(5), [&]() { return m_endpoints.size() >= count; });
+		}
+
+		std::vector<std::size_t> shards() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_shards;
+		}
+
+		std::size_t threads() {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_threads.size();
+		}
+
+		// only after the acceptor was stopped
+		void clear() {
+			m_endpoints.clear();
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		std::vector<std::shared_ptr<caney::streams::sharded_acceptor::endpoint_t>> m_endpoints;
+		std::vector<std::size_t> m_shards;
+		std::set<std::thread::id> m_threads;
+	};
+
+	void run_clients(caney::streams::sharded_acceptor& acceptor, std::size_t count) {
+		boost::asio::io_context io;
+		std::vector<boost::asio::ip::tcp::socket> clients;
+		for (std::size_t i = 0; i < count; ++i) {
+			clients.emplace_back(io);
+			clients.back().connect(acceptor.local_endpoint());
+		}
+		for (std::size_t i = 0; i < count; ++i) {
+			std::string const msg = "hello " + std::to_string(i);
+			boost::asio::write(clients[i], boost::asio::buffer(msg));
+			std::string reply(msg.size(), '\0');
+			boost::asio::read(clients[i], boost::asio::buffer(&reply[0], reply.size()));
+			BOOST_CHECK_EQUAL(reply, msg);
+		}
+		for (boost::asio::ip::tcp::socket& client : clients) {
+			client.shutdown(boost::asio::socket_base::shutdown_send);
+			// echo endpoint shuts down its side after the end of the stream
+			char c;
+			boost::system::error_code ec;
+			BOOST_CHECK_EQUAL(client.read_some(boost::asio::buffer(&c, 1), ec), 0u);
+			BOOST_CHECK(ec == boost::asio::error::eof);
+		}
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(acceptor_test)
+
+BOOST_AUTO_TEST_CASE(round_robin) {
+	caney::streams::acceptor_options options;
+	options.threads = 2;
+	options.reuse_port = false;
+	options.pin_threads = false;
+	caney::streams::sharded_acceptor acceptor(options);
+	connections conns;
+
+	std::error_code ec;
+	acceptor.listen(
+		boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0),
+		[&conns](std::shared_ptr<caney::streams::sharded_acceptor::endpoint_t> endpoint, std::size_t shard) { conns.add(std::move(endpoint), shard); },
+		ec);
+	BOOST_REQUIRE(!ec);
+	BOOST_CHECK(!acceptor.uses_reuse_port());
+	BOOST_CHECK_NE(acceptor.local_endpoint().port(), 0);
+
+	run_clients(acceptor, 4);
+	BOOST_REQUIRE(conns.wait(4));
+	BOOST_CHECK_EQUAL(acceptor.accepted(0), 2u);
+	BOOST_CHECK_EQUAL(acceptor.accepted(1), 2u);
+	BOOST_CHECK_EQUAL(conns.threads(), 2u);
+
+	acceptor.stop();
+	conns.clear();
+}
+
+BOOST_AUTO_TEST_CASE(reuse_port) {
+	caney::streams::acceptor_options options;
+	options.threads = 3;
+	caney::streams::sharded_acceptor acceptor(options);
+	connections conns;
+
+	std::error_code ec;
+	acceptor.listen(
+		boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0),
+		[&conns](std::shared_ptr<caney::streams::sharded_acceptor::endpoint_t> endpoint, std::size_t shard) { conns.add(std::move(endpoint), shard); },
+		ec);
+	BOOST_REQUIRE(!ec);
+
+	run_clients(acceptor, 16);
+	BOOST_REQUIRE(conns.wait(16));
+	std::uint64_t total = 0;
+	for (std::size_t i = 0; i < acceptor.shards(); ++i) total += acceptor.accepted(i);
+	BOOST_CHECK_EQUAL(total, 16u);
+	for (std::size_t shard : conns.shards()) BOOST_CHECK_LT(shard, acceptor.shards());
+
+	acceptor.stop();
+	conns.clear();
+}
+
+BOOST_AUTO_TEST_CASE(io_uring) {
+	caney::streams::acceptor_options options;
+	options.threads = 2;
+	options.pin_threads = false;
+	options.io_uring = true;
+	caney::streams::sharded_acceptor acceptor(options);
+	for (std::size_t i = 0; i < acceptor.shards(); ++i) BOOST_CHECK_EQUAL(acceptor.uses_io_uring(i), caney::streams::io_uring_engine::is_available());
+	connections conns;
+
+	std::error_code ec;
+	acceptor.listen(
+		boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0),
+		[&conns](std::shared_ptr<caney::streams::sharded_acceptor::endpoint_t> endpoint, std::size_t shard) { conns.add(std::move(endpoint), shard); },
+		ec);
+	BOOST_REQUIRE(!ec);
+
+	// echo (and end of stream) through io_uring receives
+	run_clients(acceptor, 8);
+	BOOST_REQUIRE(conns.wait(8));
+
+	acceptor.stop();
+	conns.clear();
+}
+
+BOOST_AUTO_TEST_CASE(stop_closes_listener) {
+	caney::streams::acceptor_options options;
+	options.threads = 2;
+	options.pin_threads = false;
+	caney::streams::sharded_acceptor acceptor(options);
+	std::error_code ec;
+	acceptor.listen(
+		boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0), [](std::shared_ptr<caney::streams::sharded_acceptor::endpoint_t>, std::size_t) {},
+		ec);
+	BOOST_REQUIRE(!ec);
+	acceptor.stop();
+
+	boost::asio::io_context io;
+	boost::asio::ip::tcp::socket client(io);
+	boost::system::error_code bec;
+	client.connect(acceptor.local_endpoint(), bec);
+	BOOST_CHECK(bec == boost::asio::error::connection_refused);
+}
+
+BOOST_AUTO_TEST_CASE(error_backoff) {
+	caney::streams::acceptor_options options;
+	options.threads = 1;
+	options.pin_threads = false;
+	options.error_backoff = std::chrono::milliseconds(50);
+	caney::streams::sharded_acceptor acceptor(options);
+	connections conns;
+	std::error_code ec;
+	acceptor.listen(
+		boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0),
+		[&conns](std::shared_ptr<caney::streams::sharded_acceptor::endpoint_t> endpoint, std::size_t shard) { conns.add(std::move(endpoint), shard); },
+		ec);
+	BOOST_REQUIRE(!ec);
+
+	boost::asio::io_context io;
+	boost::asio::ip::tcp::socket client(io);
+	client.open(boost::asio::ip::tcp::v4());
+
+	// no file descriptors left for accepted connections (dup returns the lowest free descriptor)
+	struct rlimit old_limit;
+	BOOST_REQUIRE_EQUAL(0, ::getrlimit(RLIMIT_NOFILE, &old_limit));
+	int const probe = ::dup(0);
+	BOOST_REQUIRE_GE(probe, 0);
+	::close(probe);
+	struct rlimit limit = old_limit;
+	limit.rlim_cur = static_cast<rlim_t>(probe);
+	BOOST_REQUIRE_EQUAL(0, ::setrlimit(RLIMIT_NOFILE, &limit));
+
+	client.connect(acceptor.local_endpoint());
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	std::uint64_t const errors = acceptor.accept_errors(0);
+	BOOST_CHECK(::setrlimit(RLIMIT_NOFILE, &old_limit) == 0);
+
+	// retried after each backoff instead of spinning
+	BOOST_CHECK_GE(errors, 1u);
+	BOOST_CHECK_LE(errors, 10u);
+	BOOST_CHECK_EQUAL(acceptor.accepted(0), 0u);
+
+	// pending connection accepted after the next backoff
+	BOOST_CHECK(conns.wait(1));
+	acceptor.stop();
+	conns.clear();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
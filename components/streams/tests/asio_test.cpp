@@ -0,0 +1,539 @@
+#include "caney/streams/asio.hpp"
+
+#include "test_helpers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+	using test_helpers::collect_sink;
+	using test_helpers::test_source;
+
+	class temp_file {
+	public:
+		explicit temp_file(std::string const& content) {
+			char name[] = "/tmp/caney-asio-test-XXXXXX";
+			int const fd = ::mkstemp(name);
+			if (-1 == fd) throw std::runtime_error("mkstemp failed");
+			::close(fd);
+			m_path = name;
+			std::ofstream(m_path, std::ios::binary) << content;
+		}
+
+		~temp_file() {
+			std::remove(m_path.c_str());
+		}
+
+		std::string const& path() const {
+			return m_path;
+		}
+
+	private:
+		std::string m_path;
+	};
+
+	std::string read_all(boost::asio::local::stream_protocol::socket& sock) {
+		std::string result;
+		char buf[4096];
+		boost::system::error_code ec;
+		for (;;) {
+			std::size_t const n = sock.read_some(boost::asio::buffer(buf), ec);
+			if (ec) break;
+			result.append(buf, n);
+		}
+		return result;
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(asio_test)
+
+BOOST_AUTO_TEST_CASE(send_mixed_chunks) {
+	using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+	std::string file_content;
+	for (int i = 0; i < 20000; ++i) file_content.push_back(static_cast<char>('a' + i % 26));
+	temp_file file(file_content);
+	std::error_code ec;
+	std::shared_ptr<caney::streams::file_handle> handle = caney::streams::file_handle::open(file.path(), ec);
+	BOOST_REQUIRE(!ec);
+	BOOST_CHECK(handle->size(ec) == caney::streams::file_size{20000});
+
+	boost::asio::io_context io;
+	boost::asio::local::stream_protocol::socket local(io), remote(io);
+	boost::asio::local::connect_pair(local, remote);
+
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	std::shared_ptr<endpoint_t> endpoint = endpoint_t::create(strand, std::move(local));
+	auto source = std::make_shared<test_source>();
+	caney::streams::connect(source, endpoint);
+
+	caney::streams::chunk_queue chunks;
+	chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(std::string("head:"))));
+	chunks.append(caney::streams::chunk(caney::streams::file_chunk(handle, caney::streams::file_size{2}, caney::streams::file_size{10000})));
+	chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(std::string(":middle:"))));
+	chunks.append(caney::streams::chunk(caney::streams::file_chunk(handle, caney::streams::file_size{19990}, caney::streams::file_size{10})));
+	chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(std::string(":tail"))));
+	source->push(std::move(chunks));
+	source->end();
+
+	io.run();
+
+	std::string const expected = "head:" + file_content.substr(2, 10000) + ":middle:" + file_content.substr(19990) + ":tail";
+	std::string const received = read_all(remote);
+	BOOST_CHECK_EQUAL(received.size(), expected.size());
+	BOOST_CHECK(received == expected);
+}
+
+BOOST_AUTO_TEST_CASE(empty_chunks) {
+	using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+	temp_file file("file");
+	std::error_code ec;
+	std::shared_ptr<caney::streams::file_handle> handle = caney::streams::file_handle::open(file.path(), ec);
+	BOOST_REQUIRE(!ec);
+
+	boost::asio::io_context io;
+	boost::asio::local::stream_protocol::socket local(io), remote(io);
+	boost::asio::local::connect_pair(local, remote);
+
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	std::shared_ptr<endpoint_t> endpoint = endpoint_t::create(strand, std::move(local));
+	auto source = std::make_shared<test_source>();
+	caney::streams::connect(source, endpoint);
+
+	// only empty chunks: nothing to write
+	source->push(std::string());
+	source->push(std::string());
+	io.run();
+
+	// empty chunks in front of a file chunk and at the end
+	caney::streams::chunk_queue chunks;
+	chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(std::string())));
+	chunks.append(caney::streams::chunk(caney::streams::file_chunk(handle, caney::streams::file_size{0}, caney::streams::file_size{4})));
+	chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(std::string(":"))));
+	chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(std::string())));
+	source->push(std::move(chunks));
+	source->end();
+	io.restart();
+	io.run();
+
+	BOOST_CHECK_EQUAL(read_all(remote), "file:");
+}
+
+BOOST_AUTO_TEST_CASE(coalesce_small_chunks) {
+	using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+	boost::asio::io_context io;
+	boost::asio::local::stream_protocol::socket local(io), remote(io);
+	boost::asio::local::connect_pair(local, remote);
+
+	caney::streams::asio_endpoint_options options;
+	options.max_write_bytes = 1000;
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	std::shared_ptr<endpoint_t> endpoint = endpoint_t::create(strand, std::move(local), options);
+	auto source = std::make_shared<test_source>();
+	caney::streams::connect(source, endpoint);
+
+	// more chunks than buffers per write, with large chunks interrupting runs of small ones
+	std::string expected;
+	caney::streams::chunk_queue chunks;
+	for (int i = 0; i < 2000; ++i) {
+		std::string const data = (0 == i % 300) ? std::string(3000, static_cast<char>('A' + i % 26)) : std::to_string(i) + ",";
+		expected += data;
+		chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(data)));
+	}
+	source->push(std::move(chunks));
+	source->end();
+
+	io.run();
+
+	std::string const received = read_all(remote);
+	BOOST_CHECK_EQUAL(received.size(), expected.size());
+	BOOST_CHECK(received == expected);
+}
+
+BOOST_AUTO_TEST_CASE(coalesce_partial_writes) {
+	using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+	boost::asio::io_context io;
+	boost::asio::local::stream_protocol::socket local(io), remote(io);
+	boost::asio::local::connect_pair(local, remote);
+	local.set_option(boost::asio::socket_base::send_buffer_size(16 * 1024));
+	remote.non_blocking(true);
+
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	std::shared_ptr<endpoint_t> endpoint = endpoint_t::create(strand, std::move(local));
+	auto source = std::make_shared<test_source>();
+	caney::streams::connect(source, endpoint);
+
+	// writes of coalesced runs don't fit into the socket: continue in the middle of them
+	std::string expected;
+	caney::streams::chunk_queue chunks;
+	for (int i = 0; i < 50000; ++i) {
+		std::string const data = (0 == i % 5000) ? std::string(20000, static_cast<char>('A' + i % 26)) : std::to_string(i) + ",";
+		expected += data;
+		chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(data)));
+	}
+	source->push(std::move(chunks));
+
+	std::string received;
+	std::array<char, 4096> buf;
+	for (int i = 0; i < 10000 && received.size() < expected.size(); ++i) {
+		io.restart();
+		io.poll();
+		// read slowly: one small read per round
+		boost::system::error_code ec;
+		std::size_t const bytes = remote.read_some(boost::asio::buffer(buf), ec);
+		if (!ec) received.append(buf.data(), bytes);
+	}
+	BOOST_CHECK_EQUAL(received.size(), expected.size());
+	BOOST_CHECK(received == expected);
+}
+
+BOOST_AUTO_TEST_CASE(cork_and_flush) {
+	using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+	boost::asio::io_context io;
+	boost::asio::local::stream_protocol::socket local(io), remote(io);
+	boost::asio::local::connect_pair(local, remote);
+	remote.non_blocking(true);
+
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	std::shared_ptr<endpoint_t> endpoint = endpoint_t::create(strand, std::move(local));
+	auto source = std::make_shared<test_source>();
+	caney::streams::connect(source, endpoint);
+	endpoint->cork();
+
+	std::string expected;
+	for (int round = 0; round < 2; ++round) {
+		caney::streams::chunk_queue chunks;
+		for (int i = 0; i < 100; ++i) {
+			std::string const data = "message " + std::to_string(i) + "\n";
+			expected += data;
+			chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(data)));
+		}
+		source->push(std::move(chunks));
+	}
+
+	// nothing written while corked
+	io.poll();
+	BOOST_CHECK(read_all(remote).empty());
+
+	endpoint->flush();
+	io.run();
+	BOOST_CHECK(read_all(remote) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(read_batches) {
+	using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+	boost::asio::io_context io;
+	boost::asio::local::stream_protocol::socket local(io), remote(io);
+	boost::asio::local::connect_pair(local, remote);
+
+	// fits into the socket buffer
+	std::string sent;
+	for (int i = 0; i < 100000; ++i) sent.push_back(static_cast<char>('a' + i % 26));
+	boost::asio::write(remote, boost::asio::buffer(sent));
+	remote.shutdown(boost::asio::local::stream_protocol::socket::shutdown_send);
+
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	std::shared_ptr<endpoint_t> endpoint = endpoint_t::create(strand, std::move(local));
+	auto sink = std::make_shared<collect_sink>();
+	caney::streams::connect(endpoint, sink);
+
+	io.run();
+
+	BOOST_CHECK(sink->ended);
+	BOOST_CHECK_EQUAL(sink->data.size(), sent.size());
+	BOOST_CHECK(sink->data == sent);
+	// the first wakeup read more than one buffer
+	BOOST_CHECK(sink->max_chunks > 1);
+}
+
+namespace {
+	void check_pause_suspends_reading(bool io_uring) {
+		using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+		boost::asio::io_context io;
+		boost::asio::local::stream_protocol::socket local(io), remote(io);
+		boost::asio::local::connect_pair(local, remote);
+		// to look at the receive queue of the endpoint socket
+		int const local_fd = ::dup(local.native_handle());
+		BOOST_REQUIRE(-1 != local_fd);
+		auto queued = [local_fd]() {
+			int n = -1;
+			::ioctl(local_fd, FIONREAD, &n);
+			return n;
+		};
+
+		auto poll = [&io]() {
+			io.restart();
+			io.poll();
+		};
+
+		auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+		caney::streams::asio_endpoint_options options;
+		if (io_uring) {
+			std::error_code ec;
+			options.io_uring = caney::streams::io_uring_reactor::create(strand, caney::streams::io_uring_options(), ec);
+			if (!options.io_uring) {
+				BOOST_TEST_MESSAGE("io_uring not available: " << ec.message());
+				::close(local_fd);
+				return;
+			}
+		}
+		std::shared_ptr<endpoint_t> endpoint = endpoint_t::create(strand, std::move(local), options);
+		auto sink = std::make_shared<collect_sink>();
+		sink->hold();
+		caney::streams::connect(endpoint, sink);
+
+		boost::asio::write(remote, boost::asio::buffer(std::string("first")));
+		for (int i = 0; i < 10 && sink->data.empty(); ++i) poll();
+		BOOST_CHECK_EQUAL(sink->data, "first");
+		BOOST_CHECK(endpoint->caney::streams::origin::is_paused());
+
+		// not read while paused
+		boost::asio::write(remote, boost::asio::buffer(std::string("second")));
+		for (int i = 0; i < 10; ++i) poll();
+		BOOST_CHECK_EQUAL(sink->data, "first");
+		BOOST_CHECK_EQUAL(queued(), 6);
+
+		sink->release();
+		for (int i = 0; i < 10 && sink->data.size() < 11; ++i) poll();
+		BOOST_CHECK_EQUAL(sink->data, "firstsecond");
+		BOOST_CHECK_EQUAL(queued(), 0);
+
+		::close(local_fd);
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(pause_suspends_reading) {
+	check_pause_suspends_reading(false);
+}
+
+BOOST_AUTO_TEST_CASE(io_uring_pause_suspends_reading) {
+	check_pause_suspends_reading(true);
+}
+
+BOOST_AUTO_TEST_CASE(io_uring_read) {
+	using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+	boost::asio::io_context io;
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	std::error_code ec;
+	caney::streams::io_uring_options ring_options;
+	ring_options.buffer_size = 4096;
+	ring_options.recv_buffers = 8;
+	caney::streams::asio_endpoint_options options;
+	options.io_uring = caney::streams::io_uring_reactor::create(strand, ring_options, ec);
+	BOOST_CHECK_EQUAL(bool(options.io_uring), caney::streams::io_uring_engine::is_available());
+	if (!options.io_uring) return;
+	caney::streams::io_uring_engine& engine = options.io_uring->engine();
+
+	// more data than provided buffers
+	std::string sent;
+	for (int i = 0; i < 100000; ++i) sent.push_back(static_cast<char>('a' + i % 26));
+
+	std::array<boost::asio::local::stream_protocol::socket, 8> remotes{{
+		boost::asio::local::stream_protocol::socket(io),
+		boost::asio::local::stream_protocol::socket(io),
+		boost::asio::local::stream_protocol::socket(io),
+		boost::asio::local::stream_protocol::socket(io),
+		boost::asio::local::stream_protocol::socket(io),
+		boost::asio::local::stream_protocol::socket(io),
+		boost::asio::local::stream_protocol::socket(io),
+		boost::asio::local::stream_protocol::socket(io),
+	}};
+	std::vector<std::shared_ptr<endpoint_t>> endpoints;
+	std::vector<std::shared_ptr<collect_sink>> sinks;
+	for (boost::asio::local::stream_protocol::socket& remote : remotes) {
+		boost::asio::local::stream_protocol::socket local(io);
+		boost::asio::local::connect_pair(local, remote);
+		endpoints.push_back(endpoint_t::create(strand, std::move(local), options));
+		sinks.push_back(std::make_shared<collect_sink>());
+		caney::streams::connect(endpoints.back(), sinks.back());
+	}
+
+	// all receives are submitted together
+	std::uint64_t const enter_calls = engine.stats().enter_calls;
+	io.poll();
+	BOOST_CHECK_EQUAL(engine.stats().enter_calls, enter_calls + 1);
+	BOOST_CHECK_EQUAL(engine.pending(), remotes.size());
+
+	for (boost::asio::local::stream_protocol::socket& remote : remotes) {
+		boost::asio::write(remote, boost::asio::buffer(sent));
+		remote.shutdown(boost::asio::local::stream_protocol::socket::shutdown_send);
+	}
+	// the reactor keeps waiting for completions: io.run() wouldn't return
+	auto all_ended = [&sinks]() { return std::all_of(sinks.begin(), sinks.end(), [](std::shared_ptr<collect_sink> const& sink) { return sink->ended; }); };
+	while (!all_ended()) io.run_one();
+
+	for (std::shared_ptr<collect_sink> const& sink : sinks) BOOST_CHECK(sink->data == sent);
+	BOOST_CHECK_EQUAL(engine.pending(), 0u);
+	BOOST_CHECK(!options.io_uring->error());
+}
+
+namespace {
+	// relay data written to `in` through two connected endpoints to `out`
+	std::string relay(std::string const& sent, caney::streams::asio_endpoint_options const& options, std::uint64_t& spliced_bytes) {
+		using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+		boost::asio::io_context io;
+		boost::asio::local::stream_protocol::socket in_local(io), in(io), out_local(io), out(io);
+		boost::asio::local::connect_pair(in_local, in);
+		boost::asio::local::connect_pair(out_local, out);
+
+		auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+		std::shared_ptr<endpoint_t> from = endpoint_t::create(strand, std::move(in_local), options);
+		std::shared_ptr<endpoint_t> to = endpoint_t::create(strand, std::move(out_local), options);
+		caney::streams::connect(from, to);
+
+		boost::asio::async_write(in, boost::asio::buffer(sent), [&](boost::system::error_code const& ec, std::size_t) {
+			BOOST_CHECK(!ec);
+			in.shutdown(boost::asio::local::stream_protocol::socket::shutdown_send);
+		});
+
+		std::string received;
+		std::array<char, 65536> buf;
+		std::function<void()> read_more = [&]() {
+			out.async_read_some(boost::asio::buffer(buf), [&](boost::system::error_code const& ec, std::size_t bytes) {
+				received.append(buf.data(), bytes);
+				if (!ec) read_more();
+			});
+		};
+		read_more();
+
+		io.run();
+		spliced_bytes = from->spliced_bytes();
+		return received;
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(splice_relay) {
+	// larger than the socket buffers and the pipe
+	std::string sent;
+	for (int i = 0; i < 4 * 1024 * 1024; ++i) sent.push_back(static_cast<char>('a' + i % 26));
+
+	std::uint64_t spliced_bytes = 0;
+	std::string const received = relay(sent, caney::streams::asio_endpoint_options(), spliced_bytes);
+	BOOST_CHECK_EQUAL(received.size(), sent.size());
+	BOOST_CHECK(received == sent);
+	BOOST_CHECK_EQUAL(spliced_bytes, sent.size());
+
+	caney::streams::asio_endpoint_options options;
+	options.splice_relay = false;
+	BOOST_CHECK(relay(sent, options, spliced_bytes) == sent);
+	BOOST_CHECK_EQUAL(spliced_bytes, 0u);
+}
+
+namespace {
+	// connected TCP sockets on loopback; buffer sizes are set before connecting
+	void tcp_pair(boost::asio::ip::tcp::socket& server, boost::asio::ip::tcp::socket& client, int server_send_buffer, int client_buffer) {
+		boost::asio::ip::tcp::acceptor acceptor(server.get_executor(), boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+		client.open(boost::asio::ip::tcp::v4());
+		client.set_option(boost::asio::socket_base::send_buffer_size(client_buffer));
+		client.set_option(boost::asio::socket_base::receive_buffer_size(client_buffer));
+		client.connect(acceptor.local_endpoint());
+		acceptor.accept(server);
+		server.set_option(boost::asio::socket_base::send_buffer_size(server_send_buffer));
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE(splice_relay_paused_and_corked) {
+	using endpoint_t = caney::streams::asio_endpoint<boost::asio::ip::tcp>;
+
+	// request fits into the pipe; the peer waits for it to arrive before sending more
+	std::string sent;
+	for (int i = 0; i < 64 * 1024; ++i) sent.push_back(static_cast<char>('a' + i % 26));
+
+	// pause the relaying endpoint and/or cork the target while the pipe holds data
+	for (int mode = 0; mode < 3; ++mode) {
+		bool const pause = (1 != mode), cork = (0 != mode);
+		BOOST_TEST_CONTEXT("pause " << pause << ", cork " << cork) {
+			boost::asio::io_context io;
+			boost::asio::ip::tcp::socket in_local(io), in(io), out_local(io), out(io);
+			// request arrives at once; target socket fills up before the pipe is empty
+			tcp_pair(in_local, in, 1024 * 1024, 1024 * 1024);
+			tcp_pair(out_local, out, 4096, 4096);
+			out.non_blocking(true);
+
+			auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+			std::shared_ptr<endpoint_t> from = endpoint_t::create(strand, std::move(in_local));
+			std::shared_ptr<endpoint_t> to = endpoint_t::create(strand, std::move(out_local));
+			caney::streams::connect(from, to);
+			boost::asio::write(in, boost::asio::buffer(sent));
+
+			std::string received;
+			auto run = [&io]() {
+				io.restart();
+				io.run_for(std::chrono::milliseconds(10));
+			};
+			auto read_out = [&out, &received]() {
+				std::array<char, 65536> buf;
+				boost::system::error_code ec;
+				for (;;) {
+					std::size_t const bytes = out.read_some(boost::asio::buffer(buf), ec);
+					if (ec) break;
+					received.append(buf.data(), bytes);
+				}
+			};
+
+			for (int i = 0; i < 10; ++i) run();
+			BOOST_REQUIRE_EQUAL(from->spliced_bytes(), sent.size());
+			int queued = -1;
+			::ioctl(out.native_handle(), FIONREAD, &queued);
+			BOOST_REQUIRE_LT(queued, static_cast<int>(sent.size()));
+
+			caney::streams::origin_pause paused;
+			if (pause) paused = from->caney::streams::origin::pause();
+			if (cork) to->cork();
+			for (int i = 0; i < 10; ++i) {
+				read_out();
+				run();
+			}
+			// corked target holds back the rest
+			if (cork) BOOST_CHECK_LT(received.size(), sent.size());
+
+			paused.reset();
+			if (cork) to->uncork();
+			for (int i = 0; i < 100 && received.size() < sent.size(); ++i) {
+				read_out();
+				run();
+			}
+			BOOST_CHECK_EQUAL(received.size(), sent.size());
+			BOOST_CHECK(received == sent);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(truncated_file) {
+	temp_file file("short");
+	std::error_code ec;
+	std::shared_ptr<caney::streams::file_handle> handle = caney::streams::file_handle::open(file.path(), ec);
+	BOOST_REQUIRE(!ec);
+
+	int fds[2];
+	BOOST_REQUIRE_EQUAL(::pipe(fds), 0);
+	caney::streams::file_chunk chunk(handle, caney::streams::file_size{5}, caney::streams::file_size{10});
+	BOOST_CHECK_EQUAL(chunk.send_to(fds[1], ec), 0u);
+	BOOST_CHECK(ec == std::errc::no_message_available);
+	::close(fds[0]);
+	::close(fds[1]);
+
+	BOOST_CHECK(!caney::streams::file_handle::open("/nonexistent/file", ec));
+	BOOST_CHECK(ec == std::errc::no_such_file_or_directory);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,117 @@
+#include "caney/streams/chunks.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+namespace {
+	caney::streams::chunk make_chunk(std::string const& data) {
+		return caney::streams::chunk(caney::memory::shared_const_buf::copy(data));
+	}
+
+	std::string content(caney::streams::chunk_queue const& queue) {
+		std::string result;
+		for (caney::streams::chunk const& c : queue.queue()) {
+			boost::asio::const_buffer const buf = *c.get_const_buffer();
+			result.append(static_cast<char const*>(buf.data()), buf.size());
+		}
+		return result;
+	}
+
+	caney::streams::file_size bytes(std::uint64_t n) {
+		return caney::streams::file_size{n};
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(chunks_test)
+
+BOOST_AUTO_TEST_CASE(byte_count) {
+	caney::streams::chunk_queue queue;
+	BOOST_CHECK(queue.bytes() == bytes(0));
+	queue.append(make_chunk("hello"));
+	queue.append(make_chunk(" "));
+	queue.append(make_chunk("world"));
+	BOOST_CHECK(queue.bytes() == bytes(11));
+
+	caney::streams::chunk_queue other(make_chunk("!"));
+	queue.append(std::move(other));
+	BOOST_CHECK(other.empty());
+	BOOST_CHECK(other.bytes() == bytes(0));
+	BOOST_CHECK(queue.bytes() == bytes(12));
+	BOOST_CHECK_EQUAL(content(queue), "hello world!");
+
+	queue.clear();
+	BOOST_CHECK(queue.empty());
+	BOOST_CHECK(queue.bytes() == bytes(0));
+}
+
+BOOST_AUTO_TEST_CASE(split) {
+	caney::streams::chunk_queue queue;
+	queue.append(make_chunk("hello"));
+	queue.append(make_chunk(" "));
+	queue.append(make_chunk("world"));
+
+	// splits inside the first chunk
+	caney::streams::chunk_queue head = queue.split(bytes(3));
+	BOOST_CHECK_EQUAL(content(head), "hel");
+	BOOST_CHECK_EQUAL(head.queue().size(), 1u);
+	BOOST_CHECK(head.bytes() == bytes(3));
+	BOOST_CHECK_EQUAL(content(queue), "lo world");
+	BOOST_CHECK(queue.bytes() == bytes(8));
+
+	// takes complete chunks, splits the last one
+	head = queue.split(bytes(5));
+	BOOST_CHECK_EQUAL(content(head), "lo wo");
+	BOOST_CHECK_EQUAL(head.queue().size(), 3u);
+	BOOST_CHECK_EQUAL(content(queue), "rld");
+	BOOST_CHECK(queue.bytes() == bytes(3));
+
+	// exactly at chunk boundary
+	head = queue.split(bytes(3));
+	BOOST_CHECK_EQUAL(content(head), "rld");
+	BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(remove) {
+	caney::streams::chunk_queue queue;
+	for (int i = 0; i < 20; ++i) queue.append(make_chunk(std::to_string(i % 10)));
+	BOOST_CHECK(queue.bytes() == bytes(20));
+
+	queue.remove(bytes(0));
+	BOOST_CHECK(queue.bytes() == bytes(20));
+	queue.remove(bytes(15));
+	BOOST_CHECK_EQUAL(content(queue), "56789");
+	BOOST_CHECK(queue.bytes() == bytes(5));
+
+	queue.append(make_chunk("abcdef"));
+	queue.remove(bytes(7));
+	BOOST_CHECK_EQUAL(content(queue), "cdef");
+	BOOST_CHECK(queue.bytes() == bytes(4));
+}
+
+BOOST_AUTO_TEST_CASE(append_keeps_buffer) {
+	caney::streams::chunk_queue queue;
+	for (int i = 0; i < 6; ++i) queue.append(make_chunk(std::to_string(i)));
+	BOOST_CHECK(!queue.queue().is_inline());
+	std::size_t const capacity = queue.queue().capacity();
+
+	// drained queue keeps its heap buffer when appending a queue again
+	queue.remove(bytes(6));
+	BOOST_CHECK(queue.empty());
+	caney::streams::chunk_queue other(make_chunk("ab"));
+	queue.append(std::move(other));
+	BOOST_CHECK(!queue.queue().is_inline());
+	BOOST_CHECK_EQUAL(queue.queue().capacity(), capacity);
+	BOOST_CHECK_EQUAL(content(queue), "ab");
+	BOOST_CHECK(queue.bytes() == bytes(2));
+
+	// empty inline queue takes over the heap buffer of the other queue
+	caney::streams::chunk_queue inline_queue;
+	inline_queue.append(std::move(queue));
+	BOOST_CHECK(!inline_queue.queue().is_inline());
+	BOOST_CHECK(queue.bytes() == bytes(0));
+	BOOST_CHECK(inline_queue.bytes() == bytes(2));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
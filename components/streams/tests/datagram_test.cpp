@@ -0,0 +1,165 @@
+#include "caney/streams/datagram.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+	// source pushing datagrams into the endpoint
+	class test_source : public caney::streams::source<caney::streams::datagram> {
+	public:
+		void push(chunks_t&& datagrams) {
+			send(std::move(datagrams));
+		}
+
+	protected:
+		void on_disconnect() override {}
+	};
+
+	// sink collecting received datagrams
+	class test_sink : public caney::streams::sink<caney::streams::datagram> {
+	public:
+		std::vector<caney::streams::datagram> datagrams;
+
+	protected:
+		void on_receive(chunks_t&& chunks) override {
+			for (caney::streams::datagram& d : chunks) datagrams.push_back(std::move(d));
+		}
+
+		void on_end(caney::streams::StreamEnd) override {}
+	};
+
+	boost::asio::ip::udp::socket bound_socket(boost::asio::io_context& io) {
+		return boost::asio::ip::udp::socket(io, boost::asio::ip::udp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+	}
+
+	std::string to_string(caney::memory::const_buf const& buf) {
+		return std::string(reinterpret_cast<char const*>(buf.data()), buf.size());
+	}
+
+	std::string message(std::size_t i) {
+		std::string msg = "datagram " + std::to_string(i);
+		msg.resize(100, '.');
+		return msg;
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(datagram_test)
+
+BOOST_AUTO_TEST_CASE(receive_batches) {
+	boost::asio::io_context io;
+	std::shared_ptr<boost::asio::io_context::strand> strand = std::make_shared<boost::asio::io_context::strand>(io);
+	boost::asio::ip::udp::socket client = bound_socket(io);
+	boost::asio::ip::udp::socket server = bound_socket(io);
+	boost::asio::ip::udp::endpoint const server_address = server.local_endpoint();
+	std::shared_ptr<caney::streams::datagram_endpoint> endpoint = caney::streams::datagram_endpoint::create(strand, std::move(server));
+
+	// queue all datagrams in the kernel before the endpoint reads
+	for (std::size_t i = 0; i < 20; ++i) client.send_to(boost::asio::buffer(message(i)), server_address);
+
+	std::shared_ptr<test_sink> sink = std::make_shared<test_sink>();
+	caney::streams::connect(endpoint, sink);
+	for (int i = 0; i < 100 && sink->datagrams.size() < 20; ++i) {
+		io.restart();
+		io.poll();
+	}
+
+	BOOST_REQUIRE_EQUAL(sink->datagrams.size(), 20u);
+	for (std::size_t i = 0; i < 20; ++i) {
+		BOOST_CHECK_EQUAL(to_string(sink->datagrams[i].data), message(i));
+		BOOST_CHECK(sink->datagrams[i].peer == client.local_endpoint());
+	}
+	BOOST_CHECK_EQUAL(endpoint->stats().received, 20u);
+	BOOST_CHECK_LT(endpoint->stats().receive_calls, 20u);
+	// GRO is opt-in; the receive buffers hold many datagrams
+	BOOST_CHECK(!endpoint->uses_gro());
+	BOOST_CHECK_EQUAL(endpoint->stats().copied, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(receive_gro_copies_small_datagrams) {
+	boost::asio::io_context io;
+	std::shared_ptr<boost::asio::io_context::strand> strand = std::make_shared<boost::asio::io_context::strand>(io);
+	boost::asio::ip::udp::socket client = bound_socket(io);
+	boost::asio::ip::udp::socket server = bound_socket(io);
+	boost::asio::ip::udp::endpoint const server_address = server.local_endpoint();
+	caney::streams::datagram_endpoint_options options;
+	options.gro = true;
+	std::shared_ptr<caney::streams::datagram_endpoint> endpoint = caney::streams::datagram_endpoint::create(strand, std::move(server), options);
+
+	for (std::size_t i = 0; i < 20; ++i) client.send_to(boost::asio::buffer(message(i)), server_address);
+	std::string const large(4000, 'x');
+	client.send_to(boost::asio::buffer(large), server_address);
+
+	std::shared_ptr<test_sink> sink = std::make_shared<test_sink>();
+	caney::streams::connect(endpoint, sink);
+	for (int i = 0; i < 100 && sink->datagrams.size() < 21; ++i) {
+		io.restart();
+		io.poll();
+	}
+
+	BOOST_REQUIRE_EQUAL(sink->datagrams.size(), 21u);
+	for (std::size_t i = 0; i < 20; ++i) BOOST_CHECK_EQUAL(to_string(sink->datagrams[i].data), message(i));
+	BOOST_CHECK_EQUAL(to_string(sink->datagrams[20].data), large);
+	if (endpoint->uses_gro()) {
+		// small datagrams don't take a 64 KiB receive slot each; the large one is received in place
+		BOOST_CHECK_EQUAL(endpoint->stats().copied, 20u);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(send_batches) {
+	boost::asio::io_context io;
+	std::shared_ptr<boost::asio::io_context::strand> strand = std::make_shared<boost::asio::io_context::strand>(io);
+	boost::asio::ip::udp::socket client = bound_socket(io);
+	std::shared_ptr<caney::streams::datagram_endpoint> endpoint = caney::streams::datagram_endpoint::create(strand, bound_socket(io));
+
+	std::shared_ptr<test_source> source = std::make_shared<test_source>();
+	caney::streams::connect(source, endpoint);
+
+	// equally sized datagrams to the same peer (GSO), and a shorter one ending the run
+	test_source::chunks_t datagrams;
+	for (std::size_t i = 0; i < 20; ++i) {
+		datagrams.push_back(caney::streams::datagram{client.local_endpoint(), caney::memory::shared_const_buf::copy(message(i))});
+	}
+	datagrams.push_back(caney::streams::datagram{client.local_endpoint(), caney::memory::shared_const_buf::copy(std::string("end"))});
+	source->push(std::move(datagrams));
+	io.restart();
+	io.poll();
+
+	BOOST_CHECK_EQUAL(endpoint->stats().sent, 21u);
+	BOOST_CHECK_LT(endpoint->stats().send_calls, 21u);
+
+	char buf[2048];
+	for (std::size_t i = 0; i < 20; ++i) {
+		std::size_t const got = client.receive(boost::asio::buffer(buf));
+		BOOST_CHECK_EQUAL(std::string(buf, got), message(i));
+	}
+	std::size_t const got = client.receive(boost::asio::buffer(buf));
+	BOOST_CHECK_EQUAL(std::string(buf, got), "end");
+}
+
+BOOST_AUTO_TEST_CASE(send_errors_drop_datagrams) {
+	boost::asio::io_context io;
+	std::shared_ptr<boost::asio::io_context::strand> strand = std::make_shared<boost::asio::io_context::strand>(io);
+	boost::asio::ip::udp::socket client = bound_socket(io);
+	std::shared_ptr<caney::streams::datagram_endpoint> endpoint = caney::streams::datagram_endpoint::create(strand, bound_socket(io));
+
+	std::shared_ptr<test_source> source = std::make_shared<test_source>();
+	caney::streams::connect(source, endpoint);
+
+	// IPv6 destination on an IPv4 socket fails; the following datagram still gets sent
+	test_source::chunks_t datagrams;
+	datagrams.push_back(caney::streams::datagram{boost::asio::ip::udp::endpoint(boost::asio::ip::address_v6::loopback(), 1), caney::memory::shared_const_buf::copy(std::string("lost"))});
+	datagrams.push_back(caney::streams::datagram{client.local_endpoint(), caney::memory::shared_const_buf::copy(std::string("ok"))});
+	source->push(std::move(datagrams));
+	io.restart();
+	io.poll();
+
+	BOOST_CHECK_EQUAL(endpoint->stats().send_errors, 1u);
+	BOOST_CHECK_EQUAL(endpoint->stats().sent, 1u);
+	char buf[16];
+	std::size_t const got = client.receive(boost::asio::buffer(buf));
+	BOOST_CHECK_EQUAL(std::string(buf, got), "ok");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+#include "caney/streams/file_io.hpp"
+#include "caney/streams/io_uring.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace {
+	class temp_file {
+	public:
+		explicit temp_file(std::string const& content) {
+			char name[] = "/tmp/caney-file-io-test-XXXXXX";
+			int const fd = ::mkstemp(name);
+			if (-1 == fd) throw std::runtime_error("mkstemp failed");
+			::close(fd);
+			m_path = name;
+			std::ofstream(m_path, std::ios::binary) << content;
+		}
+
+		~temp_file() {
+			std::remove(m_path.c_str());
+		}
+
+		std::string const& path() const {
+			return m_path;
+		}
+
+	private:
+		std::string m_path;
+	};
+
+	std::string content(caney::streams::chunk_queue const& queue) {
+		std::string result;
+		for (caney::streams::chunk const& c : queue.queue()) {
+			boost::asio::const_buffer const buf = *c.get_const_buffer();
+			result.append(static_cast<char const*>(buf.data()), buf.size());
+		}
+		return result;
+	}
+
+	void check_read_chunks(bool io_uring) {
+		std::string data;
+		for (int i = 0; i < 10000; ++i) data.push_back(static_cast<char>('0' + i % 10));
+		temp_file file(data);
+		std::error_code ec;
+		std::shared_ptr<caney::streams::file_handle> handle = caney::streams::file_handle::open(file.path(), ec);
+		BOOST_REQUIRE(!ec);
+
+		caney::streams::file_io_options options;
+		options.buffer_size = 1024;
+		options.io_uring = io_uring;
+		caney::streams::file_io_pool pool(options);
+		BOOST_CHECK_EQUAL(pool.uses_io_uring(), io_uring && caney::streams::io_uring_engine::is_available());
+		boost::asio::io_context io;
+
+		// spans multiple pooled buffers
+		std::string first, tail, past_end;
+		caney::streams::file_chunk chunk(handle, caney::streams::file_size{100}, caney::streams::file_size{5000});
+		chunk.read(pool, io.get_executor(), 4000, [&](std::error_code read_ec, caney::streams::chunk_queue queue) {
+			BOOST_CHECK(!read_ec);
+			BOOST_CHECK_EQUAL(queue.queue().size(), 4u);
+			first = content(queue);
+		});
+		// short read at end of file
+		pool.read(handle, caney::streams::file_size{9990}, 100, io.get_executor(), [&](std::error_code read_ec, caney::streams::chunk_queue queue) {
+			BOOST_CHECK(!read_ec);
+			tail = content(queue);
+		});
+		pool.read(handle, caney::streams::file_size{20000}, 100, io.get_executor(), [&](std::error_code read_ec, caney::streams::chunk_queue queue) {
+			BOOST_CHECK(!read_ec);
+			BOOST_CHECK(queue.empty());
+			past_end = "done";
+		});
+
+		// handlers run on the io_context only
+		while (pool.metrics().completed < 3) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		BOOST_CHECK(first.empty());
+		io.run();
+
+		BOOST_CHECK(first == data.substr(100, 4000));
+		BOOST_CHECK_EQUAL(tail, data.substr(9990));
+		BOOST_CHECK_EQUAL(past_end, "done");
+
+		caney::streams::file_io_metrics const metrics = pool.metrics();
+		BOOST_CHECK_EQUAL(metrics.submitted, 3u);
+		BOOST_CHECK_EQUAL(metrics.failed, 0u);
+		BOOST_CHECK_EQUAL(metrics.bytes, 4010u);
+		BOOST_CHECK_EQUAL(metrics.queue_depth, 0u);
+		BOOST_CHECK(metrics.max_latency >= metrics.average_latency());
+		std::uint64_t histogram_total = 0;
+		for (std::uint64_t count : metrics.latency_histogram) histogram_total += count;
+		BOOST_CHECK_EQUAL(histogram_total, 3u);
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(file_io_test)
+
+BOOST_AUTO_TEST_CASE(read_chunks) {
+	check_read_chunks(true);
+}
+
+BOOST_AUTO_TEST_CASE(read_chunks_thread_pool) {
+	check_read_chunks(false);
+}
+
+BOOST_AUTO_TEST_CASE(queue_depth_limit) {
+	temp_file file("data");
+	std::error_code ec;
+	std::shared_ptr<caney::streams::file_handle> handle = caney::streams::file_handle::open(file.path(), ec);
+	BOOST_REQUIRE(!ec);
+
+	caney::streams::file_io_options options;
+	options.threads = 1;
+	options.max_queue_depth = 0;
+	caney::streams::file_io_pool pool(options);
+	boost::asio::io_context io;
+
+	std::error_code result;
+	pool.read(handle, caney::streams::file_size{0}, 4, io.get_executor(), [&](std::error_code read_ec, caney::streams::chunk_queue) { result = read_ec; });
+	io.run();
+	BOOST_CHECK(result == std::errc::resource_unavailable_try_again);
+	BOOST_CHECK_EQUAL(pool.metrics().rejected, 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,159 @@
+#include "caney/streams/framing.hpp"
+
+#include "test_helpers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+	using test_helpers::test_source;
+
+	class frame_sink : public caney::streams::sink<caney::streams::frame> {
+	public:
+		std::vector<std::string> frames;
+		std::vector<std::size_t> slices;
+		std::vector<std::uint32_t> tags;
+		bool ended{false};
+		caney::streams::StreamEnd end{caney::streams::StreamEnd::Aborted};
+
+	protected:
+		void on_receive(chunks_t&& received) override {
+			for (caney::streams::frame const& f : received) {
+				frames.push_back(test_helpers::to_string(f.payload));
+				slices.push_back(f.payload.queue().size());
+				tags.push_back(f.tag);
+			}
+		}
+
+		void on_end(caney::streams::StreamEnd e) override {
+			ended = true;
+			end = e;
+		}
+	};
+
+	struct pipeline {
+		explicit pipeline(std::shared_ptr<caney::streams::framing_transform> transform) : framer(std::move(transform)) {
+			caney::streams::connect(source, framer);
+			caney::streams::connect(framer, sink);
+		}
+
+		std::shared_ptr<test_source> source = std::make_shared<test_source>();
+		std::shared_ptr<caney::streams::framing_transform> framer;
+		std::shared_ptr<frame_sink> sink = std::make_shared<frame_sink>();
+	};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(framing_test)
+
+BOOST_AUTO_TEST_CASE(length_prefixed) {
+	{
+		pipeline p(caney::streams::framing_transform::length_prefixed(1));
+		p.source->push(std::string("\x03" "abc" "\x00" "\x02" "de", 8));
+		BOOST_REQUIRE_EQUAL(p.sink->frames.size(), 3u);
+		BOOST_CHECK_EQUAL(p.sink->frames[0], "abc");
+		BOOST_CHECK_EQUAL(p.sink->frames[1], "");
+		BOOST_CHECK_EQUAL(p.sink->frames[2], "de");
+		// single slice of the received chunk
+		BOOST_CHECK_EQUAL(p.sink->slices[0], 1u);
+		p.source->end();
+		BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == p.sink->end);
+	}
+
+	{
+		pipeline p(caney::streams::framing_transform::length_prefixed(2, caney::streams::byte_order::little));
+		p.source->push(std::string("\x05\x00he", 4));
+		BOOST_CHECK(p.sink->frames.empty());
+		p.source->push("llo");
+		BOOST_REQUIRE_EQUAL(p.sink->frames.size(), 1u);
+		BOOST_CHECK_EQUAL(p.sink->frames[0], "hello");
+		// frame spread over two chunks
+		BOOST_CHECK_EQUAL(p.sink->slices[0], 2u);
+	}
+
+	{
+		pipeline p(caney::streams::framing_transform::length_prefixed(4));
+		p.source->push(std::string("\x00\x00\x00\x02xy\x00\x00\x01\x00", 10), 1);
+		BOOST_REQUIRE_EQUAL(p.sink->frames.size(), 1u);
+		BOOST_CHECK_EQUAL(p.sink->frames[0], "xy");
+		BOOST_CHECK_EQUAL(p.framer->buffered_bytes().get(), 4u);
+		// truncated frame
+		p.source->end();
+		BOOST_CHECK(caney::streams::StreamEnd::Aborted == p.sink->end);
+		BOOST_CHECK(p.framer->error() == std::errc::no_message_available);
+	}
+
+	{
+		pipeline p(caney::streams::framing_transform::length_prefixed(2, caney::streams::byte_order::big, 100));
+		p.source->push(std::string("\x01\x00", 2));
+		BOOST_CHECK(p.sink->ended);
+		BOOST_CHECK(caney::streams::StreamEnd::Aborted == p.sink->end);
+		BOOST_CHECK(p.framer->error() == std::errc::message_size);
+		BOOST_CHECK(!p.framer->get_source());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(delimited) {
+	{
+		pipeline p(caney::streams::framing_transform::delimited("\r\n"));
+		p.source->push("GET / HTTP/1.1\r\nHost: x\r");
+		BOOST_REQUIRE_EQUAL(p.sink->frames.size(), 1u);
+		BOOST_CHECK_EQUAL(p.sink->frames[0], "GET / HTTP/1.1");
+		p.source->push("\n\r\nrest");
+		BOOST_REQUIRE_EQUAL(p.sink->frames.size(), 3u);
+		BOOST_CHECK_EQUAL(p.sink->frames[1], "Host: x");
+		BOOST_CHECK_EQUAL(p.sink->frames[2], "");
+		BOOST_CHECK_EQUAL(p.framer->buffered_bytes().get(), 4u);
+	}
+
+	{
+		// delimiter and partial matches spread over single-byte chunks
+		pipeline p(caney::streams::framing_transform::delimited("abc"));
+		p.source->push("xabxababcyabc", 1);
+		p.source->push("ab", 1);
+		p.source->push("c", 1);
+		BOOST_REQUIRE_EQUAL(p.sink->frames.size(), 3u);
+		BOOST_CHECK_EQUAL(p.sink->frames[0], "xabxab");
+		BOOST_CHECK_EQUAL(p.sink->frames[1], "y");
+		BOOST_CHECK_EQUAL(p.sink->frames[2], "");
+		BOOST_CHECK_EQUAL(p.sink->slices[0], 6u);
+		p.source->end();
+		BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == p.sink->end);
+	}
+
+	{
+		pipeline p(caney::streams::framing_transform::delimited("\n", 8));
+		p.source->push("12345678\n");
+		BOOST_REQUIRE_EQUAL(p.sink->frames.size(), 1u);
+		p.source->push("123456789");
+		BOOST_CHECK(caney::streams::StreamEnd::Aborted == p.sink->end);
+		BOOST_CHECK(p.framer->error() == std::errc::message_size);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(peer_wire) {
+	std::string const pstr = "BitTorrent protocol";
+	std::string const handshake = std::string(1, static_cast<char>(pstr.size())) + pstr + std::string(8, '\0') + std::string(20, 'H') + std::string(20, 'P');
+	// keep-alive, interested (id 2), have (id 4) piece 7
+	std::string const messages = std::string("\x00\x00\x00\x00", 4) + std::string("\x00\x00\x00\x01\x02", 5) + std::string("\x00\x00\x00\x05\x04\x00\x00\x00\x07", 9);
+
+	pipeline p(caney::streams::framing_transform::peer_wire());
+	std::string const all = handshake + messages;
+	p.source->push(all.substr(0, 30));
+	BOOST_CHECK(p.sink->frames.empty());
+	p.source->push(all.substr(30));
+	BOOST_REQUIRE_EQUAL(p.sink->frames.size(), 4u);
+	BOOST_CHECK_EQUAL(p.sink->frames[0], handshake);
+	BOOST_CHECK_EQUAL(p.sink->tags[0], caney::streams::peer_wire_format::handshake_tag);
+	BOOST_CHECK_EQUAL(p.sink->frames[1], "");
+	BOOST_CHECK_EQUAL(p.sink->frames[2], "\x02");
+	BOOST_CHECK_EQUAL(p.sink->frames[3], std::string("\x04\x00\x00\x00\x07", 5));
+	BOOST_CHECK_EQUAL(p.sink->tags[3], 0u);
+
+	pipeline q(caney::streams::framing_transform::peer_wire(false));
+	q.source->push(messages);
+	BOOST_CHECK_EQUAL(q.sink->frames.size(), 3u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
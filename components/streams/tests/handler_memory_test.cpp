@@ -0,0 +1,112 @@
+#include "caney/streams/asio.hpp"
+
+#include "test_helpers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <string>
+
+namespace {
+	using test_helpers::collect_sink;
+	using test_helpers::test_source;
+
+	std::atomic<std::size_t> heap_allocations{0};
+
+	void count_heap_allocation(std::size_t) {
+		++heap_allocations;
+	}
+
+	// count handler allocations falling back to the heap while alive
+	class heap_allocation_counter {
+	public:
+		heap_allocation_counter() {
+			heap_allocations = 0;
+			caney::streams::impl::handler_heap_hook.store(&count_heap_allocation);
+		}
+
+		~heap_allocation_counter() {
+			caney::streams::impl::handler_heap_hook.store(nullptr);
+		}
+
+		std::size_t count() const {
+			return heap_allocations.load();
+		}
+	};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(handler_memory_test)
+
+BOOST_AUTO_TEST_CASE(memory_outlives_owner) {
+	auto memory = std::make_shared<caney::streams::impl::handler_memory>();
+	std::weak_ptr<caney::streams::impl::handler_memory> const weak_memory = memory;
+	auto handler = caney::streams::impl::make_handler_with_memory(memory, []() {});
+
+	// operation still pending when its owner is gone: the handler keeps the block alive for the deallocation
+	void* const pointer = asio_handler_allocate(64, &handler);
+	memory.reset();
+	BOOST_CHECK(!weak_memory.expired());
+	asio_handler_deallocate(pointer, 64, &handler);
+
+	{
+		auto moved = std::move(handler);
+	}
+	BOOST_CHECK(weak_memory.expired());
+}
+
+BOOST_AUTO_TEST_CASE(heap_fallback) {
+	heap_allocation_counter counter;
+	caney::streams::impl::handler_memory memory;
+
+	void* const first = memory.allocate(64);
+	BOOST_CHECK_EQUAL(counter.count(), 0u);
+	// block in use
+	void* const second = memory.allocate(64);
+	BOOST_CHECK_EQUAL(counter.count(), 1u);
+	memory.deallocate(second);
+	memory.deallocate(first);
+
+	// block reusable after deallocation
+	memory.deallocate(memory.allocate(64));
+	BOOST_CHECK_EQUAL(counter.count(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(steady_state_without_heap_allocations) {
+	using endpoint_t = caney::streams::asio_endpoint<boost::asio::local::stream_protocol>;
+
+	boost::asio::io_context io;
+	boost::asio::local::stream_protocol::socket local(io), remote(io);
+	boost::asio::local::connect_pair(local, remote);
+
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	std::shared_ptr<endpoint_t> endpoint = endpoint_t::create(strand, std::move(local));
+	auto source = std::make_shared<test_source>();
+	auto sink = std::make_shared<collect_sink>();
+	caney::streams::connect(source, endpoint);
+	caney::streams::connect(endpoint, sink);
+
+	caney::memory::shared_const_buf const message = caney::memory::shared_const_buf::copy(std::string(100, 'x'));
+	char buf[100];
+
+	auto round_trip = [&]() {
+		// remote -> endpoint -> sink
+		std::size_t const expected = sink->data.size() + sizeof(buf);
+		boost::asio::write(remote, boost::asio::buffer(buf));
+		while (sink->data.size() < expected) {
+			io.restart();
+			io.run_one();
+		}
+		// source -> endpoint -> remote
+		source->push(message);
+		io.restart();
+		io.poll();
+		boost::asio::read(remote, boost::asio::buffer(buf));
+	};
+
+	// reads and writes (and their strand dispatches) alternate: each kind reuses its block
+	heap_allocation_counter counter;
+	for (int i = 0; i < 100; ++i) round_trip();
+	BOOST_CHECK_EQUAL(counter.count(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
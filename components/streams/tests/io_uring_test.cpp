@@ -0,0 +1,236 @@
+#include "caney/streams/io_uring.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+	class temp_file {
+	public:
+		explicit temp_file(std::string const& content) {
+			char name[] = "/tmp/caney-io-uring-test-XXXXXX";
+			int const fd = ::mkstemp(name);
+			if (-1 == fd) throw std::runtime_error("mkstemp failed");
+			::close(fd);
+			m_path = name;
+			std::ofstream(m_path, std::ios::binary) << content;
+		}
+
+		~temp_file() {
+			std::remove(m_path.c_str());
+		}
+
+		std::string const& path() const {
+			return m_path;
+		}
+
+	private:
+		std::string m_path;
+	};
+
+	std::string content(caney::streams::chunk_queue const& queue) {
+		std::string result;
+		for (caney::streams::chunk const& c : queue.queue()) {
+			boost::asio::const_buffer const buf = *c.get_const_buffer();
+			result.append(static_cast<char const*>(buf.data()), buf.size());
+		}
+		return result;
+	}
+
+	std::unique_ptr<caney::streams::io_uring_engine> create_engine(caney::streams::io_uring_options const& options) {
+		std::error_code ec;
+		std::unique_ptr<caney::streams::io_uring_engine> engine = caney::streams::io_uring_engine::create(options, ec);
+		if (!engine) BOOST_TEST_MESSAGE("io_uring not available: " << ec.message());
+		BOOST_CHECK_EQUAL(bool(engine), caney::streams::io_uring_engine::is_available());
+		return engine;
+	}
+
+	void run_once(caney::streams::io_uring_engine& engine) {
+		std::error_code ec;
+		engine.run_once(ec);
+		BOOST_REQUIRE(!ec);
+	}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(io_uring_test)
+
+BOOST_AUTO_TEST_CASE(read_file) {
+	caney::streams::io_uring_options options;
+	options.buffer_size = 1024;
+	options.fixed_buffers = 2;
+	std::unique_ptr<caney::streams::io_uring_engine> engine = create_engine(options);
+	if (!engine) return;
+
+	std::string data;
+	for (int i = 0; i < 10000; ++i) data.push_back(static_cast<char>('0' + i % 10));
+	temp_file file(data);
+	std::error_code ec;
+	std::shared_ptr<caney::streams::file_handle> handle = caney::streams::file_handle::open(file.path(), ec);
+	BOOST_REQUIRE(!ec);
+
+	// more pieces than fixed buffers: the remaining ones use normal pooled buffers
+	std::string first, tail, past_end;
+	caney::streams::file_chunk chunk(handle, caney::streams::file_size{100}, caney::streams::file_size{5000});
+	engine->read(chunk, 4000, [&](std::error_code read_ec, caney::streams::chunk_queue queue) {
+		BOOST_CHECK(!read_ec);
+		BOOST_CHECK_EQUAL(queue.queue().size(), 4u);
+		first = content(queue);
+	});
+	engine->read(handle, caney::streams::file_size{9990}, 100, [&](std::error_code read_ec, caney::streams::chunk_queue queue) {
+		BOOST_CHECK(!read_ec);
+		tail = content(queue);
+	});
+	engine->read(handle, caney::streams::file_size{20000}, 100, [&](std::error_code read_ec, caney::streams::chunk_queue queue) {
+		BOOST_CHECK(!read_ec);
+		BOOST_CHECK(queue.empty());
+		past_end = "done";
+	});
+
+	// handlers only run from the event loop
+	BOOST_CHECK(first.empty());
+	BOOST_CHECK_EQUAL(engine->pending(), 6u);
+	while (engine->pending() > 0) run_once(*engine);
+
+	BOOST_CHECK(first == data.substr(100, 4000));
+	BOOST_CHECK_EQUAL(tail, data.substr(9990));
+	BOOST_CHECK_EQUAL(past_end, "done");
+
+	// all six reads were passed to the kernel in one batch
+	caney::streams::io_uring_stats const stats = engine->stats();
+	BOOST_CHECK_EQUAL(stats.completed, stats.submitted);
+	BOOST_CHECK(stats.enter_calls < 6u);
+}
+
+BOOST_AUTO_TEST_CASE(read_error) {
+	std::unique_ptr<caney::streams::io_uring_engine> engine = create_engine(caney::streams::io_uring_options());
+	if (!engine) return;
+
+	std::error_code ec;
+	std::shared_ptr<caney::streams::file_handle> handle = caney::streams::file_handle::open("/tmp", ec);
+	BOOST_REQUIRE(!ec);
+
+	// reading a directory fails
+	std::error_code result;
+	engine->read(handle, caney::streams::file_size{0}, 10, [&](std::error_code read_ec, caney::streams::chunk_queue) { result = read_ec; });
+	while (engine->pending() > 0) run_once(*engine);
+	BOOST_CHECK(result == std::errc::is_a_directory);
+}
+
+BOOST_AUTO_TEST_CASE(socket_io) {
+	caney::streams::io_uring_options options;
+	options.buffer_size = 256;
+	options.recv_buffers = 4;
+	std::unique_ptr<caney::streams::io_uring_engine> engine = create_engine(options);
+	if (!engine) return;
+
+	int fds[2];
+	BOOST_REQUIRE_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+	std::string received;
+	bool eof = false;
+	engine->recv_multishot(fds[1], [&](std::error_code ec, caney::memory::shared_const_buf data) {
+		BOOST_CHECK(!ec);
+		if (data.empty()) {
+			eof = true;
+		} else {
+			received.append(data.char_begin(), data.char_end());
+		}
+	});
+
+	// more data than provided buffers
+	std::string sent;
+	for (int i = 0; i < 20; ++i) {
+		std::string const message(100, static_cast<char>('a' + i));
+		sent += message;
+		std::size_t written = 0;
+		engine->write(fds[0], caney::memory::shared_const_buf::copy(message), [&](std::error_code ec, std::size_t bytes) {
+			BOOST_CHECK(!ec);
+			written = bytes;
+		});
+		while (0 == written) run_once(*engine);
+		BOOST_CHECK_EQUAL(written, message.size());
+		while (received.size() < sent.size()) run_once(*engine);
+	}
+	BOOST_CHECK(received == sent);
+	BOOST_CHECK(!eof);
+
+	::shutdown(fds[0], SHUT_WR);
+	while (!eof) run_once(*engine);
+	BOOST_CHECK_EQUAL(engine->pending(), 0u);
+
+	::close(fds[0]);
+	::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(cancel_recv) {
+	std::unique_ptr<caney::streams::io_uring_engine> engine = create_engine(caney::streams::io_uring_options());
+	if (!engine) return;
+
+	int fds[2];
+	BOOST_REQUIRE_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+	std::size_t calls = 0;
+	std::error_code result;
+	std::uint64_t const id = engine->recv_multishot(fds[1], [&](std::error_code ec, caney::memory::shared_const_buf) {
+		++calls;
+		result = ec;
+	});
+	std::error_code ec;
+	engine->submit(ec);
+	BOOST_REQUIRE(!ec);
+	engine->cancel(id);
+	while (engine->pending() > 0) run_once(*engine);
+	BOOST_CHECK_EQUAL(calls, 1u);
+	BOOST_CHECK(result == std::errc::operation_canceled);
+
+	::close(fds[0]);
+	::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(destroy_pending) {
+	caney::streams::io_uring_options options;
+	options.recv_buffers = 4;
+	std::unique_ptr<caney::streams::io_uring_engine> engine = create_engine(options);
+	if (!engine) return;
+
+	int fds[2];
+	BOOST_REQUIRE_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+	bool called = false;
+	engine->recv_multishot(fds[1], [&](std::error_code, caney::memory::shared_const_buf) { called = true; });
+	engine->recv(fds[1], [&](std::error_code, caney::memory::shared_const_buf) { called = true; });
+	std::error_code ec;
+	engine->submit(ec);
+	BOOST_REQUIRE(!ec);
+	BOOST_CHECK_EQUAL(engine->pending(), 2u);
+
+	// waits for the canceled receives before the provided buffers are released; handlers aren't called
+	engine.reset();
+	BOOST_CHECK(!called);
+
+	// data sent afterwards isn't received into released buffers
+	BOOST_CHECK_EQUAL(::write(fds[0], "data", 4), 4);
+	char buf[4];
+	BOOST_CHECK_EQUAL(::read(fds[1], buf, sizeof(buf)), 4);
+
+	::close(fds[0]);
+	::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(disabled_fallback) {
+	::setenv("CANEY_NO_IO_URING", "1", 1);
+	std::error_code ec;
+	std::unique_ptr<caney::streams::io_uring_engine> engine = caney::streams::io_uring_engine::create(caney::streams::io_uring_options(), ec);
+	::unsetenv("CANEY_NO_IO_URING");
+	BOOST_CHECK(!engine);
+	BOOST_CHECK(ec == std::errc::function_not_supported);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+#include "caney/streams/chunks.hpp"
+#include "caney/streams/parallel.hpp"
+
+#include "test_helpers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace {
+	using parallel_t = caney::streams::parallel_transform<caney::streams::chunk, caney::streams::chunk>;
+
+	using test_helpers::collect_sink;
+	using test_helpers::run_until;
+	using test_helpers::test_source;
+	using test_helpers::to_string;
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(parallel_test)
+
+BOOST_AUTO_TEST_CASE(keeps_order) {
+	boost::asio::io_context io;
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	boost::asio::thread_pool workers(4);
+
+	std::atomic<std::size_t> running{0};
+	std::atomic<std::size_t> max_running{0};
+	parallel_t::function_t upper = [&](caney::streams::chunk_queue chunks) {
+		std::size_t const now = ++running;
+		std::size_t prev = max_running.load();
+		while (prev < now && !max_running.compare_exchange_weak(prev, now)) {}
+
+		std::string data = to_string(chunks);
+		// earlier batches (lower digit) take longer
+		std::this_thread::sleep_for(std::chrono::milliseconds(10 - (data[0] - '0')));
+		for (auto& c : data) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+		--running;
+		return caney::streams::chunk_queue(caney::streams::chunk(caney::memory::shared_const_buf::copy(data)));
+	};
+
+	caney::streams::parallel_options options;
+	options.max_in_flight = 3;
+	auto parallel = parallel_t::create(strand, workers.get_executor(), upper, options);
+	auto source = std::make_shared<test_source>();
+	auto sink = std::make_shared<collect_sink>();
+	caney::streams::connect(source, parallel);
+	caney::streams::connect(parallel, sink);
+
+	std::string expected;
+	strand->post([&]() {
+		for (std::size_t i = 0; i < 10; ++i) {
+			std::string const data = std::to_string(i) + "abc";
+			source->push(data);
+			expected += std::to_string(i) + "ABC";
+		}
+		source->end(caney::streams::StreamEnd::EndOfStream);
+	});
+	run_until(io, [&]() { return sink->ended; });
+
+	BOOST_CHECK(sink->ended);
+	BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == sink->end);
+	BOOST_CHECK_EQUAL(sink->data, expected);
+	BOOST_CHECK_EQUAL(parallel->in_flight(), 0u);
+	BOOST_CHECK_LE(max_running.load(), 3u);
+	workers.join();
+}
+
+BOOST_AUTO_TEST_CASE(backpressure) {
+	boost::asio::io_context io;
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	boost::asio::thread_pool workers(2);
+
+	caney::streams::parallel_options options;
+	options.max_in_flight = 2;
+	auto parallel = parallel_t::create(strand, workers.get_executor(), [](caney::streams::chunk_queue chunks) { return chunks; }, options);
+	auto source = std::make_shared<test_source>();
+	auto sink = std::make_shared<collect_sink>();
+	caney::streams::connect(source, parallel);
+	caney::streams::connect(parallel, sink);
+
+	strand->post([&]() {
+		source->push("a");
+		BOOST_CHECK_EQUAL(parallel->in_flight(), 1u);
+		source->push("b");
+		BOOST_CHECK_EQUAL(parallel->in_flight(), 2u);
+		// paused: kept in the source
+		source->push("c");
+		source->push("d");
+		BOOST_CHECK_EQUAL(parallel->in_flight(), 2u);
+		source->end(caney::streams::StreamEnd::EndOfStream);
+	});
+	run_until(io, [&]() { return sink->ended; });
+
+	BOOST_CHECK(sink->ended);
+	BOOST_CHECK_EQUAL(sink->data, "abcd");
+	workers.join();
+}
+
+BOOST_AUTO_TEST_CASE(abort) {
+	boost::asio::io_context io;
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	boost::asio::thread_pool workers(1);
+
+	auto parallel = parallel_t::create(strand, workers.get_executor(), [](caney::streams::chunk_queue chunks) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		return chunks;
+	});
+	auto source = std::make_shared<test_source>();
+	auto sink = std::make_shared<collect_sink>();
+	caney::streams::connect(source, parallel);
+	caney::streams::connect(parallel, sink);
+
+	strand->post([&]() {
+		source->push("a");
+		source->end(caney::streams::StreamEnd::Aborted);
+	});
+	run_until(io, [&]() { return sink->ended; });
+	workers.join();
+	// let the dropped result arrive
+	io.restart();
+	io.poll();
+
+	BOOST_CHECK(sink->ended);
+	BOOST_CHECK(caney::streams::StreamEnd::Aborted == sink->end);
+	BOOST_CHECK(sink->data.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+#include "caney/streams/chunks.hpp"
+#include "caney/streams/pipeline.hpp"
+
+#include "test_helpers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <string>
+
+namespace {
+	using test_helpers::test_source;
+
+	class pass_filter : public caney::streams::filter<caney::streams::chunk> {};
+
+	// sink pausing while it holds data
+	class holding_sink : public caney::streams::sink<caney::streams::chunk> {
+	public:
+		void hold() {
+			pause();
+		}
+
+		void release() {
+			resume();
+		}
+
+	protected:
+		void on_receive(caney::streams::chunk_queue&&) override {}
+		void on_end(caney::streams::StreamEnd) override {}
+	};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(pipeline_test)
+
+BOOST_AUTO_TEST_CASE(walk) {
+	std::shared_ptr<test_source> source = std::make_shared<test_source>();
+	std::shared_ptr<pass_filter> first = std::make_shared<pass_filter>();
+	std::shared_ptr<pass_filter> second = std::make_shared<pass_filter>();
+	std::shared_ptr<holding_sink> sink = std::make_shared<holding_sink>();
+	caney::streams::connect(source, first);
+	caney::streams::connect(first, second);
+	caney::streams::connect(second, sink);
+
+	source->push("hello");
+	sink->hold();
+	source->push("world");
+	source->push("!");
+	sink->release();
+
+	// same result starting anywhere
+	std::vector<caney::streams::stage_info> const stages = caney::streams::walk_pipeline(static_cast<caney::streams::sink<caney::streams::chunk> const&>(*second));
+	BOOST_REQUIRE_EQUAL(stages.size(), 4u);
+	BOOST_CHECK_EQUAL(caney::streams::walk_pipeline(*source).size(), 4u);
+	BOOST_CHECK_EQUAL(caney::streams::walk_pipeline(*sink).size(), 4u);
+
+	BOOST_CHECK(stages[0].source == source.get());
+	BOOST_CHECK(!stages[0].sink);
+	BOOST_CHECK(stages[1].sink == static_cast<caney::streams::sink_base const*>(first.get()));
+	BOOST_CHECK(stages[1].source == static_cast<caney::streams::source_base const*>(first.get()));
+	BOOST_CHECK(stages[3].sink == sink.get());
+	BOOST_CHECK(!stages[3].source);
+	BOOST_CHECK_NE(stages[3].name.find("holding_sink"), std::string::npos);
+
+	std::string const dump = caney::streams::dump_pipeline(stages);
+	BOOST_CHECK_NE(dump.find("pass_filter"), std::string::npos);
+	BOOST_CHECK_EQUAL(std::count(dump.begin(), dump.end(), '\n'), 4);
+
+	if (caney::streams::stats_enabled) {
+		BOOST_CHECK_EQUAL(stages[0].out.chunks_out, 3u);
+		BOOST_CHECK_EQUAL(stages[0].out.bytes_out, 11u);
+		// without origin the paused sink only stops the last filter
+		BOOST_CHECK_EQUAL(stages[0].out.max_pending, 0u);
+		BOOST_CHECK_EQUAL(stages[2].out.max_pending, 2u);
+		BOOST_CHECK_EQUAL(stages[2].out.pending, 0u);
+		BOOST_CHECK_EQUAL(stages[3].in.chunks_in, 3u);
+		BOOST_CHECK_EQUAL(stages[3].in.bytes_in, 11u);
+		BOOST_CHECK_EQUAL(stages[3].in.callbacks, 2u); // "world" and "!" were sent together
+		BOOST_CHECK_EQUAL(stages[3].in.pauses, 1u);
+		BOOST_CHECK_NE(dump.find("bytes=11"), std::string::npos);
+	} else {
+		BOOST_CHECK_EQUAL(stages[3].in.callbacks, 0u);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+#include "caney/streams/rate_limit.hpp"
+
+#include "test_helpers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <string>
+
+namespace {
+	using test_helpers::collect_sink;
+	using test_helpers::run_until;
+	using test_helpers::test_origin;
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(rate_limit_test)
+
+BOOST_AUTO_TEST_CASE(token_bucket) {
+	using clock_t = caney::streams::token_bucket::clock_t;
+	auto bucket = caney::streams::token_bucket::create(1000, 100);
+	clock_t::time_point const start = clock_t::now();
+	BOOST_CHECK_EQUAL(bucket->available(start), 100u);
+	bucket->consume(100, start);
+	BOOST_CHECK_EQUAL(bucket->available(start), 0u);
+	BOOST_CHECK_EQUAL(bucket->available(start + std::chrono::milliseconds(50)), 50u);
+	// fractions of tokens carry over
+	BOOST_CHECK_EQUAL(bucket->available(start + std::chrono::microseconds(50500)), 50u);
+	BOOST_CHECK_EQUAL(bucket->available(start + std::chrono::microseconds(51000)), 51u);
+	// capped at burst
+	BOOST_CHECK_EQUAL(bucket->available(start + std::chrono::seconds(10)), 100u);
+
+	// child limited by parent
+	auto parent = caney::streams::token_bucket::create(100, 10);
+	auto child = caney::streams::token_bucket::create(1000, 100, parent);
+	auto unlimited = caney::streams::token_bucket::create(0, 0, parent);
+	BOOST_CHECK_EQUAL(child->available(start), 10u);
+	child->consume(4, start);
+	BOOST_CHECK_EQUAL(unlimited->available(start), 6u);
+	BOOST_CHECK_EQUAL(child->available(start), 6u);
+	parent->set_rate(0, 0);
+	BOOST_CHECK_EQUAL(child->available(start), 96u);
+}
+
+BOOST_AUTO_TEST_CASE(throttle) {
+	boost::asio::io_context io;
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	auto timer = caney::streams::rate_timer::create(strand, std::chrono::milliseconds(5));
+	// 10 kB/s, 100 bytes burst: 1000 bytes take ~90ms
+	auto limiter = caney::streams::rate_limit_filter::create(timer, caney::streams::token_bucket::create(10000, 100));
+	auto source = test_origin::create();
+	auto sink = std::make_shared<collect_sink>();
+	caney::streams::connect(source, limiter);
+	caney::streams::connect(limiter, sink);
+
+	// connecting the limiter before its sink paused the origin once already
+	std::size_t const pauses = source->pauses;
+	std::string const data(1000, 'x');
+	auto const start = std::chrono::steady_clock::now();
+	strand->post([&]() {
+		source->push(data);
+		// split at the token boundary, remainder waits for the timer
+		BOOST_CHECK_EQUAL(sink->data.size(), 100u);
+		BOOST_CHECK_EQUAL(limiter->queued_bytes().get(), 900u);
+		BOOST_CHECK(source->is_paused());
+		BOOST_CHECK_EQUAL(timer->waiting(), 1u);
+		source->end();
+	});
+	run_until(io, [&]() { return sink->ended; });
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+
+	BOOST_CHECK(sink->ended);
+	BOOST_CHECK(caney::streams::StreamEnd::EndOfStream == sink->end);
+	BOOST_CHECK(sink->data == data);
+	BOOST_CHECK_GT(sink->batches.size(), 2u);
+	BOOST_CHECK(elapsed >= std::chrono::milliseconds(80));
+	BOOST_CHECK_EQUAL(source->pauses, pauses + 1);
+	BOOST_CHECK_EQUAL(source->resumes, pauses + 1);
+	BOOST_CHECK_EQUAL(timer->waiting(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(shared_parent) {
+	boost::asio::io_context io;
+	auto strand = std::make_shared<boost::asio::io_context::strand>(io);
+	auto timer = caney::streams::rate_timer::create(strand, std::chrono::milliseconds(5));
+	// global limit shared by two unlimited peers
+	auto global = caney::streams::token_bucket::create(20000, 200);
+	std::shared_ptr<test_origin> sources[2];
+	std::shared_ptr<collect_sink> sinks[2];
+	for (std::size_t i = 0; i < 2; ++i) {
+		auto limiter = caney::streams::rate_limit_filter::create(timer, caney::streams::token_bucket::create(0, 0, global));
+		sources[i] = test_origin::create();
+		sinks[i] = std::make_shared<collect_sink>();
+		caney::streams::connect(sources[i], limiter);
+		caney::streams::connect(limiter, sinks[i]);
+	}
+
+	std::string const data(1000, 'y');
+	auto const start = std::chrono::steady_clock::now();
+	strand->post([&]() {
+		for (auto& source : sources) {
+			source->push(data);
+			source->end();
+		}
+		// first one took the whole burst
+		BOOST_CHECK_EQUAL(sinks[0]->data.size(), 200u);
+		BOOST_CHECK_EQUAL(sinks[1]->data.size(), 0u);
+	});
+	run_until(io, [&]() { return sinks[0]->ended && sinks[1]->ended; });
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+
+	for (auto& sink : sinks) {
+		BOOST_CHECK(sink->ended);
+		BOOST_CHECK(sink->data == data);
+	}
+	// 2000 bytes with 200 burst at 20 kB/s
+	BOOST_CHECK(elapsed >= std::chrono::milliseconds(80));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,30 @@
+#include "caney/streams/read_buffers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(read_buffers_test)
+
+BOOST_AUTO_TEST_CASE(adaptive_sizes) {
+	caney::streams::adaptive_read_buffers buffers(10000);
+	BOOST_CHECK_EQUAL(buffers.preferred_size(), 16u * 1024);
+	BOOST_CHECK_EQUAL(buffers.allocate().size(), 16u * 1024);
+
+	// full reads grow the buffers up to the limit
+	for (int i = 0; i < 10; ++i) buffers.record(buffers.preferred_size(), buffers.preferred_size());
+	BOOST_CHECK_EQUAL(buffers.preferred_size(), caney::streams::adaptive_read_buffers::max_size);
+	BOOST_CHECK_EQUAL(buffers.allocate().size(), caney::streams::adaptive_read_buffers::max_size);
+
+	// filling a smaller (left over) buffer doesn't
+	caney::streams::adaptive_read_buffers other;
+	other.record(4096, 4096);
+	BOOST_CHECK_EQUAL(other.preferred_size(), 16u * 1024);
+
+	// a few small reads are fine, a longer series shrinks the buffers
+	for (unsigned i = 0; i + 1 < caney::streams::adaptive_read_buffers::shrink_after; ++i) buffers.record(100, buffers.preferred_size());
+	buffers.record(200 * 1024, buffers.preferred_size());
+	BOOST_CHECK_EQUAL(buffers.preferred_size(), caney::streams::adaptive_read_buffers::max_size);
+	for (int i = 0; i < 1000; ++i) buffers.record(100, buffers.preferred_size());
+	BOOST_CHECK_EQUAL(buffers.preferred_size(), caney::streams::adaptive_read_buffers::min_size);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
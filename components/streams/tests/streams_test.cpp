@@ -0,0 +1,90 @@
+#include "caney/streams/chunks.hpp"
+#include "caney/streams/streams.hpp"
+
+#include "test_helpers.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+namespace {
+	using test_helpers::test_origin;
+
+	// sink buffering everything until told to process it
+	class buffering_sink : public caney::streams::sink<caney::streams::chunk> {
+	public:
+		void process(std::size_t bytes) {
+			m_queue.remove(caney::streams::file_size{bytes});
+			buffered_remove(bytes);
+		}
+
+		caney::streams::chunk_queue const& queue() const {
+			return m_queue;
+		}
+
+	protected:
+		void on_receive(caney::streams::chunk_queue&& chunks) override {
+			buffered_add(chunks);
+			m_queue.append(std::move(chunks));
+		}
+
+		void on_end(caney::streams::StreamEnd) override {}
+
+	private:
+		caney::streams::chunk_queue m_queue;
+	};
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(streams_test)
+
+BOOST_AUTO_TEST_CASE(watermarks) {
+	std::shared_ptr<test_origin> source = test_origin::create();
+	std::shared_ptr<buffering_sink> sink = std::make_shared<buffering_sink>();
+	sink->set_watermarks(100, 40);
+	caney::streams::connect(source, sink);
+
+	source->push(std::string(60, 'a'));
+	source->push(std::string(40, 'b'));
+	BOOST_CHECK(!source->is_paused());
+	BOOST_CHECK_EQUAL(sink->buffered(), 100u);
+
+	// above high watermark
+	source->push(std::string(30, 'c'));
+	BOOST_CHECK(source->is_paused());
+	BOOST_CHECK(sink->is_paused());
+	BOOST_CHECK_EQUAL(source->pauses, 1u);
+
+	// data still sent by the origin stays in the source
+	source->push(std::string(10, 'd'));
+	BOOST_CHECK_EQUAL(sink->buffered(), 130u);
+
+	// not below low watermark yet
+	sink->process(60);
+	BOOST_CHECK(source->is_paused());
+
+	// resumes and fetches pending data
+	sink->process(40);
+	BOOST_CHECK(!sink->is_paused());
+	BOOST_CHECK_EQUAL(source->resumes, 1u);
+	BOOST_CHECK_EQUAL(sink->buffered(), 40u);
+	BOOST_CHECK_EQUAL(sink->queue().bytes().get(), 40u);
+	BOOST_CHECK(!source->is_paused());
+}
+
+BOOST_AUTO_TEST_CASE(disable_watermarks) {
+	std::shared_ptr<test_origin> source = test_origin::create();
+	std::shared_ptr<buffering_sink> sink = std::make_shared<buffering_sink>();
+	sink->set_watermarks(10, 0);
+	caney::streams::connect(source, sink);
+
+	source->push(std::string(20, 'a'));
+	source->push(std::string(20, 'b'));
+	BOOST_CHECK(source->is_paused());
+	BOOST_CHECK_EQUAL(sink->buffered(), 20u);
+
+	sink->set_watermarks(0, 0);
+	BOOST_CHECK(!source->is_paused());
+	BOOST_CHECK_EQUAL(sink->buffered(), 40u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "caney/streams/chunks.hpp"
+#include "caney/streams/origin.hpp"
+#include "caney/streams/streams.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// stream stages shared by the tests of streams and the components built on it
+namespace test_helpers {
+	// concatenated content of memory chunks
+	inline std::string to_string(caney::streams::chunk_queue const& chunks) {
+		std::string result;
+		for (caney::streams::chunk const& c : chunks.queue()) {
+			boost::asio::const_buffer const buf = c.get_const_buffer().value();
+			result.append(static_cast<char const*>(buf.data()), buf.size());
+		}
+		return result;
+	}
+
+	class test_source : public caney::streams::source<caney::streams::chunk> {
+	public:
+		// push data split into chunks of `step` bytes (0: single chunk)
+		void push(std::string const& data, std::size_t step = 0) {
+			if (0 == step || step >= data.size()) {
+				send(caney::streams::chunk_queue(caney::streams::chunk(caney::memory::shared_const_buf::copy(data))));
+				return;
+			}
+			caney::streams::chunk_queue chunks;
+			for (std::size_t pos = 0; pos < data.size(); pos += step) {
+				chunks.append(caney::streams::chunk(caney::memory::shared_const_buf::copy(data.substr(pos, step))));
+			}
+			send(std::move(chunks));
+		}
+
+		void push(caney::memory::shared_const_buf const& buf) {
+			send(caney::streams::chunk_queue(caney::streams::chunk(caney::memory::shared_const_buf(buf))));
+		}
+
+		void push(caney::streams::chunk_queue&& chunks) {
+			send(std::move(chunks));
+		}
+
+		void end(caney::streams::StreamEnd end = caney::streams::StreamEnd::EndOfStream) {
+			send_end(end);
+		}
+
+	protected:
+		void on_disconnect() override {}
+	};
+
+	// source which is its own origin
+	class test_origin : public test_source, public caney::streams::origin, public std::enable_shared_from_this<test_origin> {
+	public:
+		static std::shared_ptr<test_origin> create() {
+			std::shared_ptr<test_origin> self = std::make_shared<test_origin>();
+			self->set_origin(self);
+			return self;
+		}
+
+		std::size_t pauses = 0;
+		std::size_t resumes = 0;
+
+	protected:
+		void on_pause() override {
+			++pauses;
+		}
+
+		void on_resume() override {
+			++resumes;
+		}
+	};
+
+	// collects all data; optionally pauses after each receive
+	class collect_sink : public caney::streams::sink<caney::streams::chunk> {
+	public:
+		// pause after each receive
+		void hold() {
+			m_hold = true;
+		}
+
+		// resume until the next receive
+		void next() {
+			resume();
+		}
+
+		// stop pausing and resume
+		void release() {
+			m_hold = false;
+			resume();
+		}
+
+		std::string data;
+		std::vector<std::size_t> batches; // bytes per receive
+		std::size_t max_chunks{0}; // max number of chunks per receive
+		bool ended{false};
+		caney::streams::StreamEnd end{caney::streams::StreamEnd::Aborted};
+
+	protected:
+		void on_receive(caney::streams::chunk_queue&& chunks) override {
+			batches.push_back(static_cast<std::size_t>(chunks.bytes().get()));
+			max_chunks = std::max(max_chunks, chunks.queue().size());
+			data += to_string(chunks);
+			if (m_hold) pause();
+		}
+
+		void on_end(caney::streams::StreamEnd e) override {
+			ended = true;
+			end = e;
+		}
+
+	private:
+		bool m_hold{false};
+	};
+
+	// run handlers until `done()`; handlers posted from other threads might arrive while the io_context is out of work
+	template <typename Predicate>
+	void run_until(boost::asio::io_context& io, Predicate done) {
+		for (std::size_t i = 0; i < 5000 && !done(); ++i) {
+			io.restart();
+			if (0 == io.poll()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+} // namespace test_helpers
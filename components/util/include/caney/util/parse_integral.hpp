@@ -27,27 +27,31 @@ __CANEY_UTILV1_BEGIN
  * @param str string to parse
  */
 template <typename Integral>
+caney::optional<Integral> parse_integral_open(memory::byte_view& str);
+
+/** @brief same as above for @ref memory::raw_const_buf */
+template <typename Integral>
 caney::optional<Integral> parse_integral_open(memory::raw_const_buf& str);
 
 #else // defined(DOXYGEN)
 
 template <typename Integral, std::enable_if_t<std::is_signed<Integral>::value>* = nullptr>
-caney::optional<Integral> parse_integral_open(memory::raw_const_buf& str) {
+caney::optional<Integral> parse_integral_open(memory::byte_view& str) {
 	unsigned char constexpr digit_0{'0'};
 	Integral constexpr Min = std::numeric_limits<Integral>::min();
 	Integral constexpr Max = std::numeric_limits<Integral>::max();
-	memory::raw_const_buf strCopy{str};
+	memory::byte_view strCopy{str};
 
 	if (strCopy.empty()) return caney::nullopt;
 	if ('-' == strCopy[size_t{0}]) {
-		strCopy = strCopy.raw_slice(1);
+		strCopy.remove_prefix(1);
 		if (strCopy.empty()) return caney::nullopt;
 		Integral result = 0;
 		for (auto const& c : strCopy) {
 			unsigned char const digit = c - digit_0;
 			if (CANEY_UNLIKELY(digit > 9)) {
 				if (&c == strCopy.begin()) return caney::nullopt;
-				str = strCopy.raw_slice(static_cast<std::size_t>(&c - strCopy.begin()));
+				str = strCopy.slice(static_cast<std::size_t>(&c - strCopy.begin()));
 				return result;
 			}
 			Integral const digitValue = static_cast<Integral>(digit);
@@ -55,45 +59,53 @@ caney::optional<Integral> parse_integral_open(memory::raw_const_buf& str) {
 			if (CANEY_UNLIKELY(result <= Min / 10) && (result < Min / 10 || digitValue > (-(Min + 10)) % 10)) return caney::nullopt;
 			result = 10 * result - digitValue;
 		}
-		str.reset();
+		str = memory::byte_view();
 		return result;
 	} else {
 		Integral result = 0;
-		for (auto c : strCopy) {
+		for (auto const& c : strCopy) {
 			unsigned char const digit = c - digit_0;
 			if (CANEY_UNLIKELY(digit > 9)) {
 				if (&c == strCopy.begin()) return caney::nullopt;
-				str = strCopy.raw_slice(static_cast<std::size_t>(&c - strCopy.begin()));
+				str = strCopy.slice(static_cast<std::size_t>(&c - strCopy.begin()));
 				return result;
 			}
 			Integral const digitValue = static_cast<Integral>(digit);
 			if (CANEY_UNLIKELY(result >= Max / 10) && (result > Max / 10 || digitValue > Max % 10)) return caney::nullopt;
 			result = 10 * result + digit;
 		}
-		str.reset();
+		str = memory::byte_view();
 		return result;
 	}
 }
 
 template <typename Integral, std::enable_if_t<std::is_unsigned<Integral>::value>* = nullptr>
-caney::optional<Integral> parse_integral_open(memory::raw_const_buf& str) {
+caney::optional<Integral> parse_integral_open(memory::byte_view& str) {
 	unsigned char constexpr digit_0{'0'};
 	Integral constexpr Max = std::numeric_limits<Integral>::max();
 
 	if (str.empty()) return caney::nullopt;
 	Integral result = 0;
-	for (auto c : str) {
+	for (auto const& c : str) {
 		unsigned char const digit = c - digit_0;
 		if (CANEY_UNLIKELY(digit > 9)) {
 			if (&c == str.begin()) return caney::nullopt;
-			str = str.raw_slice(static_cast<std::size_t>(&c - str.begin()));
+			str = str.slice(static_cast<std::size_t>(&c - str.begin()));
 			return result;
 		}
 		Integral const digitValue = static_cast<Integral>(digit);
 		if (CANEY_UNLIKELY(result >= Max / 10) && (result > Max / 10 || digitValue > Max % 10)) return caney::nullopt;
 		result = 10 * result + digit;
 	}
-	str.reset();
+	str = memory::byte_view();
+	return result;
+}
+
+template <typename Integral, std::enable_if_t<std::is_integral<Integral>::value>* = nullptr>
+caney::optional<Integral> parse_integral_open(memory::raw_const_buf& str) {
+	memory::byte_view view{str};
+	caney::optional<Integral> result = parse_integral_open<Integral>(view);
+	if (result) str = view.raw();
 	return result;
 }
 
@@ -112,10 +124,9 @@ caney::optional<Integral> parse_integral_open(memory::raw_const_buf& str) {
  * @param str string to parse
  */
 template <typename Integral, std::enable_if_t<std::is_integral<Integral>::value>* = nullptr>
-caney::optional<Integral> parse_integral(memory::const_buf const& str) {
-	memory::raw_const_buf buf = str.raw_copy();
-	caney::optional<Integral> result = parse_integral_open<Integral>(buf);
-	return buf.empty() ? result : caney::nullopt;
+caney::optional<Integral> parse_integral(memory::byte_view str) {
+	caney::optional<Integral> result = parse_integral_open<Integral>(str);
+	return str.empty() ? result : caney::nullopt;
 }
 
 __CANEY_UTILV1_END
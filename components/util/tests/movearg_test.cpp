@@ -95,11 +95,11 @@ namespace {
 
 			callback_counter = 0;
 
-			BOOST_MESSAGE("callback call 1");
+			BOOST_TEST_MESSAGE("callback call 1");
 			bound_callback(Arg());
 			BOOST_CHECK_EQUAL(callback_counter, 1);
 
-			BOOST_MESSAGE("callback call 2");
+			BOOST_TEST_MESSAGE("callback call 2");
 			bound_callback(Arg());
 			BOOST_CHECK_EQUAL(callback_counter, 2);
 		}
@@ -107,21 +107,21 @@ namespace {
 		template <typename Callback>
 		void test_strand_wrapped_call(Callback&& callback) {
 			boost::asio::io_service service;
-			boost::asio::strand strand(service);
+			boost::asio::io_service::strand strand(service);
 			std::function<void(Arg)> bound_callback = std::bind(callback, this, std::placeholders::_1);
 			std::function<void(Arg)> wrapped_callback = caney::util::wrap_dispatch(strand, bound_callback);
 			std::function<void(caney::util::move_arg<Arg>)> wrapped_callback_movearg = strand.wrap(bound_callback);
 
 			service.post([=, &service]() {
 				callback_counter = 0;
-				BOOST_MESSAGE("callback call 1");
+				BOOST_TEST_MESSAGE("callback call 1");
 				wrapped_callback(Arg());
-				BOOST_MESSAGE("callback call 2");
+				BOOST_TEST_MESSAGE("callback call 2");
 				wrapped_callback(Arg());
 				BOOST_CHECK_EQUAL(callback_counter, 2);
-				BOOST_MESSAGE("callback call 3");
+				BOOST_TEST_MESSAGE("callback call 3");
 				wrapped_callback_movearg(Arg());
-				BOOST_MESSAGE("callback call 4");
+				BOOST_TEST_MESSAGE("callback call 4");
 				wrapped_callback_movearg(Arg());
 				BOOST_CHECK_EQUAL(callback_counter, 4);
 				service.stop();